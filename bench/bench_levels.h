@@ -0,0 +1,73 @@
+#ifndef BOXWORLD_BENCH_LEVELS_H_
+#define BOXWORLD_BENCH_LEVELS_H_
+
+#include <boxworld/boxworld.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace boxworld::bench {
+
+// Board sizes each benchmark is run over
+constexpr std::array<int, 4> kBenchBoardSizes{10, 16, 20, 32};
+
+// Format a board in the same way as scripts/generate_levelset.py
+inline auto board_to_str(int size, const std::vector<int> &board) -> std::string {
+    std::stringstream ss;
+    ss << size << "|" << size;
+    for (const auto &el : board) {
+        ss << "|" << (el < 10 ? "0" : "") << el;
+    }
+    return ss.str();
+}
+
+// Fixed level with a goal chain of length 4 and one distractor box, similar to the generated levels.
+inline auto make_fixed_level(int size) -> std::string {
+    constexpr int kEmpty = static_cast<int>(Element::kEmpty);
+    std::vector<int> board(static_cast<std::size_t>(size * size), kEmpty);
+    const auto set = [&](int row, int col, Element el) {
+        board[static_cast<std::size_t>(row * size + col)] = static_cast<int>(el);
+    };
+    set(0, 0, Element::kAgent);
+    set(size - 1, size - 1, Element::kColour0);
+    // Boxes (contained key, lock)
+    set(1, 2, Element::kColour1);
+    set(1, 3, Element::kColour0);
+    set(3, size - 4, Element::kColour2);
+    set(3, size - 3, Element::kColour1);
+    set(size - 3, 2, Element::kColourGoal);
+    set(size - 3, 3, Element::kColour2);
+    set(size / 2, size / 2, Element::kColour5);
+    set(size / 2, size / 2 + 1, Element::kColour0);
+    return board_to_str(size, board);
+}
+
+// Get a level of the given size, taken from the level file in BOXWORLD_BENCH_LEVELS if it contains one
+// (e.g. train.txt from scripts/generate_levelset.py), otherwise a fixed level
+inline auto get_level(int size) -> std::string {
+    const char *path = std::getenv("BOXWORLD_BENCH_LEVELS");    // NOLINT(concurrency-mt-unsafe)
+    if (path != nullptr) {
+        std::ifstream file(path);
+        std::string line;
+        const auto prefix = std::to_string(size) + "|" + std::to_string(size) + "|";
+        while (std::getline(file, line)) {
+            if (line.rfind(prefix, 0) == 0) {
+                return line;
+            }
+        }
+    }
+    return make_fixed_level(size);
+}
+
+inline auto make_params(int size) -> GameParameters {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(get_level(size));
+    return params;
+}
+
+}    // namespace boxworld::bench
+
+#endif    // BOXWORLD_BENCH_LEVELS_H_
@@ -0,0 +1,521 @@
+#include <benchmark/benchmark.h>
+#include <boxworld/boxworld.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_levels.h"
+
+using namespace boxworld;
+using namespace boxworld::bench;
+
+namespace {
+
+// Fixed random action sequence so each run steps the same trajectory
+auto make_actions(std::size_t n) -> std::vector<Action> {
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(kNumActions) - 1);
+    std::vector<Action> actions;
+    actions.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        actions.push_back(static_cast<Action>(dist(gen)));
+    }
+    return actions;
+}
+
+void BoardSizes(benchmark::internal::Benchmark *b) {
+    for (const auto &size : kBenchBoardSizes) {
+        b->Arg(size);
+    }
+}
+
+void BM_ApplyAction(benchmark::State &bench_state) {
+    BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    const auto actions = make_actions(1024);
+    std::size_t i = 0;
+    for (auto _ : bench_state) {
+        state.apply_action(actions[i++ % actions.size()]);
+        if (state.is_solution()) {
+            state.reset();
+        }
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ApplyAction)->Apply(BoardSizes);
+
+template <std::size_t Size>
+void BM_FixedApplyAction(benchmark::State &bench_state) {
+    const BoxWorldGameState start_state(make_params(static_cast<int>(Size)));
+    const FixedBoxWorld<Size, Size> start(start_state);
+    auto state = start;
+    const auto actions = make_actions(1024);
+    std::size_t i = 0;
+    for (auto _ : bench_state) {
+        state.apply_action(actions[i++ % actions.size()]);
+        if (state.is_solution()) {
+            state = start;
+        }
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_FixedApplyAction, 10);
+BENCHMARK_TEMPLATE(BM_FixedApplyAction, 16);
+BENCHMARK_TEMPLATE(BM_FixedApplyAction, 20);
+BENCHMARK_TEMPLATE(BM_FixedApplyAction, 32);
+
+void BM_BitboardApplyAction(benchmark::State &bench_state) {
+    const BoxWorldGameState start_state(make_params(static_cast<int>(bench_state.range(0))));
+    const BitboardBoxWorld start(start_state);
+    auto state = start;
+    const auto actions = make_actions(1024);
+    std::size_t i = 0;
+    for (auto _ : bench_state) {
+        state.apply_action(actions[i++ % actions.size()]);
+        if (state.is_solution()) {
+            state = start;
+        }
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_BitboardApplyAction)->Arg(10)->Arg(16);
+
+void BM_GetIndices(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        auto indices = state.get_indices(Element::kColour0);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_GetIndices)->Arg(10)->Arg(16);
+
+void BM_BitboardGetIndices(benchmark::State &bench_state) {
+    const BitboardBoxWorld state(BoxWorldGameState(make_params(static_cast<int>(bench_state.range(0)))));
+    for (auto _ : bench_state) {
+        auto indices = state.get_indices(Element::kColour0);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_BitboardGetIndices)->Arg(10)->Arg(16);
+
+void BM_BitboardGetObservation(benchmark::State &bench_state) {
+    const BitboardBoxWorld state(BoxWorldGameState(make_params(static_cast<int>(bench_state.range(0)))));
+    std::vector<float> obs(state.observation_size());
+    for (auto _ : bench_state) {
+        state.get_observation(obs.data());
+        benchmark::DoNotOptimize(obs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_BitboardGetObservation)->Arg(10)->Arg(16);
+
+// Reachable cells by a BFS over the board through the public API
+void BM_ReachableBaseline(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    const auto cols = state.observation_shape()[1];
+    const auto num_cells = cols * state.observation_shape()[2];
+    std::vector<bool> reachable;
+    std::vector<std::size_t> queue;
+    for (auto _ : bench_state) {
+        reachable.assign(num_cells, false);
+        queue.assign(1, state.get_agent_index());
+        reachable[state.get_agent_index()] = true;
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const auto idx = queue[head];
+            const std::size_t neighbours[] = {idx >= cols ? idx - cols : num_cells,
+                                              idx + cols < num_cells ? idx + cols : num_cells,
+                                              idx % cols != 0 ? idx - 1 : num_cells,
+                                              idx % cols != cols - 1 ? idx + 1 : num_cells};
+            for (const auto &next : neighbours) {
+                if (next < num_cells && !reachable[next] && state.get_item(next) == Element::kEmpty) {
+                    reachable[next] = true;
+                    queue.push_back(next);
+                }
+            }
+        }
+        benchmark::DoNotOptimize(queue.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ReachableBaseline)->Arg(10)->Arg(16);
+
+// Flood fill of the reachable cells and the keys and locks next to them
+void BM_BitboardReachable(benchmark::State &bench_state) {
+    const BitboardBoxWorld start(BoxWorldGameState(make_params(static_cast<int>(bench_state.range(0)))));
+    for (auto _ : bench_state) {
+        // A fresh copy has no cached mask, so each iteration runs the flood fill
+        auto state = start;
+        benchmark::DoNotOptimize(state.reachable_targets());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_BitboardReachable)->Arg(10)->Arg(16);
+
+template <std::size_t Size>
+void BM_FixedStateCopy(benchmark::State &bench_state) {
+    const BoxWorldGameState start_state(make_params(static_cast<int>(Size)));
+    const FixedBoxWorld<Size, Size> state(start_state);
+    for (auto _ : bench_state) {
+        auto state_copy = state;
+        benchmark::DoNotOptimize(state_copy);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_FixedStateCopy, 10);
+BENCHMARK_TEMPLATE(BM_FixedStateCopy, 16);
+BENCHMARK_TEMPLATE(BM_FixedStateCopy, 20);
+BENCHMARK_TEMPLATE(BM_FixedStateCopy, 32);
+
+void BM_Reset(benchmark::State &bench_state) {
+    BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        state.reset();
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_Reset)->Apply(BoardSizes);
+
+void BM_StateCopy(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        BoxWorldGameState state_copy = state;
+        benchmark::DoNotOptimize(state_copy);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_StateCopy)->Apply(BoardSizes);
+
+// Large boards as well, where the sparse state copies only its entities
+void BM_LargeStateCopy(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        BoxWorldGameState state_copy = state;
+        benchmark::DoNotOptimize(state_copy);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_LargeStateCopy)->Arg(32)->Arg(64)->Arg(128);
+
+void BM_SparseStateCopy(benchmark::State &bench_state) {
+    const SparseBoxWorld state(BoxWorldGameState(make_params(static_cast<int>(bench_state.range(0)))));
+    for (auto _ : bench_state) {
+        auto state_copy = state;
+        benchmark::DoNotOptimize(state_copy);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_SparseStateCopy)->Arg(32)->Arg(64)->Arg(128);
+
+void BM_SparseApplyAction(benchmark::State &bench_state) {
+    const SparseBoxWorld start(BoxWorldGameState(make_params(static_cast<int>(bench_state.range(0)))));
+    auto state = start;
+    const auto actions = make_actions(1024);
+    std::size_t i = 0;
+    for (auto _ : bench_state) {
+        state.apply_action(actions[i++ % actions.size()]);
+        if (state.is_solution()) {
+            state = start;
+        }
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_SparseApplyAction)->Arg(10)->Arg(32)->Arg(128);
+
+// Expand every child of a state by copying the state for each productive action
+void BM_ExpandCopy(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    std::vector<Action> actions;
+    for (auto _ : bench_state) {
+        state.productive_actions(actions);
+        for (const auto &action : actions) {
+            auto child = state;
+            child.apply_action(action);
+            benchmark::DoNotOptimize(child.get_hash());
+        }
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ExpandCopy)->Apply(BoardSizes);
+
+void BM_ExpandSuccessors(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    BoxWorldGameState scratch = state;
+    for (auto _ : bench_state) {
+        for (const auto &successor : successors(state, scratch)) {
+            benchmark::DoNotOptimize(successor.hash);
+        }
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ExpandSuccessors)->Apply(BoardSizes);
+
+// Copies from many threads at once, where owning copies contend on the shared refcount
+void BM_StateCopyThreaded(benchmark::State &bench_state) {
+    BoxWorldGameState state(make_params(20));
+    if (bench_state.range(0) != 0) {
+        state.borrow_level();
+    }
+    for (auto _ : bench_state) {
+        BoxWorldGameState state_copy = state;
+        benchmark::DoNotOptimize(state_copy);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_StateCopyThreaded)->Arg(0)->Arg(1)->ThreadRange(1, 8);
+
+void BM_GetObservation(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        auto obs = state.get_observation();
+        benchmark::DoNotOptimize(obs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_GetObservation)->Apply(BoardSizes);
+
+void BM_GetObservationReuse(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    std::vector<float> obs;
+    for (auto _ : bench_state) {
+        state.get_observation(obs);
+        benchmark::DoNotOptimize(obs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_GetObservationReuse)->Apply(BoardSizes);
+
+void BM_GetObservationEnvironment(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    std::vector<float> obs;
+    for (auto _ : bench_state) {
+        state.get_observation_environment(obs);
+        benchmark::DoNotOptimize(obs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_GetObservationEnvironment)->Apply(BoardSizes);
+
+// Batch of 256 16x16 environments stepped with observations, on the given number of threads
+void BM_VecEnvStep(benchmark::State &bench_state) {
+    constexpr std::size_t kNumEnvs = 256;
+    BoxWorldVecEnv vec_env(make_params(16), kNumEnvs);
+    vec_env.set_num_threads(static_cast<std::size_t>(bench_state.range(0)));
+    std::vector<float> obs(kNumEnvs * vec_env.observation_size());
+    const auto action_sequence = make_actions(1024 + kNumEnvs);
+    std::size_t i = 0;
+    for (auto _ : bench_state) {
+        vec_env.step(&action_sequence[i++ % 1024], obs.data());
+        benchmark::DoNotOptimize(obs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * static_cast<int64_t>(kNumEnvs));
+}
+BENCHMARK(BM_VecEnvStep)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// Random playouts with the built in rollout engine
+void BM_Rollout(benchmark::State &bench_state) {
+    const BoxWorldGameState start(make_params(static_cast<int>(bench_state.range(0))));
+    const auto snapshot = start.snapshot();
+    auto state = start;
+    Xoshiro256 rng(0);
+    std::size_t num_actions = 0;
+    for (auto _ : bench_state) {
+        state.restore(snapshot);
+        num_actions += rollout(state, 256, rng).depth;
+    }
+    bench_state.SetItemsProcessed(static_cast<int64_t>(num_actions));
+}
+BENCHMARK(BM_Rollout)->Apply(BoardSizes);
+
+// Random playouts copying the state and sampling actions through the public API
+void BM_RolloutBaseline(benchmark::State &bench_state) {
+    const BoxWorldGameState start(make_params(static_cast<int>(bench_state.range(0))));
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(kNumActions) - 1);
+    std::size_t num_actions = 0;
+    for (auto _ : bench_state) {
+        auto state = start;
+        for (std::size_t depth = 0; depth < 256 && !state.is_solution(); ++depth, ++num_actions) {
+            state.apply_action(static_cast<Action>(dist(gen)));
+        }
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(static_cast<int64_t>(num_actions));
+}
+BENCHMARK(BM_RolloutBaseline)->Apply(BoardSizes);
+
+// Construct a state for a level not yet registered, which sets up the parsed level and hashing tables
+void BM_ConstructLevel(benchmark::State &bench_state) {
+    GeneratorConfig config;
+    config.map_size = static_cast<std::size_t>(bench_state.range(0));
+    const auto levels = LevelGenerator(config).generate(0, 64);
+    auto &registry = LevelRegistry::get_instance();
+    std::size_t i = 0;
+    for (auto _ : bench_state) {
+        const BoxWorldGameState state(levels[i++ % levels.size()], false);
+        benchmark::DoNotOptimize(state.get_hash());
+        bench_state.PauseTiming();
+        registry.erase(state.get_level_id());
+        bench_state.ResumeTiming();
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ConstructLevel)->Apply(BoardSizes);
+
+void BM_MakeStates(benchmark::State &bench_state) {
+    constexpr std::size_t kNumLevels = 1024;
+    std::vector<std::string> board_strs;
+    for (const auto &level : LevelGenerator(GeneratorConfig{}).generate(0, kNumLevels)) {
+        board_strs.push_back(to_board_str(level));
+    }
+    for (auto _ : bench_state) {
+        const auto states =
+            BoxWorldGameState::make_states(board_strs, false, static_cast<std::size_t>(bench_state.range(0)));
+        benchmark::DoNotOptimize(states.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * static_cast<int64_t>(kNumLevels));
+}
+BENCHMARK(BM_MakeStates)->Arg(1)->Arg(0)->UseRealTime();
+
+void BM_ExecutePlans(benchmark::State &bench_state) {
+    constexpr std::size_t kNumLevels = 256;
+    const auto generated = LevelGenerator(GeneratorConfig{}).generate(0, kNumLevels);
+    const auto levels = BoxWorldGameState::make_states(generated.data(), generated.size());
+    std::vector<std::vector<Action>> plans;
+    std::size_t num_actions = 0;
+    for (std::size_t i = 0; i < kNumLevels; ++i) {
+        plans.push_back(make_actions(200));
+        num_actions += plans.back().size();
+    }
+    std::vector<PlanResult> results;
+    for (auto _ : bench_state) {
+        execute_plans(levels, plans, results, static_cast<std::size_t>(bench_state.range(0)));
+        benchmark::DoNotOptimize(results.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * static_cast<int64_t>(num_actions));
+}
+BENCHMARK(BM_ExecutePlans)->Arg(1)->Arg(0)->UseRealTime();
+
+void BM_ReplayRingPush(benchmark::State &bench_state) {
+    static ReplayRing ring({BoxWorldGameState(kDefaultGameParams)}, 1 << 16);
+    const BoxWorldGameState state(kDefaultGameParams);
+    ReplayTransition transition;
+    transition.state = state.packed_key();
+    transition.next_state = transition.state;
+    for (auto _ : bench_state) {
+        ring.push(transition);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ReplayRingPush)->ThreadRange(1, 4);
+
+void BM_ReplayRingSample(benchmark::State &bench_state) {
+    constexpr std::size_t kBatchSize = 256;
+    const BoxWorldGameState state(kDefaultGameParams);
+    ReplayRing ring({state}, 1 << 12);
+    ReplayTransition transition;
+    transition.state = state.packed_key();
+    transition.next_state = transition.state;
+    for (std::size_t i = 0; i < ring.capacity(); ++i) {
+        ring.push(transition);
+    }
+    std::vector<ReplayTransition> transitions(kBatchSize);
+    std::vector<float> obs(kBatchSize * ring.observation_size());
+    uint64_t seed = 0;
+    for (auto _ : bench_state) {
+        ring.sample(kBatchSize, seed++, transitions.data(), obs.data());
+        benchmark::DoNotOptimize(obs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * static_cast<int64_t>(kBatchSize));
+}
+BENCHMARK(BM_ReplayRingSample);
+
+void BM_ToImage(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        auto img = state.to_image();
+        benchmark::DoNotOptimize(img.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ToImage)->Apply(BoardSizes);
+
+void BM_ToIndexedImage(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    std::vector<uint8_t> img(state.indexed_image_shape()[0] * state.indexed_image_shape()[1]);
+    for (auto _ : bench_state) {
+        state.to_indexed_image(img.data());
+        benchmark::DoNotOptimize(img.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_ToIndexedImage)->Apply(BoardSizes);
+
+void BM_PermuteColours(benchmark::State &bench_state) {
+    BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    ColourPermutation permutation{};
+    for (std::size_t colour = 0; colour < permutation.size(); ++colour) {
+        permutation[colour] = static_cast<Element>((colour + 1) % permutation.size());
+    }
+    for (auto _ : bench_state) {
+        state.permute_colours(permutation);
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_PermuteColours)->Apply(BoardSizes);
+
+void BM_FlipVertical(benchmark::State &bench_state) {
+    BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        state.flip_vertical();
+        benchmark::DoNotOptimize(state.get_hash());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_FlipVertical)->Apply(BoardSizes);
+
+void BM_RenderBatch(benchmark::State &bench_state) {
+    constexpr std::size_t kNumEnvs = 64;
+    BoxWorldVecEnv vec_env(make_params(static_cast<int>(bench_state.range(0))), kNumEnvs);
+    vec_env.set_num_threads(0);
+    const auto shape = vec_env.image_shape();
+    std::vector<uint8_t> imgs(kNumEnvs * shape[0] * shape[1] * shape[2]);
+    for (auto _ : bench_state) {
+        vec_env.render(imgs.data());
+        benchmark::DoNotOptimize(imgs.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * static_cast<int64_t>(kNumEnvs));
+}
+BENCHMARK(BM_RenderBatch)->Apply(BoardSizes);
+
+void BM_Serialize(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    for (auto _ : bench_state) {
+        auto bytes = state.serialize();
+        benchmark::DoNotOptimize(bytes.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_Serialize)->Apply(BoardSizes);
+
+void BM_Deserialize(benchmark::State &bench_state) {
+    const BoxWorldGameState state(make_params(static_cast<int>(bench_state.range(0))));
+    const auto bytes = state.serialize();
+    for (auto _ : bench_state) {
+        BoxWorldGameState state_copy(bytes);
+        benchmark::DoNotOptimize(state_copy);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations());
+}
+BENCHMARK(BM_Deserialize)->Apply(BoardSizes);
+
+}    // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,151 @@
+#include "gpu_vec_env.h"
+
+#include <cuda_runtime.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace boxworld {
+
+namespace {
+constexpr unsigned int kBlockSize = 256;
+
+void check_cuda(cudaError_t error, const char *what) {
+    if (error != cudaSuccess) {
+        throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(error));
+    }
+}
+
+template <typename T>
+auto device_alloc(std::size_t count) -> T * {
+    void *ptr = nullptr;
+    check_cuda(cudaMalloc(&ptr, count * sizeof(T)), "cudaMalloc");
+    return static_cast<T *>(ptr);
+}
+
+template <typename T>
+auto device_upload(const std::vector<T> &values) -> T * {
+    auto *ptr = device_alloc<T>(values.size());
+    check_cuda(cudaMemcpy(ptr, values.data(), values.size() * sizeof(T), cudaMemcpyHostToDevice), "cudaMemcpy");
+    return ptr;
+}
+
+auto num_blocks(std::size_t count) -> unsigned int {
+    return static_cast<unsigned int>((count + kBlockSize - 1) / kBlockSize);
+}
+
+__global__ void reset_kernel(FlatLevelsView levels, FlatEnvsView envs) {
+    const auto env = blockIdx.x * blockDim.x + threadIdx.x;
+    if (env < envs.num_envs) {
+        envs.episodes[env] = 0;
+        flat_reset(levels, envs, env);
+    }
+}
+
+__global__ void step_kernel(FlatLevelsView levels, FlatEnvsView envs, const uint8_t *actions,
+                            uint64_t *reward_signals, uint8_t *dones, bool use_colour) {
+    const auto env = blockIdx.x * blockDim.x + threadIdx.x;
+    if (env >= envs.num_envs) {
+        return;
+    }
+    uint64_t reward_signal = 0;
+    uint8_t done = 0;
+    flat_step(levels, envs, env, actions[env], use_colour, reward_signal, done);
+    if (reward_signals != nullptr) {
+        reward_signals[env] = reward_signal;
+    }
+    if (dones != nullptr) {
+        dones[env] = done;
+    }
+}
+
+// One thread per cell of every environment, so consecutive threads write consecutive values of each plane
+__global__ void observation_kernel(FlatLevelsView levels, FlatEnvsView envs, float *obs) {
+    const auto cells = levels.rows * levels.cols;
+    const auto index = static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (index >= static_cast<std::size_t>(envs.num_envs) * cells) {
+        return;
+    }
+    const auto env = static_cast<uint32_t>(index / cells);
+    const auto cell = static_cast<uint32_t>(index % cells);
+    flat_write_observation_cell(levels, envs, env, cell, obs + static_cast<std::size_t>(env) * kNumChannels * cells);
+}
+}    // namespace
+
+GpuVecEnv::GpuVecEnv(const LevelPack &pack, std::size_t num_envs, bool collect_first_key) {
+    if (num_envs == 0) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    const auto flat = make_flat_levels(pack, collect_first_key);
+    const std::size_t cells = static_cast<std::size_t>(flat.rows) * flat.cols;
+    levels.boards = device_upload(flat.boards);
+    levels.kinds = device_upload(flat.kinds);
+    levels.agent_indices = device_upload(flat.agent_indices);
+    levels.inventories = device_upload(flat.inventories);
+    levels.rows = flat.rows;
+    levels.cols = flat.cols;
+    levels.num_levels = flat.num_levels;
+    envs.boards = device_alloc<uint8_t>(num_envs * cells);
+    envs.agent_indices = device_alloc<uint32_t>(num_envs);
+    envs.inventories = device_alloc<uint8_t>(num_envs);
+    envs.levels = device_alloc<uint32_t>(num_envs);
+    envs.episodes = device_alloc<uint32_t>(num_envs);
+    envs.num_envs = static_cast<uint32_t>(num_envs);
+    reset();
+}
+
+GpuVecEnv::~GpuVecEnv() {
+    cudaFree(const_cast<uint8_t *>(levels.boards));
+    cudaFree(const_cast<uint8_t *>(levels.kinds));
+    cudaFree(const_cast<uint32_t *>(levels.agent_indices));
+    cudaFree(const_cast<uint8_t *>(levels.inventories));
+    cudaFree(envs.boards);
+    cudaFree(envs.agent_indices);
+    cudaFree(envs.inventories);
+    cudaFree(envs.levels);
+    cudaFree(envs.episodes);
+}
+
+auto GpuVecEnv::num_envs() const noexcept -> std::size_t {
+    return envs.num_envs;
+}
+
+auto GpuVecEnv::observation_size() const noexcept -> std::size_t {
+    return kNumChannels * levels.rows * levels.cols;
+}
+
+void GpuVecEnv::reset(float *obs) {
+    reset_kernel<<<num_blocks(envs.num_envs), kBlockSize>>>(levels, envs);
+    check_cuda(cudaGetLastError(), "reset kernel");
+    if (obs != nullptr) {
+        WriteObservations(obs);
+    }
+    synchronize();
+}
+
+void GpuVecEnv::step(const uint8_t *actions, float *obs, uint64_t *reward_signals, uint8_t *dones,
+                     bool use_colour) {
+    step_kernel<<<num_blocks(envs.num_envs), kBlockSize>>>(levels, envs, actions, reward_signals, dones,
+                                                           use_colour);
+    check_cuda(cudaGetLastError(), "step kernel");
+    if (obs != nullptr) {
+        WriteObservations(obs);
+    }
+}
+
+void GpuVecEnv::synchronize() const {
+    check_cuda(cudaDeviceSynchronize(), "cudaDeviceSynchronize");
+}
+
+auto GpuVecEnv::get_envs() const noexcept -> const FlatEnvsView & {
+    return envs;
+}
+
+void GpuVecEnv::WriteObservations(float *obs) const {
+    const auto count = static_cast<std::size_t>(envs.num_envs) * levels.rows * levels.cols;
+    observation_kernel<<<num_blocks(count), kBlockSize>>>(levels, envs, obs);
+    check_cuda(cudaGetLastError(), "observation kernel");
+}
+
+}    // namespace boxworld
@@ -0,0 +1,88 @@
+#ifndef BOXWORLD_GPU_VEC_ENV_H_
+#define BOXWORLD_GPU_VEC_ENV_H_
+
+#include <cstdint>
+
+#include "../src/device_rules.h"
+#include "../src/level_pack.h"
+
+namespace boxworld {
+
+// Batch of environments whose boards live on a CUDA device as uint8 cells, stepped by one kernel per call.
+// Rules are those of device_rules.h, shared with the host, so every step matches BoxWorldGameState::apply_action().
+// Solved environments reset to the next level of the uploaded pack for them, see flat_level_index().
+// Buffers passed to reset() and step() are device pointers, so observations never leave the device.
+// @note Dead end termination and the hash are not maintained on the device
+class GpuVecEnv {
+public:
+    GpuVecEnv() = delete;
+
+    /**
+     * Upload the levels of the pack, and allocate the device state of each environment.
+     * @note Throws std::invalid_argument if num_envs is 0 or the pack is empty, std::runtime_error on CUDA errors
+     * @param pack The levels to play, all of the same board size
+     * @param num_envs Number of environments in the batch
+     * @param collect_first_key Flag to start with the single key in the inventory
+     */
+    GpuVecEnv(const LevelPack &pack, std::size_t num_envs, bool collect_first_key = false);
+    ~GpuVecEnv();
+
+    GpuVecEnv(const GpuVecEnv &) = delete;
+    GpuVecEnv(GpuVecEnv &&) = delete;
+    auto operator=(const GpuVecEnv &) -> GpuVecEnv & = delete;
+    auto operator=(GpuVecEnv &&) -> GpuVecEnv & = delete;
+
+    /**
+     * Get the number of environments in the batch
+     * @return Count of environments
+     */
+    [[nodiscard]] auto num_envs() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of values in a single environment observation, laid out as BoxWorldGameState::get_observation()
+     * @return Flat observation size for one environment
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Reset every environment to the first level of its cycle, and write the starting observations.
+     * @note Throws std::runtime_error on CUDA errors
+     * @param obs Device buffer of num_envs() * observation_size() values, or nullptr to skip
+     */
+    void reset(float *obs = nullptr);
+
+    /**
+     * Apply one action to each environment, and write the results into the given device buffers.
+     * Environments which reach the solution are reset, and the observation written is that of the reset state.
+     * @note Runs asynchronously on the stream, throws std::runtime_error on CUDA launch errors
+     * @param actions Device buffer of num_envs() actions, one per environment
+     * @param obs Device buffer of num_envs() * observation_size() values, or nullptr to skip
+     * @param reward_signals Device buffer of num_envs() reward signals, or nullptr to skip
+     * @param dones Device buffer of num_envs() flags set to kDoneSolved if solved (and reset), or nullptr to skip
+     * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+     */
+    void step(const uint8_t *actions, float *obs = nullptr, uint64_t *reward_signals = nullptr,
+              uint8_t *dones = nullptr, bool use_colour = false);
+
+    /**
+     * Wait for every launched kernel to finish.
+     * @note Throws std::runtime_error on CUDA errors
+     */
+    void synchronize() const;
+
+    /**
+     * Get the device state of the environments, such as to copy the boards back for checking.
+     * @return View of the device arrays
+     */
+    [[nodiscard]] auto get_envs() const noexcept -> const FlatEnvsView &;
+
+private:
+    void WriteObservations(float *obs) const;
+
+    FlatLevelsView levels{};    // Uploaded levels, owned by the env
+    FlatEnvsView envs{};        // Device state of the environments, owned by the env
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_GPU_VEC_ENV_H_
@@ -1,6 +1,36 @@
 #ifndef BOXWORLD_H_
 #define BOXWORLD_H_
 
+#include "../../src/async_vec_env.h"
+#include "../../src/bitboard.h"
 #include "../../src/boxworld_base.h"
+#include "../../src/device_rules.h"
+#include "../../src/distributed_search.h"
+#include "../../src/fixed_boxworld.h"
+#include "../../src/incremental_observation.h"
+#include "../../src/key_lock_graph.h"
+#include "../../src/level.h"
+#include "../../src/level_generator.h"
+#include "../../src/level_index.h"
+#include "../../src/level_pack.h"
+#include "../../src/level_registry.h"
+#include "../../src/level_sampler.h"
+#include "../../src/mapped_search.h"
+#include "../../src/remote_env.h"
+#include "../../src/render.h"
+#include "../../src/replay_ring.h"
+#include "../../src/rollout.h"
+#include "../../src/search.h"
+#include "../../src/shm_vec_env.h"
+#include "../../src/solver.h"
+#include "../../src/sparse_boxworld.h"
+#include "../../src/state_pool.h"
+#include "../../src/state_tree.h"
+#include "../../src/stats.h"
+#include "../../src/successors.h"
+#include "../../src/trajectory.h"
+#include "../../src/transposition_table.h"
+#include "../../src/vec_env.h"
+#include "../../src/zobrist.h"
 
 #endif    // BOXWORLD_H_
@@ -0,0 +1,334 @@
+// Python bindings of BoxWorldGameState and the vectorized environments.
+// Observations, images, and step results are returned as NumPy arrays viewing buffers owned by the C++ objects,
+// which stay valid until the next call writing the same buffer. Copy an array to keep it past that call.
+
+#include <boxworld/boxworld.h>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <array>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+using namespace boxworld;
+
+namespace {
+
+using ActionArray = py::array_t<int32_t, py::array::c_style | py::array::forcecast>;
+using ObsArray = py::array_t<float, py::array::c_style>;
+static_assert(sizeof(Action) == sizeof(int32_t), "Actions are read in place from int32 arrays.");
+
+auto make_params(const std::string &board_str, bool collect_first_key) -> GameParameters {
+    GameParameters params = kDefaultGameParams;
+    if (!board_str.empty()) {
+        params["game_board_str"] = GameParameter(board_str);
+    }
+    params["collect_first_key"] = GameParameter(collect_first_key);
+    return params;
+}
+
+// Array viewing the buffer of owner, which is kept alive for as long as the array
+template <typename T>
+auto make_view(const T *data, std::vector<py::ssize_t> shape, py::handle owner) -> py::array_t<T> {
+    return py::array_t<T>(std::move(shape), data, owner);
+}
+
+template <std::size_t N>
+auto to_shape(std::size_t leading, const std::array<std::size_t, N> &shape) -> std::vector<py::ssize_t> {
+    std::vector<py::ssize_t> result{static_cast<py::ssize_t>(leading)};
+    for (const auto &dim : shape) {
+        result.push_back(static_cast<py::ssize_t>(dim));
+    }
+    return result;
+}
+
+template <std::size_t N>
+auto to_shape(const std::array<std::size_t, N> &shape) -> std::vector<py::ssize_t> {
+    return std::vector<py::ssize_t>(shape.begin(), shape.end());
+}
+
+auto get_actions(const ActionArray &actions, std::size_t num_envs) -> const Action * {
+    if (actions.ndim() != 1 || static_cast<std::size_t>(actions.shape(0)) != num_envs) {
+        throw py::value_error("Expected one action per environment.");
+    }
+    const auto *data = actions.data();
+    for (std::size_t i = 0; i < num_envs; ++i) {
+        if (data[i] < 0 || data[i] >= static_cast<int32_t>(kNumActions)) {
+            throw py::value_error("Unknown action.");
+        }
+    }
+    return reinterpret_cast<const Action *>(data);
+}
+
+// Game state with the buffers its observation and image views point into
+class PyGameState {
+public:
+    explicit PyGameState(BoxWorldGameState state) : state(std::move(state)) {}
+
+    [[nodiscard]] auto get() noexcept -> BoxWorldGameState & {
+        return state;
+    }
+    [[nodiscard]] auto get() const noexcept -> const BoxWorldGameState & {
+        return state;
+    }
+
+    auto observation(py::handle self) -> ObsArray {
+        const auto shape = state.observation_shape();
+        obs.resize(shape[0] * shape[1] * shape[2]);
+        state.get_observation(obs.data());
+        return make_view(obs.data(), to_shape(shape), self);
+    }
+
+    auto image(py::handle self) -> py::array_t<uint8_t> {
+        const auto shape = state.image_shape();
+        img.resize(shape[0] * shape[1] * shape[2]);
+        state.to_image(img.data());
+        return make_view(img.data(), to_shape(shape), self);
+    }
+
+private:
+    BoxWorldGameState state;
+    std::vector<float> obs;
+    std::vector<uint8_t> img;
+};
+
+// Vectorized environments with the buffers their step result views point into
+class PyVecEnv {
+public:
+    explicit PyVecEnv(BoxWorldVecEnv env)
+        : env(std::move(env)),
+          obs(this->env.num_envs() * this->env.observation_size()),
+          reward_signals(this->env.num_envs()),
+          dones(this->env.num_envs()) {}
+
+    auto reset(py::handle self) -> ObsArray {
+        {
+            const py::gil_scoped_release release;
+            env.reset(obs.data());
+        }
+        return ObsView(self);
+    }
+
+    auto step(py::handle self, const ActionArray &actions, bool use_colour) -> py::tuple {
+        const auto *action_data = get_actions(actions, env.num_envs());
+        {
+            const py::gil_scoped_release release;
+            env.step(action_data, obs.data(), reward_signals.data(), dones.data(), use_colour);
+        }
+        const auto num_envs = static_cast<py::ssize_t>(env.num_envs());
+        return py::make_tuple(ObsView(self), make_view(reward_signals.data(), {num_envs}, self),
+                              make_view(dones.data(), {num_envs}, self));
+    }
+
+    auto action_masks() const -> py::array_t<uint8_t> {
+        py::array_t<uint8_t> masks(static_cast<py::ssize_t>(env.num_envs()));
+        env.get_action_masks(masks.mutable_data());
+        return masks;
+    }
+
+    [[nodiscard]] auto get() noexcept -> BoxWorldVecEnv & {
+        return env;
+    }
+
+private:
+    [[nodiscard]] auto ObsView(py::handle self) const -> ObsArray {
+        return make_view(obs.data(), to_shape(env.num_envs(), env.observation_shape()), self);
+    }
+
+    BoxWorldVecEnv env;
+    std::vector<float> obs;
+    std::vector<uint64_t> reward_signals;
+    std::vector<uint8_t> dones;
+};
+
+auto as_tuple(const AsyncVecEnv &env, const AsyncVecEnv::StepResult &result, py::handle self) -> py::tuple {
+    const auto num_envs = static_cast<py::ssize_t>(env.num_envs());
+    const auto shape = to_shape(env.num_envs(), env.get_vec_env().observation_shape());
+    return py::make_tuple(make_view(result.obs, shape, self), make_view(result.reward_signals, {num_envs}, self),
+                          make_view(result.dones, {num_envs}, self));
+}
+
+}    // namespace
+
+PYBIND11_MODULE(pyboxworld, m) {
+    m.doc() = "Box-World environment";
+    m.attr("NUM_ACTIONS") = kNumActions;
+    m.attr("NUM_CHANNELS") = kNumChannels;
+
+    py::enum_<Action>(m, "Action")
+        .value("UP", Action::kUp)
+        .value("RIGHT", Action::kRight)
+        .value("DOWN", Action::kDown)
+        .value("LEFT", Action::kLeft);
+
+    py::class_<PyGameState>(m, "BoxWorldGameState")
+        .def(py::init([](const std::string &board_str, bool collect_first_key) {
+                 return PyGameState(BoxWorldGameState(make_params(board_str, collect_first_key)));
+             }),
+             py::arg("board_str") = "", py::arg("collect_first_key") = false)
+        .def("__copy__", [](const PyGameState &self) { return PyGameState(self.get()); })
+        .def("__deepcopy__", [](const PyGameState &self, const py::dict &) { return PyGameState(self.get()); })
+        .def("__eq__", [](const PyGameState &self, const PyGameState &other) { return self.get() == other.get(); })
+        .def("__hash__", [](const PyGameState &self) { return self.get().get_hash(); })
+        .def("__str__",
+             [](const PyGameState &self) {
+                 std::ostringstream os;
+                 os << self.get();
+                 return os.str();
+             })
+        .def("reset", [](PyGameState &self) { self.get().reset(); })
+        .def("reset_procedural", [](PyGameState &self, uint64_t seed) { self.get().reset(seed, GeneratorConfig{}); })
+        .def("apply_action",
+             [](PyGameState &self, int action) {
+                 if (action < 0 || action >= static_cast<int>(kNumActions)) {
+                     throw py::value_error("Unknown action.");
+                 }
+                 self.get().apply_action(static_cast<Action>(action));
+             })
+        .def("is_solution", [](const PyGameState &self) { return self.get().is_solution(); })
+        .def("is_dead_end", [](const PyGameState &self) { return self.get().is_dead_end(); })
+        .def("get_remaining_chain_length",
+             [](const PyGameState &self) { return self.get().get_remaining_chain_length(); })
+        .def("legal_actions", [](const PyGameState &self) { return self.get().legal_actions(); })
+        .def("productive_actions", [](const PyGameState &self) { return self.get().productive_actions(); })
+        .def(
+            "get_reward_signal",
+            [](const PyGameState &self, bool use_colour) { return self.get().get_reward_signal(use_colour); },
+            py::arg("use_colour") = false)
+        .def("get_hash", [](const PyGameState &self) { return self.get().get_hash(); })
+#ifdef BOXWORLD_HASH128
+        .def("get_hash128",
+             [](const PyGameState &self) {
+                 const auto hash = self.get().get_hash128();
+                 return py::make_tuple(hash.low, hash.high);
+             })
+#endif
+        .def("get_agent_index", [](const PyGameState &self) { return self.get().get_agent_index(); })
+        .def("get_inventory", [](const PyGameState &self) { return static_cast<int>(self.get().get_inventory()); })
+        .def("observation_shape", [](const PyGameState &self) { return self.get().observation_shape(); })
+        .def("image_shape", [](const PyGameState &self) { return self.get().image_shape(); })
+        .def(
+            "get_observation", [](py::object self) { return self.cast<PyGameState &>().observation(self); },
+            "Observation viewing a buffer of the state, overwritten by the next call")
+        .def(
+            "to_image", [](py::object self) { return self.cast<PyGameState &>().image(self); },
+            "RGB image viewing a buffer of the state, overwritten by the next call")
+        .def("serialize",
+             [](const PyGameState &self) {
+                 const auto bytes = self.get().serialize();
+                 return py::bytes(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+             })
+        .def_static("deserialize", [](const py::bytes &data) {
+            const auto view = std::string(data);
+            return PyGameState(BoxWorldGameState(std::vector<uint8_t>(view.begin(), view.end())));
+        });
+
+    py::class_<PyVecEnv>(m, "BoxWorldVecEnv")
+        .def(py::init([](const std::string &board_str, std::size_t num_envs, std::size_t num_threads,
+                         bool collect_first_key, bool terminate_dead_ends) {
+                 BoxWorldVecEnv env(make_params(board_str, collect_first_key), num_envs);
+                 env.set_num_threads(num_threads);
+                 env.set_terminate_dead_ends(terminate_dead_ends);
+                 return std::make_unique<PyVecEnv>(std::move(env));
+             }),
+             py::arg("board_str") = "", py::arg("num_envs") = 1, py::arg("num_threads") = 1,
+             py::arg("collect_first_key") = false, py::arg("terminate_dead_ends") = false)
+        .def_property_readonly("num_envs", [](PyVecEnv &self) { return self.get().num_envs(); })
+        .def_property_readonly("observation_shape", [](PyVecEnv &self) { return self.get().observation_shape(); })
+        .def(
+            "reset", [](py::object self) { return self.cast<PyVecEnv &>().reset(self); },
+            "Observations viewing a buffer of the env, overwritten by the next reset or step")
+        .def(
+            "step",
+            [](py::object self, const ActionArray &actions, bool use_colour) {
+                return self.cast<PyVecEnv &>().step(self, actions, use_colour);
+            },
+            py::arg("actions"), py::arg("use_colour") = false,
+            "Tuple of (observations, reward signals, dones) viewing buffers of the env, overwritten by the next reset "
+            "or step. Dones are 1 if solved, or 2 if ended at a dead end")
+        .def("action_masks", &PyVecEnv::action_masks);
+
+    py::class_<AsyncVecEnv>(m, "AsyncVecEnv")
+        .def(py::init([](const std::string &board_str, std::size_t num_envs, std::size_t num_threads,
+                         bool collect_first_key, bool use_colour, bool terminate_dead_ends) {
+                 BoxWorldVecEnv env(make_params(board_str, collect_first_key), num_envs);
+                 env.set_num_threads(num_threads);
+                 env.set_terminate_dead_ends(terminate_dead_ends);
+                 return std::make_unique<AsyncVecEnv>(std::move(env), use_colour);
+             }),
+             py::arg("board_str") = "", py::arg("num_envs") = 1, py::arg("num_threads") = 1,
+             py::arg("collect_first_key") = false, py::arg("use_colour") = false,
+             py::arg("terminate_dead_ends") = false)
+        .def_property_readonly("num_envs", &AsyncVecEnv::num_envs)
+        .def(
+            "reset",
+            [](py::object self) {
+                auto &env = self.cast<AsyncVecEnv &>();
+                AsyncVecEnv::StepResult result{};
+                {
+                    const py::gil_scoped_release release;
+                    result = env.reset();
+                }
+                return as_tuple(env, result, self);
+            },
+            "Tuple of (observations, reward signals, dones), valid until the second step_async() after it")
+        .def(
+            "step_async",
+            [](AsyncVecEnv &self, const ActionArray &actions) {
+                self.step_async(get_actions(actions, self.num_envs()));
+            },
+            py::arg("actions"))
+        .def(
+            "step_wait",
+            [](py::object self) {
+                auto &env = self.cast<AsyncVecEnv &>();
+                AsyncVecEnv::StepResult result{};
+                {
+                    const py::gil_scoped_release release;
+                    result = env.step_wait();
+                }
+                return as_tuple(env, result, self);
+            },
+            "Tuple of (observations, reward signals, dones), valid until the second step_async() after it");
+
+    m.def(
+        "execute_plans",
+        [](const py::list &states, const std::vector<ActionArray> &plans, std::size_t num_threads) {
+            if (states.size() != plans.size()) {
+                throw py::value_error("Expected one state per plan.");
+            }
+            std::vector<BoxWorldGameState> levels;
+            std::vector<std::vector<Action>> plan_actions;
+            levels.reserve(plans.size());
+            plan_actions.reserve(plans.size());
+            for (std::size_t i = 0; i < plans.size(); ++i) {
+                levels.push_back(states[i].cast<const PyGameState &>().get());
+                if (plans[i].ndim() != 1) {
+                    throw py::value_error("Expected a 1D array of actions per plan.");
+                }
+                const auto num_actions = static_cast<std::size_t>(plans[i].shape(0));
+                const auto *actions = get_actions(plans[i], num_actions);
+                plan_actions.emplace_back(actions, actions + num_actions);
+            }
+            std::vector<PlanResult> results;
+            {
+                const py::gil_scoped_release release;
+                execute_plans(levels, plan_actions, results, num_threads);
+            }
+            py::list out;
+            for (const auto &result : results) {
+                py::list events;
+                for (const auto &event : result.reward_events) {
+                    events.append(py::make_tuple(event.step, event.signal_index, event.signal_colour));
+                }
+                out.append(py::make_tuple(result.final_hash, result.solved, result.num_steps, events));
+            }
+            return out;
+        },
+        py::arg("states"), py::arg("plans"), py::arg("num_threads") = 0,
+        "Apply each int32 array of actions to its state, returning a (final hash, solved, steps, reward events) "
+        "tuple per plan, with each reward event a (step, signal index, signal colour) tuple");
+}
@@ -0,0 +1,111 @@
+#include "async_vec_env.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace boxworld {
+
+namespace {
+// Wait for the condition by spinning, then yielding, then sleeping, so short waits have low latency and long waits
+// (such as the stepping thread between steps) do not hold a core
+template <typename Condition>
+void wait_until(Condition&& condition) noexcept {
+    constexpr int kNumSpins = 64;
+    constexpr int kNumYields = 1024;
+    constexpr auto kSleep = std::chrono::microseconds(50);
+    for (int i = 0; !condition(); ++i) {
+        if (i < kNumSpins) {
+            continue;
+        }
+        if (i < kNumSpins + kNumYields) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(kSleep);
+        }
+    }
+}
+}    // namespace
+
+AsyncVecEnv::AsyncVecEnv(BoxWorldVecEnv vec_env, bool use_colour)
+    : vec_env(std::move(vec_env)), use_colour(use_colour), actions(this->vec_env.num_envs()) {
+    const auto num_envs = this->vec_env.num_envs();
+    for (auto& buffer : buffers) {
+        buffer.obs.resize(num_envs * this->vec_env.observation_size());
+        buffer.reward_signals.resize(num_envs);
+        buffer.dones.resize(num_envs);
+    }
+    step_thread = std::thread(&AsyncVecEnv::StepLoop, this);
+}
+
+AsyncVecEnv::~AsyncVecEnv() {
+    stop.store(true, std::memory_order_release);
+    step_thread.join();
+}
+
+auto AsyncVecEnv::reset() -> StepResult {
+    wait_until([this]() { return completed.load(std::memory_order_acquire) == num_steps; });
+    is_pending = false;
+    // The reset replaces the results of the last step, leaving the other buffer for the next step to write
+    const auto buffer_index = num_steps % 2;
+    auto& buffer = buffers[buffer_index];
+    vec_env.reset(buffer.obs.data());
+    std::fill(buffer.reward_signals.begin(), buffer.reward_signals.end(), 0);
+    std::fill(buffer.dones.begin(), buffer.dones.end(), 0);
+    return GetResult(buffer_index);
+}
+
+void AsyncVecEnv::step_async(const Action* step_actions) {
+    if (is_pending) {
+        throw std::invalid_argument("step_wait() must be called before the next step_async().");
+    }
+    std::copy_n(step_actions, actions.size(), actions.begin());
+    ++num_steps;
+    is_pending = true;
+    requested.store(num_steps, std::memory_order_release);
+}
+
+auto AsyncVecEnv::step_wait() -> StepResult {
+    if (!is_pending) {
+        throw std::invalid_argument("step_async() must be called before step_wait().");
+    }
+    wait_until([this]() { return completed.load(std::memory_order_acquire) == num_steps; });
+    is_pending = false;
+    return GetResult(num_steps % 2);
+}
+
+auto AsyncVecEnv::num_envs() const noexcept -> std::size_t {
+    return vec_env.num_envs();
+}
+
+auto AsyncVecEnv::observation_size() const noexcept -> std::size_t {
+    return vec_env.observation_size();
+}
+
+auto AsyncVecEnv::get_vec_env() const noexcept -> const BoxWorldVecEnv& {
+    return vec_env;
+}
+
+void AsyncVecEnv::StepLoop() noexcept {
+    std::size_t step = 0;
+    while (true) {
+        wait_until([&]() {
+            return requested.load(std::memory_order_acquire) != step || stop.load(std::memory_order_acquire);
+        });
+        if (stop.load(std::memory_order_acquire)) {
+            return;
+        }
+        step = requested.load(std::memory_order_acquire);
+        auto& buffer = buffers[step % 2];
+        vec_env.step(actions.data(), buffer.obs.data(), buffer.reward_signals.data(), buffer.dones.data(),
+                     use_colour);
+        completed.store(step, std::memory_order_release);
+    }
+}
+
+auto AsyncVecEnv::GetResult(std::size_t buffer_index) const noexcept -> StepResult {
+    const auto& buffer = buffers[buffer_index];
+    return {buffer.obs.data(), buffer.reward_signals.data(), buffer.dones.data()};
+}
+
+}    // namespace boxworld
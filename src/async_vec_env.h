@@ -0,0 +1,106 @@
+#ifndef BOXWORLD_ASYNC_VEC_ENV_H_
+#define BOXWORLD_ASYNC_VEC_ENV_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "definitions.h"
+#include "vec_env.h"
+
+namespace boxworld {
+
+// Batch of environments stepped on a background thread, so stepping overlaps with the caller choosing the next
+// actions. Results are written into one of two buffers owned by the env, alternating each step, so the caller can
+// read the results of one step while the next is being written. The handoff between the caller and the stepping
+// thread uses only atomics.
+class AsyncVecEnv {
+public:
+    // View of the results of a step, valid until the second step_async() after it was returned
+    struct StepResult {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        const float *obs;                 // num_envs() * observation_size() observations
+        const uint64_t *reward_signals;   // num_envs() reward signals
+        const uint8_t *dones;             // num_envs() done values, see BoxWorldVecEnv::step()
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    AsyncVecEnv() = delete;
+
+    /**
+     * @param vec_env The environments to step, which may step on their own thread pool
+     * @param use_colour Flag if using colour collected reward signal, or index of key/lock collected if false
+     */
+    explicit AsyncVecEnv(BoxWorldVecEnv vec_env, bool use_colour = false);
+    ~AsyncVecEnv();
+
+    AsyncVecEnv(const AsyncVecEnv &) = delete;
+    AsyncVecEnv(AsyncVecEnv &&) = delete;
+    auto operator=(const AsyncVecEnv &) -> AsyncVecEnv & = delete;
+    auto operator=(AsyncVecEnv &&) -> AsyncVecEnv & = delete;
+
+    /**
+     * Reset every environment, waiting for any step in progress first.
+     * @return The starting observations, with reward signals and dones of 0
+     */
+    auto reset() -> StepResult;
+
+    /**
+     * Start stepping each environment with the given actions, and return without waiting for the step to finish.
+     * @note Throws std::invalid_argument if the previous step has not been waited on
+     * @param actions Buffer of num_envs() actions, copied before returning
+     */
+    void step_async(const Action *actions);
+
+    /**
+     * Wait for the step started by step_async() to finish.
+     * @note Throws std::invalid_argument if no step is in progress
+     * @return The results of the step
+     */
+    auto step_wait() -> StepResult;
+
+    /**
+     * Get the number of environments in the batch
+     * @return Count of environments
+     */
+    [[nodiscard]] auto num_envs() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of values in a single environment observation.
+     * @return Flat observation size for one environment
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the environments, which are only safe to read while no step is in progress
+     * @return Reference to the environments
+     */
+    [[nodiscard]] auto get_vec_env() const noexcept -> const BoxWorldVecEnv &;
+
+private:
+    struct Buffers {
+        std::vector<float> obs;
+        std::vector<uint64_t> reward_signals;
+        std::vector<uint8_t> dones;
+    };
+
+    void StepLoop() noexcept;
+    [[nodiscard]] auto GetResult(std::size_t buffer_index) const noexcept -> StepResult;
+
+    BoxWorldVecEnv vec_env;
+    bool use_colour;
+    std::array<Buffers, 2> buffers;
+    std::vector<Action> actions;
+    std::size_t num_steps = 0;                // Steps started by the caller
+    bool is_pending = false;                  // Flag if the last step started has not been waited on
+    std::atomic<std::size_t> requested{0};    // Steps handed to the stepping thread
+    std::atomic<std::size_t> completed{0};    // Steps finished by the stepping thread
+    std::atomic<bool> stop{false};
+    std::thread step_thread;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_ASYNC_VEC_ENV_H_
@@ -0,0 +1,415 @@
+#include "bitboard.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "one_hot.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kNoIndex = std::numeric_limits<std::size_t>::max();
+
+// Move each bit n cells towards the higher indices, dropping bits shifted past the end.
+// The words are read from a zero padded copy so the shift has no branches on n
+auto shift_forward(const Bitboard& board, std::size_t n) noexcept -> Bitboard {
+    std::array<uint64_t, 2 * std::tuple_size_v<Bitboard>> padded{};
+    std::copy(board.begin(), board.end(), padded.begin() + board.size());
+    const auto words = n / 64;
+    const auto bits = n % 64;
+    Bitboard shifted{};
+    for (std::size_t w = 0; w < shifted.size(); ++w) {
+        const auto src = board.size() + w - words;
+        // Split the carry shift in two so a zero bit shift does not shift by 64
+        shifted[w] = (padded[src] << bits) | ((padded[src - 1] >> 1) >> (63 - bits));
+    }
+    return shifted;
+}
+
+// Move each bit n cells towards the lower indices, dropping bits shifted past the start
+auto shift_back(const Bitboard& board, std::size_t n) noexcept -> Bitboard {
+    std::array<uint64_t, 2 * std::tuple_size_v<Bitboard>> padded{};
+    std::copy(board.begin(), board.end(), padded.begin());
+    const auto words = n / 64;
+    const auto bits = n % 64;
+    Bitboard shifted{};
+    for (std::size_t w = 0; w < shifted.size(); ++w) {
+        const auto src = w + words;
+        shifted[w] = (padded[src] >> bits) | ((padded[src + 1] << 1) << (63 - bits));
+    }
+    return shifted;
+}
+
+auto and_not(const Bitboard& lhs, const Bitboard& rhs) noexcept -> Bitboard {
+    Bitboard result{};
+    for (std::size_t w = 0; w < result.size(); ++w) {
+        result[w] = lhs[w] & ~rhs[w];
+    }
+    return result;
+}
+
+// Kogge-Stone fill of the region along one direction, through the cells of propagate.
+// Step is the shift of a single move, and limit bounds the length of a run, so doubling stops once it is covered
+template <bool Forward>
+void occluded_fill(Bitboard& region, Bitboard propagate, std::size_t step, std::size_t limit) noexcept {
+    for (auto distance = step; distance < limit; distance *= 2) {
+        const auto next = Forward ? shift_forward(region, distance) : shift_back(region, distance);
+        const auto mask = Forward ? shift_forward(propagate, distance) : shift_back(propagate, distance);
+        for (std::size_t w = 0; w < region.size(); ++w) {
+            region[w] |= propagate[w] & next[w];
+            propagate[w] &= mask[w];
+        }
+    }
+}
+
+// Boards of at most 16x16 are filled with one 16 bit lane per row of a vector, so moves along a row are lane shifts
+// and moves along a column are lane offsets, both by constants
+constexpr std::size_t kLaneWidth = 16;
+#if defined(__GNUC__) && !defined(__clang__)
+// The lane helpers are internal, so the vector argument ABI without AVX does not matter
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+using LaneBoard = uint16_t __attribute__((vector_size(kLaneWidth * sizeof(uint16_t))));
+
+auto to_lanes(const Bitboard& board, std::size_t rows, std::size_t cols) noexcept -> LaneBoard {
+    LaneBoard lanes{};
+    const auto lane_mask = (uint64_t{1} << cols) - 1;
+    for (std::size_t r = 0; r < rows; ++r) {
+        const auto start = r * cols;
+        const auto w = start / 64;
+        const auto b = start % 64;
+        auto bits = board[w] >> b;
+        if (b + cols > 64) {
+            bits |= board[w + 1] << (64 - b);
+        }
+        lanes[r] = static_cast<uint16_t>(bits & lane_mask);
+    }
+    return lanes;
+}
+
+auto from_lanes(const LaneBoard& lanes, std::size_t rows, std::size_t cols) noexcept -> Bitboard {
+    Bitboard board{};
+    for (std::size_t r = 0; r < rows; ++r) {
+        const auto start = r * cols;
+        const auto w = start / 64;
+        const auto b = start % 64;
+        board[w] |= uint64_t{lanes[r]} << b;
+        if (b + cols > 64) {
+            board[w + 1] |= uint64_t{lanes[r]} >> (64 - b);
+        }
+    }
+    return board;
+}
+
+// Move each row the given number of lanes forwards (positive) or backwards, filling with empty rows
+template <int Offset, std::size_t... Lane>
+auto offset_lanes(const LaneBoard& lanes, std::index_sequence<Lane...>) noexcept -> LaneBoard {
+    constexpr int kWidth = static_cast<int>(kLaneWidth);
+    // Indices of kWidth and above read the empty board
+    return __builtin_shufflevector(lanes, LaneBoard{},
+                                   (static_cast<int>(Lane) - Offset >= 0 && static_cast<int>(Lane) - Offset < kWidth
+                                        ? static_cast<int>(Lane) - Offset
+                                        : kWidth)...);
+}
+
+template <int Offset>
+auto offset_lanes(const LaneBoard& lanes) noexcept -> LaneBoard {
+    return offset_lanes<Offset>(lanes, std::make_index_sequence<kLaneWidth>{});
+}
+
+auto lanes_equal(const LaneBoard& lhs, const LaneBoard& rhs) noexcept -> bool {
+    return std::memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+}
+
+// Kogge-Stone fill through the cells of passable, first along the rows and then along the columns.
+// The propagation masks of each doubling step only depend on passable, so are found once per fill.
+// Lanes past the last row and bits past the last column are never passable, so need no masking.
+class LaneFill {
+public:
+    explicit LaneFill(const LaneBoard& passable) noexcept {
+        LaneBoard east_propagate = passable;
+        LaneBoard west_propagate = passable;
+        LaneBoard down_propagate = passable;
+        LaneBoard up_propagate = passable;
+        ForEachStep([&](std::size_t step, auto distance) {
+            constexpr int kDistance = decltype(distance)::value;
+            east[step] = east_propagate;
+            west[step] = west_propagate;
+            down[step] = down_propagate;
+            up[step] = up_propagate;
+            east_propagate &= east_propagate << kDistance;
+            west_propagate &= west_propagate >> kDistance;
+            down_propagate &= offset_lanes<kDistance>(down_propagate);
+            up_propagate &= offset_lanes<-kDistance>(up_propagate);
+        });
+    }
+
+    /**
+     * Extend the region along its rows and then its columns.
+     * @param region The region to extend
+     * @return True if the region is closed, so can not be extended further
+     */
+    auto operator()(LaneBoard& region) const noexcept -> bool {
+        auto east_fill = region;
+        auto west_fill = region;
+        ForEachStep([&](std::size_t step, auto distance) {
+            constexpr int kDistance = decltype(distance)::value;
+            east_fill |= east[step] & (east_fill << kDistance);
+            west_fill |= west[step] & (west_fill >> kDistance);
+        });
+        const auto row_fill = east_fill | west_fill;
+        auto down_fill = row_fill;
+        auto up_fill = row_fill;
+        ForEachStep([&](std::size_t step, auto distance) {
+            constexpr int kDistance = decltype(distance)::value;
+            down_fill |= down[step] & offset_lanes<kDistance>(down_fill);
+            up_fill |= up[step] & offset_lanes<-kDistance>(up_fill);
+        });
+        region = down_fill | up_fill;
+        // Closed along the rows by the first fill, so closed if the columns added nothing
+        return lanes_equal(region, row_fill);
+    }
+
+private:
+    static constexpr std::size_t kNumSteps = 4;
+
+    template <typename F>
+    static void ForEachStep(F&& f) noexcept {
+        f(0, std::integral_constant<int, 1>{});
+        f(1, std::integral_constant<int, 2>{});
+        f(2, std::integral_constant<int, 4>{});
+        f(3, std::integral_constant<int, 8>{});
+    }
+
+    std::array<LaneBoard, kNumSteps> east{};
+    std::array<LaneBoard, kNumSteps> west{};
+    std::array<LaneBoard, kNumSteps> down{};
+    std::array<LaneBoard, kNumSteps> up{};
+};
+
+}    // namespace
+
+BitboardBoxWorld::BitboardBoxWorld(const BoxWorldGameState& state) {
+    const auto shape = state.observation_shape();
+    cols = shape[1];
+    rows = shape[2];
+    const auto num_cells = rows * cols;
+    if (num_cells > kMaxCells) {
+        throw std::invalid_argument("Board is too large for a bitboard.");
+    }
+    // The cache keeps tables alive for the lifetime of the process
+    zobrist = get_zobrist_table(rows, cols).get();
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        SetBit(planes[static_cast<std::size_t>(state.get_item(i))], i);
+        if (i % cols == 0) {
+            SetBit(left_edge, i);
+        }
+        if (i % cols == cols - 1) {
+            SetBit(right_edge, i);
+        }
+    }
+    for (const auto& idx : state.get_key_indices()) {
+        SetBit(key_mask, idx);
+    }
+    for (const auto& idx : state.get_lock_indices()) {
+        SetBit(lock_mask, idx);
+    }
+    agent_idx = state.get_agent_index();
+    inventory = state.get_inventory();
+    zorb_hash = state.get_hash();
+    reward_signal_index = state.get_reward_signal(false);
+    reward_signal_colour = state.get_reward_signal(true);
+}
+
+void BitboardBoxWorld::apply_action(Action action) noexcept {
+    reward_signal_colour = 0;
+    reward_signal_index = 0;
+    const auto new_index = Neighbour(agent_idx, action);
+    // Do nothing if move puts agent out of bounds
+    if (new_index == kNoIndex) {
+        return;
+    }
+    // If empty, just move
+    if (TestBit(planes[static_cast<std::size_t>(Element::kEmpty)], new_index)) {
+        MoveAgent(new_index);
+        return;
+    }
+    // Single key not part of a lock/box
+    if (TestBit(key_mask, new_index)) {
+        reachable_valid = false;
+        ClearBit(key_mask, new_index);
+        AddToInventory(new_index);
+        reward_signal_colour = static_cast<std::size_t>(inventory) + 1;
+        MoveAgent(new_index);
+        reward_signal_index = agent_idx + 1;
+        return;
+    }
+    // Lock/box pair and we have the corresponding key
+    if (has_key() && TestBit(lock_mask, new_index) && TestBit(planes[static_cast<std::size_t>(inventory)], new_index)) {
+        reachable_valid = false;
+        ClearBit(lock_mask, new_index);
+        reward_signal_colour = static_cast<std::size_t>(inventory) + 1;
+        zorb_hash ^= zobrist->inventory[static_cast<std::size_t>(inventory)];
+        SetCell(new_index, inventory, Element::kEmpty);
+        inventory = Element::kAgent;
+        AddToInventory(new_index - 1);
+        MoveAgent(new_index);
+        reward_signal_index = agent_idx + 1;
+    }
+}
+
+auto BitboardBoxWorld::get_item(std::size_t index) const noexcept -> Element {
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        if (TestBit(planes[el], index)) {
+            return static_cast<Element>(el);
+        }
+    }
+    return Element::kEmpty;
+}
+
+auto BitboardBoxWorld::get_indices(Element element) const -> std::vector<std::size_t> {
+    std::vector<std::size_t> indices;
+    indices.reserve(count(element));
+    const auto& board = planes[static_cast<std::size_t>(element)];
+    for (std::size_t w = 0; w < board.size(); ++w) {
+        for (auto word = board[w]; word != 0; word &= word - 1) {
+            indices.push_back(w * 64 + static_cast<std::size_t>(__builtin_ctzll(word)));
+        }
+    }
+    return indices;
+}
+
+auto BitboardBoxWorld::count(Element element) const noexcept -> std::size_t {
+    std::size_t total = 0;
+    for (const auto& word : planes[static_cast<std::size_t>(element)]) {
+        total += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return total;
+}
+
+auto BitboardBoxWorld::reachable_mask() const noexcept -> const Bitboard& {
+    if (reachable_valid) {
+        return reachable;
+    }
+    Bitboard passable{};
+    for (std::size_t w = 0; w < passable.size(); ++w) {
+        passable[w] = planes[static_cast<std::size_t>(Element::kEmpty)][w] |
+                      planes[static_cast<std::size_t>(Element::kAgent)][w];
+    }
+    // Extend the region as far as possible in each direction in turn until it stops changing, so each pass follows
+    // a straight run of any length and the number of passes is set by the turns along the paths
+    if (rows <= kLaneWidth && cols <= kLaneWidth) {
+        const LaneFill fill(to_lanes(passable, rows, cols));
+        LaneBoard region{};
+        region[agent_idx / cols] = static_cast<uint16_t>(1U << (agent_idx % cols));
+        bool closed = false;
+        while (!closed) {
+            closed = fill(region);
+        }
+        reachable = from_lanes(region, rows, cols);
+        reachable_valid = true;
+        return reachable;
+    }
+    const auto not_left = and_not(passable, left_edge);
+    const auto not_right = and_not(passable, right_edge);
+    Bitboard region{};
+    SetBit(region, agent_idx);
+    for (;;) {
+        auto grown = region;
+        occluded_fill<true>(grown, not_left, 1, cols);
+        occluded_fill<false>(grown, not_right, 1, cols);
+        occluded_fill<true>(grown, passable, cols, rows * cols);
+        occluded_fill<false>(grown, passable, cols, rows * cols);
+        if (grown == region) {
+            break;
+        }
+        region = grown;
+    }
+    reachable = region;
+    reachable_valid = true;
+    return reachable;
+}
+
+auto BitboardBoxWorld::reachable_targets() const noexcept -> Bitboard {
+    auto targets = Expand(reachable_mask());
+    for (std::size_t w = 0; w < targets.size(); ++w) {
+        targets[w] &= key_mask[w] | lock_mask[w];
+    }
+    return targets;
+}
+
+void BitboardBoxWorld::get_observation(float* obs) const noexcept {
+    const auto channel_length = rows * cols;
+    // Board planes are the element bitboards expanded to one float per bit
+    static_assert(sizeof(planes) == kNumElements * sizeof(Bitboard), "Bitboards should be contiguous.");
+    write_bit_planes(planes[0].data(), std::tuple_size_v<Bitboard>, channel_length, kNumElements - 1, obs);
+    float* inventory_obs = obs + (kNumElements - 1) * channel_length;
+    std::fill_n(inventory_obs, kNumColours * channel_length, static_cast<float>(0));
+    if (has_key()) {
+        std::fill_n(inventory_obs + static_cast<std::size_t>(inventory) * channel_length, channel_length,
+                    static_cast<float>(1));
+    }
+}
+
+auto BitboardBoxWorld::Neighbour(std::size_t index, Action action) const noexcept -> std::size_t {
+    switch (action) {
+        case Action::kUp:
+            return index >= cols ? index - cols : kNoIndex;
+        case Action::kRight:
+            return TestBit(right_edge, index) ? kNoIndex : index + 1;
+        case Action::kDown:
+            return index + cols < rows * cols ? index + cols : kNoIndex;
+        case Action::kLeft:
+            return TestBit(left_edge, index) ? kNoIndex : index - 1;
+        default:
+            return kNoIndex;
+    }
+}
+
+auto BitboardBoxWorld::ColourAt(std::size_t index) const noexcept -> Element {
+    for (std::size_t c = 0; c < kNumColours; ++c) {
+        if (TestBit(planes[c], index)) {
+            return static_cast<Element>(c);
+        }
+    }
+    return Element::kEmpty;
+}
+
+// Cells one step from the region, masking moves which would wrap around a row edge
+auto BitboardBoxWorld::Expand(const Bitboard& region) const noexcept -> Bitboard {
+    const auto right = shift_forward(region, 1);
+    const auto left = shift_back(region, 1);
+    const auto down = shift_forward(region, cols);
+    const auto up = shift_back(region, cols);
+    Bitboard expanded{};
+    for (std::size_t w = 0; w < expanded.size(); ++w) {
+        expanded[w] = (right[w] & ~left_edge[w]) | (left[w] & ~right_edge[w]) | down[w] | up[w];
+    }
+    return expanded;
+}
+
+void BitboardBoxWorld::SetCell(std::size_t index, Element from, Element to) noexcept {
+    const auto num_cells = rows * cols;
+    ClearBit(planes[static_cast<std::size_t>(from)], index);
+    SetBit(planes[static_cast<std::size_t>(to)], index);
+    zorb_hash ^= zobrist->board[static_cast<std::size_t>(from) * num_cells + index] ^
+                 zobrist->board[static_cast<std::size_t>(to) * num_cells + index];
+}
+
+void BitboardBoxWorld::MoveAgent(std::size_t new_index) noexcept {
+    SetCell(agent_idx, Element::kAgent, Element::kEmpty);
+    SetCell(new_index, Element::kEmpty, Element::kAgent);
+    agent_idx = new_index;
+}
+
+void BitboardBoxWorld::AddToInventory(std::size_t index) noexcept {
+    inventory = ColourAt(index);
+    zorb_hash ^= zobrist->inventory[static_cast<std::size_t>(inventory)];
+    SetCell(index, inventory, Element::kEmpty);
+}
+
+}    // namespace boxworld
@@ -0,0 +1,211 @@
+#ifndef BOXWORLD_BITBOARD_H_
+#define BOXWORLD_BITBOARD_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+#include "zobrist.h"
+
+namespace boxworld {
+
+// One bit per cell, cell i at bit i % 64 of word i / 64
+using Bitboard = std::array<uint64_t, 4>;
+
+// Game state for boards of up to 256 cells, with one bitboard per element mirroring BoxWorldGameState's board.
+// Follows the same rules and observation as BoxWorldGameState, and hashes with the same Zobrist tables, but finds
+// elements with bit scans and writes observation planes by expanding the bitboards.
+// The state is trivially copyable, so can be snapshot with memcpy.
+class BitboardBoxWorld {
+public:
+    static constexpr std::size_t kMaxCells = 256;
+
+    BitboardBoxWorld() = delete;
+
+    /**
+     * Construct from a state.
+     * @note Throws std::invalid_argument if the board has more than kMaxCells cells
+     * @param state The state to copy
+     */
+    explicit BitboardBoxWorld(const BoxWorldGameState &state);
+
+    /**
+     * Apply the action to the current state, see BoxWorldGameState::apply_action().
+     * @param action The action to apply
+     */
+    void apply_action(Action action) noexcept;
+
+    /**
+     * Check if the state is in the solution state.
+     * @return True if holding the goal, false otherwise
+     */
+    [[nodiscard]] auto is_solution() const noexcept -> bool {
+        return inventory == Element::kColourGoal;
+    }
+
+    /**
+     * Get the reward signal of the last action, see BoxWorldGameState::get_reward_signal().
+     * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+     * @return reward signal
+     */
+    [[nodiscard]] auto get_reward_signal(bool use_colour = false) const noexcept -> uint64_t {
+        return use_colour ? reward_signal_colour : reward_signal_index;
+    }
+
+    /**
+     * Get the hash of the current state, equal to BoxWorldGameState::get_hash() of the same state.
+     * @return hash value
+     */
+    [[nodiscard]] auto get_hash() const noexcept -> uint64_t {
+        return zorb_hash;
+    }
+
+    /**
+     * Get the current agent index
+     * @return agent index
+     */
+    [[nodiscard]] auto get_agent_index() const noexcept -> std::size_t {
+        return agent_idx;
+    }
+
+    /**
+     * Get the current key in the inventory
+     * @return Element of the key held, or kAgent if no key is held
+     */
+    [[nodiscard]] auto get_inventory() const noexcept -> Element {
+        return inventory;
+    }
+
+    /**
+     * Check if key is being held in inventory
+     * @return True if holding key of any colour, false otherwise
+     */
+    [[nodiscard]] auto has_key() const noexcept -> bool {
+        return inventory != Element::kAgent;
+    }
+
+    /**
+     * Get the item at the given index
+     * @param index Board index
+     * @return Element at the index
+     */
+    [[nodiscard]] auto get_item(std::size_t index) const noexcept -> Element;
+
+    /**
+     * Get the bitboard of an element
+     * @param element The element
+     * @return Bitboard with the cells holding the element set
+     */
+    [[nodiscard]] auto get_bitboard(Element element) const noexcept -> const Bitboard & {
+        return planes[static_cast<std::size_t>(element)];
+    }
+
+    /**
+     * Get all indices for a given element type, see BoxWorldGameState::get_indices().
+     * @param element The element to search for
+     * @return flat indices for each instance of element, in increasing order
+     */
+    [[nodiscard]] auto get_indices(Element element) const -> std::vector<std::size_t>;
+
+    /**
+     * Count the cells holding an element
+     * @param element The element to count
+     * @return Number of cells holding the element
+     */
+    [[nodiscard]] auto count(Element element) const noexcept -> std::size_t;
+
+    /**
+     * Get the cells the agent can walk to through empty cells, including the cell of the agent.
+     * @note The mask is found with a shift-and-mask flood fill and cached, and is only recomputed after a key is
+     * collected or a lock opened, as moving within the region does not change it.
+     * The cache is not synchronised, so concurrent calls on the same state are not safe.
+     * @return Bitboard of the reachable cells
+     */
+    [[nodiscard]] auto reachable_mask() const noexcept -> const Bitboard &;
+
+    /**
+     * Check if the agent can walk to the cell through empty cells, see reachable_mask().
+     * @param index Board index
+     * @return True if the cell is reachable, false otherwise
+     */
+    [[nodiscard]] auto is_reachable(std::size_t index) const noexcept -> bool {
+        return TestBit(reachable_mask(), index);
+    }
+
+    /**
+     * Get the single keys and locks next to the reachable cells, which the agent can step onto next.
+     * @note Locks are included regardless of the key held, mask with get_bitboard() of the held colour for the locks
+     * which can be opened
+     * @return Bitboard of the key and lock cells adjacent to reachable_mask()
+     */
+    [[nodiscard]] auto reachable_targets() const noexcept -> Bitboard;
+
+    /**
+     * Get the shape the observations should be viewed as.
+     * @return array indicating observation CHW
+     */
+    [[nodiscard]] auto observation_shape() const noexcept -> std::array<std::size_t, 3> {
+        return {kNumChannels, cols, rows};
+    }
+
+    /**
+     * Get the number of values in an observation
+     * @return Flat observation size
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t {
+        return kNumChannels * rows * cols;
+    }
+
+    /**
+     * Write the observation into the given buffer, see BoxWorldGameState::get_observation().
+     * @param obs Buffer of observation_size() values
+     */
+    void get_observation(float *obs) const noexcept;
+
+    auto operator==(const BitboardBoxWorld &other) const noexcept -> bool {
+        return planes == other.planes && inventory == other.inventory && rows == other.rows && cols == other.cols;
+    }
+    auto operator!=(const BitboardBoxWorld &other) const noexcept -> bool {
+        return !(*this == other);
+    }
+
+private:
+    static auto TestBit(const Bitboard &board, std::size_t index) noexcept -> bool {
+        return (board[index / 64] >> (index % 64)) & 1;
+    }
+    static void SetBit(Bitboard &board, std::size_t index) noexcept {
+        board[index / 64] |= uint64_t{1} << (index % 64);
+    }
+    static void ClearBit(Bitboard &board, std::size_t index) noexcept {
+        board[index / 64] &= ~(uint64_t{1} << (index % 64));
+    }
+
+    [[nodiscard]] auto Neighbour(std::size_t index, Action action) const noexcept -> std::size_t;
+    [[nodiscard]] auto ColourAt(std::size_t index) const noexcept -> Element;
+    [[nodiscard]] auto Expand(const Bitboard &region) const noexcept -> Bitboard;
+    void SetCell(std::size_t index, Element from, Element to) noexcept;
+    void MoveAgent(std::size_t new_index) noexcept;
+    void AddToInventory(std::size_t index) noexcept;
+
+    std::array<Bitboard, kNumElements> planes{};
+    Bitboard key_mask{};      // Cells of the single keys
+    Bitboard lock_mask{};     // Cells of the locks
+    Bitboard left_edge{};     // Cells in the first column
+    Bitboard right_edge{};    // Cells in the last column
+    const ZobristTable *zobrist = nullptr;
+    uint64_t zorb_hash = 0;
+    uint64_t reward_signal_index = 0;
+    uint64_t reward_signal_colour = 0;
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::size_t agent_idx = 0;
+    Element inventory = Element::kAgent;
+    mutable Bitboard reachable{};    // Cached reachable_mask(), valid only if reachable_valid is set
+    mutable bool reachable_valid = false;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_BITBOARD_H_
@@ -3,24 +3,31 @@
 #include <nop/serializer.h>
 #include <nop/utility/buffer_reader.h>
 #include <nop/utility/buffer_writer.h>
-#include <nop/utility/stream_reader.h>
-#include <nop/utility/stream_writer.h>
 
 #include <algorithm>
 #include <array>
 #include <cassert>
-#include <random>
-#include <sstream>
+#include <cstring>
+#include <stdexcept>
+
+#include "level_registry.h"
+#include "one_hot.h"
+#include "parallel.h"
+#include "render.h"
+#include "stats.h"
 
 namespace boxworld {
 
 SharedStateInfo::SharedStateInfo(GameParameters params)
-    : game_board_str(std::get<std::string>(params.at("game_board_str"))) {
+    : level(parse_board(std::get<std::string>(params.at("game_board_str")))) {
     if (params.find("collect_first_key") != params.end()) {
         collect_first_key = std::get<bool>(params.at("collect_first_key"));
     }
 }
 
+SharedStateInfo::SharedStateInfo(Level level, bool collect_first_key)
+    : level(std::move(level)), collect_first_key(collect_first_key) {}
+
 auto SharedStateInfo::operator==(const SharedStateInfo& other) const -> bool {
     return rows == other.rows && cols == other.cols;
 }
@@ -29,19 +36,45 @@ auto LocalState::operator==(const LocalState& other) const -> bool {
     return agent_idx == other.agent_idx && inventory == other.inventory && board == other.board;
 }
 
-BoxWorldGameState::BoxWorldGameState(const GameParameters& params)
-    : shared_state(std::make_shared<SharedStateInfo>(params)) {
+auto LocalState::memory_usage() const noexcept -> std::size_t {
+    return sizeof(*this) + heap_bytes(board) +
+           (key_indices.capacity() + lock_indices.capacity()) * sizeof(FlatIndexSet::value_type);
+}
+
+auto SharedStateInfo::memory_usage() const noexcept -> std::size_t {
+    std::size_t bytes = sizeof(*this) + heap_bytes(level.board) + level_template.memory_usage() - sizeof(LocalState) +
+                        heap_bytes(neighbours) + heap_bytes(key_lock_graph.boxes) +
+                        heap_bytes(key_lock_graph.cell_box) + heap_bytes(key_lock_graph.goal_chain);
+    for (std::size_t i = 0; i < kNumColours; ++i) {
+        bytes += heap_bytes(key_lock_graph.colour_locks[i]) + heap_bytes(key_lock_graph.colour_keys[i]);
+    }
+    return bytes;
+}
+
+BoxWorldGameState::BoxWorldGameState(const GameParameters& params) {
+    AttachLevel(SharedStateInfo(params));
+    reset();
+}
+
+BoxWorldGameState::BoxWorldGameState(const Level& level, bool collect_first_key) {
+    AttachLevel(SharedStateInfo(level, collect_first_key));
     reset();
 }
 
 auto BoxWorldGameState::operator==(const BoxWorldGameState& other) const noexcept -> bool {
-    return local_state == other.local_state && *shared_state == *other.shared_state;
+    // Equal states have equal hashes, so only states with matching hashes need their boards compared
+    return local_state.zorb_hash == other.local_state.zorb_hash && *shared_state == *other.shared_state &&
+           local_state == other.local_state;
 }
 
 auto BoxWorldGameState::operator!=(const BoxWorldGameState& other) const noexcept -> bool {
     return !(*this == other);
 }
 
+auto BoxWorldGameState::is_same_level(const BoxWorldGameState& other) const noexcept -> bool {
+    return shared_state == other.shared_state || shared_state->level_id == other.shared_state->level_id;
+}
+
 const std::vector<Action> BoxWorldGameState::ALL_ACTIONS{Action::kUp, Action::kRight, Action::kDown, Action::kLeft};
 
 // ---------------------------------------------------------------------------
@@ -92,108 +125,489 @@ constexpr std::array<Offset, kNumActions> kActionOffsets{{
 }};
 static_assert(kActionOffsets.size() == kNumActions);
 
-// Colour maps for state to image
-struct Pixel {
-    unsigned char r;
-    unsigned char g;
-    unsigned char b;
-};
-const Pixel WHITE = {0xff, 0xff, 0xff};
-const Pixel BLACK = {0x00, 0x00, 0x00};
-const std::unordered_map<Element, Pixel> kElementToPixelMap{
-    {Element::kColour0, {0xfe, 0x00, 0x00}},     // light red
-    {Element::kColour1, {0x80, 0x00, 0x01}},     // dark red
-    {Element::kColour2, {0xff, 0xb7, 0x32}},     // orange
-    {Element::kColour3, {0x80, 0x34, 0x00}},     // brown
-    {Element::kColour4, {0xff, 0xff, 0x00}},     // yellow
-    {Element::kColour5, {0x00, 0xfe, 0x21}},     // light green
-    {Element::kColour6, {0x00, 0x7f, 0x0e}},     // dark green
-    {Element::kColour7, {0x32, 0xa9, 0xfe}},     // light blue
-    {Element::kColour8, {0x00, 0x26, 0xff}},     // blue
-    {Element::kColour9, {0x00, 0xe6, 0x66}},     // dark blue
-    {Element::kColour10, {0xb1, 0x00, 0xfe}},    // light purple
-    {Element::kColour11, {0x47, 0x00, 0x66}},    // dark purple
-    {Element::kColourGoal, WHITE},
-    {Element::kAgent, BLACK},
-    {Element::kEmpty, {0xb4, 0xb4, 0xb4}},
-};
+// Renderer used by to_image(), see ImageRenderer for other sprite sizes
+auto default_renderer() -> const ImageRenderer& {
+    static const ImageRenderer renderer(SPRITE_WIDTH);
+    return renderer;
+}
 
 // ---------------------------------------------------------------------------
 
-BoxWorldGameState::BoxWorldGameState(const std::vector<uint8_t>& byte_data)
-    : shared_state(std::make_shared<SharedStateInfo>()) {
-    std::stringstream ss;
-    // ss.write((char const*)byte_data.data(), std::streamsize(byte_data.size()));    // NOLINT(*cstyle-cast)
-    ss.write(reinterpret_cast<char const*>(byte_data.data()), std::streamsize(byte_data.size()));
-    nop::Deserializer<nop::StreamReader<std::stringstream>> deserializer{std::move(ss)};
-    deserializer.Read(&local_state);
-    SharedStateInfo& info = *shared_state;
-    deserializer.Read(&info);
-    InitZrbhtTable();
+BoxWorldGameState::BoxWorldGameState(const std::vector<uint8_t>& byte_data) {
+    deserialize_from(byte_data.data(), byte_data.size());
 }
 
-auto BoxWorldGameState::serialize() const -> std::vector<uint8_t> {
-    nop::Serializer<nop::StreamWriter<std::stringstream>> serializer;
-    serializer.Write(local_state);
-    const SharedStateInfo& info = *shared_state;
-    serializer.Write(info);
-    auto& ss = serializer.writer().stream();
-    // discover size of data in stream
-    ss.seekg(0, std::ios::beg);
-    auto bof = ss.tellg();
-    ss.seekg(0, std::ios::end);
-    auto stream_size = std::size_t(ss.tellg() - bof);
-    ss.seekg(0, std::ios::beg);
-
-    // make your vector long enough
-    std::vector<uint8_t> byte_data(stream_size);
-
-    // read directly in
-    // ss.read((char*)byte_data.data(), std::streamsize(byte_data.size()));    // NOLINT(*cstyle-cast)
-    ss.read(reinterpret_cast<char*>(byte_data.data()), std::streamsize(byte_data.size()));    // NOLINT(*cstyle-cast)
+void BoxWorldGameState::deserialize_from(const uint8_t* data, std::size_t size) {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kDeserialize);
+    nop::Deserializer<nop::BufferReader> deserializer{data, size};
+    LocalState deserialized_state;
+    SharedStateInfo info;
+    if (!deserializer.Read(&deserialized_state) || !deserializer.Read(&info)) {
+        throw std::invalid_argument("Unable to deserialize state from bytes.");
+    }
+    const auto previous_level = shared_state;
+    AttachLevel(std::move(info));
+    if (shared_state != previous_level) {
+        distance_cache.clear();
+        has_chain_length = false;
+    }
+    local_state = std::move(deserialized_state);
+    ++version;
+}
+
+void BoxWorldGameState::deserialize_local_from(const uint8_t* data, std::size_t size) {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kDeserialize);
+    nop::Deserializer<nop::BufferReader> deserializer{data, size};
+    uint64_t level_id = 0;
+    LocalState deserialized_state;
+    if (!deserializer.Read(&level_id) || !deserializer.Read(&deserialized_state)) {
+        throw std::invalid_argument("Unable to deserialize state from bytes.");
+    }
+    auto info = LevelRegistry::get_instance().find(level_id);
+    if (info == nullptr) {
+        throw std::invalid_argument("Level of serialized state is not registered.");
+    }
+    if (info != shared_state) {
+        distance_cache.clear();
+        has_chain_length = false;
+    }
+    shared_state = std::move(info);
+    local_state = std::move(deserialized_state);
+    ++version;
+}
+
+auto BoxWorldGameState::serialized_local_size() const noexcept -> std::size_t {
+    return nop::Encoding<uint64_t>::Size(shared_state->level_id) + nop::Encoding<LocalState>::Size(local_state);
+}
+
+auto BoxWorldGameState::serialize_local_into(uint8_t* buffer, std::size_t capacity) const -> std::size_t {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kSerialize);
+    RegisterLevel();
+    nop::Serializer<nop::BufferWriter> serializer{buffer, capacity};
+    if (!serializer.Write(shared_state->level_id) || !serializer.Write(local_state)) {
+        throw std::invalid_argument("Buffer too small to serialize state.");
+    }
+    return serializer.writer().size();
+}
+
+auto BoxWorldGameState::serialize_local() const -> std::vector<uint8_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint8_t> byte_data(serialized_local_size());
+    byte_data.resize(serialize_local_into(byte_data.data(), byte_data.size()));
     return byte_data;
 }
 
-void BoxWorldGameState::InitZrbhtTable() noexcept {
-    // zorbist hashing
-    std::mt19937 gen(static_cast<std::mt19937::result_type>(0));
-    std::uniform_int_distribution<uint64_t> dist(0);
-    const auto channel_size = shared_state->rows * shared_state->cols;
-    // Game board
-    shared_state->zrbht_board.clear();
-    shared_state->zrbht_board.reserve(channel_size * kNumElements);
-    for (std::size_t channel = 0; channel < kNumElements; ++channel) {
-        for (std::size_t i = 0; i < channel_size; ++i) {
-            shared_state->zrbht_board.push_back(dist(gen));
+namespace {
+// Fixed size fields of a sparse serialized state, written between the starting level and the current board
+struct SparseStateFields {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t zorb_hash = 0;
+#ifdef BOXWORLD_HASH128
+    uint64_t zorb_hash_high = 0;
+#endif
+    uint64_t reward_signal_index = 0;
+    uint64_t reward_signal_colour = 0;
+    uint16_t agent_idx = 0;
+    uint8_t inventory = 0;
+    uint8_t collect_first_key = 0;
+    uint32_t reserved = 0;    // Explicit padding, so no uninitialized bytes are written
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+}    // namespace
+
+auto BoxWorldGameState::serialized_sparse_size() const noexcept -> std::size_t {
+    return sparse_level_size(shared_state->level) + sizeof(SparseStateFields) +
+           sparse_cells_size(local_state.board.data(), local_state.board.size());
+}
+
+auto BoxWorldGameState::serialize_sparse_into(uint8_t* buffer, std::size_t capacity) const -> std::size_t {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kSerialize);
+    auto offset = encode_sparse_level(shared_state->level, buffer, capacity);
+    SparseStateFields fields;
+    fields.zorb_hash = local_state.zorb_hash;
+#ifdef BOXWORLD_HASH128
+    fields.zorb_hash_high = local_state.zorb_hash_high;
+#endif
+    fields.reward_signal_index = local_state.reward_signal_index;
+    fields.reward_signal_colour = local_state.reward_signal_colour;
+    fields.agent_idx = static_cast<uint16_t>(local_state.agent_idx);
+    fields.inventory = static_cast<uint8_t>(local_state.inventory);
+    fields.collect_first_key = static_cast<uint8_t>(shared_state->collect_first_key);
+    if (capacity - offset < sizeof(fields)) {
+        throw std::invalid_argument("Buffer too small to serialize state.");
+    }
+    std::memcpy(buffer + offset, &fields, sizeof(fields));
+    offset += sizeof(fields);
+    return offset + encode_sparse_cells(local_state.board.data(), local_state.board.size(), buffer + offset,
+                                        capacity - offset);
+}
+
+auto BoxWorldGameState::serialize_sparse() const -> std::vector<uint8_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint8_t> byte_data(serialized_sparse_size());
+    byte_data.resize(serialize_sparse_into(byte_data.data(), byte_data.size()));
+    return byte_data;
+}
+
+void BoxWorldGameState::deserialize_sparse_from(const uint8_t* data, std::size_t size) {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kDeserialize);
+    std::size_t offset = 0;
+    auto level = decode_sparse_level(data, size, &offset);
+    SparseStateFields fields;
+    if (size - offset < sizeof(fields)) {
+        throw std::invalid_argument("Unable to deserialize state from bytes.");
+    }
+    std::memcpy(&fields, data + offset, sizeof(fields));
+    offset += sizeof(fields);
+    if (fields.agent_idx >= level.board.size() || fields.inventory >= kNumElements ||
+        static_cast<Element>(fields.inventory) == Element::kEmpty) {
+        throw std::invalid_argument("Unable to deserialize state from bytes.");
+    }
+
+    // Decode into a copy of the starting state, so only the board and the removed keys and locks differ
+    AttachLevel(SharedStateInfo(std::move(level), fields.collect_first_key != 0));
+    LocalState deserialized_state = shared_state->level_template;
+    decode_sparse_cells(data + offset, size - offset, deserialized_state.board.data(),
+                        deserialized_state.board.size());
+    if (deserialized_state.board[fields.agent_idx] != Element::kAgent) {
+        throw std::invalid_argument("Unable to deserialize state from bytes.");
+    }
+    deserialized_state.zorb_hash = fields.zorb_hash;
+#ifdef BOXWORLD_HASH128
+    deserialized_state.zorb_hash_high = fields.zorb_hash_high;
+#endif
+    deserialized_state.reward_signal_index = fields.reward_signal_index;
+    deserialized_state.reward_signal_colour = fields.reward_signal_colour;
+    deserialized_state.agent_idx = fields.agent_idx;
+    deserialized_state.inventory = static_cast<Element>(fields.inventory);
+    // Keys and locks are only ever removed, so those of the starting board still on the board remain
+    const auto is_removed = [&](std::size_t idx) {
+        const auto el = deserialized_state.board[idx];
+        return el == Element::kEmpty || el == Element::kAgent;
+    };
+    for (const auto idx : shared_state->level_template.key_indices) {
+        if (is_removed(idx)) {
+            deserialized_state.key_indices.erase(idx);
         }
     }
-    // Inventory keys
-    for (std::size_t i = 0; i < kNumColours; ++i) {
-        shared_state->zrbht_inventory.push_back(dist(gen));
+    for (const auto idx : shared_state->level_template.lock_indices) {
+        if (is_removed(idx)) {
+            deserialized_state.lock_indices.erase(idx);
+        }
     }
+    local_state = std::move(deserialized_state);
+    ++version;
+}
+
+auto BoxWorldGameState::get_cached_observation() const -> const std::vector<float>& {
+    if (!observation_cache.is_valid || observation_cache.version != version) {
+        get_observation(observation_cache.obs);
+        observation_cache.version = version;
+        observation_cache.is_valid = true;
+    }
+    return observation_cache.obs;
+}
+
+auto BoxWorldGameState::get_version() const noexcept -> uint64_t {
+    return version;
+}
+
+auto BoxWorldGameState::get_level_id() const noexcept -> uint64_t {
+    return shared_state->level_id;
+}
+
+auto BoxWorldGameState::get_key_lock_graph() const noexcept -> const KeyLockGraph& {
+    return shared_state->key_lock_graph;
+}
+
+void BoxWorldGameState::borrow_level() {
+    // The registry keeps the level alive for the borrowing states
+    shared_state = LevelRegistry::get_instance().insert(shared_state);
+    // Aliasing an empty shared_ptr gives a pointer with no control block, so copies skip the refcount
+    shared_state = std::shared_ptr<SharedStateInfo>(std::shared_ptr<SharedStateInfo>(), shared_state.get());
+}
+
+auto BoxWorldGameState::is_level_borrowed() const noexcept -> bool {
+    return shared_state.use_count() == 0;
+}
+
+auto BoxWorldGameState::memory_usage() const noexcept -> StateMemoryUsage {
+    StateMemoryUsage usage;
+    usage.local_bytes = sizeof(*this) + local_state.memory_usage() - sizeof(LocalState) +
+                        heap_bytes(observation_cache.obs) + heap_bytes(distance_cache.maps) +
+                        (distance_cache.key_indices.capacity() + distance_cache.lock_indices.capacity()) *
+                            sizeof(FlatIndexSet::value_type);
+    for (const auto& [target, distances] : distance_cache.maps) {
+        usage.local_bytes += heap_bytes(distances);
+    }
+    usage.shared_bytes = shared_state->memory_usage();
+    return usage;
+}
+
+auto BoxWorldGameState::serialized_size() const noexcept -> std::size_t {
+    return nop::Encoding<LocalState>::Size(local_state) + nop::Encoding<SharedStateInfo>::Size(*shared_state);
+}
+
+auto BoxWorldGameState::serialize_into(uint8_t* buffer, std::size_t capacity) const -> std::size_t {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kSerialize);
+    nop::Serializer<nop::BufferWriter> serializer{buffer, capacity};
+    const SharedStateInfo& info = *shared_state;
+    if (!serializer.Write(local_state) || !serializer.Write(info)) {
+        throw std::invalid_argument("Buffer too small to serialize state.");
+    }
+    return serializer.writer().size();
+}
+
+auto BoxWorldGameState::serialize() const -> std::vector<uint8_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint8_t> byte_data(serialized_size());
+    byte_data.resize(serialize_into(byte_data.data(), byte_data.size()));
+    return byte_data;
+}
+
+void BoxWorldGameState::InitZrbhtTable() {
+    // Tables only depend on the board dimensions, so are generated once per size and shared
+    shared_state->zobrist = get_zobrist_table(shared_state->rows, shared_state->cols);
 }
 
 void BoxWorldGameState::reset() {
-    // Board, local, and shared state info
-    local_state = LocalState();
+    BOXWORLD_STATS_SCOPE(StatsEvent::kReset);
+    ++version;
+    // Level is parsed and hashed once on construction, so reset is just a copy
+    local_state = shared_state->level_template;
+}
 
-    // Parse board
-    ParseBoard();
-    InitKeyLockIndices();
+void BoxWorldGameState::reset(Level level) {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kReset);
+    ++version;
+    DetachLevel();
+    shared_state->level = std::move(level);
+    shared_state->level_id = compute_level_id(shared_state->level, shared_state->collect_first_key);
+    InitLevelTemplate();
+}
 
-    // Zorbist hashing
-    InitZrbhtTable();
+void BoxWorldGameState::reset(uint64_t seed, const GeneratorConfig& config) {
+    reset(LevelGenerator(config).generate(seed));
+}
 
-    // Set initial hash
-    const auto channel_size = shared_state->rows * shared_state->cols;
-    for (std::size_t i = 0; i < shared_state->cols * shared_state->rows; ++i) {
-        local_state.zorb_hash ^=
-            shared_state->zrbht_board.at((static_cast<std::size_t>(local_state.board.at(i)) * channel_size) + i);
+void BoxWorldGameState::reset(const LevelPack& pack, std::size_t index) {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kReset);
+    ++version;
+    const auto record = pack.get_record(index);
+    DetachLevel();
+    auto& level = shared_state->level;
+    level.rows = pack.rows();
+    level.cols = pack.cols();
+    level.board.assign(record.board, record.board + (level.rows * level.cols));
+    shared_state->level_id = compute_level_id(level, shared_state->collect_first_key);
+    InitLevelBoard();
+
+    // Indices are precomputed, so no need to scan the board
+    local_state.agent_idx = record.agent_idx;
+    for (std::size_t i = 0; i < record.num_keys; ++i) {
+        const auto idx = record.key_indices[i];
+        if (shared_state->collect_first_key) {
+            local_state.inventory = local_state.board[idx];
+            local_state.board[idx] = Element::kEmpty;
+        } else {
+            local_state.key_indices.insert(idx);
+        }
     }
+    for (std::size_t i = 0; i < record.num_locks; ++i) {
+        local_state.lock_indices.insert(record.lock_indices[i]);
+    }
+    InitLevelHash();
+}
+
+void BoxWorldGameState::reset(const PackedStateKey& key) {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kReset);
+    ++version;
+    const auto& start = shared_state->level_template;
+    local_state = start;
+    const auto clear_cell = [&](std::size_t idx) {
+        XorCellHash(local_state.board[idx], idx);
+        XorCellHash(Element::kEmpty, idx);
+        local_state.board[idx] = Element::kEmpty;
+    };
+    // Removed single keys were collected, and removed locks were opened along with the key in their box
+    std::size_t bit = 0;
+    for (const auto& idx : start.key_indices) {
+        if ((key.remaining & (uint64_t{1} << bit++)) == 0) {
+            clear_cell(idx);
+            local_state.key_indices.erase(idx);
+        }
+    }
+    for (const auto& idx : start.lock_indices) {
+        if ((key.remaining & (uint64_t{1} << bit++)) == 0) {
+            clear_cell(idx);
+            clear_cell(IndexFromAction(idx, Action::kLeft));
+            local_state.lock_indices.erase(idx);
+        }
+    }
+    if (key.agent_idx != start.agent_idx) {
+        clear_cell(start.agent_idx);
+        XorCellHash(Element::kEmpty, key.agent_idx);
+        XorCellHash(Element::kAgent, key.agent_idx);
+        local_state.board[key.agent_idx] = Element::kAgent;
+        local_state.agent_idx = key.agent_idx;
+    }
+    // Held keys are hashed, apart from the key held from the start with collect_first_key until it is used
+    for (const auto held : {key.inventory, start.inventory}) {
+        if (held != Element::kAgent) {
+            XorInventoryHash(held);
+        }
+    }
+    local_state.inventory = key.inventory;
 }
 
 void BoxWorldGameState::apply_action(Action action) noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kApplyAction);
+    ApplyAction(action, nullptr);
+}
+
+auto BoxWorldGameState::apply_action_with_undo(Action action) noexcept -> UndoRecord {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kApplyAction);
+    UndoRecord record;
+    record.zorb_hash = local_state.zorb_hash;
+#ifdef BOXWORLD_HASH128
+    record.zorb_hash_high = local_state.zorb_hash_high;
+#endif
+    record.reward_signal_index = local_state.reward_signal_index;
+    record.reward_signal_colour = local_state.reward_signal_colour;
+    record.agent_idx = local_state.agent_idx;
+    record.inventory = local_state.inventory;
+    ApplyAction(action, &record);
+    return record;
+}
+
+void BoxWorldGameState::undo_action(const UndoRecord& record) noexcept {
+    ++version;
+    // Restore cells in reverse order so cells changed more than once end with their original element
+    for (std::size_t i = record.num_cell_changes; i > 0; --i) {
+        const auto& change = record.cell_changes[i - 1];
+        local_state.board[change.index] = change.element;
+    }
+    if (record.removed_key) {
+        local_state.key_indices.insert(*record.removed_key);
+    }
+    if (record.removed_lock) {
+        local_state.lock_indices.insert(*record.removed_lock);
+    }
+    local_state.zorb_hash = record.zorb_hash;
+#ifdef BOXWORLD_HASH128
+    local_state.zorb_hash_high = record.zorb_hash_high;
+#endif
+    local_state.reward_signal_index = record.reward_signal_index;
+    local_state.reward_signal_colour = record.reward_signal_colour;
+    local_state.agent_idx = record.agent_idx;
+    local_state.inventory = record.inventory;
+}
+
+auto BoxWorldGameState::snapshot() const -> StateSnapshot {
+    StateSnapshot result;
+    snapshot(result);
+    return result;
+}
+
+void BoxWorldGameState::snapshot(StateSnapshot& snapshot) const {
+    if (local_state.board.size() > StateSnapshot::kMaxCells) {
+        throw std::invalid_argument("Board is too large for a snapshot.");
+    }
+    if (local_state.key_indices.size() > StateSnapshot::kMaxTargets ||
+        local_state.lock_indices.size() > StateSnapshot::kMaxTargets) {
+        throw std::invalid_argument("State has too many keys or locks for a snapshot.");
+    }
+    snapshot.zorb_hash = local_state.zorb_hash;
+#ifdef BOXWORLD_HASH128
+    snapshot.zorb_hash_high = local_state.zorb_hash_high;
+#endif
+    snapshot.reward_signal_index = local_state.reward_signal_index;
+    snapshot.reward_signal_colour = local_state.reward_signal_colour;
+    snapshot.agent_idx = static_cast<uint16_t>(local_state.agent_idx);
+    snapshot.num_cells = static_cast<uint16_t>(local_state.board.size());
+    snapshot.num_keys = static_cast<uint16_t>(local_state.key_indices.size());
+    snapshot.num_locks = static_cast<uint16_t>(local_state.lock_indices.size());
+    snapshot.inventory = local_state.inventory;
+    std::copy(local_state.key_indices.begin(), local_state.key_indices.end(), snapshot.key_indices.begin());
+    std::copy(local_state.lock_indices.begin(), local_state.lock_indices.end(), snapshot.lock_indices.begin());
+    std::memcpy(snapshot.board.data(), local_state.board.data(), local_state.board.size() * sizeof(Element));
+}
+
+void BoxWorldGameState::restore(const StateSnapshot& snapshot) {
+    if (snapshot.num_cells != local_state.board.size()) {
+        throw std::invalid_argument("Snapshot does not match the board size of the level.");
+    }
+    ++version;
+    local_state.zorb_hash = snapshot.zorb_hash;
+#ifdef BOXWORLD_HASH128
+    local_state.zorb_hash_high = snapshot.zorb_hash_high;
+#endif
+    local_state.reward_signal_index = snapshot.reward_signal_index;
+    local_state.reward_signal_colour = snapshot.reward_signal_colour;
+    local_state.agent_idx = snapshot.agent_idx;
+    local_state.inventory = snapshot.inventory;
+    // Indices are sorted so each insert appends, reusing the capacity of the sets
+    local_state.key_indices.clear();
+    for (std::size_t i = 0; i < snapshot.num_keys; ++i) {
+        local_state.key_indices.insert(snapshot.key_indices[i]);
+    }
+    local_state.lock_indices.clear();
+    for (std::size_t i = 0; i < snapshot.num_locks; ++i) {
+        local_state.lock_indices.insert(snapshot.lock_indices[i]);
+    }
+    std::memcpy(local_state.board.data(), snapshot.board.data(), snapshot.num_cells * sizeof(Element));
+}
+
+auto BoxWorldGameState::get_distance_map(std::size_t target_index) const -> const std::vector<uint16_t>& {
+    if (!local_state.key_indices.contains(target_index) && !local_state.lock_indices.contains(target_index)) {
+        throw std::invalid_argument("Target index is not a single key or lock.");
+    }
+    // Within a level, maps only change when a key or lock is removed (or restored). Changing level clears the cache.
+    if (!(distance_cache.key_indices == local_state.key_indices) ||
+        !(distance_cache.lock_indices == local_state.lock_indices)) {
+        distance_cache.clear();
+        distance_cache.key_indices = local_state.key_indices;
+        distance_cache.lock_indices = local_state.lock_indices;
+    }
+    auto [it, inserted] = distance_cache.maps.try_emplace(target_index);
+    if (inserted) {
+        ComputeDistanceMap(target_index, it->second);
+    }
+    return it->second;
+}
+
+auto BoxWorldGameState::get_macro_path(std::size_t target_index) const -> std::vector<Action> {
+    const auto& distances = get_distance_map(target_index);
+    auto idx = local_state.agent_idx;
+    if (distances[idx] == kUnreachable) {
+        return {};
+    }
+    // Descend the distance map, the last step moves into the target
+    std::vector<Action> path;
+    path.reserve(distances[idx]);
+    while (idx != target_index) {
+        for (const auto& action : ALL_ACTIONS) {
+            if (InBounds(idx, action) && distances[IndexFromAction(idx, action)] + 1 == distances[idx]) {
+                path.push_back(action);
+                idx = IndexFromAction(idx, action);
+                break;
+            }
+        }
+    }
+    return path;
+}
+
+auto BoxWorldGameState::apply_macro_action(std::size_t target_index) -> std::size_t {
+    const auto path = get_macro_path(target_index);
+    for (const auto& action : path) {
+        ApplyAction(action, nullptr);
+    }
+    return path.size();
+}
+
+void BoxWorldGameState::ApplyAction(Action action, UndoRecord* record) noexcept {
     assert(is_valid_action(action));
+    ++version;
 
     local_state.reward_signal_colour = 0;
     local_state.reward_signal_index = 0;
@@ -204,30 +618,36 @@ void BoxWorldGameState::apply_action(Action action) noexcept {
     }
     // If empty, just move
     if (IsEmpty(agent_idx, action)) {
-        MoveAgent(action);
+        MoveAgent(action, record);
     }
 
     const auto new_index = IndexFromAction(agent_idx, action);
 
     // Single key not part of a lock/box
-    if (local_state.key_indices.find(new_index) != local_state.key_indices.end()) {
+    if (local_state.key_indices.contains(new_index)) {
         local_state.reward_signal_colour = static_cast<std::size_t>(local_state.board[new_index]) + 1;
         local_state.key_indices.erase(new_index);
-        AddToInventory(new_index);
-        MoveAgent(action);
+        if (record != nullptr) {
+            record->removed_key = static_cast<uint16_t>(new_index);
+        }
+        AddToInventory(new_index, record);
+        MoveAgent(action, record);
         local_state.reward_signal_index = local_state.agent_idx + 1;
     }
 
     // Lock/box pair and we have the corresponding key
     // Key is consumed, and we add the box colour to our inventory
-    if (local_state.lock_indices.find(new_index) != local_state.lock_indices.end() && HasKey(new_index)) {
+    if (local_state.lock_indices.contains(new_index) && HasKey(new_index)) {
         local_state.lock_indices.erase(new_index);
+        if (record != nullptr) {
+            record->removed_lock = static_cast<uint16_t>(new_index);
+        }
         local_state.reward_signal_colour = static_cast<std::size_t>(local_state.board[new_index]) + 1;
         RemoveFromInventory();
-        RemoveLock(new_index);
-        AddToInventory(IndexFromAction(new_index, Action::kLeft));
+        RemoveLock(new_index, record);
+        AddToInventory(IndexFromAction(new_index, Action::kLeft), record);
         // local_state.reward_signal_colour = static_cast<uint64_t>(local_state.inventory.value()) + 1;
-        MoveAgent(action);
+        MoveAgent(action, record);
         local_state.reward_signal_index = local_state.agent_idx + 1;
     }
 }
@@ -236,6 +656,21 @@ auto BoxWorldGameState::is_solution() const noexcept -> bool {
     return local_state.inventory == Element::kColourGoal;
 }
 
+auto BoxWorldGameState::is_dead_end() const noexcept -> bool {
+    return get_remaining_chain_length() == kDeadEnd;
+}
+
+auto BoxWorldGameState::get_remaining_chain_length() const noexcept -> std::size_t {
+    // Moving the agent leaves the key, lock, and inventory part of the hash unchanged
+    const auto key = ChainLengthKey();
+    if (!has_chain_length || chain_length_key != key) {
+        chain_length = ComputeChainLength();
+        chain_length_key = key;
+        has_chain_length = true;
+    }
+    return chain_length;
+}
+
 auto BoxWorldGameState::legal_actions() const noexcept -> std::vector<Action> {
     return ALL_ACTIONS;
 }
@@ -247,6 +682,67 @@ void BoxWorldGameState::legal_actions(std::vector<Action>& actions) const noexce
     }
 }
 
+auto BoxWorldGameState::productive_actions() const noexcept -> std::vector<Action> {
+    std::vector<Action> actions;
+    productive_actions(actions);
+    return actions;
+}
+
+void BoxWorldGameState::productive_actions(std::vector<Action>& actions) const noexcept {
+    actions.clear();
+    for (const auto& a : ALL_ACTIONS) {
+        if (IsProductive(a)) {
+            actions.push_back(a);
+        }
+    }
+}
+
+auto BoxWorldGameState::productive_actions_mask() const noexcept -> uint8_t {
+    uint8_t mask = 0;
+    for (const auto& a : ALL_ACTIONS) {
+        mask |= static_cast<uint8_t>(static_cast<uint8_t>(IsProductive(a)) << static_cast<uint8_t>(a));
+    }
+    return mask;
+}
+
+void BoxWorldGameState::successor_hashes(std::array<uint64_t, kNumActions>& out, uint8_t& valid_mask) const noexcept {
+    // Same hash changes as ApplyAction() makes through MoveAgent(), AddToInventory(), and RemoveLock()
+    const auto flat_size = shared_state->rows * shared_state->cols;
+    const auto& zobrist = *shared_state->zobrist;
+    const auto cell_hash = [&](Element el, std::size_t index) {
+        return zobrist.board[static_cast<std::size_t>(el) * flat_size + index];
+    };
+    const auto inventory_hash = [&](Element el) {
+        return zobrist.inventory[static_cast<std::size_t>(el)];
+    };
+    const auto agent_idx = local_state.agent_idx;
+    const auto move_hash = local_state.zorb_hash ^ cell_hash(Element::kAgent, agent_idx) ^
+                           cell_hash(Element::kEmpty, agent_idx);
+    valid_mask = 0;
+    for (const auto& action : ALL_ACTIONS) {
+        const auto a = static_cast<std::size_t>(action);
+        out[a] = local_state.zorb_hash;    // NOLINT(*-bounds-constant-array-index)
+        if (!IsProductive(action)) {
+            continue;
+        }
+        const auto new_index = IndexFromAction(agent_idx, action);
+        const auto el = local_state.board[new_index];
+        // The agent ends on the new cell, which is empty once its key is collected or its lock opened
+        auto hash = move_hash ^ cell_hash(el, new_index) ^ cell_hash(Element::kAgent, new_index);
+        if (local_state.key_indices.contains(new_index)) {
+            hash ^= inventory_hash(el);
+        } else if (el != Element::kEmpty) {
+            // Held key is consumed, and the key in the box moves into the inventory
+            const auto key_index = IndexFromAction(new_index, Action::kLeft);
+            const auto key = local_state.board[key_index];
+            hash ^= inventory_hash(local_state.inventory) ^ cell_hash(key, key_index) ^
+                    cell_hash(Element::kEmpty, key_index) ^ inventory_hash(key);
+        }
+        out[a] = hash;    // NOLINT(*-bounds-constant-array-index)
+        valid_mask |= static_cast<uint8_t>(1U << a);
+    }
+}
+
 auto BoxWorldGameState::observation_shape() const noexcept -> std::array<std::size_t, 3> {
     return {kNumChannels, shared_state->cols, shared_state->rows};
 }
@@ -255,56 +751,146 @@ auto BoxWorldGameState::observation_shape_environment() const noexcept -> std::a
     return {kNumElements - 1, shared_state->cols, shared_state->rows};
 }
 
+auto BoxWorldGameState::observation_shape(const ObservationConfig& config) const noexcept
+    -> std::array<std::size_t, 3> {
+    if (config.layout == ObservationLayout::kHWC) {
+        return {shared_state->cols, shared_state->rows, config.num_channels()};
+    }
+    return {config.num_channels(), shared_state->cols, shared_state->rows};
+}
+
 auto BoxWorldGameState::get_observation() const noexcept -> std::vector<float> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<float> obs(kNumChannels * shared_state->rows * shared_state->cols);
+    get_observation(obs.data());
+    return obs;
+}
+
+void BoxWorldGameState::get_observation(std::vector<float>& obs) const noexcept {
+    obs.resize(kNumChannels * shared_state->rows * shared_state->cols);
+    get_observation(obs.data());
+}
+
+void BoxWorldGameState::get_observation(float* obs) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
     const auto channel_length = shared_state->rows * shared_state->cols;
-    std::vector<float> obs(kNumChannels * channel_length, 0);
 
     // Fill board (elements which are not empty)
     assert(local_state.board.size() == channel_length);
-    for (std::size_t i = 0; i < channel_length; ++i) {
-        const auto& el = local_state.board[i];
-        if (el != Element::kEmpty) {
-            obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
-        }
-    }
+    write_one_hot(local_state.board.data(), channel_length, kNumElements - 1, obs);
 
     // Fill inventory
+    float* inventory_obs = obs + (kNumElements - 1) * channel_length;
+    std::fill_n(inventory_obs, kNumColours * channel_length, static_cast<float>(0));
     if (has_key()) {
-        const auto inventory_channel = static_cast<std::size_t>(local_state.inventory) + kNumElements - 1;
-        const auto inventory_start_idx = inventory_channel * channel_length;
-        std::fill_n(obs.begin() + static_cast<int>(inventory_start_idx), channel_length, static_cast<float>(1));
+        const auto inventory_channel = static_cast<std::size_t>(local_state.inventory);
+        std::fill_n(inventory_obs + inventory_channel * channel_length, channel_length, static_cast<float>(1));
     }
+}
 
+auto BoxWorldGameState::get_observation_environment() const noexcept -> std::vector<float> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<float> obs((kNumElements - 1) * shared_state->rows * shared_state->cols);
+    get_observation_environment(obs.data());
     return obs;
 }
 
-void BoxWorldGameState::get_observation(std::vector<float>& obs) const noexcept {
+void BoxWorldGameState::get_observation_environment(std::vector<float>& obs) const noexcept {
+    obs.resize((kNumElements - 1) * shared_state->rows * shared_state->cols);
+    get_observation_environment(obs.data());
+}
+
+void BoxWorldGameState::get_observation_environment(float* obs) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
     const auto channel_length = shared_state->rows * shared_state->cols;
-    const auto obs_size = kNumChannels * channel_length;
-    obs.clear();
-    obs.reserve(obs_size);
-    std::fill_n(std::back_inserter(obs), obs_size, static_cast<float>(0));
 
     // Fill board (elements which are not empty)
     assert(local_state.board.size() == channel_length);
+    write_one_hot(local_state.board.data(), channel_length, kNumElements - 1, obs);
+}
+
+void BoxWorldGameState::get_observation(const ObservationConfig& config, float* obs, float* inventory) const {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
+    // Channel of each element, kNoChannel if the element is not kept
+    constexpr std::size_t kNoChannel = std::numeric_limits<std::size_t>::max();
+    std::array<std::size_t, kNumElements> element_channels{};
+    element_channels.fill(kNoChannel);
+    std::size_t num_board_channels = 0;
+    if (config.board_channels.empty()) {
+        for (; num_board_channels < kNumElements - 1; ++num_board_channels) {
+            element_channels[num_board_channels] = num_board_channels;
+        }
+    } else {
+        for (const auto& el : config.board_channels) {
+            if (!is_valid_element(el) || el == Element::kEmpty) {
+                throw std::invalid_argument("Observation channels must be non-empty elements.");
+            }
+            element_channels[static_cast<std::size_t>(el)] = num_board_channels++;
+        }
+    }
+    if (inventory != nullptr) {
+        get_inventory_one_hot(inventory);
+    }
+
+    const auto channel_length = shared_state->rows * shared_state->cols;
+    const auto num_channels = config.num_channels();
+    assert(local_state.board.size() == channel_length);
+    if (config.layout == ObservationLayout::kCHW) {
+        if (config.board_channels.empty()) {
+            write_one_hot(local_state.board.data(), channel_length, kNumElements - 1, obs);
+        } else {
+            for (std::size_t channel = 0; channel < num_board_channels; ++channel) {
+                const auto el = config.board_channels[channel];
+                float* plane = obs + channel * channel_length;
+                for (std::size_t i = 0; i < channel_length; ++i) {
+                    plane[i] = local_state.board[i] == el ? 1.0F : 0.0F;
+                }
+            }
+        }
+        if (config.inventory_planes) {
+            float* inventory_obs = obs + num_board_channels * channel_length;
+            std::fill_n(inventory_obs, kNumColours * channel_length, static_cast<float>(0));
+            if (has_key()) {
+                const auto inventory_channel = static_cast<std::size_t>(local_state.inventory);
+                std::fill_n(inventory_obs + inventory_channel * channel_length, channel_length, static_cast<float>(1));
+            }
+        }
+        return;
+    }
+
+    std::fill_n(obs, num_channels * channel_length, static_cast<float>(0));
     for (std::size_t i = 0; i < channel_length; ++i) {
-        const auto& el = local_state.board[i];
-        if (el != Element::kEmpty) {
-            obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
+        const auto channel = element_channels[static_cast<std::size_t>(local_state.board[i])];
+        if (channel != kNoChannel) {
+            obs[i * num_channels + channel] = 1;
         }
     }
+    if (config.inventory_planes && has_key()) {
+        const auto inventory_channel = num_board_channels + static_cast<std::size_t>(local_state.inventory);
+        for (std::size_t i = 0; i < channel_length; ++i) {
+            obs[i * num_channels + inventory_channel] = 1;
+        }
+    }
+}
 
-    // Fill inventory
+void BoxWorldGameState::get_inventory_one_hot(float* inventory) const noexcept {
+    std::fill_n(inventory, kNumColours, static_cast<float>(0));
     if (has_key()) {
-        const auto inventory_channel = static_cast<std::size_t>(local_state.inventory) + kNumElements - 1;
-        const auto inventory_start_idx = inventory_channel * channel_length;
-        std::fill_n(obs.begin() + static_cast<int>(inventory_start_idx), channel_length, static_cast<float>(1));
+        inventory[static_cast<std::size_t>(local_state.inventory)] = 1;
     }
 }
 
-auto BoxWorldGameState::get_observation_environment() const noexcept -> std::vector<float> {
+auto BoxWorldGameState::get_observation_uint8() const noexcept -> std::vector<uint8_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint8_t> obs(kNumChannels * shared_state->rows * shared_state->cols);
+    get_observation_uint8(obs.data());
+    return obs;
+}
+
+void BoxWorldGameState::get_observation_uint8(uint8_t* obs) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
     const auto channel_length = shared_state->rows * shared_state->cols;
-    std::vector<float> obs((kNumElements - 1) * channel_length, 0);
+    std::fill_n(obs, kNumChannels * channel_length, static_cast<uint8_t>(0));
 
     // Fill board (elements which are not empty)
     assert(local_state.board.size() == channel_length);
@@ -315,66 +901,259 @@ auto BoxWorldGameState::get_observation_environment() const noexcept -> std::vec
         }
     }
 
+    // Fill inventory
+    if (has_key()) {
+        const auto inventory_channel = static_cast<std::size_t>(local_state.inventory) + kNumElements - 1;
+        std::fill_n(obs + inventory_channel * channel_length, channel_length, static_cast<uint8_t>(1));
+    }
+}
+
+auto BoxWorldGameState::observation_packed_size() const noexcept -> std::size_t {
+    return (kNumChannels * shared_state->rows * shared_state->cols + 7) / 8;
+}
+
+auto BoxWorldGameState::get_observation_packed() const noexcept -> std::vector<uint8_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint8_t> obs(observation_packed_size());
+    get_observation_packed(obs.data());
     return obs;
 }
 
-void BoxWorldGameState::get_observation_environment(std::vector<float>& obs) const noexcept {
+void BoxWorldGameState::get_observation_packed(uint8_t* obs) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
     const auto channel_length = shared_state->rows * shared_state->cols;
-    const auto obs_size = (kNumElements - 1) * channel_length;
-    obs.clear();
-    obs.reserve(obs_size);
-    std::fill_n(std::back_inserter(obs), obs_size, static_cast<float>(0));
+    const auto set_bit = [&](std::size_t bit) { obs[bit / 8] |= static_cast<uint8_t>(1U << (bit % 8)); };
+    std::fill_n(obs, observation_packed_size(), static_cast<uint8_t>(0));
 
     // Fill board (elements which are not empty)
     assert(local_state.board.size() == channel_length);
     for (std::size_t i = 0; i < channel_length; ++i) {
         const auto& el = local_state.board[i];
         if (el != Element::kEmpty) {
-            obs[static_cast<std::size_t>(el) * channel_length + i] = 1;
+            set_bit(static_cast<std::size_t>(el) * channel_length + i);
+        }
+    }
+
+    // Fill inventory
+    if (has_key()) {
+        const auto inventory_channel = static_cast<std::size_t>(local_state.inventory) + kNumElements - 1;
+        const auto inventory_start_idx = inventory_channel * channel_length;
+        for (std::size_t i = 0; i < channel_length; ++i) {
+            set_bit(inventory_start_idx + i);
         }
     }
 }
 
-auto BoxWorldGameState::image_shape() const noexcept -> std::array<std::size_t, 3> {
-    const auto rows = shared_state->rows + 2;
-    const auto cols = shared_state->cols + 2;
-    return {rows * SPRITE_HEIGHT, cols * SPRITE_WIDTH, SPRITE_CHANNELS};
+auto BoxWorldGameState::observation_index_size() const noexcept -> std::size_t {
+    return shared_state->rows * shared_state->cols + 1;
+}
+
+auto BoxWorldGameState::get_observation_index() const noexcept -> std::vector<uint8_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint8_t> obs(observation_index_size());
+    get_observation_index(obs.data());
+    return obs;
+}
+
+void BoxWorldGameState::get_observation_index(uint8_t* obs) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
+    const auto channel_length = shared_state->rows * shared_state->cols;
+    assert(local_state.board.size() == channel_length);
+    static_assert(sizeof(Element) == sizeof(uint8_t));
+    std::memcpy(obs, local_state.board.data(), channel_length);
+    obs[channel_length] = static_cast<uint8_t>(local_state.inventory);
 }
 
-void fill_sprite(std::vector<uint8_t>& img, std::size_t h, std::size_t w, std::size_t cols, const Pixel& pixel) {
-    const std::size_t img_idx_top_left = h * (SPRITE_DATA_LEN * cols) + (w * SPRITE_DATA_LEN_PER_ROW);
-    for (std::size_t r = 0; r < SPRITE_HEIGHT; ++r) {
-        for (std::size_t c = 0; c < SPRITE_WIDTH; ++c) {
-            const std::size_t img_idx = (r * SPRITE_DATA_LEN_PER_ROW * cols) + (SPRITE_CHANNELS * c) + img_idx_top_left;
-            img[img_idx + 0] = pixel.r;
-            img[img_idx + 1] = pixel.g;
-            img[img_idx + 2] = pixel.b;
+auto BoxWorldGameState::observation_entities_max_size() const noexcept -> std::size_t {
+    return shared_state->rows * shared_state->cols + 1;
+}
+
+auto BoxWorldGameState::get_observation_entities() const noexcept -> std::vector<uint16_t> {
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    std::vector<uint16_t> entities(observation_entities_max_size() * kEntitySize);
+    entities.resize(get_observation_entities(entities.data(), observation_entities_max_size()) * kEntitySize);
+    return entities;
+}
+
+auto BoxWorldGameState::get_observation_entities(uint16_t* entities, std::size_t max_entities) const noexcept
+    -> std::size_t {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kGetObservation);
+    std::size_t count = 0;
+    const auto add_entity = [&](uint16_t row, uint16_t col, Element element) {
+        if (count < max_entities) {
+            entities[count * kEntitySize] = row;
+            entities[count * kEntitySize + 1] = col;
+            entities[count * kEntitySize + 2] = static_cast<uint16_t>(element);
+        }
+        ++count;
+    };
+    add_entity(kInventoryEntityPos, kInventoryEntityPos, local_state.inventory);
+    const auto cols = shared_state->cols;
+    for (std::size_t idx = 0; idx < local_state.board.size(); ++idx) {
+        if (local_state.board[idx] != Element::kEmpty) {
+            add_entity(static_cast<uint16_t>(idx / cols), static_cast<uint16_t>(idx % cols), local_state.board[idx]);
         }
     }
+    return count;
 }
 
-auto BoxWorldGameState::to_image() const noexcept -> std::vector<uint8_t> {
-    // Pad board with black border
-    const auto rows = shared_state->rows + 2;
-    const auto cols = shared_state->cols + 2;
-    const auto channel_length = rows * cols;
-    std::vector<uint8_t> img(channel_length * SPRITE_DATA_LEN, 0);
+void BoxWorldGameState::write_observations(const BoxWorldGameState* states, std::size_t n, float* out,
+                                           std::size_t num_threads) {
+    if (n == 0) {
+        return;
+    }
+    const auto obs_size = kNumChannels * states[0].shared_state->rows * states[0].shared_state->cols;
+    parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            assert(states[i].observation_shape() == states[0].observation_shape());
+            states[i].get_observation(out + i * obs_size);
+        }
+    });
+}
 
-    // Top left item is the key held by the agent
-    if (has_key()) {
-        fill_sprite(img, 0, 0, cols, kElementToPixelMap.at(local_state.inventory));
+void BoxWorldGameState::write_observations_environment(const BoxWorldGameState* states, std::size_t n, float* out,
+                                                       std::size_t num_threads) {
+    if (n == 0) {
+        return;
     }
+    const auto obs_size = (kNumElements - 1) * states[0].shared_state->rows * states[0].shared_state->cols;
+    parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            assert(states[i].observation_shape() == states[0].observation_shape());
+            states[i].get_observation_environment(out + i * obs_size);
+        }
+    });
+}
 
-    // Reset of board is inside the border
-    std::size_t board_idx = 0;
-    for (std::size_t h = 1; h < rows - 1; ++h) {
-        for (std::size_t w = 1; w < cols - 1; ++w) {
-            const auto& el = local_state.board.at(board_idx);
-            fill_sprite(img, h, w, cols, kElementToPixelMap.at(el));
-            ++board_idx;
+namespace {
+// Number of states each thread takes at a time in make_states()
+constexpr std::size_t kMakeStatesGrainSize = 64;
+
+// Construct the state made by make_state(i) for each i in [0, n) over the threads
+template <typename MakeState>
+auto make_states_parallel(std::size_t n, std::size_t num_threads, MakeState&& make_state)
+    -> std::vector<BoxWorldGameState> {
+    if (n == 0) {
+        return {};
+    }
+    // States have no default constructor, so the storage is filled with copies of the first state and replaced
+    std::vector<BoxWorldGameState> states(n, make_state(0));
+    parallel_for_dynamic(n, num_threads, kMakeStatesGrainSize, [&](std::size_t begin, std::size_t end) {
+        for (auto i = std::max<std::size_t>(begin, 1); i < end; ++i) {
+            states[i] = make_state(i);
         }
+    });
+    return states;
+}
+}    // namespace
+
+auto BoxWorldGameState::make_states(const Level* levels, std::size_t n, bool collect_first_key,
+                                    std::size_t num_threads) -> std::vector<BoxWorldGameState> {
+    return make_states_parallel(
+        n, num_threads, [&](std::size_t i) { return BoxWorldGameState(levels[i], collect_first_key); });
+}
+
+auto BoxWorldGameState::make_states(const std::vector<std::string>& board_strs, bool collect_first_key,
+                                    std::size_t num_threads) -> std::vector<BoxWorldGameState> {
+    return make_states_parallel(board_strs.size(), num_threads, [&](std::size_t i) {
+        return BoxWorldGameState(parse_board(board_strs[i]), collect_first_key);
+    });
+}
+
+auto BoxWorldGameState::make_states(const LevelPack& pack, bool collect_first_key, std::size_t num_threads)
+    -> std::vector<BoxWorldGameState> {
+    return make_states_parallel(pack.size(), num_threads, [&](std::size_t i) {
+        return BoxWorldGameState(pack.get_level(i), collect_first_key);
+    });
+}
+
+namespace {
+// Element mapping of a colour permutation, which keeps the goal, agent, and empty elements
+auto colour_mapping(const ColourPermutation& permutation) -> std::array<Element, kNumElements> {
+    std::array<Element, kNumElements> mapping{};
+    std::array<bool, kNumColours - 1> is_mapped{};
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        mapping[el] = static_cast<Element>(el);
+    }
+    for (std::size_t colour = 0; colour < permutation.size(); ++colour) {
+        const auto new_colour = static_cast<std::size_t>(permutation[colour]);
+        if (new_colour >= permutation.size() || is_mapped[new_colour]) {
+            throw std::invalid_argument("Colour permutation is not a permutation of the key colours.");
+        }
+        is_mapped[new_colour] = true;
+        mapping[colour] = permutation[colour];
+    }
+    return mapping;
+}
+
+// Move the planes of the key colours, starting at first_plane, to their permuted channels
+void permute_planes(float* first_plane, std::size_t plane_size, const std::array<Element, kNumElements>& mapping,
+                    std::vector<float>& scratch) {
+    const auto num_planes = kNumColours - 1;
+    scratch.assign(first_plane, first_plane + num_planes * plane_size);
+    for (std::size_t colour = 0; colour < num_planes; ++colour) {
+        std::copy_n(scratch.data() + colour * plane_size, plane_size,
+                    first_plane + static_cast<std::size_t>(mapping[colour]) * plane_size);
     }
-    return img;
+}
+}    // namespace
+
+void BoxWorldGameState::permute_observation_colours(float* obs, std::size_t n, std::size_t rows, std::size_t cols,
+                                                    const ColourPermutation& permutation, std::size_t num_threads) {
+    const auto mapping = colour_mapping(permutation);
+    const auto plane_size = rows * cols;
+    const auto obs_size = kNumChannels * plane_size;
+    parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end) {
+        std::vector<float> scratch;
+        for (std::size_t i = begin; i < end; ++i) {
+            float* board_planes = obs + i * obs_size;
+            permute_planes(board_planes, plane_size, mapping, scratch);
+            permute_planes(board_planes + (kNumElements - 1) * plane_size, plane_size, mapping, scratch);
+        }
+    });
+}
+
+void BoxWorldGameState::flip_observation_vertical(float* obs, std::size_t n, std::size_t rows, std::size_t cols,
+                                                  std::size_t num_threads) {
+    const auto plane_size = rows * cols;
+    parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (float* plane = obs + begin * kNumChannels * plane_size; plane != obs + end * kNumChannels * plane_size;
+             plane += plane_size) {
+            for (std::size_t row = 0; row < rows / 2; ++row) {
+                std::swap_ranges(plane + row * cols, plane + (row + 1) * cols, plane + (rows - 1 - row) * cols);
+            }
+        }
+    });
+}
+
+auto BoxWorldGameState::image_shape() const noexcept -> std::array<std::size_t, 3> {
+    return default_renderer().image_shape(*this);
+}
+
+auto BoxWorldGameState::to_image() const noexcept -> std::vector<uint8_t> {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kToImage);
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    return default_renderer().render(*this);
+}
+
+void BoxWorldGameState::to_image(uint8_t* img) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kToImage);
+    default_renderer().render(*this, img);
+}
+
+auto BoxWorldGameState::indexed_image_shape() const noexcept -> std::array<std::size_t, 3> {
+    return default_renderer().indexed_image_shape(*this);
+}
+
+auto BoxWorldGameState::to_indexed_image() const noexcept -> std::vector<uint8_t> {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kToImage);
+    BOXWORLD_STATS_COUNT(StatsEvent::kBufferAllocation);
+    return default_renderer().render_indexed(*this);
+}
+
+void BoxWorldGameState::to_indexed_image(uint8_t* img) const noexcept {
+    BOXWORLD_STATS_SCOPE(StatsEvent::kToImage);
+    default_renderer().render_indexed(*this, img);
 }
 
 auto BoxWorldGameState::get_reward_signal(bool use_colour) const noexcept -> uint64_t {
@@ -385,6 +1164,72 @@ auto BoxWorldGameState::get_hash() const noexcept -> uint64_t {
     return local_state.zorb_hash;
 }
 
+#ifdef BOXWORLD_HASH128
+auto BoxWorldGameState::get_hash128() const noexcept -> Hash128 {
+    return {local_state.zorb_hash, local_state.zorb_hash_high};
+}
+#endif
+
+auto BoxWorldGameState::packed_key() const -> PackedStateKey {
+    const auto& start = shared_state->level_template;
+    if (start.key_indices.size() + start.lock_indices.size() > PackedStateKey::kMaxTargets) {
+        throw std::invalid_argument("Level has too many keys and locks for a packed key.");
+    }
+    PackedStateKey key;
+    key.agent_idx = static_cast<uint16_t>(local_state.agent_idx);
+    key.inventory = local_state.inventory;
+    // Targets are only ever removed within an episode, so walk both sorted sets together
+    std::size_t bit = 0;
+    const auto pack_remaining = [&](const FlatIndexSet& start_indices, const FlatIndexSet& indices) {
+        auto it = indices.begin();
+        for (const auto& idx : start_indices) {
+            if (it != indices.end() && *it == idx) {
+                key.remaining |= uint64_t{1} << bit;
+                ++it;
+            }
+            ++bit;
+        }
+    };
+    pack_remaining(start.key_indices, local_state.key_indices);
+    pack_remaining(start.lock_indices, local_state.lock_indices);
+    return key;
+}
+
+void BoxWorldGameState::decode_observation(const PackedStateKey& key, float* obs) const noexcept {
+    const auto& start = shared_state->level_template;
+    const auto channel_length = shared_state->rows * shared_state->cols;
+    write_one_hot(start.board.data(), channel_length, kNumElements - 1, obs);
+    const auto clear_cell = [&](std::size_t idx) {
+        const auto el = start.board[idx];
+        if (el != Element::kEmpty) {
+            obs[static_cast<std::size_t>(el) * channel_length + idx] = 0;
+        }
+    };
+    // Removed single keys were collected, and removed locks were opened along with the key in their box
+    std::size_t bit = 0;
+    for (const auto& idx : start.key_indices) {
+        if ((key.remaining & (uint64_t{1} << bit++)) == 0) {
+            clear_cell(idx);
+        }
+    }
+    for (const auto& idx : start.lock_indices) {
+        if ((key.remaining & (uint64_t{1} << bit++)) == 0) {
+            clear_cell(idx);
+            clear_cell(IndexFromAction(idx, Action::kLeft));
+        }
+    }
+    const auto agent_channel = static_cast<std::size_t>(Element::kAgent) * channel_length;
+    obs[agent_channel + start.agent_idx] = 0;
+    obs[agent_channel + key.agent_idx] = 1;
+
+    float* inventory_obs = obs + (kNumElements - 1) * channel_length;
+    std::fill_n(inventory_obs, kNumColours * channel_length, static_cast<float>(0));
+    if (key.inventory != Element::kAgent) {
+        const auto inventory_channel = static_cast<std::size_t>(key.inventory);
+        std::fill_n(inventory_obs + inventory_channel * channel_length, channel_length, static_cast<float>(1));
+    }
+}
+
 auto BoxWorldGameState::get_agent_index() const noexcept -> std::size_t {
     return local_state.agent_idx;
 }
@@ -408,6 +1253,14 @@ auto BoxWorldGameState::get_target_indices() const noexcept -> std::vector<std::
     return indices;
 }
 
+auto BoxWorldGameState::get_key_indices() const noexcept -> const FlatIndexSet& {
+    return local_state.key_indices;
+}
+
+auto BoxWorldGameState::get_lock_indices() const noexcept -> const FlatIndexSet& {
+    return local_state.lock_indices;
+}
+
 auto BoxWorldGameState::get_item(std::size_t index) const noexcept -> Element {
     assert(index < shared_state->rows * shared_state->cols);
     return local_state.board[index];
@@ -427,6 +1280,10 @@ auto BoxWorldGameState::has_key() const noexcept -> bool {
     return local_state.inventory != Element::kAgent;
 }
 
+auto BoxWorldGameState::get_inventory() const noexcept -> Element {
+    return local_state.inventory;
+}
+
 void BoxWorldGameState::set_key(Element element) {
     if (!is_valid_element(element) || element == Element::kEmpty || element == Element::kAgent) {
         throw std::invalid_argument("Unknown key element.");
@@ -437,47 +1294,207 @@ void BoxWorldGameState::set_key(Element element) {
     if (!local_state.key_indices.empty()) {
         throw std::invalid_argument("Single key already exists.");
     }
+    ++version;
     local_state.inventory = element;
-    local_state.zorb_hash ^= shared_state->zrbht_inventory[static_cast<std::size_t>(local_state.inventory)];
+    XorInventoryHash(local_state.inventory);
+}
+
+void BoxWorldGameState::permute_colours(const ColourPermutation& permutation) {
+    const auto mapping = colour_mapping(permutation);
+    ++version;
+    DetachLevel();
+    auto& info = *shared_state;
+    for (auto& el : info.level.board) {
+        el = mapping[static_cast<std::size_t>(el)];
+    }
+    info.level_id = compute_level_id(info.level, info.collect_first_key);
+    const auto start_inventory = info.level_template.inventory;
+    PermuteColours(info.level_template, mapping, start_inventory);
+    PermuteColours(local_state, mapping, start_inventory);
+    info.key_lock_graph = build_key_lock_graph(info.level_template.board, info.level_template.key_indices,
+                                               info.level_template.lock_indices, info.level_template.inventory);
+    has_chain_length = false;
+}
+
+void BoxWorldGameState::flip_vertical() {
+    ++version;
+    DetachLevel();
+    auto& info = *shared_state;
+    for (std::size_t row = 0; row < info.rows / 2; ++row) {
+        std::swap_ranges(info.level.board.begin() + static_cast<std::ptrdiff_t>(row * info.cols),
+                         info.level.board.begin() + static_cast<std::ptrdiff_t>((row + 1) * info.cols),
+                         info.level.board.begin() + static_cast<std::ptrdiff_t>((info.rows - 1 - row) * info.cols));
+    }
+    info.level_id = compute_level_id(info.level, info.collect_first_key);
+    FlipVertical(info.level_template);
+    FlipVertical(local_state);
+    info.key_lock_graph = build_key_lock_graph(info.level_template.board, info.level_template.key_indices,
+                                               info.level_template.lock_indices, info.level_template.inventory);
+    distance_cache.clear();
+    has_chain_length = false;
 }
 
 // ---------------------------------------------------------------------------
 
-void BoxWorldGameState::ParseBoard() {
-    std::stringstream board_ss(shared_state->game_board_str);
-    std::string segment;
-    std::vector<std::string> seglist;
-    // string split on |
-    while (std::getline(board_ss, segment, '|')) {
-        seglist.push_back(segment);
+void BoxWorldGameState::AttachLevel(SharedStateInfo info) {
+    // States of a registered level share its parsed level and hashing tables. Other levels are only registered by
+    // serialize_local() or borrow_level(), so constructing states does not grow the registry.
+    const auto level_id = compute_level_id(info.level, info.collect_first_key);
+    auto registered = LevelRegistry::get_instance().find(level_id);
+    // Level ids are 64-bit hashes, so a registered level of the same id may be a different level
+    if (registered != nullptr && registered->collect_first_key == info.collect_first_key &&
+        registered->level == info.level) {
+        shared_state = std::move(registered);
+        return;
     }
+    info.level_id = level_id;
+    BOXWORLD_STATS_COUNT(StatsEvent::kLevelAllocation);
+    shared_state = std::make_shared<SharedStateInfo>(std::move(info));
+    InitLevelTemplate();
+}
 
-    // Check input
-    if (seglist.size() < 2) {
-        throw std::invalid_argument("Board string should have at minimum 3 values separated by '|'.");
+void BoxWorldGameState::RegisterLevel() const {
+    // Skips the registry lock once registered, until a level is removed from the registry
+    auto& registry = LevelRegistry::get_instance();
+    if (shared_state->registered_epoch.load() != registry.epoch()) {
+        [[maybe_unused]] const auto registered = registry.insert(shared_state);
     }
-    const int rows = std::stoi(seglist[0]);
-    const int cols = std::stoi(seglist[1]);
-    if (seglist.size() != static_cast<std::size_t>(rows * cols) + 2) {
-        throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+}
+
+void BoxWorldGameState::DetachLevel() {
+    // Modify the shared info in place only if no other state or the registry holds it.
+    // The copy keeps the hashing and neighbour tables, which are reused if the board dimensions match.
+    if (shared_state.use_count() != 1 || shared_state->is_registered.load() != 0) {
+        BOXWORLD_STATS_COUNT(StatsEvent::kLevelAllocation);
+        shared_state = std::make_shared<SharedStateInfo>(*shared_state);
     }
+    // The level is about to change, so its id no longer finds it in the registry
+    shared_state->registered_epoch.store(0);
+}
 
-    // Parse
-    local_state.board.clear();
-    shared_state->rows = static_cast<std::size_t>(rows);
-    shared_state->cols = static_cast<std::size_t>(cols);
-    for (std::size_t i = 2; i < seglist.size(); ++i) {
-        const auto el_idx = static_cast<std::size_t>(std::stoi(seglist[i]));
-        if (el_idx > kNumElements) {
-            std::cerr << shared_state->game_board_str << std::endl;
-            std::cerr << el_idx << std::endl;
-            throw std::invalid_argument("Unknown element type.");
+void BoxWorldGameState::InitLevelTemplate() {
+    InitLevelBoard();
+    for (std::size_t i = 0; i < local_state.board.size(); ++i) {
+        if (local_state.board[i] == Element::kAgent) {
+            local_state.agent_idx = i;
         }
-        const auto el = static_cast<Element>(el_idx);
-        if (el == Element::kAgent) {
-            local_state.agent_idx = i - 2;
+    }
+    InitKeyLockIndices();
+    InitLevelHash();
+}
+
+void BoxWorldGameState::InitLevelBoard() {
+    auto& info = *shared_state;
+    validate_level(info.level);
+
+    // Hashing and neighbour tables only depend on the board dimensions
+    const bool same_dims = info.rows == info.level.rows && info.cols == info.level.cols && !info.neighbours.empty();
+    info.rows = info.level.rows;
+    info.cols = info.level.cols;
+    if (!same_dims) {
+        InitNeighbourTable();
+        InitZrbhtTable();
+    }
+
+    local_state = LocalState();
+    local_state.board = info.level.board;
+    // Caches of the previous level may match the key and lock indices or hash of the new one, but not its board
+    distance_cache.clear();
+    has_chain_length = false;
+}
+
+void BoxWorldGameState::InitLevelHash() {
+    const auto channel_size = shared_state->rows * shared_state->cols;
+    for (std::size_t i = 0; i < channel_size; ++i) {
+        XorCellHash(local_state.board[i], i);
+    }
+    shared_state->level_template = local_state;
+    shared_state->key_lock_graph = build_key_lock_graph(local_state.board, local_state.key_indices,
+                                                        local_state.lock_indices, local_state.inventory);
+}
+
+void BoxWorldGameState::ComputeDistanceMap(std::size_t target_index, std::vector<uint16_t>& distances) const {
+    // BFS out from the target through the cells the agent can walk on
+    distances.assign(local_state.board.size(), kUnreachable);
+    distances[target_index] = 0;
+    std::vector<std::size_t> queue{target_index};
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const auto idx = queue[head];
+        for (const auto& action : ALL_ACTIONS) {
+            if (!InBounds(idx, action)) {
+                continue;
+            }
+            const auto next = IndexFromAction(idx, action);
+            const auto el = local_state.board[next];
+            if ((el == Element::kEmpty || el == Element::kAgent) && distances[next] == kUnreachable) {
+                distances[next] = static_cast<uint16_t>(distances[idx] + 1);
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+auto BoxWorldGameState::ComputeChainLength() const noexcept -> std::size_t {
+    if (is_solution()) {
+        return 0;
+    }
+    // Breadth first over the colours which can still be held, through the locks not yet opened.
+    // The held colour is queued before the single keys, so the queue stays ordered by distance.
+    const auto& graph = shared_state->key_lock_graph;
+    std::array<std::size_t, kNumColours> distances{};
+    distances.fill(kDeadEnd);
+    std::array<Element, kNumColours> queue{};
+    std::size_t tail = 0;
+    const auto reach = [&](Element colour, std::size_t distance) {
+        const auto c = static_cast<std::size_t>(colour);
+        if (distances[c] == kDeadEnd) {
+            distances[c] = distance;
+            queue[tail++] = colour;
+        }
+    };
+    if (has_key()) {
+        reach(local_state.inventory, 0);
+    }
+    for (const auto& idx : local_state.key_indices) {
+        reach(local_state.board[idx], 1);
+    }
+    for (std::size_t head = 0; head < tail; ++head) {
+        const auto distance = distances[static_cast<std::size_t>(queue[head])] + 1;
+        for (const auto& lock_index : graph.colour_locks[static_cast<std::size_t>(queue[head])]) {
+            if (local_state.lock_indices.contains(lock_index)) {
+                reach(graph.box_at(lock_index)->key_colour, distance);
+            }
+        }
+    }
+    return distances[static_cast<std::size_t>(Element::kColourGoal)];
+}
+
+auto BoxWorldGameState::ChainLengthKey() const noexcept -> uint64_t {
+    // Replace the agent with an empty cell in the hash
+    const auto flat_size = shared_state->rows * shared_state->cols;
+    const auto agent_idx = local_state.agent_idx;
+    return local_state.zorb_hash ^
+           shared_state->zobrist->board[static_cast<std::size_t>(Element::kAgent) * flat_size + agent_idx] ^
+           shared_state->zobrist->board[static_cast<std::size_t>(Element::kEmpty) * flat_size + agent_idx];
+}
+
+void BoxWorldGameState::InitNeighbourTable() {
+    const auto rows = static_cast<int>(shared_state->rows);
+    const auto cols = static_cast<int>(shared_state->cols);
+    auto& neighbours = shared_state->neighbours;
+    neighbours.assign(shared_state->rows * shared_state->cols * kNumActions, kNoNeighbour);
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            const auto index = static_cast<std::size_t>(row * cols + col);
+            for (std::size_t a = 0; a < kNumActions; ++a) {
+                const auto& offsets = kActionOffsets[a];    // NOLINT(*-bounds-constant-array-index)
+                const int new_col = col + offsets.first;
+                const int new_row = row + offsets.second;
+                if (new_col >= 0 && new_col < cols && new_row >= 0 && new_row < rows) {
+                    neighbours[index * kNumActions + a] = static_cast<uint16_t>(new_row * cols + new_col);
+                }
+            }
         }
-        local_state.board.push_back(el);
     }
 }
 
@@ -519,73 +1536,159 @@ auto BoxWorldGameState::IsEmpty(std::size_t index, Action action) const noexcept
     return InBounds(index, action) && GetItem(index, action) == Element::kEmpty;
 }
 
-void BoxWorldGameState::MoveAgent(Action action) noexcept {
+void BoxWorldGameState::RecordCell(UndoRecord* record, std::size_t index) const noexcept {
+    if (record != nullptr) {
+        assert(record->num_cell_changes < UndoRecord::kMaxCellChanges);
+        record->cell_changes[record->num_cell_changes++] = {static_cast<uint16_t>(index), local_state.board[index]};
+    }
+}
+
+void BoxWorldGameState::MoveAgent(Action action, UndoRecord* record) noexcept {
     const auto idx_old = local_state.agent_idx;
     const auto idx_new = IndexFromAction(idx_old, action);
-    const auto flat_size = shared_state->rows * shared_state->cols;
+    RecordCell(record, idx_old);
+    RecordCell(record, idx_new);
 
     // Undo old hash
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(Element::kAgent) * flat_size + idx_old);
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(Element::kEmpty) * flat_size + idx_new);
+    XorCellHash(Element::kAgent, idx_old);
+    XorCellHash(Element::kEmpty, idx_new);
     // Move
     local_state.agent_idx = idx_new;
     local_state.board[idx_old] = Element::kEmpty;
     local_state.board[idx_new] = Element::kAgent;
     // New hash
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(Element::kAgent) * flat_size + idx_new);
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(Element::kEmpty) * flat_size + idx_old);
+    XorCellHash(Element::kAgent, idx_new);
+    XorCellHash(Element::kEmpty, idx_old);
 }
 
-void BoxWorldGameState::AddToInventory(std::size_t index) noexcept {
+void BoxWorldGameState::AddToInventory(std::size_t index, UndoRecord* record) noexcept {
     assert(!has_key());
-    const auto flat_size = shared_state->rows * shared_state->cols;
+    RecordCell(record, index);
     local_state.inventory = local_state.board[index];
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(local_state.inventory) * flat_size + index);
-    local_state.zorb_hash ^= shared_state->zrbht_inventory[static_cast<std::size_t>(local_state.inventory)];
+    XorCellHash(local_state.inventory, index);
+    XorInventoryHash(local_state.inventory);
 
     local_state.board[index] = Element::kEmpty;
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(Element::kEmpty) * flat_size + index);
+    XorCellHash(Element::kEmpty, index);
 }
 
 void BoxWorldGameState::RemoveFromInventory() noexcept {
     assert(has_key());
-    local_state.zorb_hash ^= shared_state->zrbht_inventory[static_cast<std::size_t>(local_state.inventory)];
+    XorInventoryHash(local_state.inventory);
     local_state.inventory = Element::kAgent;
 }
 
-void BoxWorldGameState::RemoveLock(std::size_t index) noexcept {
-    const auto flat_size = shared_state->rows * shared_state->cols;
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(local_state.board[index]) * flat_size + index);
+void BoxWorldGameState::RemoveLock(std::size_t index, UndoRecord* record) noexcept {
+    RecordCell(record, index);
+    XorCellHash(local_state.board[index], index);
     local_state.board[index] = Element::kEmpty;
-    local_state.zorb_hash ^=
-        shared_state->zrbht_board.at(static_cast<std::size_t>(Element::kEmpty) * flat_size + index);
+    XorCellHash(Element::kEmpty, index);
+}
+
+void BoxWorldGameState::XorCellHash(Element element, std::size_t index) noexcept {
+    const auto table_index = static_cast<std::size_t>(element) * shared_state->rows * shared_state->cols + index;
+    local_state.zorb_hash ^= shared_state->zobrist->board[table_index];
+#ifdef BOXWORLD_HASH128
+    local_state.zorb_hash_high ^= shared_state->zobrist->board_high[table_index];
+#endif
+}
+
+void BoxWorldGameState::XorInventoryHash(Element element) noexcept {
+    local_state.zorb_hash ^= shared_state->zobrist->inventory[static_cast<std::size_t>(element)];
+#ifdef BOXWORLD_HASH128
+    local_state.zorb_hash_high ^= shared_state->zobrist->inventory_high[static_cast<std::size_t>(element)];
+#endif
+}
+
+void BoxWorldGameState::XorCellHash(LocalState& state, Element element, std::size_t index) const noexcept {
+    const auto table_index = static_cast<std::size_t>(element) * shared_state->rows * shared_state->cols + index;
+    state.zorb_hash ^= shared_state->zobrist->board[table_index];
+#ifdef BOXWORLD_HASH128
+    state.zorb_hash_high ^= shared_state->zobrist->board_high[table_index];
+#endif
+}
+
+void BoxWorldGameState::XorInventoryHash(LocalState& state, Element element) const noexcept {
+    state.zorb_hash ^= shared_state->zobrist->inventory[static_cast<std::size_t>(element)];
+#ifdef BOXWORLD_HASH128
+    state.zorb_hash_high ^= shared_state->zobrist->inventory_high[static_cast<std::size_t>(element)];
+#endif
+}
+
+void BoxWorldGameState::PermuteColours(LocalState& state, const std::array<Element, kNumElements>& mapping,
+                                       Element start_inventory) const noexcept {
+    for (std::size_t idx = 0; idx < state.board.size(); ++idx) {
+        const auto el = state.board[idx];
+        const auto new_el = mapping[static_cast<std::size_t>(el)];
+        if (new_el != el) {
+            XorCellHash(state, el, idx);
+            XorCellHash(state, new_el, idx);
+            state.board[idx] = new_el;
+        }
+    }
+    // Held keys are in the hash, apart from the key held from the start with collect_first_key which is not hashed
+    // until it is used. Swapping both terms covers each case, as they cancel while the starting key is still held.
+    for (const auto held : {state.inventory, start_inventory}) {
+        if (held != Element::kAgent) {
+            XorInventoryHash(state, held);
+            XorInventoryHash(state, mapping[static_cast<std::size_t>(held)]);
+        }
+    }
+    state.inventory = mapping[static_cast<std::size_t>(state.inventory)];
+    if (state.reward_signal_colour != 0) {
+        state.reward_signal_colour = static_cast<uint64_t>(mapping[state.reward_signal_colour - 1]) + 1;
+    }
+}
+
+void BoxWorldGameState::FlipVertical(LocalState& state) const noexcept {
+    const auto rows = shared_state->rows;
+    const auto cols = shared_state->cols;
+    const auto flip_index = [&](std::size_t idx) { return (rows - 1 - idx / cols) * cols + idx % cols; };
+    // Only the cells which differ from their mirror change the hash
+    for (std::size_t idx = 0; idx < (rows / 2) * cols; ++idx) {
+        const auto mirror_idx = flip_index(idx);
+        const auto el = state.board[idx];
+        const auto mirror_el = state.board[mirror_idx];
+        if (el != mirror_el) {
+            XorCellHash(state, el, idx);
+            XorCellHash(state, mirror_el, mirror_idx);
+            XorCellHash(state, el, mirror_idx);
+            XorCellHash(state, mirror_el, idx);
+            state.board[idx] = mirror_el;
+            state.board[mirror_idx] = el;
+        }
+    }
+    state.agent_idx = flip_index(state.agent_idx);
+    if (state.reward_signal_index != 0) {
+        state.reward_signal_index = flip_index(state.reward_signal_index - 1) + 1;
+    }
+    for (auto* indices : {&state.key_indices, &state.lock_indices}) {
+        const std::vector<std::size_t> old_indices(indices->begin(), indices->end());
+        indices->clear();
+        for (const auto idx : old_indices) {
+            indices->insert(flip_index(idx));
+        }
+    }
 }
 
 auto BoxWorldGameState::IndexFromAction(std::size_t index, Action action) const noexcept -> std::size_t {
-    auto col = index % shared_state->cols;
-    auto row = (index - col) / shared_state->cols;
-    const auto& offsets = kActionOffsets[static_cast<std::size_t>(action)];    // NOLINT(*-bounds-constant-array-index)
-    col = static_cast<std::size_t>(static_cast<int>(col) + offsets.first);
-    row = static_cast<std::size_t>(static_cast<int>(row) + offsets.second);
-    return (shared_state->cols * row) + col;
+    assert(InBounds(index, action));
+    return shared_state->neighbours[index * kNumActions + static_cast<std::size_t>(action)];
 }
 
 auto BoxWorldGameState::InBounds(std::size_t index, Action action) const noexcept -> bool {
-    const auto rows = static_cast<int>(shared_state->rows);
-    const auto cols = static_cast<int>(shared_state->cols);
-    auto col = static_cast<int>(index) % cols;
-    auto row = (static_cast<int>(index) - col) / cols;
-    const auto& offsets = kActionOffsets[static_cast<std::size_t>(action)];    // NOLINT(*-bounds-constant-array-index)
-    col = col + offsets.first;
-    row = row + offsets.second;
-    return col >= 0 && col < cols && row >= 0 && row < rows;
+    return shared_state->neighbours[index * kNumActions + static_cast<std::size_t>(action)] != kNoNeighbour;
+}
+
+auto BoxWorldGameState::IsProductive(Action action) const noexcept -> bool {
+    // Same cases as ApplyAction() which change the state
+    const auto agent_idx = local_state.agent_idx;
+    if (!InBounds(agent_idx, action)) {
+        return false;
+    }
+    const auto new_index = IndexFromAction(agent_idx, action);
+    return IsEmpty(agent_idx, action) || local_state.key_indices.contains(new_index) ||
+           (local_state.lock_indices.contains(new_index) && HasKey(new_index));
 }
 
 auto BoxWorldGameState::HasKey(std::size_t index) const noexcept -> bool {
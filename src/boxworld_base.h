@@ -3,17 +3,26 @@
 
 #include <nop/structure.h>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
-#include <unordered_set>
 #include <variant>
 #include <vector>
 
 #include "definitions.h"
+#include "flat_index_set.h"
+#include "key_lock_graph.h"
+#include "level.h"
+#include "level_generator.h"
+#include "level_pack.h"
+#include "zobrist.h"
 
 namespace boxworld {
 
@@ -24,6 +33,9 @@ constexpr int SPRITE_CHANNELS = 3;
 constexpr int SPRITE_DATA_LEN_PER_ROW = SPRITE_WIDTH * SPRITE_CHANNELS;
 constexpr int SPRITE_DATA_LEN = SPRITE_WIDTH * SPRITE_HEIGHT * SPRITE_CHANNELS;
 
+// Chain length or heuristic value of states which cannot reach the solution
+constexpr std::size_t kDeadEnd = std::numeric_limits<std::size_t>::max();
+
 // Game parameter can be boolean, integral or floating point
 using GameParameter = std::variant<bool, int, float, std::string>;
 using GameParameters = std::unordered_map<std::string, GameParameter>;
@@ -47,74 +59,457 @@ static const GameParameters kDefaultGameParams{
     {"collect_first_key", GameParameter(false)},
 };
 
+// Information specific for the current game state
+struct LocalState {
+    LocalState() = default;
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t zorb_hash = 0;                          // hash value of the current state
+#ifdef BOXWORLD_HASH128
+    uint64_t zorb_hash_high = 0;                     // High half of the 128-bit hash of the current state
+#endif
+    uint64_t reward_signal_index = 0;                // Signal for external information about events
+    uint64_t reward_signal_colour = 0;               // Signal for external information about events
+    std::size_t agent_idx = 0;                       // Board index the agent resides
+    std::vector<Element> board{};                    // Main storage of the board (one byte per cell)
+    Element inventory = Element::kAgent;             // Current key in the inventory
+    FlatIndexSet key_indices;                        // Fast lookup of keys
+    FlatIndexSet lock_indices;                       // Fast lookup of locks
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator==(const LocalState &other) const -> bool;
+
+    /**
+     * Get the memory held by the local state
+     * @return Bytes of the object and of its board and index sets
+     */
+    [[nodiscard]] auto memory_usage() const noexcept -> std::size_t;
+#ifdef BOXWORLD_HASH128
+    NOP_STRUCTURE(LocalState, zorb_hash, zorb_hash_high, reward_signal_index, reward_signal_colour, agent_idx, board,
+                  inventory, key_indices, lock_indices);
+#else
+    NOP_STRUCTURE(LocalState, zorb_hash, reward_signal_index, reward_signal_colour, agent_idx, board, inventory,
+                  key_indices, lock_indices);
+#endif
+};
+
+// Neighbour table entry for moves which leave the board
+constexpr uint16_t kNoNeighbour = std::numeric_limits<uint16_t>::max();
+
+// Value of a shared info which is set by the LevelRegistry and read by states without its lock.
+// Copies start at 0, as a copied shared info is a separate object from the one the value was set on.
+class RegistryMark {
+public:
+    RegistryMark() = default;
+    ~RegistryMark() = default;
+    RegistryMark(const RegistryMark &) noexcept {}
+    RegistryMark(RegistryMark &&) noexcept {}
+    auto operator=(const RegistryMark &other) noexcept -> RegistryMark & {
+        if (this != &other) {
+            store(0);
+        }
+        return *this;
+    }
+    auto operator=(RegistryMark &&other) noexcept -> RegistryMark & {
+        if (this != &other) {
+            store(0);
+        }
+        return *this;
+    }
+
+    [[nodiscard]] auto load() const noexcept -> uint64_t {
+        return value.load(std::memory_order_acquire);
+    }
+
+    void store(uint64_t mark) noexcept {
+        value.store(mark, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
 // Shared global state information relevant to all states for the given game
 struct SharedStateInfo {
     SharedStateInfo() = default;
     SharedStateInfo(GameParameters params);
+    SharedStateInfo(Level level, bool collect_first_key);
     // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
-    std::string game_board_str;               // String representation of the starting state
+    Level level;                              // Starting board of the level
     bool collect_first_key = false;           // Flag to collect the first key from the start
-    std::vector<uint64_t> zrbht_board;        // Zobrist hashing table for board items
-    std::vector<uint64_t> zrbht_inventory;    // Zobrist hashing table for inventory
+    RegistryMark is_registered;               // 1 if held by the LevelRegistry, else 0
+    RegistryMark registered_epoch;            // LevelRegistry::epoch() when level_id last found this level, or 0
+    std::shared_ptr<const ZobristTable> zobrist;    // Zobrist hashing tables shared by levels of the board size
+    LocalState level_template;                // Parsed starting state, copied on reset
+    std::vector<uint16_t> neighbours;         // Neighbour index per (cell, action), kNoNeighbour if out of bounds
+    KeyLockGraph key_lock_graph;              // Which keys open which boxes in the starting board
+    uint64_t level_id = 0;                    // Identifier of the level in the LevelRegistry
     std::size_t rows = 0;                     // Rows of the common board
     std::size_t cols = 0;                     // Cols of the common board
     // NOLINTEND(misc-non-private-member-variables-in-classes)
 
     auto operator==(const SharedStateInfo &other) const -> bool;
-    NOP_STRUCTURE(SharedStateInfo, game_board_str, collect_first_key, rows, cols);
+
+    /**
+     * Get the memory held by the shared info, without the Zobrist tables shared by every level of the board size,
+     * see get_zobrist_cache_usage()
+     * @return Bytes of the object, its level, level template, neighbour table and key-lock graph
+     */
+    [[nodiscard]] auto memory_usage() const noexcept -> std::size_t;
+    NOP_STRUCTURE(SharedStateInfo, level, collect_first_key);
 };
 
-// Information specific for the current game state
-struct LocalState {
-    LocalState() = default;
+// Changes made to a state by a single action, used to undo the action in place
+struct UndoRecord {
+    // Most cells an action can change: lock, contained key, and agent old/new position
+    static constexpr std::size_t kMaxCellChanges = 4;
+    struct CellChange {
+        uint16_t index = 0;                 // Board index of the changed cell
+        Element element = Element::kEmpty;  // Element at the index before the change
+    };
     // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
-    uint64_t zorb_hash = 0;                          // hash value of the current state
-    uint64_t reward_signal_index = 0;                // Signal for external information about events
-    uint64_t reward_signal_colour = 0;               // Signal for external information about events
-    std::size_t agent_idx = 0;                       // Board index the agent resides
-    std::vector<Element> board{};                    // Main storage of the board
-    Element inventory = Element::kAgent;             // Current key in the inventory
-    std::unordered_set<std::size_t> key_indices;     // Fast lookup of keys
-    std::unordered_set<std::size_t> lock_indices;    // Fast lookup of locks
+    uint64_t zorb_hash = 0;                                  // Hash before the action
+#ifdef BOXWORLD_HASH128
+    uint64_t zorb_hash_high = 0;                             // High half of the 128-bit hash before the action
+#endif
+    uint64_t reward_signal_index = 0;                        // Reward signal before the action
+    uint64_t reward_signal_colour = 0;                       // Reward signal before the action
+    std::size_t agent_idx = 0;                               // Agent index before the action
+    Element inventory = Element::kAgent;                     // Inventory before the action
+    std::optional<uint16_t> removed_key;                     // Single key index removed by the action
+    std::optional<uint16_t> removed_lock;                    // Lock index removed by the action
+    std::array<CellChange, kMaxCellChanges> cell_changes{};  // Changed cells, in order of modification
+    std::size_t num_cell_changes = 0;                        // Number of valid entries in cell_changes
     // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
 
-    auto operator==(const LocalState &other) const -> bool;
-    NOP_STRUCTURE(LocalState, zorb_hash, reward_signal_index, reward_signal_colour, agent_idx, board, inventory,
-                  key_indices, lock_indices);
+// Compact key of the parts of a state which change within an episode, for exact duplicate detection.
+// Keys are only comparable between states of the same level.
+struct PackedStateKey {
+    // Most single keys and locks a level can have to be packed
+    static constexpr std::size_t kMaxTargets = 64;
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint16_t agent_idx = 0;                     // Index of the agent
+    Element inventory = Element::kAgent;        // Key held, kAgent if none
+    uint64_t remaining = 0;                     // Bit i set if the i-th single key/lock of the level start remains
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator==(const PackedStateKey &other) const noexcept -> bool {
+        return agent_idx == other.agent_idx && inventory == other.inventory && remaining == other.remaining;
+    }
+    auto operator!=(const PackedStateKey &other) const noexcept -> bool {
+        return !(*this == other);
+    }
+};
+
+// Memory layout of observations
+enum class ObservationLayout {
+    kCHW,    // Channels first, each channel a contiguous plane
+    kHWC,    // Channels last, the channels of each cell contiguous
+};
+
+// Options for the channels and layout of observations, see BoxWorldGameState::get_observation()
+struct ObservationConfig {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    ObservationLayout layout = ObservationLayout::kCHW;    // Memory layout of the observation
+    bool inventory_planes = true;                          // Flag to broadcast the inventory into kNumColours planes
+    std::vector<Element> board_channels{};                 // Board elements kept as channels in order, empty for all
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    /**
+     * Get the number of channels of the observation
+     * @return Board channels, plus kNumColours if the inventory planes are kept
+     */
+    [[nodiscard]] auto num_channels() const noexcept -> std::size_t {
+        const auto num_board = board_channels.empty() ? kNumElements - 1 : board_channels.size();
+        return num_board + (inventory_planes ? kNumColours : 0);
+    }
+};
+
+// Fixed capacity copy of the local state, trivially copyable so it can be cloned with memcpy into arena memory.
+// Snapshots are only restorable into states of the same level.
+struct StateSnapshot {
+    // Most board cells a snapshot can hold (32x32 boards)
+    static constexpr std::size_t kMaxCells = 1024;
+    // Most single keys and most locks a snapshot can hold
+    static constexpr std::size_t kMaxTargets = 64;
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t zorb_hash = 0;                             // Hash of the state
+#ifdef BOXWORLD_HASH128
+    uint64_t zorb_hash_high = 0;                        // High half of the 128-bit hash of the state
+#endif
+    uint64_t reward_signal_index = 0;                   // Reward signal of the last action
+    uint64_t reward_signal_colour = 0;                  // Reward signal of the last action
+    uint16_t agent_idx = 0;                             // Index of the agent
+    uint16_t num_cells = 0;                             // Number of valid entries in board
+    uint16_t num_keys = 0;                              // Number of valid entries in key_indices
+    uint16_t num_locks = 0;                             // Number of valid entries in lock_indices
+    Element inventory = Element::kAgent;                // Key held, kAgent if none
+    std::array<uint16_t, kMaxTargets> key_indices{};    // Sorted indices of the single keys
+    std::array<uint16_t, kMaxTargets> lock_indices{};   // Sorted indices of the locks
+    std::array<Element, kMaxCells> board{};             // Board elements
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Cache of BFS distance maps to the targets of a state, valid while no key or lock is removed.
+// The cache is not copied along with the state, so copies never share or duplicate the maps.
+class DistanceMapCache {
+public:
+    DistanceMapCache() = default;
+    ~DistanceMapCache() = default;
+    DistanceMapCache(const DistanceMapCache &) noexcept {}
+    DistanceMapCache(DistanceMapCache &&) noexcept = default;
+    auto operator=(const DistanceMapCache &other) noexcept -> DistanceMapCache & {
+        if (this != &other) {
+            clear();
+        }
+        return *this;
+    }
+    auto operator=(DistanceMapCache &&) noexcept -> DistanceMapCache & = default;
+
+    void clear() noexcept {
+        maps.clear();
+    }
+
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    FlatIndexSet key_indices;                                       // Single keys the maps were built for
+    FlatIndexSet lock_indices;                                      // Locks the maps were built for
+    std::unordered_map<std::size_t, std::vector<uint16_t>> maps;    // Distance map of each target index
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Cache of the observation of a state, valid while the state version is unchanged.
+// The cache is not copied along with the state, so copies never share or duplicate the buffer.
+class ObservationCache {
+public:
+    ObservationCache() = default;
+    ~ObservationCache() = default;
+    ObservationCache(const ObservationCache &) noexcept {}
+    ObservationCache(ObservationCache &&) noexcept = default;
+    auto operator=(const ObservationCache &other) noexcept -> ObservationCache & {
+        if (this != &other) {
+            is_valid = false;
+        }
+        return *this;
+    }
+    auto operator=(ObservationCache &&) noexcept -> ObservationCache & = default;
+
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::vector<float> obs;    // Observation of the state at version
+    uint64_t version = 0;      // Version of the state the observation was built for
+    bool is_valid = false;     // Flag if obs has been built
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Memory held by a state, see BoxWorldGameState::memory_usage()
+struct StateMemoryUsage {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::size_t local_bytes = 0;     // The state object, its local state and caches
+    std::size_t shared_bytes = 0;    // The shared level info, held once by every state of the level
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
 };
 
+// New colour of each key colour kColour0..kColour11, for BoxWorldGameState::permute_colours()
+using ColourPermutation = std::array<Element, kNumColours - 1>;
+
 class BoxWorldGameState {
 public:
     BoxWorldGameState() = delete;
     BoxWorldGameState(const GameParameters &params);
 
+    /**
+     * Construct from a parsed or generated level, without going through a board string.
+     * @param level The starting board
+     * @param collect_first_key Flag to collect the first key from the start
+     */
+    BoxWorldGameState(const Level &level, bool collect_first_key = false);
+
     /**
      * Construct from byte serialization.
      * @note this is not safe, only for internal use.
      */
     BoxWorldGameState(const std::vector<uint8_t> &byte_data);
 
+    /**
+     * Compare the board, agent, and inventory of two states of the same board size.
+     * @note The hashes are compared first, so unequal states are almost always rejected without comparing boards.
+     * Equal states of different levels compare equal, see is_same_level()
+     */
     bool operator==(const BoxWorldGameState &other) const noexcept;
     bool operator!=(const BoxWorldGameState &other) const noexcept;
 
+    /**
+     * Check if two states belong to the same level, see get_level_id().
+     * @param other The state to compare against
+     * @return True if both states share the level or their levels have the same id
+     */
+    [[nodiscard]] auto is_same_level(const BoxWorldGameState &other) const noexcept -> bool;
+
     /**
      * Reset the environment to the state as given by the GameParameters
      */
     void reset();
 
+    /**
+     * Reset the environment to the given level, keeping the collect_first_key setting.
+     * @param level The starting board
+     */
+    void reset(Level level);
+
+    /**
+     * Reset the environment to a new level generated in place from the given seed.
+     * @param seed Seed of the level
+     * @param config Parameters of the generated level
+     */
+    void reset(uint64_t seed, const GeneratorConfig &config);
+
+    /**
+     * Reset the environment to a level of the pack, using its precomputed agent and key/lock indices.
+     * @param pack The level pack
+     * @param index Index of the level in the pack
+     */
+    void reset(const LevelPack &pack, std::size_t index);
+
+    /**
+     * Reset the environment to the state of the current level with the given packed key, rebuilt from the level
+     * start without replaying actions. The reward signals are cleared, as the key does not hold them.
+     * @param key Packed key of a state of this level, see packed_key()
+     */
+    void reset(const PackedStateKey &key);
+
     /**
      * Serialize the state
      * @return char vector representing state
      */
     [[nodiscard]] auto serialize() const -> std::vector<uint8_t>;
 
+    /**
+     * Get an upper bound on the number of bytes serialize_into() writes for the current state
+     * @return serialized size in bytes
+     */
+    [[nodiscard]] auto serialized_size() const noexcept -> std::size_t;
+
+    /**
+     * Serialize the state directly into the given buffer.
+     * @note Use when writing into pre-allocated memory, such as a ring buffer
+     * @param buffer Start of the buffer to write into
+     * @param capacity Size of the buffer in bytes, should be at least serialized_size()
+     * @return Number of bytes written
+     */
+    auto serialize_into(uint8_t *buffer, std::size_t capacity) const -> std::size_t;
+
+    /**
+     * Replace the current state with the one serialized in the given bytes.
+     * @note this is not safe, only for internal use.
+     * @param data Start of the serialized bytes
+     * @param size Number of serialized bytes
+     */
+    void deserialize_from(const uint8_t *data, std::size_t size);
+
+    /**
+     * Serialize only the local state and the level id, which is much smaller than serialize().
+     * The level is registered in the LevelRegistry on the first call, so this process can deserialize the state.
+     * @note The level must be registered in the LevelRegistry of the process which deserializes the state.
+     * Throws std::runtime_error if a different level with the same id is registered
+     * @return char vector representing state
+     */
+    [[nodiscard]] auto serialize_local() const -> std::vector<uint8_t>;
+
+    /**
+     * Get an upper bound on the number of bytes serialize_local_into() writes for the current state
+     * @return serialized size in bytes
+     */
+    [[nodiscard]] auto serialized_local_size() const noexcept -> std::size_t;
+
+    /**
+     * Serialize only the local state and the level id directly into the given buffer, see serialize_local().
+     * @param buffer Start of the buffer to write into
+     * @param capacity Size of the buffer in bytes, should be at least serialized_local_size()
+     * @return Number of bytes written
+     */
+    auto serialize_local_into(uint8_t *buffer, std::size_t capacity) const -> std::size_t;
+
+    /**
+     * Replace the current state with the one serialized by serialize_local(), sharing the registered level.
+     * @note Throws if the level of the serialized state is not registered
+     * @param data Start of the serialized bytes
+     * @param size Number of serialized bytes
+     */
+    void deserialize_local_from(const uint8_t *data, std::size_t size);
+
+    /**
+     * Serialize the state storing only the non-empty cells of the starting and current boards, see
+     * encode_sparse_level(), which is several times smaller than serialize() and needs no registered level.
+     * @return char vector representing state
+     */
+    [[nodiscard]] auto serialize_sparse() const -> std::vector<uint8_t>;
+
+    /**
+     * Get the number of bytes serialize_sparse_into() writes for the current state
+     * @return serialized size in bytes
+     */
+    [[nodiscard]] auto serialized_sparse_size() const noexcept -> std::size_t;
+
+    /**
+     * Serialize the state sparsely directly into the given buffer.
+     * @note Throws std::invalid_argument if the buffer is too small
+     * @param buffer Start of the buffer to write into
+     * @param capacity Size of the buffer in bytes, should be at least serialized_sparse_size()
+     * @return Number of bytes written
+     */
+    auto serialize_sparse_into(uint8_t *buffer, std::size_t capacity) const -> std::size_t;
+
+    /**
+     * Replace the current state with the one serialized by serialize_sparse().
+     * @note Throws std::invalid_argument if the bytes are malformed
+     * @param data Start of the serialized bytes
+     * @param size Number of serialized bytes
+     */
+    void deserialize_sparse_from(const uint8_t *data, std::size_t size);
+
+    /**
+     * Get the identifier of the level this state belongs to, see LevelRegistry.
+     * @return level id
+     */
+    [[nodiscard]] auto get_level_id() const noexcept -> uint64_t;
+
+    /**
+     * Get the key-lock graph of the starting board of the level, shared by every state of the level.
+     * @note Describes the level as it starts, so includes keys and locks this state has already removed
+     * @return Read only reference to the graph
+     */
+    [[nodiscard]] auto get_key_lock_graph() const noexcept -> const KeyLockGraph &;
+
+    /**
+     * Hold the level by a non-owning pointer into the LevelRegistry, so copies of this state do no atomic
+     * reference counting. The level is registered if it is not already. The state owns its level again after
+     * resetting to a different level.
+     * @note Throws std::runtime_error if a different level with the same id is registered
+     * @note The level must not be removed from the registry while any borrowing state is alive
+     */
+    void borrow_level();
+
+    /**
+     * Check if the level is held by a non-owning pointer, see borrow_level().
+     * @return True if the level is borrowed from the LevelRegistry, false if owned
+     */
+    [[nodiscard]] auto is_level_borrowed() const noexcept -> bool;
+
+    /**
+     * Get the memory held by the state, with the part shared with other states of the level reported separately.
+     * Vectors are counted by their capacity, and the distance map cache by an estimate of its buckets and nodes.
+     * @note The shared part is held once by every state of the level, and by the LevelRegistry if registered, so
+     * sizing many states of a level adds their local parts to a single shared part
+     * @return Bytes of the local and shared parts of the state
+     */
+    [[nodiscard]] auto memory_usage() const noexcept -> StateMemoryUsage;
+
     /**
      * Check if the given element is valid.
      * @param element Element to check
      * @return True if element is valid, false otherwise
      */
     [[nodiscard]] constexpr static auto is_valid_element(Element element) -> bool {
-        return static_cast<int>(element) >= 0 && static_cast<int>(element) < static_cast<int>(kNumElements);
+        return static_cast<std::underlying_type_t<Element>>(element) < kNumElements;
     }
 
     /**
@@ -132,12 +527,99 @@ public:
      */
     void apply_action(Action action) noexcept;
 
+    /**
+     * Apply the action to the current state, and record the changes so the action can be undone.
+     * @note Use for tree search which walks a single state in place instead of copying states
+     * @param action The action to apply, should be one of the legal actions
+     * @return Record of the changes made, to be passed to undo_action()
+     */
+    [[nodiscard]] auto apply_action_with_undo(Action action) noexcept -> UndoRecord;
+
+    /**
+     * Undo a previously applied action, restoring the state before it was applied.
+     * @note Actions must be undone in the reverse order they were applied
+     * @param record The record returned by apply_action_with_undo()
+     */
+    void undo_action(const UndoRecord &record) noexcept;
+
+    /**
+     * Take a trivially copyable snapshot of the local state.
+     * @note Throws std::invalid_argument if the board or its keys/locks exceed the StateSnapshot capacity
+     * @return The snapshot
+     */
+    [[nodiscard]] auto snapshot() const -> StateSnapshot;
+
+    /**
+     * Write a trivially copyable snapshot of the local state into the given snapshot, such as one in arena memory.
+     * @note Throws std::invalid_argument if the board or its keys/locks exceed the StateSnapshot capacity
+     * @param snapshot The snapshot to write into
+     */
+    void snapshot(StateSnapshot &snapshot) const;
+
+    /**
+     * Restore the local state from a snapshot taken of a state of the same level.
+     * @note Throws std::invalid_argument if the snapshot board size does not match the level
+     * @param snapshot The snapshot to restore
+     */
+    void restore(const StateSnapshot &snapshot);
+
+    /**
+     * Get the number of actions needed to step into the target from each cell, moving only through empty cells.
+     * The map is cached until a key or lock is removed, as agent moves alone do not change it.
+     * @note Throws std::invalid_argument if target_index is not a single key or lock, see get_target_indices()
+     * The reference is valid until a key or lock is removed or restored, the level changes, or the state is assigned
+     * to or destroyed. Not thread safe, as the first call for a target builds its map
+     * @param target_index Board index of the single key or lock
+     * @return Distance from each board index, or kUnreachable for cells which cannot reach the target
+     */
+    [[nodiscard]] auto get_distance_map(std::size_t target_index) const -> const std::vector<uint16_t> &;
+
+    /**
+     * Get the shortest sequence of actions which walks the agent into the target.
+     * @note Throws std::invalid_argument if target_index is not a single key or lock, see get_target_indices()
+     * @param target_index Board index of the single key or lock
+     * @return The actions, or empty if the target cannot be reached
+     */
+    [[nodiscard]] auto get_macro_path(std::size_t target_index) const -> std::vector<Action>;
+
+    /**
+     * Walk the agent along a shortest path into the target, collecting the key or opening the lock if the matching
+     * key is held. The reward signal is that of the final action.
+     * @note Throws std::invalid_argument if target_index is not a single key or lock, see get_target_indices()
+     * @param target_index Board index of the single key or lock
+     * @return Number of actions applied, 0 if the target cannot be reached
+     */
+    auto apply_macro_action(std::size_t target_index) -> std::size_t;
+
+    // Distance of cells which cannot reach a target
+    static constexpr uint16_t kUnreachable = std::numeric_limits<uint16_t>::max();
+
     /**
      * Check if the state is in the solution state (agent inside exit).
      * @return True if terminal, false otherwise
      */
     [[nodiscard]] auto is_solution() const noexcept -> bool;
 
+    /**
+     * Check if the state can no longer be solved, as no chain of the remaining single keys and locks reaches the
+     * goal from the held key.
+     * @note Found from the colours each remaining lock opens in the key-lock graph of the level. Holding one key at a
+     * time is relaxed, so a dead end is never solvable but a state which is not a dead end may still be unsolvable.
+     * Not thread safe, as it fills the cache of get_remaining_chain_length()
+     * @return True if the goal can no longer be reached, false otherwise
+     */
+    [[nodiscard]] auto is_dead_end() const noexcept -> bool;
+
+    /**
+     * Get the fewest keys to collect and locks to open before holding kColourGoal, following the remaining chain of
+     * boxes from the held key and single keys.
+     * @note Admissible, as each collect or open takes at least one action. The length is cached against the hash of
+     * the state without the agent, so it is only recomputed after a key is collected or a lock opened. Not thread
+     * safe, as a call after a change fills the cache
+     * @return Remaining chain length, 0 if solved, or kDeadEnd if no chain reaches the goal
+     */
+    [[nodiscard]] auto get_remaining_chain_length() const noexcept -> std::size_t;
+
     /**
      * Get the legal actions which can be applied in the state.
      * @return vector containing each actions available
@@ -151,6 +633,34 @@ public:
      */
     void legal_actions(std::vector<Action> &actions) const noexcept;
 
+    /**
+     * Get the legal actions which change the state, dropping moves out of bounds, into walls of boxes, and into
+     * locks without the matching key.
+     * @return vector containing each action which changes the state
+     */
+    [[nodiscard]] auto productive_actions() const noexcept -> std::vector<Action>;
+
+    /**
+     * Get the legal actions which change the state, and store in the given vector.
+     * @note Use when wanting to reuse a pre-allocated vector
+     * @param actions The vector to store the productive actions in
+     */
+    void productive_actions(std::vector<Action> &actions) const noexcept;
+
+    /**
+     * Get the productive actions as a bitmask, usable directly as an action mask.
+     * @return Mask with bit a set if Action a changes the state
+     */
+    [[nodiscard]] auto productive_actions_mask() const noexcept -> uint8_t;
+
+    /**
+     * Get the hash of the state each action leads to, without applying the actions.
+     * @note Use to skip copying children which are already known, as the hashes match get_hash() of the children
+     * @param out Hash of the child of each Action, the current hash for actions which do not change the state
+     * @param valid_mask Set to productive_actions_mask(), bit a is set if out[a] is the hash of a new state
+     */
+    void successor_hashes(std::array<uint64_t, kNumActions> &out, uint8_t &valid_mask) const noexcept;
+
     /**
      * Get the number of possible actions
      * @return Count of possible actions
@@ -171,6 +681,14 @@ public:
      */
     [[nodiscard]] auto observation_shape_environment() const noexcept -> std::array<std::size_t, 3>;
 
+    /**
+     * Get the shape the observations with the given config should be viewed as.
+     * @param config Channels and layout of the observation
+     * @return array indicating observation CHW, or HWC for ObservationLayout::kHWC
+     */
+    [[nodiscard]] auto observation_shape(const ObservationConfig &config) const noexcept
+        -> std::array<std::size_t, 3>;
+
     /**
      * Get a flat representation of the current state observation.
      * The observation should be viewed as the shape given by observation_shape().
@@ -187,6 +705,30 @@ public:
      */
     void get_observation(std::vector<float> &obs) const noexcept;
 
+    /**
+     * Write a flat representation of the current state observation into the given buffer.
+     * @note Use when writing into externally owned memory, such as a batched tensor
+     * The buffer must hold at least kNumChannels * rows * cols values, and is viewed as observation_shape().
+     * @param obs Pointer to the start of the buffer to write into
+     */
+    void get_observation(float *obs) const noexcept;
+
+    /**
+     * Get the observation of get_observation(), built on the first call after the state changes and otherwise
+     * returned from a cache, for consumers which read the observation of the same state several times.
+     * @note The reference is valid until the state is next changed, assigned to, or destroyed. Not thread safe, as
+     * the first call builds the cache
+     * @return Reference to the cached observation, viewed as observation_shape()
+     */
+    [[nodiscard]] auto get_cached_observation() const -> const std::vector<float> &;
+
+    /**
+     * Get the version of the state, which every change such as apply_action(), reset(), or set_key() increments.
+     * @note Copies keep the version of the state they are copied from
+     * @return Version counter
+     */
+    [[nodiscard]] auto get_version() const noexcept -> uint64_t;
+
     /**
      * Get a flat representation of the current state observation.
      * The observation should be viewed as the shape given by observation_shape().
@@ -204,6 +746,192 @@ public:
      */
     void get_observation_environment(std::vector<float> &obs) const noexcept;
 
+    /**
+     * Write a flat representation of the current state observation without the goal or inventory into the given
+     * buffer.
+     * The buffer must hold at least (kNumElements - 1) * rows * cols values, and is viewed as
+     * observation_shape_environment().
+     * @param obs Pointer to the start of the buffer to write into
+     */
+    void get_observation_environment(float *obs) const noexcept;
+
+    /**
+     * Write the current state observation with the given channels and layout into the given buffer.
+     * Board channels are 1 where the cell holds the element, and inventory planes are all 1 for the held key.
+     * @note Throws std::invalid_argument if a board channel is kEmpty or not an element
+     * @param config Channels and layout of the observation
+     * @param obs Pointer to the start of the buffer of observation_shape(config) values to write into
+     * @param inventory Pointer to kNumColours values to write the one-hot inventory into, or nullptr to skip
+     */
+    void get_observation(const ObservationConfig &config, float *obs, float *inventory = nullptr) const;
+
+    /**
+     * Write the held key as a one-hot vector, all 0 if no key is held.
+     * @param inventory Pointer to the start of the buffer of kNumColours values to write into
+     */
+    void get_inventory_one_hot(float *inventory) const noexcept;
+
+    /**
+     * Get the current state observation as uint8 one-hot planes, viewed as observation_shape().
+     * @return vector where 1 represents object at position
+     */
+    [[nodiscard]] auto get_observation_uint8() const noexcept -> std::vector<uint8_t>;
+
+    /**
+     * Write the current state observation as uint8 one-hot planes into the given buffer.
+     * The buffer must hold at least kNumChannels * rows * cols values, and is viewed as observation_shape().
+     * @param obs Pointer to the start of the buffer to write into
+     */
+    void get_observation_uint8(uint8_t *obs) const noexcept;
+
+    /**
+     * Get the number of bytes of the bit-packed observation.
+     * @return Size of the bit-packed observation in bytes
+     */
+    [[nodiscard]] auto observation_packed_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the current state observation with each value of get_observation() packed into a single bit.
+     * Bit i (least significant first in each byte) is value i of the flat observation, padded with 0 to whole bytes.
+     * @return vector of observation_packed_size() bytes
+     */
+    [[nodiscard]] auto get_observation_packed() const noexcept -> std::vector<uint8_t>;
+
+    /**
+     * Write the bit-packed current state observation into the given buffer, see get_observation_packed().
+     * @param obs Pointer to the start of the buffer of observation_packed_size() bytes to write into
+     */
+    void get_observation_packed(uint8_t *obs) const noexcept;
+
+    /**
+     * Get the number of bytes of the element index observation.
+     * @return rows * cols + 1
+     */
+    [[nodiscard]] auto observation_index_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the current state observation as the element index of each cell, followed by the inventory element.
+     * The first rows * cols values are viewed as (rows, cols), the inventory is kAgent if no key is held.
+     * @return vector of observation_index_size() element indices
+     */
+    [[nodiscard]] auto get_observation_index() const noexcept -> std::vector<uint8_t>;
+
+    /**
+     * Write the element index observation into the given buffer, see get_observation_index().
+     * @param obs Pointer to the start of the buffer of observation_index_size() bytes to write into
+     */
+    void get_observation_index(uint8_t *obs) const noexcept;
+
+    /**
+     * Get the most entities the entity observation can hold.
+     * @return rows * cols + 1
+     */
+    [[nodiscard]] auto observation_entities_max_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the current state observation as a list of entities, each a (row, col, element) triple.
+     * The first entity is the inventory, at (kInventoryEntityPos, kInventoryEntityPos) with element kAgent if no key
+     * is held, followed by each non-empty cell in board order.
+     * @return vector of 3 values per entity
+     */
+    [[nodiscard]] auto get_observation_entities() const noexcept -> std::vector<uint16_t>;
+
+    /**
+     * Write the entity observation into the given buffer, see get_observation_entities().
+     * @param entities Pointer to the start of the buffer of 3 * max_entities values to write into
+     * @param max_entities Capacity of the buffer in entities, entities past the capacity are not written
+     * @return Number of entities in the observation, which may be more than max_entities
+     */
+    auto get_observation_entities(uint16_t *entities, std::size_t max_entities) const noexcept -> std::size_t;
+
+    // Values per entity of the entity observation (row, col, element)
+    static constexpr std::size_t kEntitySize = 3;
+    // Row and col of the inventory entity
+    static constexpr uint16_t kInventoryEntityPos = std::numeric_limits<uint16_t>::max();
+
+    /**
+     * Write the observations of a batch of states into a contiguous [n, kNumChannels, rows, cols] buffer.
+     * @note All states must have the same board dimensions
+     * @param states Pointer to the first of n states
+     * @param n Number of states
+     * @param out Buffer of n * observation size values to write into
+     * @param num_threads Number of threads to split the batch over, 0 to use the hardware concurrency
+     */
+    static void write_observations(const BoxWorldGameState *states, std::size_t n, float *out,
+                                   std::size_t num_threads = 1);
+
+    /**
+     * Write the observations without the goal or inventory of a batch of states into a contiguous
+     * [n, kNumElements - 1, rows, cols] buffer.
+     * @note All states must have the same board dimensions
+     * @param states Pointer to the first of n states
+     * @param n Number of states
+     * @param out Buffer of n * environment observation size values to write into
+     * @param num_threads Number of threads to split the batch over, 0 to use the hardware concurrency
+     */
+    static void write_observations_environment(const BoxWorldGameState *states, std::size_t n, float *out,
+                                               std::size_t num_threads = 1);
+
+    /**
+     * Construct a state at the start of each level, split over threads.
+     * States of equal levels share the parsed level as if constructed one at a time, and the Zobrist tables are
+     * shared per board size.
+     * @note Throws std::invalid_argument if a level is invalid
+     * @param levels Pointer to the first of n levels
+     * @param n Number of levels
+     * @param collect_first_key Flag to start each state with the single key in the inventory
+     * @param num_threads Number of threads to construct with, 0 to use the hardware concurrency
+     * @return The states in order of the levels, stored contiguously
+     */
+    [[nodiscard]] static auto make_states(const Level *levels, std::size_t n, bool collect_first_key = false,
+                                          std::size_t num_threads = 0) -> std::vector<BoxWorldGameState>;
+
+    /**
+     * Parse and construct a state at the start of each board string, split over threads.
+     * @note Throws std::invalid_argument if a board string or level is invalid
+     * @param board_strs Board strings in the format of the game_board_str parameter
+     * @param collect_first_key Flag to start each state with the single key in the inventory
+     * @param num_threads Number of threads to parse and construct with, 0 to use the hardware concurrency
+     * @return The states in order of the board strings, stored contiguously
+     */
+    [[nodiscard]] static auto make_states(const std::vector<std::string> &board_strs, bool collect_first_key = false,
+                                          std::size_t num_threads = 0) -> std::vector<BoxWorldGameState>;
+
+    /**
+     * Construct a state at the start of every level of a pack, split over threads.
+     * @param pack The levels to start
+     * @param collect_first_key Flag to start each state with the single key in the inventory
+     * @param num_threads Number of threads to construct with, 0 to use the hardware concurrency
+     * @return The states in order of the pack, stored contiguously
+     */
+    [[nodiscard]] static auto make_states(const LevelPack &pack, bool collect_first_key = false,
+                                          std::size_t num_threads = 0) -> std::vector<BoxWorldGameState>;
+
+    /**
+     * Relabel the key colours of a batch of observations in place, see permute_colours().
+     * Both the board and inventory planes of each colour are moved, the goal, agent, and empty planes are kept.
+     * @note Throws std::invalid_argument if the permutation is not a permutation of kColour0..kColour11
+     * @param obs Buffer of n observations of shape [kNumChannels, rows, cols], as written by write_observations()
+     * @param n Number of observations
+     * @param rows Rows of the boards
+     * @param cols Cols of the boards
+     * @param permutation New colour of each key colour
+     * @param num_threads Number of threads to split the batch over, 0 to use the hardware concurrency
+     */
+    static void permute_observation_colours(float *obs, std::size_t n, std::size_t rows, std::size_t cols,
+                                            const ColourPermutation &permutation, std::size_t num_threads = 1);
+
+    /**
+     * Mirror the rows of a batch of observations in place, see flip_vertical().
+     * @param obs Buffer of n observations of shape [kNumChannels, rows, cols], as written by write_observations()
+     * @param n Number of observations
+     * @param rows Rows of the boards
+     * @param cols Cols of the boards
+     * @param num_threads Number of threads to split the batch over, 0 to use the hardware concurrency
+     */
+    static void flip_observation_vertical(float *obs, std::size_t n, std::size_t rows, std::size_t cols,
+                                          std::size_t num_threads = 1);
+
     /**
      * Get the shape the image should be viewed as.
      * @return array indicating observation HWC
@@ -216,6 +944,32 @@ public:
      */
     [[nodiscard]] auto to_image() const noexcept -> std::vector<uint8_t>;
 
+    /**
+     * Write the flat (HWC) image representation of the current state into the given buffer.
+     * @note Use when writing into a pre-allocated buffer, such as a video frame
+     * @param img Pointer to the start of a buffer of image_shape() bytes to write into
+     */
+    void to_image(uint8_t *img) const noexcept;
+
+    /**
+     * Get the shape the indexed image should be viewed as.
+     * @return array indicating image HWC, with a single channel
+     */
+    [[nodiscard]] auto indexed_image_shape() const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Get the flat (HW) image of the current state with one palette index per pixel, a third the size of to_image().
+     * @note See get_palette() for the colour of each index, ImageRenderer(1) renders one index per cell
+     * @return flattened byte vector of palette indices (HW)
+     */
+    [[nodiscard]] auto to_indexed_image() const noexcept -> std::vector<uint8_t>;
+
+    /**
+     * Write the flat (HW) indexed image of the current state into the given buffer.
+     * @param img Pointer to the start of a buffer of indexed_image_shape() bytes to write into
+     */
+    void to_indexed_image(uint8_t *img) const noexcept;
+
     /**
      * Get the current reward signal as a result of the previous action taken.
      * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
@@ -229,6 +983,32 @@ public:
      */
     [[nodiscard]] auto get_hash() const noexcept -> uint64_t;
 
+#ifdef BOXWORLD_HASH128
+    /**
+     * Get the 128-bit hash of the current state, maintained alongside get_hash() as its low half.
+     * @note Only available when built with the BOXWORLD_HASH128 CMake option
+     * @return hash value
+     */
+    [[nodiscard]] auto get_hash128() const noexcept -> Hash128;
+#endif
+
+    /**
+     * Get the compact key of the state, holding only the agent, inventory, and which of the single keys and locks
+     * of the level start remain, in the order of their indices.
+     * Unlike get_hash(), equal keys imply equal states of the same level.
+     * @note Throws std::invalid_argument if the level has more than PackedStateKey::kMaxTargets single keys and locks
+     * @return The packed key
+     */
+    [[nodiscard]] auto packed_key() const -> PackedStateKey;
+
+    /**
+     * Write the observation of the state of this level with the given packed key, as get_observation() of that
+     * state would, decoded from the level start without building the state.
+     * @param key Packed key of a state of this level, see packed_key()
+     * @param obs Buffer of the observation size to write into, viewed as observation_shape()
+     */
+    void decode_observation(const PackedStateKey &key, float *obs) const noexcept;
+
     /**
      * Get the agent index position, even if in exit
      * @return Agent index
@@ -269,41 +1049,157 @@ public:
      */
     [[nodiscard]] auto get_target_indices() const noexcept -> std::vector<std::size_t>;
 
+    /**
+     * Get the indices of the single keys
+     * @return sorted flat indices of each single key
+     */
+    [[nodiscard]] auto get_key_indices() const noexcept -> const FlatIndexSet &;
+
+    /**
+     * Get the indices of the locks
+     * @return sorted flat indices of each lock
+     */
+    [[nodiscard]] auto get_lock_indices() const noexcept -> const FlatIndexSet &;
+
     /**
      * Check if key is being held in inventory
      * @return True if holding key of any colour, false otherwise
      */
     [[nodiscard]] auto has_key() const noexcept -> bool;
 
+    /**
+     * Get the current key in the inventory
+     * @return Element of the key held, or kAgent if no key is held
+     */
+    [[nodiscard]] auto get_inventory() const noexcept -> Element;
+
     /**
      * Set the current key in the inventory
      */
     void set_key(Element element);
 
+    /**
+     * Relabel the key colours of the level and the current state in place, as if the level had been built with
+     * the permuted colours. The rules do not depend on which colour is which, so the result plays the same.
+     * The hash, key/lock graph, and reward colour signal are updated without reparsing, and reset() starts the
+     * permuted level.
+     * @note Throws std::invalid_argument if the permutation is not a permutation of kColour0..kColour11
+     * @param permutation New colour of each key colour, the goal keeps its colour
+     */
+    void permute_colours(const ColourPermutation &permutation);
+
+    /**
+     * Mirror the rows of the level and the current state in place, so row r becomes row rows - 1 - r.
+     * Columns are kept, so every key stays left of its lock and the result plays the same.
+     * The hash, key/lock indices, and reward index signal are updated without reparsing, and reset() starts the
+     * flipped level.
+     */
+    void flip_vertical();
+
     // All possible actions
     static const std::vector<Action> ALL_ACTIONS;
 
     friend auto operator<<(std::ostream &os, const BoxWorldGameState &state) -> std::ostream &;
+    friend class ImageRenderer;
+    friend class BoxWorldSolver;
 
 private:
-    void ParseBoard();
     void InitKeyLockIndices() noexcept;
     [[nodiscard]] auto GetItem(std::size_t index, Action action) const noexcept -> const Element &;
     [[nodiscard]] auto IsAgent(std::size_t index, Action action) const noexcept -> bool;
     [[nodiscard]] auto IsEmpty(std::size_t index, Action action) const noexcept -> bool;
     [[nodiscard]] auto IndexFromAction(std::size_t index, Action action) const noexcept -> std::size_t;
     [[nodiscard]] auto InBounds(std::size_t index, Action action) const noexcept -> bool;
-    void MoveAgent(Action action) noexcept;
+    [[nodiscard]] auto IsProductive(Action action) const noexcept -> bool;
+    void ApplyAction(Action action, UndoRecord *record) noexcept;
+    void RecordCell(UndoRecord *record, std::size_t index) const noexcept;
+    void MoveAgent(Action action, UndoRecord *record) noexcept;
     [[nodiscard]] auto HasKey(std::size_t index) const noexcept -> bool;
-    void AddToInventory(std::size_t index) noexcept;
+    void AddToInventory(std::size_t index, UndoRecord *record) noexcept;
     void RemoveFromInventory() noexcept;
-    void RemoveLock(std::size_t index) noexcept;
-    void InitZrbhtTable() noexcept;
+    void RemoveLock(std::size_t index, UndoRecord *record) noexcept;
+    void XorCellHash(Element element, std::size_t index) noexcept;
+    void XorInventoryHash(Element element) noexcept;
+    void XorCellHash(LocalState &state, Element element, std::size_t index) const noexcept;
+    void XorInventoryHash(LocalState &state, Element element) const noexcept;
+    void PermuteColours(LocalState &state, const std::array<Element, kNumElements> &mapping,
+                        Element start_inventory) const noexcept;
+    void FlipVertical(LocalState &state) const noexcept;
+    void InitZrbhtTable();
+    void AttachLevel(SharedStateInfo info);
+    void RegisterLevel() const;
+    void DetachLevel();
+    void InitLevelTemplate();
+    void InitLevelBoard();
+    void InitLevelHash();
+    void InitNeighbourTable();
+    void ComputeDistanceMap(std::size_t target_index, std::vector<uint16_t> &distances) const;
+    [[nodiscard]] auto ComputeChainLength() const noexcept -> std::size_t;
+    [[nodiscard]] auto ChainLengthKey() const noexcept -> uint64_t;
 
     std::shared_ptr<SharedStateInfo> shared_state;
     LocalState local_state;
+    uint64_t version = 0;                               // Incremented by every change of the local state
+    mutable DistanceMapCache distance_cache;
+    mutable ObservationCache observation_cache;
+    mutable uint64_t chain_length_key = 0;              // Agent free hash chain_length was computed for
+    mutable std::size_t chain_length = kDeadEnd;        // Cached get_remaining_chain_length()
+    mutable bool has_chain_length = false;              // Flag if chain_length has been computed
+};
+
+// Hash of a state used as a heterogeneous lookup key, to find a state in a hash container by its hash alone
+struct StateHashKey {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t hash = 0;    // BoxWorldGameState::get_hash() of the state to find
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Transparent hasher of states and StateHashKey, for containers which support heterogeneous lookup
+struct StateHash {
+    using is_transparent = void;
+    auto operator()(const BoxWorldGameState &state) const noexcept -> std::size_t {
+        return static_cast<std::size_t>(state.get_hash());
+    }
+    auto operator()(const StateHashKey &key) const noexcept -> std::size_t {
+        return static_cast<std::size_t>(key.hash);
+    }
+};
+
+// Transparent equality of states, where lookups by StateHashKey trust the hash
+struct StateEqual {
+    using is_transparent = void;
+    auto operator()(const BoxWorldGameState &lhs, const BoxWorldGameState &rhs) const noexcept -> bool {
+        return lhs == rhs;
+    }
+    auto operator()(const StateHashKey &lhs, const BoxWorldGameState &rhs) const noexcept -> bool {
+        return lhs.hash == rhs.get_hash();
+    }
+    auto operator()(const BoxWorldGameState &lhs, const StateHashKey &rhs) const noexcept -> bool {
+        return lhs.get_hash() == rhs.hash;
+    }
 };
 
 }    // namespace boxworld
 
+namespace std {
+template <>
+struct hash<boxworld::BoxWorldGameState> {
+    auto operator()(const boxworld::BoxWorldGameState &state) const noexcept -> std::size_t {
+        return boxworld::StateHash{}(state);
+    }
+};
+
+template <>
+struct hash<boxworld::PackedStateKey> {
+    auto operator()(const boxworld::PackedStateKey &key) const noexcept -> std::size_t {
+        // Mix so keys differing only in the agent or inventory spread over buckets
+        uint64_t hash = key.remaining ^ (static_cast<uint64_t>(key.agent_idx) << 48) ^
+                        (static_cast<uint64_t>(key.inventory) << 40);
+        hash = (hash ^ (hash >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        hash = (hash ^ (hash >> 27U)) * 0x94d049bb133111ebULL;
+        return static_cast<std::size_t>(hash ^ (hash >> 31U));
+    }
+};
+}    // namespace std
+
 #endif    // BOXWORLD_BASE_H_
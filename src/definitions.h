@@ -5,7 +5,7 @@
 
 namespace boxworld {
 
-enum class Element {
+enum class Element : uint8_t {
     kColour0 = 0,
     kColour1,
     kColour2,
@@ -0,0 +1,47 @@
+#include "device_rules.h"
+
+#include <stdexcept>
+
+#include "level_pack.h"
+
+namespace boxworld {
+
+auto make_flat_levels(const LevelPack& pack, bool collect_first_key) -> FlatLevels {
+    if (pack.size() == 0) {
+        throw std::invalid_argument("Level pack is empty.");
+    }
+    FlatLevels levels;
+    levels.rows = static_cast<uint32_t>(pack.rows());
+    levels.cols = static_cast<uint32_t>(pack.cols());
+    levels.num_levels = static_cast<uint32_t>(pack.size());
+    const std::size_t cells = pack.rows() * pack.cols();
+    levels.boards.resize(pack.size() * cells);
+    levels.kinds.assign(pack.size() * cells, kCellNone);
+    levels.agent_indices.resize(pack.size());
+    levels.inventories.assign(pack.size(), static_cast<uint8_t>(Element::kAgent));
+    for (std::size_t i = 0; i < pack.size(); ++i) {
+        const auto record = pack.get_record(i);
+        auto* board = levels.boards.data() + i * cells;
+        auto* kinds = levels.kinds.data() + i * cells;
+        for (std::size_t cell = 0; cell < cells; ++cell) {
+            board[cell] = static_cast<uint8_t>(record.board[cell]);
+        }
+        // Same starting state as BoxWorldGameState::reset(pack, index)
+        for (std::size_t k = 0; k < record.num_keys; ++k) {
+            const auto idx = record.key_indices[k];
+            if (collect_first_key) {
+                levels.inventories[i] = board[idx];
+                board[idx] = static_cast<uint8_t>(Element::kEmpty);
+            } else {
+                kinds[idx] = kCellKey;
+            }
+        }
+        for (std::size_t k = 0; k < record.num_locks; ++k) {
+            kinds[record.lock_indices[k]] = kCellLock;
+        }
+        levels.agent_indices[i] = static_cast<uint32_t>(record.agent_idx);
+    }
+    return levels;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,241 @@
+#ifndef BOXWORLD_DEVICE_RULES_H_
+#define BOXWORLD_DEVICE_RULES_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "definitions.h"
+
+// Rules are compiled for both the host and CUDA devices, so the GPU backend and its host tests share one definition
+#if defined(__CUDACC__)
+#define BOXWORLD_HOST_DEVICE __host__ __device__
+#else
+#define BOXWORLD_HOST_DEVICE
+#endif
+
+namespace boxworld {
+
+class LevelPack;
+
+// Role of a cell of a level start, fixed for the episode as keys and locks are only ever removed
+constexpr uint8_t kCellNone = 0;    // Empty, agent, or the key inside a box
+constexpr uint8_t kCellKey = 1;     // Single key
+constexpr uint8_t kCellLock = 2;    // Lock of a box
+
+// View of flattened levels, in host or device memory
+struct FlatLevelsView {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    const uint8_t *boards;            // See FlatLevels
+    const uint8_t *kinds;
+    const uint32_t *agent_indices;
+    const uint8_t *inventories;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t num_levels;
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Levels flattened into contiguous arrays of uint8 cells, ready to be uploaded to a device
+struct FlatLevels {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint32_t rows = 0;                     // Rows of every level
+    uint32_t cols = 0;                     // Cols of every level
+    uint32_t num_levels = 0;               // Number of levels
+    std::vector<uint8_t> boards;           // num_levels * rows * cols starting elements
+    std::vector<uint8_t> kinds;            // num_levels * rows * cols cell roles, kCellNone, kCellKey, or kCellLock
+    std::vector<uint32_t> agent_indices;   // Starting agent index of each level
+    std::vector<uint8_t> inventories;      // Starting inventory of each level, kAgent if no key is held
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    /**
+     * Get a view of the levels in host memory, to run the rules on the host
+     * @return View of the arrays, valid while the levels are unchanged
+     */
+    [[nodiscard]] auto view() const noexcept -> FlatLevelsView {
+        return {boards.data(), kinds.data(), agent_indices.data(), inventories.data(), rows, cols, num_levels};
+    }
+};
+
+/**
+ * Flatten every level of a pack, as BoxWorldGameState::reset(pack, index) would start them.
+ * @note Throws std::invalid_argument if the pack is empty
+ * @param pack The level pack
+ * @param collect_first_key Flag to start with the single key in the inventory
+ * @return The flattened levels
+ */
+[[nodiscard]] auto make_flat_levels(const LevelPack &pack, bool collect_first_key = false) -> FlatLevels;
+
+// View of a batch of environments stored as arrays, in host or device memory
+struct FlatEnvsView {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint8_t *boards;            // num_envs * rows * cols elements
+    uint32_t *agent_indices;    // Agent index of each environment
+    uint8_t *inventories;       // Held key of each environment, kAgent if none
+    uint32_t *levels;           // Level of each environment, indexing the levels view
+    uint32_t *episodes;         // Episodes started by each environment
+    uint32_t num_envs;          // Number of environments
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+/**
+ * Get the level an environment plays for an episode, cycling each environment through the pack in steps of the
+ * batch size so environments start on different levels.
+ * @param env Index of the environment
+ * @param episode Episode of the environment
+ * @param num_envs Number of environments in the batch
+ * @param num_levels Number of levels
+ * @return Index of the level
+ */
+BOXWORLD_HOST_DEVICE inline auto flat_level_index(uint32_t env, uint32_t episode, uint32_t num_envs,
+                                                  uint32_t num_levels) noexcept -> uint32_t {
+    return static_cast<uint32_t>((static_cast<uint64_t>(episode) * num_envs + env) % num_levels);
+}
+
+/**
+ * Reset an environment to the level of its current episode.
+ * @param levels The levels
+ * @param envs The environments
+ * @param env Index of the environment
+ */
+BOXWORLD_HOST_DEVICE inline void flat_reset(const FlatLevelsView &levels, const FlatEnvsView &envs,
+                                            uint32_t env) noexcept {
+    const auto cells = levels.rows * levels.cols;
+    const auto level = flat_level_index(env, envs.episodes[env], envs.num_envs, levels.num_levels);
+    const auto *src = levels.boards + static_cast<std::size_t>(level) * cells;
+    auto *board = envs.boards + static_cast<std::size_t>(env) * cells;
+    for (uint32_t i = 0; i < cells; ++i) {
+        board[i] = src[i];
+    }
+    envs.agent_indices[env] = levels.agent_indices[level];
+    envs.inventories[env] = levels.inventories[level];
+    envs.levels[env] = level;
+}
+
+/**
+ * Apply an action to an environment, with the same rules as BoxWorldGameState::apply_action().
+ * @param levels The levels
+ * @param envs The environments
+ * @param env Index of the environment
+ * @param action The action to apply
+ * @param reward_index Set to 1 + the index of the key/lock collected/opened, 0 if none
+ * @param reward_colour Set to 1 + the colour of the key/lock collected/opened, 0 if none
+ */
+BOXWORLD_HOST_DEVICE inline void flat_apply_action(const FlatLevelsView &levels, const FlatEnvsView &envs,
+                                                   uint32_t env, uint8_t action, uint64_t &reward_index,
+                                                   uint64_t &reward_colour) noexcept {
+    const auto rows = levels.rows;
+    const auto cols = levels.cols;
+    const auto cells = rows * cols;
+    auto *board = envs.boards + static_cast<std::size_t>(env) * cells;
+    const auto *kinds = levels.kinds + static_cast<std::size_t>(envs.levels[env]) * cells;
+    const auto agent = envs.agent_indices[env];
+    auto &inventory = envs.inventories[env];
+    reward_index = 0;
+    reward_colour = 0;
+
+    // Do nothing if move puts agent out of bounds
+    const auto row = agent / cols;
+    const auto col = agent % cols;
+    uint32_t next = 0;
+    switch (static_cast<Action>(action)) {
+        case Action::kUp:
+            if (row == 0) {
+                return;
+            }
+            next = agent - cols;
+            break;
+        case Action::kRight:
+            if (col + 1 == cols) {
+                return;
+            }
+            next = agent + 1;
+            break;
+        case Action::kDown:
+            if (row + 1 == rows) {
+                return;
+            }
+            next = agent + cols;
+            break;
+        case Action::kLeft:
+            if (col == 0) {
+                return;
+            }
+            next = agent - 1;
+            break;
+    }
+
+    // Removed keys and locks are empty cells, so the cell kinds of the level start stay valid
+    const auto el = board[next];
+    const auto empty = static_cast<uint8_t>(Element::kEmpty);
+    const bool is_key = el != empty && kinds[next] == kCellKey;
+    const bool is_open = el != empty && kinds[next] == kCellLock && inventory == el;
+    if (el != empty && !is_key && !is_open) {
+        return;
+    }
+    if (is_key) {
+        // Single key not part of a lock/box
+        inventory = el;
+    }
+    if (is_open) {
+        // Key is consumed, and we add the box colour to our inventory
+        inventory = board[next - 1];
+        board[next - 1] = empty;
+    }
+    if (is_key || is_open) {
+        reward_colour = static_cast<uint64_t>(el) + 1;
+        reward_index = static_cast<uint64_t>(next) + 1;
+    }
+    board[agent] = empty;
+    board[next] = static_cast<uint8_t>(Element::kAgent);
+    envs.agent_indices[env] = next;
+}
+
+/**
+ * Step an environment, resetting it to the level of its next episode if solved, as BoxWorldVecEnv::step().
+ * @param levels The levels
+ * @param envs The environments
+ * @param env Index of the environment
+ * @param action The action to apply
+ * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+ * @param reward_signal Set to the reward signal of the action
+ * @param done Set to kDoneSolved if solved and reset, else kNotDone
+ */
+BOXWORLD_HOST_DEVICE inline void flat_step(const FlatLevelsView &levels, const FlatEnvsView &envs, uint32_t env,
+                                           uint8_t action, bool use_colour, uint64_t &reward_signal,
+                                           uint8_t &done) noexcept {
+    uint64_t reward_index = 0;
+    uint64_t reward_colour = 0;
+    flat_apply_action(levels, envs, env, action, reward_index, reward_colour);
+    reward_signal = use_colour ? reward_colour : reward_index;
+    done = 0;
+    if (envs.inventories[env] == static_cast<uint8_t>(Element::kColourGoal)) {
+        done = 1;
+        ++envs.episodes[env];
+        flat_reset(levels, envs, env);
+    }
+}
+
+/**
+ * Write the observation values of one cell of an environment, in the layout of BoxWorldGameState::get_observation().
+ * @param levels The levels
+ * @param envs The environments
+ * @param env Index of the environment
+ * @param cell Index of the cell
+ * @param obs Buffer of kNumChannels * rows * cols values of the environment observation
+ */
+BOXWORLD_HOST_DEVICE inline void flat_write_observation_cell(const FlatLevelsView &levels, const FlatEnvsView &envs,
+                                                             uint32_t env, uint32_t cell, float *obs) noexcept {
+    const auto cells = levels.rows * levels.cols;
+    const auto el = envs.boards[static_cast<std::size_t>(env) * cells + cell];
+    const auto inventory = envs.inventories[env];
+    for (uint32_t plane = 0; plane < kNumElements - 1; ++plane) {
+        obs[static_cast<std::size_t>(plane) * cells + cell] = el == plane ? 1.0F : 0.0F;
+    }
+    for (uint32_t colour = 0; colour < kNumColours; ++colour) {
+        obs[static_cast<std::size_t>(kNumElements - 1 + colour) * cells + cell] = inventory == colour ? 1.0F : 0.0F;
+    }
+}
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_DEVICE_RULES_H_
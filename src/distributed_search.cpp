@@ -0,0 +1,502 @@
+#include "distributed_search.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "parallel.h"
+#include "successors.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kGrainSize = 64;
+constexpr auto kConnectRetryDelay = std::chrono::milliseconds(50);
+
+// State sent to its owner, with the state it was generated from
+struct FrontierMessage {
+    uint64_t hash;
+    uint64_t parent_hash;
+    Action action;
+    PackedStateKey key;
+};
+
+// Sent at the front of every batch of a depth, so every node learns the totals of the depth
+struct DepthSummary {
+    uint64_t expanded = 0;          // States the sending node expanded this depth
+    bool found = false;             // Flag if the sending node generated a solution this depth
+    uint64_t found_parent = 0;      // Hash of the state the solution was generated from
+    Action found_action = Action::kUp;
+};
+
+struct FrontierEntry {
+    uint64_t hash;
+    PackedStateKey key;
+};
+
+struct ParentRecord {
+    uint64_t parent_hash;
+    Action action;
+};
+
+template <typename T>
+void append_value(ByteBatch& batch, const T& value) {
+    const auto offset = batch.size();
+    batch.resize(offset + sizeof(T));
+    std::memcpy(batch.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+auto read_value(const ByteBatch& batch, std::size_t& offset) -> T {
+    if (batch.size() - offset < sizeof(T)) {
+        throw std::invalid_argument("Malformed search batch.");
+    }
+    T value;
+    std::memcpy(&value, batch.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+auto read_action(const ByteBatch& batch, std::size_t& offset) -> Action {
+    const auto action = read_value<uint8_t>(batch, offset);
+    if (action >= kNumActions) {
+        throw std::invalid_argument("Malformed search batch.");
+    }
+    return static_cast<Action>(action);
+}
+
+void append_summary(ByteBatch& batch, const DepthSummary& summary) {
+    append_value(batch, summary.expanded);
+    append_value(batch, static_cast<uint8_t>(summary.found));
+    append_value(batch, summary.found_parent);
+    append_value(batch, static_cast<uint8_t>(summary.found_action));
+}
+
+auto read_summary(const ByteBatch& batch, std::size_t& offset) -> DepthSummary {
+    DepthSummary summary;
+    summary.expanded = read_value<uint64_t>(batch, offset);
+    summary.found = read_value<uint8_t>(batch, offset) != 0;
+    summary.found_parent = read_value<uint64_t>(batch, offset);
+    summary.found_action = read_action(batch, offset);
+    return summary;
+}
+
+void append_message(ByteBatch& batch, const FrontierMessage& message) {
+    append_value(batch, message.hash);
+    append_value(batch, message.parent_hash);
+    append_value(batch, static_cast<uint8_t>(message.action));
+    append_value(batch, message.key.agent_idx);
+    append_value(batch, static_cast<uint8_t>(message.key.inventory));
+    append_value(batch, message.key.remaining);
+}
+
+auto read_message(const ByteBatch& batch, std::size_t& offset) -> FrontierMessage {
+    FrontierMessage message{};
+    message.hash = read_value<uint64_t>(batch, offset);
+    message.parent_hash = read_value<uint64_t>(batch, offset);
+    message.action = read_action(batch, offset);
+    message.key.agent_idx = read_value<uint16_t>(batch, offset);
+    message.key.inventory = static_cast<Element>(read_value<uint8_t>(batch, offset));
+    message.key.remaining = read_value<uint64_t>(batch, offset);
+    return message;
+}
+
+void set_no_delay(int fd) noexcept {
+    // Each depth ends with a small summary batch, so do not wait to coalesce packets
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+auto send_all(int fd, const void* data, std::size_t size) noexcept -> bool {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const auto ret = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        bytes += ret;
+        size -= static_cast<std::size_t>(ret);
+    }
+    return true;
+}
+
+auto recv_all(int fd, void* data, std::size_t size) noexcept -> bool {
+    auto* bytes = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        const auto ret = ::recv(fd, bytes, size, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        bytes += ret;
+        size -= static_cast<std::size_t>(ret);
+    }
+    return true;
+}
+
+auto connect_to(const std::string& host, uint16_t port) -> int {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (auto* address = addresses; address != nullptr && fd < 0; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd >= 0 && ::connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+void check_rank(std::size_t rank, std::size_t num_nodes) {
+    if (num_nodes == 0) {
+        throw std::invalid_argument("Number of nodes must be positive.");
+    }
+    if (rank >= num_nodes) {
+        throw std::invalid_argument("Rank must be below the number of nodes.");
+    }
+}
+}    // namespace
+
+DistributedSearch::DistributedSearch(std::size_t rank, std::size_t num_nodes, BatchExchange exchange,
+                                     std::size_t num_threads, std::size_t max_expansions)
+    : rank(rank),
+      num_nodes(num_nodes),
+      exchange(std::move(exchange)),
+      num_threads(num_threads),
+      max_expansions(max_expansions) {
+    check_rank(rank, num_nodes);
+}
+
+auto DistributedSearch::bfs(const BoxWorldGameState& state) const -> SolverResult {
+    SolverResult result;
+    // Throws on every node alike if the level cannot be packed
+    const auto start_key = state.packed_key();
+    if (state.is_solution()) {
+        result.solved = true;
+        return result;
+    }
+    const auto owner_of = [&](uint64_t hash) { return static_cast<std::size_t>(hash % num_nodes); };
+    const auto start_hash = state.get_hash();
+    std::unordered_map<uint64_t, ParentRecord> closed;
+    std::vector<FrontierEntry> frontier;
+    if (owner_of(start_hash) == rank) {
+        closed.emplace(start_hash, ParentRecord{start_hash, Action::kUp});
+        frontier.push_back({start_hash, start_key});
+    }
+
+    // Batches and the first solution generated by each chunk of the frontier, merged in order after the depth
+    struct ChunkOutput {
+        std::vector<ByteBatch> batches;
+        DepthSummary summary;
+    };
+    std::vector<ChunkOutput> chunks;
+    DepthSummary solution;
+    std::size_t solution_rank = num_nodes;
+    while (max_expansions == 0 || result.expanded < max_expansions) {
+        chunks.clear();
+        chunks.resize((frontier.size() + kGrainSize - 1) / kGrainSize);
+        parallel_for_dynamic(frontier.size(), num_threads, kGrainSize, [&](std::size_t begin, std::size_t end) {
+            auto& chunk = chunks[begin / kGrainSize];
+            chunk.batches.resize(num_nodes);
+            auto scratch = state;
+            std::array<uint64_t, kNumActions> hashes{};
+            uint8_t valid_mask = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& entry = frontier[i];
+                scratch.reset(entry.key);
+                scratch.successor_hashes(hashes, valid_mask);
+                for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+                    const auto a = static_cast<std::size_t>(action);
+                    const auto hash = hashes[a];    // NOLINT(*-bounds-constant-array-index)
+                    // The closed set is only read while expanding, so children of this node are filtered early
+                    const auto owner = owner_of(hash);
+                    if ((valid_mask & (1U << a)) == 0 || (owner == rank && closed.count(hash) != 0)) {
+                        continue;
+                    }
+                    const auto record = scratch.apply_action_with_undo(action);
+                    if (scratch.is_solution()) {
+                        if (!chunk.summary.found) {
+                            chunk.summary.found = true;
+                            chunk.summary.found_parent = entry.hash;
+                            chunk.summary.found_action = action;
+                        }
+                    } else if (!reached_dead_end(scratch)) {
+                        append_message(chunk.batches[owner], {hash, entry.hash, action, scratch.packed_key()});
+                    }
+                    scratch.undo_action(record);
+                }
+            }
+        });
+
+        DepthSummary summary;
+        summary.expanded = frontier.size();
+        for (const auto& chunk : chunks) {
+            if (chunk.summary.found) {
+                summary.found = true;
+                summary.found_parent = chunk.summary.found_parent;
+                summary.found_action = chunk.summary.found_action;
+                break;
+            }
+        }
+        std::vector<ByteBatch> batches(num_nodes);
+        for (std::size_t node = 0; node < num_nodes; ++node) {
+            append_summary(batches[node], summary);
+            for (const auto& chunk : chunks) {
+                batches[node].insert(batches[node].end(), chunk.batches[node].begin(), chunk.batches[node].end());
+            }
+        }
+        const auto received = exchange(std::move(batches));
+        if (received.size() != num_nodes) {
+            throw std::invalid_argument("Malformed search batch.");
+        }
+
+        // Every node reads the same summaries, so all of them agree on when to stop and on the solution
+        std::vector<std::size_t> offsets(num_nodes, 0);
+        std::size_t depth_expanded = 0;
+        for (std::size_t node = 0; node < num_nodes; ++node) {
+            const auto node_summary = read_summary(received[node], offsets[node]);
+            depth_expanded += node_summary.expanded;
+            if (node_summary.found && solution_rank == num_nodes) {
+                solution = node_summary;
+                solution_rank = node;
+            }
+        }
+        result.expanded += depth_expanded;
+        if (solution_rank != num_nodes || depth_expanded == 0) {
+            break;
+        }
+
+        std::vector<FrontierEntry> next_frontier;
+        for (std::size_t node = 0; node < num_nodes; ++node) {
+            const auto& batch = received[node];
+            while (offsets[node] < batch.size()) {
+                const auto message = read_message(batch, offsets[node]);
+                if (owner_of(message.hash) != rank) {
+                    throw std::invalid_argument("Malformed search batch.");
+                }
+                if (closed.emplace(message.hash, ParentRecord{message.parent_hash, message.action}).second) {
+                    next_frontier.push_back({message.hash, message.key});
+                }
+            }
+        }
+        frontier = std::move(next_frontier);
+    }
+    if (solution_rank == num_nodes) {
+        return result;
+    }
+
+    // Trace the path back one state per exchange, each parent sent to every node by its owner
+    result.solved = true;
+    result.actions.push_back(solution.found_action);
+    for (auto hash = solution.found_parent; hash != start_hash;) {
+        const auto owner = owner_of(hash);
+        std::vector<ByteBatch> batches(num_nodes);
+        if (owner == rank) {
+            const auto it = closed.find(hash);
+            if (it == closed.end()) {
+                throw std::invalid_argument("Malformed search batch.");
+            }
+            for (auto& batch : batches) {
+                append_value(batch, it->second.parent_hash);
+                append_value(batch, static_cast<uint8_t>(it->second.action));
+            }
+        }
+        const auto received = exchange(std::move(batches));
+        if (received.size() != num_nodes) {
+            throw std::invalid_argument("Malformed search batch.");
+        }
+        std::size_t offset = 0;
+        hash = read_value<uint64_t>(received[owner], offset);
+        result.actions.push_back(read_action(received[owner], offset));
+    }
+    std::reverse(result.actions.begin(), result.actions.end());
+    result.cost = result.actions.size();
+    return result;
+}
+
+LocalExchangeGroup::LocalExchangeGroup(std::size_t num_nodes)
+    : num_nodes(num_nodes), mailboxes(num_nodes, std::vector<ByteBatch>(num_nodes)) {
+    check_rank(0, num_nodes);
+}
+
+auto LocalExchangeGroup::exchange(std::size_t rank, std::vector<ByteBatch> batches) -> std::vector<ByteBatch> {
+    check_rank(rank, num_nodes);
+    if (batches.size() != num_nodes) {
+        throw std::invalid_argument("Need a batch for every node.");
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    // Nodes which finish a round early wait for the others to collect their batches before sending again
+    condition.wait(lock, [&]() { return num_left == 0; });
+    for (std::size_t node = 0; node < num_nodes; ++node) {
+        mailboxes[node][rank] = std::move(batches[node]);
+    }
+    const auto current_round = round;
+    if (++num_arrived == num_nodes) {
+        num_arrived = 0;
+        num_left = num_nodes;
+        ++round;
+        condition.notify_all();
+    } else {
+        condition.wait(lock, [&]() { return round != current_round; });
+    }
+    auto received = std::move(mailboxes[rank]);
+    mailboxes[rank].assign(num_nodes, ByteBatch{});
+    if (--num_left == 0) {
+        condition.notify_all();
+    }
+    return received;
+}
+
+auto LocalExchangeGroup::get_exchange(std::size_t rank) -> BatchExchange {
+    check_rank(rank, num_nodes);
+    return [this, rank](std::vector<ByteBatch> batches) { return exchange(rank, std::move(batches)); };
+}
+
+SocketExchange::SocketExchange(std::size_t rank, std::size_t num_nodes, uint16_t port)
+    : rank(rank), num_nodes(num_nodes), peer_fds(num_nodes, -1) {
+    check_rank(rank, num_nodes);
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error("Cannot create the listening socket.");
+    }
+    int flag = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t length = sizeof(address);
+    // Nodes of higher rank may connect before connect() is called, so their connections wait in the backlog
+    const auto backlog = static_cast<int>(std::max<std::size_t>(num_nodes, 1));
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, backlog) != 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        close(listen_fd);
+        throw std::runtime_error("Cannot listen on port " + std::to_string(port) + ".");
+    }
+    listen_port = ntohs(address.sin_port);
+}
+
+SocketExchange::~SocketExchange() {
+    for (const auto fd : peer_fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    close(listen_fd);
+}
+
+auto SocketExchange::port() const noexcept -> uint16_t {
+    return listen_port;
+}
+
+void SocketExchange::connect(const std::vector<std::string>& hosts, const std::vector<uint16_t>& ports,
+                             std::size_t timeout_ms) {
+    if (hosts.size() != num_nodes || ports.size() != num_nodes) {
+        throw std::invalid_argument("Need an address for every node.");
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (std::size_t node = 0; node < rank; ++node) {
+        int fd = connect_to(hosts[node], ports[node]);
+        while (fd < 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(kConnectRetryDelay);
+            fd = connect_to(hosts[node], ports[node]);
+        }
+        const uint64_t own_rank = rank;
+        if (fd < 0 || !send_all(fd, &own_rank, sizeof(own_rank))) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            throw std::runtime_error("Cannot connect to " + hosts[node] + ":" + std::to_string(ports[node]) + ".");
+        }
+        set_no_delay(fd);
+        peer_fds[node] = fd;
+    }
+    // Nodes of higher rank connect in any order, and identify themselves by their rank
+    for (std::size_t num_accepted = 0; num_accepted < num_nodes - rank - 1; ++num_accepted) {
+        int fd = -1;
+        do {
+            fd = accept(listen_fd, nullptr, nullptr);
+        } while (fd < 0 && errno == EINTR);
+        uint64_t peer_rank = 0;
+        if (fd < 0 || !recv_all(fd, &peer_rank, sizeof(peer_rank)) || peer_rank <= rank || peer_rank >= num_nodes ||
+            peer_fds[peer_rank] >= 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            throw std::runtime_error("Cannot accept a connection.");
+        }
+        set_no_delay(fd);
+        peer_fds[peer_rank] = fd;
+    }
+}
+
+auto SocketExchange::exchange(std::vector<ByteBatch> batches) -> std::vector<ByteBatch> {
+    if (batches.size() != num_nodes) {
+        throw std::invalid_argument("Need a batch for every node.");
+    }
+    for (std::size_t node = 0; node < num_nodes; ++node) {
+        if (node != rank && peer_fds[node] < 0) {
+            throw std::runtime_error("Not connected to every node.");
+        }
+    }
+    std::vector<ByteBatch> received(num_nodes);
+    received[rank] = std::move(batches[rank]);
+    // Every node sends before it receives, so send from another thread while receiving
+    bool sent = true;
+    std::thread sender([&]() {
+        for (std::size_t node = 0; node < num_nodes && sent; ++node) {
+            if (node != rank) {
+                const uint64_t size = batches[node].size();
+                sent = send_all(peer_fds[node], &size, sizeof(size)) &&
+                       send_all(peer_fds[node], batches[node].data(), batches[node].size());
+            }
+        }
+    });
+    bool is_received = true;
+    for (std::size_t node = 0; node < num_nodes && is_received; ++node) {
+        if (node != rank) {
+            uint64_t size = 0;
+            is_received = recv_all(peer_fds[node], &size, sizeof(size));
+            if (is_received) {
+                received[node].resize(size);
+                is_received = recv_all(peer_fds[node], received[node].data(), received[node].size());
+            }
+        }
+    }
+    sender.join();
+    if (!sent || !is_received) {
+        throw std::runtime_error("Exchange with the other nodes failed.");
+    }
+    return received;
+}
+
+auto SocketExchange::get_exchange() -> BatchExchange {
+    return [this](std::vector<ByteBatch> batches) { return exchange(std::move(batches)); };
+}
+
+}    // namespace boxworld
@@ -0,0 +1,167 @@
+#ifndef BOXWORLD_DISTRIBUTED_SEARCH_H_
+#define BOXWORLD_DISTRIBUTED_SEARCH_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "solver.h"
+
+namespace boxworld {
+
+// Batch of bytes sent from one node of a distributed search to another
+using ByteBatch = std::vector<uint8_t>;
+
+// All-to-all exchange between the nodes of a distributed search, which every node calls in lockstep.
+// Takes the batch for each node by rank, including itself, and returns the batch from each node by rank once every
+// node has made the call, so each call is also a barrier.
+using BatchExchange = std::function<std::vector<ByteBatch>(std::vector<ByteBatch>)>;
+
+// Breadth first search split over several nodes, where each node owns the states whose get_hash() modulo the number
+// of nodes is its rank, holding only their closed set and frontier.
+// Each depth, every node expands its frontier and sends the children to their owners as packed keys in one batch per
+// node, so a depth is a single exchange. Every node must call bfs() with the same state, and all of them return the
+// same result, with the solution path traced back through the owners of its states.
+// @note Frontier states are sent as packed keys, so levels can have at most PackedStateKey::kMaxTargets single keys
+// and locks, and nodes must share the byte order
+class DistributedSearch {
+public:
+    DistributedSearch() = delete;
+
+    /**
+     * @note Throws std::invalid_argument if num_nodes is 0 or rank is not below num_nodes
+     * @param rank Index of this node, from 0 to num_nodes - 1
+     * @param num_nodes Number of nodes
+     * @param exchange Exchange between the nodes, such as from a LocalExchangeGroup or a SocketExchange
+     * @param num_threads Number of threads each node expands with, 0 to use the hardware concurrency
+     * @param max_expansions Number of states all nodes together expand before giving up, 0 for no limit
+     */
+    DistributedSearch(std::size_t rank, std::size_t num_nodes, BatchExchange exchange, std::size_t num_threads = 0,
+                      std::size_t max_expansions = 0);
+
+    /**
+     * Breadth first search with the same results as ParallelSearch::bfs(), pruning children which are dead ends.
+     * @note Throws std::invalid_argument if the level has more single keys and locks than a packed key holds, or a
+     * received batch is malformed
+     * @param state The state to search from, the same on every node
+     * @return The optimal solution, with solved set to false if none is found within the expansion limit, and
+     * expanded counting the states expanded by all nodes
+     */
+    [[nodiscard]] auto bfs(const BoxWorldGameState &state) const -> SolverResult;
+
+private:
+    std::size_t rank;
+    std::size_t num_nodes;
+    BatchExchange exchange;
+    std::size_t num_threads;
+    std::size_t max_expansions;
+};
+
+// In process exchange between nodes running on threads of a single process, where each node calls
+// exchange() with its own rank.
+class LocalExchangeGroup {
+public:
+    LocalExchangeGroup() = delete;
+
+    /**
+     * @note Throws std::invalid_argument if num_nodes is 0
+     * @param num_nodes Number of nodes in the group
+     */
+    explicit LocalExchangeGroup(std::size_t num_nodes);
+
+    /**
+     * Exchange batches with the other nodes of the group, blocking until every node has made the call.
+     * @param rank Index of the calling node
+     * @param batches Batch for each node by rank
+     * @return Batch from each node by rank
+     */
+    auto exchange(std::size_t rank, std::vector<ByteBatch> batches) -> std::vector<ByteBatch>;
+
+    /**
+     * Get the exchange of a node, to pass to DistributedSearch
+     * @param rank Index of the node
+     * @return Exchange calling exchange() with the rank, which references the group
+     */
+    [[nodiscard]] auto get_exchange(std::size_t rank) -> BatchExchange;
+
+private:
+    std::size_t num_nodes;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::vector<ByteBatch>> mailboxes;    // Batches to each node, by sending rank
+    std::size_t num_arrived = 0;
+    std::size_t num_left = 0;          // Nodes yet to collect their batches of the current round
+    uint64_t round = 0;
+};
+
+// Exchange between nodes over TCP, with a connection between every pair of nodes.
+// Each batch is sent as its length followed by its bytes, and sends run on a separate thread while receiving, so
+// nodes never block each other on full socket buffers.
+// @note Not thread safe. POSIX only
+class SocketExchange {
+public:
+    SocketExchange() = delete;
+
+    /**
+     * Listen for the connections of the other nodes on the given port of every interface.
+     * @note Throws std::runtime_error if the socket cannot be bound, or std::invalid_argument if num_nodes is 0 or
+     * rank is not below num_nodes
+     * @param rank Index of this node
+     * @param num_nodes Number of nodes
+     * @param port The TCP port to listen on, 0 to pick a free port
+     */
+    SocketExchange(std::size_t rank, std::size_t num_nodes, uint16_t port = 0);
+    ~SocketExchange();
+
+    SocketExchange(const SocketExchange &) = delete;
+    SocketExchange(SocketExchange &&) = delete;
+    auto operator=(const SocketExchange &) -> SocketExchange & = delete;
+    auto operator=(SocketExchange &&) -> SocketExchange & = delete;
+
+    /**
+     * Get the port this node listens on
+     * @return The TCP port
+     */
+    [[nodiscard]] auto port() const noexcept -> uint16_t;
+
+    /**
+     * Connect to every other node, each node connecting to the nodes of lower rank and accepting the nodes of
+     * higher rank. Connections to nodes which are not listening yet are retried for the given time.
+     * @note Throws std::runtime_error if a node cannot be reached, or std::invalid_argument if not given an address
+     * for every node
+     * @param hosts Name or address of each node by rank, the entry of this node is unused
+     * @param ports Listening port of each node by rank, the entry of this node is unused
+     * @param timeout_ms Milliseconds to keep retrying connections for
+     */
+    void connect(const std::vector<std::string> &hosts, const std::vector<uint16_t> &ports,
+                 std::size_t timeout_ms = 30000);
+
+    /**
+     * Exchange batches with the other nodes, blocking until the batch of every node is received.
+     * @note Throws std::runtime_error if not connected or a connection fails
+     * @param batches Batch for each node by rank
+     * @return Batch from each node by rank
+     */
+    auto exchange(std::vector<ByteBatch> batches) -> std::vector<ByteBatch>;
+
+    /**
+     * Get the exchange of this node, to pass to DistributedSearch
+     * @return Exchange calling exchange(), which references this object
+     */
+    [[nodiscard]] auto get_exchange() -> BatchExchange;
+
+private:
+    std::size_t rank;
+    std::size_t num_nodes;
+    int listen_fd = -1;
+    uint16_t listen_port = 0;
+    std::vector<int> peer_fds;    // Connection to each node by rank, -1 for this node
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_DISTRIBUTED_SEARCH_H_
@@ -0,0 +1,271 @@
+#ifndef BOXWORLD_FIXED_BOXWORLD_H_
+#define BOXWORLD_FIXED_BOXWORLD_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+#include "flat_index_set.h"
+#include "rng.h"
+
+namespace boxworld {
+
+// Game state for a board size fixed at compile time, with the same rules and observation as BoxWorldGameState.
+// The board is stored inline, and the neighbour and Zobrist tables are compile-time constants, so the state is
+// trivially copyable and can be snapshot with memcpy.
+// The Zobrist tables are generated as by make_zobrist_table(), so hashes equal BoxWorldGameState::get_hash().
+template <std::size_t Rows, std::size_t Cols>
+class FixedBoxWorld {
+    static_assert(Rows > 0 && Cols > 0 && Rows * Cols < kMaxBoardCells, "Board is too large.");
+
+public:
+    static constexpr std::size_t kRows = Rows;
+    static constexpr std::size_t kCols = Cols;
+    static constexpr std::size_t kCells = Rows * Cols;
+    static constexpr std::size_t kObservationSize = kNumChannels * kCells;
+
+    FixedBoxWorld() = delete;
+
+    /**
+     * Construct from a state of the same board dimensions.
+     * @note Throws std::invalid_argument if the board dimensions do not match
+     * @param state The state to copy
+     */
+    explicit FixedBoxWorld(const BoxWorldGameState &state) {
+        const auto shape = state.observation_shape();
+        if (shape[1] != Cols || shape[2] != Rows) {
+            throw std::invalid_argument("State does not match the fixed board dimensions.");
+        }
+        for (std::size_t i = 0; i < kCells; ++i) {
+            board[i] = state.get_item(i);
+            zorb_hash ^= kZrbhtBoard[ZrbhtIndex(board[i], i)];
+        }
+        for (const auto &idx : state.get_key_indices()) {
+            SetBit(key_mask, idx);
+        }
+        for (const auto &idx : state.get_lock_indices()) {
+            SetBit(lock_mask, idx);
+        }
+        agent_idx = static_cast<uint16_t>(state.get_agent_index());
+        inventory = state.get_inventory();
+        if (has_key()) {
+            zorb_hash ^= kZrbhtInventory[static_cast<std::size_t>(inventory)];
+        }
+        reward_signal_index = state.get_reward_signal(false);
+        reward_signal_colour = state.get_reward_signal(true);
+    }
+
+    /**
+     * Apply the action to the current state, see BoxWorldGameState::apply_action().
+     * @param action The action to apply
+     */
+    void apply_action(Action action) noexcept {
+        reward_signal_colour = 0;
+        reward_signal_index = 0;
+        const auto new_index = kNeighbours[agent_idx * kNumActions + static_cast<std::size_t>(action)];
+        // Do nothing if move puts agent out of bounds
+        if (new_index == kNoNeighbour) {
+            return;
+        }
+        // If empty, just move
+        if (board[new_index] == Element::kEmpty) {
+            MoveAgent(new_index);
+            return;
+        }
+        // Single key not part of a lock/box
+        if (GetBit(key_mask, new_index)) {
+            reward_signal_colour = static_cast<std::size_t>(board[new_index]) + 1;
+            ClearBit(key_mask, new_index);
+            AddToInventory(new_index);
+            MoveAgent(new_index);
+            reward_signal_index = agent_idx + 1;
+            return;
+        }
+        // Lock/box pair and we have the corresponding key
+        if (GetBit(lock_mask, new_index) && inventory == board[new_index]) {
+            ClearBit(lock_mask, new_index);
+            reward_signal_colour = static_cast<std::size_t>(board[new_index]) + 1;
+            zorb_hash ^= kZrbhtInventory[static_cast<std::size_t>(inventory)];
+            inventory = Element::kAgent;
+            SetCell(new_index, Element::kEmpty);
+            AddToInventory(new_index - 1);
+            MoveAgent(new_index);
+            reward_signal_index = agent_idx + 1;
+        }
+    }
+
+    /**
+     * Check if the state is in the solution state.
+     * @return True if holding the goal, false otherwise
+     */
+    [[nodiscard]] auto is_solution() const noexcept -> bool {
+        return inventory == Element::kColourGoal;
+    }
+
+    /**
+     * Get the reward signal of the last action, see BoxWorldGameState::get_reward_signal().
+     * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+     * @return reward signal
+     */
+    [[nodiscard]] auto get_reward_signal(bool use_colour = false) const noexcept -> uint64_t {
+        return use_colour ? reward_signal_colour : reward_signal_index;
+    }
+
+    /**
+     * Get the hash of the current state.
+     * @return hash value
+     */
+    [[nodiscard]] auto get_hash() const noexcept -> uint64_t {
+        return zorb_hash;
+    }
+
+    /**
+     * Get the current agent index
+     * @return agent index
+     */
+    [[nodiscard]] auto get_agent_index() const noexcept -> std::size_t {
+        return agent_idx;
+    }
+
+    /**
+     * Get the current key in the inventory
+     * @return Element of the key held, or kAgent if no key is held
+     */
+    [[nodiscard]] auto get_inventory() const noexcept -> Element {
+        return inventory;
+    }
+
+    /**
+     * Check if key is being held in inventory
+     * @return True if holding key of any colour, false otherwise
+     */
+    [[nodiscard]] auto has_key() const noexcept -> bool {
+        return inventory != Element::kAgent;
+    }
+
+    /**
+     * Get the item at the given index
+     * @param index Board index
+     * @return Element at the index
+     */
+    [[nodiscard]] auto get_item(std::size_t index) const noexcept -> Element {
+        assert(index < kCells);
+        return board[index];
+    }
+
+    /**
+     * Get the shape the observations should be viewed as.
+     * @return array indicating observation CHW
+     */
+    [[nodiscard]] static constexpr auto observation_shape() noexcept -> std::array<std::size_t, 3> {
+        return {kNumChannels, Cols, Rows};
+    }
+
+    /**
+     * Write the observation into the given buffer, see BoxWorldGameState::get_observation().
+     * @param obs Buffer of kObservationSize values
+     */
+    void get_observation(float *obs) const noexcept {
+        std::fill_n(obs, kObservationSize, static_cast<float>(0));
+        for (std::size_t i = 0; i < kCells; ++i) {
+            if (board[i] != Element::kEmpty) {
+                obs[static_cast<std::size_t>(board[i]) * kCells + i] = 1;
+            }
+        }
+        if (has_key()) {
+            const auto inventory_channel = static_cast<std::size_t>(inventory) + kNumElements - 1;
+            std::fill_n(obs + inventory_channel * kCells, kCells, static_cast<float>(1));
+        }
+    }
+
+    auto operator==(const FixedBoxWorld &other) const noexcept -> bool {
+        return board == other.board && agent_idx == other.agent_idx && inventory == other.inventory &&
+               key_mask == other.key_mask && lock_mask == other.lock_mask;
+    }
+    auto operator!=(const FixedBoxWorld &other) const noexcept -> bool {
+        return !(*this == other);
+    }
+
+private:
+    static constexpr std::size_t kMaskWords = (kCells + 63) / 64;
+    using Mask = std::array<uint64_t, kMaskWords>;
+
+    static constexpr auto MakeNeighbours() noexcept -> std::array<uint16_t, kCells * kNumActions> {
+        std::array<uint16_t, kCells * kNumActions> neighbours{};
+        for (std::size_t idx = 0; idx < kCells; ++idx) {
+            const auto row = idx / Cols;
+            const auto col = idx % Cols;
+            neighbours[idx * kNumActions + static_cast<std::size_t>(Action::kUp)] =
+                row > 0 ? static_cast<uint16_t>(idx - Cols) : kNoNeighbour;
+            neighbours[idx * kNumActions + static_cast<std::size_t>(Action::kRight)] =
+                col + 1 < Cols ? static_cast<uint16_t>(idx + 1) : kNoNeighbour;
+            neighbours[idx * kNumActions + static_cast<std::size_t>(Action::kDown)] =
+                row + 1 < Rows ? static_cast<uint16_t>(idx + Cols) : kNoNeighbour;
+            neighbours[idx * kNumActions + static_cast<std::size_t>(Action::kLeft)] =
+                col > 0 ? static_cast<uint16_t>(idx - 1) : kNoNeighbour;
+        }
+        return neighbours;
+    }
+
+    template <std::size_t N>
+    static constexpr auto MakeZrbhtTable(uint64_t seed) noexcept -> std::array<uint64_t, N> {
+        std::array<uint64_t, N> table{};
+        SplitMix64 rng(seed);
+        for (auto &value : table) {
+            value = rng();
+        }
+        return table;
+    }
+
+    static constexpr auto ZrbhtIndex(Element el, std::size_t index) noexcept -> std::size_t {
+        return static_cast<std::size_t>(el) * kCells + index;
+    }
+    static constexpr auto GetBit(const Mask &mask, std::size_t index) noexcept -> bool {
+        return (mask[index / 64] >> (index % 64)) & 1;
+    }
+    static constexpr void SetBit(Mask &mask, std::size_t index) noexcept {
+        mask[index / 64] |= uint64_t{1} << (index % 64);
+    }
+    static constexpr void ClearBit(Mask &mask, std::size_t index) noexcept {
+        mask[index / 64] &= ~(uint64_t{1} << (index % 64));
+    }
+
+    void SetCell(std::size_t index, Element el) noexcept {
+        zorb_hash ^= kZrbhtBoard[ZrbhtIndex(board[index], index)] ^ kZrbhtBoard[ZrbhtIndex(el, index)];
+        board[index] = el;
+    }
+
+    void MoveAgent(std::size_t new_index) noexcept {
+        SetCell(agent_idx, Element::kEmpty);
+        SetCell(new_index, Element::kAgent);
+        agent_idx = static_cast<uint16_t>(new_index);
+    }
+
+    void AddToInventory(std::size_t index) noexcept {
+        inventory = board[index];
+        zorb_hash ^= kZrbhtInventory[static_cast<std::size_t>(inventory)];
+        SetCell(index, Element::kEmpty);
+    }
+
+    static constexpr std::array<uint16_t, kCells * kNumActions> kNeighbours = MakeNeighbours();
+    static constexpr std::array<uint64_t, kNumElements * kCells> kZrbhtBoard =
+        MakeZrbhtTable<kNumElements * kCells>(kCells);
+    static constexpr std::array<uint64_t, kNumColours> kZrbhtInventory = MakeZrbhtTable<kNumColours>(~kCells);
+
+    std::array<Element, kCells> board{};
+    Mask key_mask{};
+    Mask lock_mask{};
+    uint64_t zorb_hash = 0;
+    uint64_t reward_signal_index = 0;
+    uint64_t reward_signal_colour = 0;
+    uint16_t agent_idx = 0;
+    Element inventory = Element::kAgent;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_FIXED_BOXWORLD_H_
@@ -0,0 +1,161 @@
+#ifndef BOXWORLD_FLAT_INDEX_SET_H_
+#define BOXWORLD_FLAT_INDEX_SET_H_
+
+#include <nop/base/vector.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace boxworld {
+
+// Largest board (rows * cols) which can be indexed by FlatIndexSet
+constexpr std::size_t kMaxBoardCells = std::numeric_limits<uint16_t>::max();
+
+// Small sorted set of board indices stored contiguously.
+// Levels contain only a handful of keys/locks, so a sorted vector is cheaper to copy and search than a hash set.
+class FlatIndexSet {
+public:
+    using value_type = uint16_t;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    FlatIndexSet() = default;
+
+    [[nodiscard]] auto contains(std::size_t index) const noexcept -> bool {
+        const auto it = std::lower_bound(indices.begin(), indices.end(), index);
+        return it != indices.end() && *it == index;
+    }
+
+    void insert(std::size_t index) {
+        const auto it = std::lower_bound(indices.begin(), indices.end(), index);
+        if (it == indices.end() || *it != index) {
+            indices.insert(it, static_cast<value_type>(index));
+        }
+    }
+
+    void erase(std::size_t index) noexcept {
+        const auto it = std::lower_bound(indices.begin(), indices.end(), index);
+        if (it != indices.end() && *it == index) {
+            indices.erase(it);
+        }
+    }
+
+    void clear() noexcept {
+        indices.clear();
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return indices.size();
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return indices.empty();
+    }
+
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+        return indices.capacity();
+    }
+
+    [[nodiscard]] auto begin() const noexcept -> const_iterator {
+        return indices.begin();
+    }
+
+    [[nodiscard]] auto end() const noexcept -> const_iterator {
+        return indices.end();
+    }
+
+    auto operator==(const FlatIndexSet &other) const noexcept -> bool {
+        return indices == other.indices;
+    }
+
+private:
+    template <typename, typename>
+    friend struct ::nop::Encoding;
+
+    std::vector<value_type> indices;
+};
+
+}    // namespace boxworld
+
+namespace nop {
+
+// Encoding of FlatIndexSet, with the same bytes as NOP_STRUCTURE(FlatIndexSet, indices).
+// The index copy is skipped for an empty set, as libnop would otherwise pass the null data() of the empty vector to
+// memcpy, which is undefined even for a length of 0.
+template <>
+struct Encoding<boxworld::FlatIndexSet> : EncodingIO<boxworld::FlatIndexSet> {
+    using Type = boxworld::FlatIndexSet;
+    using Indices = std::vector<Type::value_type>;
+    static constexpr SizeType kNumMembers = 1;
+
+    static constexpr auto Prefix(const Type & /*value*/) -> EncodingByte {
+        return EncodingByte::Structure;
+    }
+
+    static constexpr auto Size(const Type &value) -> std::size_t {
+        return BaseEncodingSize(Prefix(value)) + Encoding<SizeType>::Size(kNumMembers) +
+               Encoding<Indices>::Size(value.indices);
+    }
+
+    static constexpr auto Match(EncodingByte prefix) -> bool {
+        return prefix == EncodingByte::Structure;
+    }
+
+    template <typename Writer>
+    static constexpr auto WritePayload(EncodingByte /*prefix*/, const Type &value, Writer *writer) -> Status<void> {
+        auto status = Encoding<SizeType>::Write(kNumMembers, writer);
+        if (!status) {
+            return status;
+        }
+        if (!value.indices.empty()) {
+            return Encoding<Indices>::Write(value.indices, writer);
+        }
+        status = writer->Write(static_cast<std::uint8_t>(EncodingByte::Binary));
+        if (!status) {
+            return status;
+        }
+        return Encoding<SizeType>::Write(0, writer);
+    }
+
+    template <typename Reader>
+    static constexpr auto ReadPayload(EncodingByte /*prefix*/, Type *value, Reader *reader) -> Status<void> {
+        SizeType count = 0;
+        auto status = Encoding<SizeType>::Read(&count, reader);
+        if (!status) {
+            return status;
+        }
+        if (count != kNumMembers) {
+            return ErrorStatus::InvalidMemberCount;
+        }
+        std::uint8_t prefix = 0;
+        status = reader->Read(&prefix);
+        if (!status) {
+            return status;
+        }
+        if (!Encoding<Indices>::Match(static_cast<EncodingByte>(prefix))) {
+            return ErrorStatus::UnexpectedEncodingType;
+        }
+        SizeType size = 0;
+        status = Encoding<SizeType>::Read(&size, reader);
+        if (!status) {
+            return status;
+        }
+        if (size % sizeof(Type::value_type) != 0) {
+            return ErrorStatus::InvalidContainerLength;
+        }
+        status = reader->Ensure(size);
+        if (!status) {
+            return status;
+        }
+        value->indices.resize(size / sizeof(Type::value_type));
+        if (value->indices.empty()) {
+            return {};
+        }
+        return reader->Read(value->indices.data(), value->indices.data() + value->indices.size());
+    }
+};
+
+}    // namespace nop
+
+#endif    // BOXWORLD_FLAT_INDEX_SET_H_
@@ -0,0 +1,55 @@
+#include "incremental_observation.h"
+
+#include <algorithm>
+
+namespace boxworld {
+
+IncrementalObservation::IncrementalObservation(const BoxWorldGameState& state) {
+    rebuild(state);
+}
+
+void IncrementalObservation::rebuild(const BoxWorldGameState& state) {
+    const auto shape = state.observation_shape();
+    channel_length = shape[1] * shape[2];
+    state.get_observation(obs);
+    inventory = state.get_inventory();
+}
+
+void IncrementalObservation::update(const BoxWorldGameState& state, const UndoRecord& record) noexcept {
+    // Clear the board channels of the changed cells, then set what they hold now.
+    // Clearing every channel handles both applying and undoing the action.
+    for (std::size_t i = 0; i < record.num_cell_changes; ++i) {
+        const auto index = record.cell_changes[i].index;
+        for (std::size_t channel = 0; channel < kNumElements - 1; ++channel) {
+            obs[channel * channel_length + index] = 0;
+        }
+    }
+    for (std::size_t i = 0; i < record.num_cell_changes; ++i) {
+        const auto index = record.cell_changes[i].index;
+        const auto el = state.get_item(index);
+        if (el != Element::kEmpty) {
+            obs[static_cast<std::size_t>(el) * channel_length + index] = 1;
+        }
+    }
+
+    // Inventory planes
+    if (state.get_inventory() != inventory) {
+        SetInventory(inventory, 0);
+        inventory = state.get_inventory();
+        SetInventory(inventory, 1);
+    }
+}
+
+auto IncrementalObservation::get_observation() const noexcept -> const std::vector<float>& {
+    return obs;
+}
+
+void IncrementalObservation::SetInventory(Element el, float value) noexcept {
+    if (el == Element::kAgent) {
+        return;
+    }
+    const auto inventory_channel = static_cast<std::size_t>(el) + kNumElements - 1;
+    std::fill_n(obs.begin() + static_cast<std::ptrdiff_t>(inventory_channel * channel_length), channel_length, value);
+}
+
+}    // namespace boxworld
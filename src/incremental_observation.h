@@ -0,0 +1,53 @@
+#ifndef BOXWORLD_INCREMENTAL_OBSERVATION_H_
+#define BOXWORLD_INCREMENTAL_OBSERVATION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+
+namespace boxworld {
+
+// Persistent observation of a state which is patched with the cells changed by each action,
+// so the per step cost is proportional to the number of changes instead of the observation size.
+// The observation matches BoxWorldGameState::get_observation().
+class IncrementalObservation {
+public:
+    IncrementalObservation() = delete;
+
+    /**
+     * Build the observation of the given state.
+     * @param state The state to observe
+     */
+    explicit IncrementalObservation(const BoxWorldGameState &state);
+
+    /**
+     * Rebuild the observation from scratch, such as after a reset or set_key().
+     * @param state The state to observe
+     */
+    void rebuild(const BoxWorldGameState &state);
+
+    /**
+     * Patch the observation after an action was applied via apply_action_with_undo() or undone via undo_action().
+     * @param state The state after the action was applied (or undone)
+     * @param record The record of the action
+     */
+    void update(const BoxWorldGameState &state, const UndoRecord &record) noexcept;
+
+    /**
+     * Get the current observation, viewed as the shape given by BoxWorldGameState::observation_shape().
+     * @return Reference to the observation
+     */
+    [[nodiscard]] auto get_observation() const noexcept -> const std::vector<float> &;
+
+private:
+    void SetInventory(Element el, float value) noexcept;
+
+    std::vector<float> obs;
+    std::size_t channel_length = 0;
+    Element inventory = Element::kAgent;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_INCREMENTAL_OBSERVATION_H_
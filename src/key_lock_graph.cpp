@@ -0,0 +1,84 @@
+#include "key_lock_graph.h"
+
+#include <algorithm>
+
+namespace boxworld {
+
+namespace {
+constexpr uint16_t kNoParent = kNoBox - 1;
+}    // namespace
+
+auto KeyLockGraph::num_distractors() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(
+        std::count_if(boxes.begin(), boxes.end(), [](const KeyLockBox& box) { return box.is_distractor; }));
+}
+
+auto build_key_lock_graph(const std::vector<Element>& board, const FlatIndexSet& key_indices,
+                          const FlatIndexSet& lock_indices, Element inventory) -> KeyLockGraph {
+    KeyLockGraph graph;
+    graph.cell_box.assign(board.size(), kNoBox);
+    for (const auto& idx : lock_indices) {
+        KeyLockBox box;
+        box.lock_index = static_cast<uint16_t>(idx);
+        box.key_index = static_cast<uint16_t>(idx - 1);
+        box.lock_colour = board[idx];
+        box.key_colour = board[idx - 1];
+        const auto box_id = static_cast<uint16_t>(graph.boxes.size());
+        graph.cell_box[box.lock_index] = box_id;
+        graph.cell_box[box.key_index] = box_id;
+        graph.colour_locks[static_cast<std::size_t>(box.lock_colour)].push_back(box.lock_index);
+        graph.boxes.push_back(box);
+    }
+    for (const auto& idx : key_indices) {
+        graph.colour_keys[static_cast<std::size_t>(board[idx])].push_back(static_cast<uint16_t>(idx));
+    }
+
+    // Breadth first over colours from those available at the start, recording the box which first gave each colour
+    std::array<uint16_t, kNumColours> colour_parent{};
+    std::array<bool, kNumColours> reached{};
+    colour_parent.fill(kNoBox);
+    std::vector<Element> queue;
+    const auto reach = [&](Element colour, uint16_t parent) {
+        const auto c = static_cast<std::size_t>(colour);
+        if (!reached[c]) {
+            reached[c] = true;
+            colour_parent[c] = parent;
+            queue.push_back(colour);
+        }
+    };
+    if (inventory != Element::kAgent) {
+        reach(inventory, kNoParent);
+    }
+    for (std::size_t c = 0; c < kNumColours; ++c) {
+        if (!graph.colour_keys[c].empty()) {
+            reach(static_cast<Element>(c), kNoParent);
+        }
+    }
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        for (const auto& lock_index : graph.colour_locks[static_cast<std::size_t>(queue[head])]) {
+            const auto box_id = graph.cell_box[lock_index];
+            reach(graph.boxes[box_id].key_colour, box_id);
+        }
+    }
+
+    const auto goal = static_cast<std::size_t>(Element::kColourGoal);
+    graph.is_goal_reachable = reached[goal];
+    if (!graph.is_goal_reachable) {
+        return graph;
+    }
+    std::array<bool, kNumColours> chain_colours{};
+    for (auto box_id = colour_parent[goal]; box_id != kNoParent;) {
+        auto& box = graph.boxes[box_id];
+        box.on_goal_chain = true;
+        graph.goal_chain.push_back(box_id);
+        chain_colours[static_cast<std::size_t>(box.lock_colour)] = true;
+        box_id = colour_parent[static_cast<std::size_t>(box.lock_colour)];
+    }
+    std::reverse(graph.goal_chain.begin(), graph.goal_chain.end());
+    for (auto& box : graph.boxes) {
+        box.is_distractor = !box.on_goal_chain && chain_colours[static_cast<std::size_t>(box.lock_colour)];
+    }
+    return graph;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,71 @@
+#ifndef BOXWORLD_KEY_LOCK_GRAPH_H_
+#define BOXWORLD_KEY_LOCK_GRAPH_H_
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "definitions.h"
+#include "flat_index_set.h"
+
+namespace boxworld {
+
+// Entry of KeyLockGraph::cell_box for cells which are not part of a box
+constexpr uint16_t kNoBox = std::numeric_limits<uint16_t>::max();
+
+// Lock and the key held inside it, to the left of the lock
+struct KeyLockBox {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint16_t lock_index = 0;                  // Cell of the lock
+    uint16_t key_index = 0;                   // Cell of the held key
+    Element lock_colour = Element::kEmpty;    // Colour of the key which opens the lock
+    Element key_colour = Element::kEmpty;     // Colour of the held key, added to the inventory on opening
+    bool on_goal_chain = false;               // Flag if opened on the shortest chain of boxes to the goal
+    bool is_distractor = false;               // Flag if off the goal chain but opened by a colour held along it
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Which keys open which boxes in the starting board of a level, built once per level.
+// The graph describes the level as it starts, and is not updated as keys are collected and locks opened.
+struct KeyLockGraph {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::vector<KeyLockBox> boxes;                                  // Boxes in order of their lock cell
+    std::vector<uint16_t> cell_box;                                 // Box of each lock or held key cell, else kNoBox
+    std::array<std::vector<uint16_t>, kNumColours> colour_locks;    // Lock cells opened by each colour
+    std::array<std::vector<uint16_t>, kNumColours> colour_keys;     // Single key cells of each colour
+    std::vector<uint16_t> goal_chain;                               // Boxes of the goal chain in opening order
+    bool is_goal_reachable = false;                                 // Flag if a chain of boxes reaches the goal
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    /**
+     * Get the box a cell belongs to
+     * @param index Board index
+     * @return The box with its lock or held key at the index, or nullptr if the cell is not part of a box
+     */
+    [[nodiscard]] auto box_at(std::size_t index) const noexcept -> const KeyLockBox * {
+        return index < cell_box.size() && cell_box[index] != kNoBox ? &boxes[cell_box[index]] : nullptr;
+    }
+
+    /**
+     * Get the number of boxes which are distractor branches
+     * @return Count of distractor boxes
+     */
+    [[nodiscard]] auto num_distractors() const noexcept -> std::size_t;
+};
+
+/**
+ * Build the key-lock graph of a board.
+ * The goal chain is the shortest chain of boxes from a held or single key to the box holding the goal.
+ * @param board Elements of the board
+ * @param key_indices Cells of the single keys
+ * @param lock_indices Cells of the locks, each with its held key in the cell to the left
+ * @param inventory Key held at the start, or kAgent if none
+ * @return The graph
+ */
+[[nodiscard]] auto build_key_lock_graph(const std::vector<Element> &board, const FlatIndexSet &key_indices,
+                                        const FlatIndexSet &lock_indices, Element inventory) -> KeyLockGraph;
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_KEY_LOCK_GRAPH_H_
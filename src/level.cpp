@@ -0,0 +1,229 @@
+#include "level.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#include "flat_index_set.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kSparseCellSize = sizeof(uint16_t) + sizeof(uint8_t);    // index, element
+constexpr std::size_t kSparseLevelHeaderSize = 2 * sizeof(uint16_t);          // rows, cols
+
+void write_u16(uint8_t* buffer, std::size_t value) noexcept {
+    const auto narrowed = static_cast<uint16_t>(value);
+    std::memcpy(buffer, &narrowed, sizeof(narrowed));
+}
+
+auto read_u16(const uint8_t* data) noexcept -> std::size_t {
+    uint16_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Parse the board string in a single pass, calling get_board(rows, cols) once for the buffer to write the cells into
+template <typename GetBoard>
+void parse_board_str(std::string_view board_str, GetBoard&& get_board) {
+    const char* it = board_str.data();
+    const char* const end = it + board_str.size();
+    // Parse the value up to the next separator, and move past it
+    const auto next_value = [&]() -> std::size_t {
+        std::size_t value = 0;
+        const auto [ptr, ec] = std::from_chars(it, end, value);
+        if (ec != std::errc() || (ptr != end && *ptr != '|')) {
+            throw std::invalid_argument("Board string should only contain integers separated by '|'.");
+        }
+        it = (ptr == end) ? end : ptr + 1;
+        return value;
+    };
+
+    // Check input
+    if (it == end) {
+        throw std::invalid_argument("Board string should have at minimum 3 values separated by '|'.");
+    }
+    const auto rows = next_value();
+    if (it == end) {
+        throw std::invalid_argument("Board string should have at minimum 3 values separated by '|'.");
+    }
+    const auto cols = next_value();
+    if (rows > kMaxBoardCells || cols > kMaxBoardCells || rows * cols > kMaxBoardCells) {
+        throw std::invalid_argument("Board is too large.");
+    }
+
+    // Parse
+    const auto num_cells = rows * cols;
+    Element* const board = get_board(rows, cols);
+    std::size_t count = 0;
+    while (it != end) {
+        if (count == num_cells) {
+            throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+        }
+        const auto el_idx = next_value();
+        if (el_idx >= kNumElements) {
+            throw std::invalid_argument("Unknown element type.");
+        }
+        board[count++] = static_cast<Element>(el_idx);
+    }
+    if (count != num_cells) {
+        throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+    }
+}
+}    // namespace
+
+auto parse_board(std::string_view board_str) -> Level {
+    Level level;
+    parse_board_str(board_str, [&](std::size_t rows, std::size_t cols) {
+        level.rows = rows;
+        level.cols = cols;
+        level.board.resize(rows * cols);
+        return level.board.data();
+    });
+    return level;
+}
+
+void parse_board_into(std::string_view board_str, std::size_t rows, std::size_t cols, Element* board) {
+    parse_board_str(board_str, [&](std::size_t parsed_rows, std::size_t parsed_cols) {
+        if (parsed_rows != rows || parsed_cols != cols) {
+            throw std::invalid_argument("Board dimensions do not match.");
+        }
+        return board;
+    });
+}
+
+void validate_level(const Level& level) {
+    if (level.board.size() != level.rows * level.cols) {
+        throw std::invalid_argument("Supplied rows/cols does not match input board length.");
+    }
+    if (level.board.size() > kMaxBoardCells) {
+        throw std::invalid_argument("Board is too large.");
+    }
+    for (const auto& el : level.board) {
+        if (static_cast<std::size_t>(el) >= kNumElements) {
+            throw std::invalid_argument("Unknown element type.");
+        }
+    }
+}
+
+auto to_board_str(const Level& level) -> std::string {
+    std::string board_str;
+    board_str.reserve((level.board.size() + 2) * 3);
+    const auto append = [&](std::size_t value) {
+        // Zero padded to at least two digits
+        if (value < 10) {
+            board_str += '0';
+        }
+        board_str += std::to_string(value);
+    };
+    append(level.rows);
+    board_str += '|';
+    append(level.cols);
+    for (const auto& el : level.board) {
+        board_str += '|';
+        append(static_cast<std::size_t>(el));
+    }
+    return board_str;
+}
+
+auto sparse_cells_size(const Element* board, std::size_t cells) noexcept -> std::size_t {
+    const auto num_cells = static_cast<std::size_t>(std::count_if(board, board + cells, [](Element el) {
+        return el != Element::kEmpty;
+    }));
+    return sizeof(uint16_t) + num_cells * kSparseCellSize;
+}
+
+auto encode_sparse_cells(const Element* board, std::size_t cells, uint8_t* buffer, std::size_t capacity)
+    -> std::size_t {
+    if (cells > kMaxBoardCells) {
+        throw std::invalid_argument("Board is too large.");
+    }
+    if (capacity < sizeof(uint16_t)) {
+        throw std::invalid_argument("Buffer too small to encode board.");
+    }
+    std::size_t offset = sizeof(uint16_t);
+    std::size_t num_cells = 0;
+    for (std::size_t idx = 0; idx < cells; ++idx) {
+        if (board[idx] == Element::kEmpty) {
+            continue;
+        }
+        if (offset + kSparseCellSize > capacity) {
+            throw std::invalid_argument("Buffer too small to encode board.");
+        }
+        write_u16(buffer + offset, idx);
+        buffer[offset + sizeof(uint16_t)] = static_cast<uint8_t>(board[idx]);
+        offset += kSparseCellSize;
+        ++num_cells;
+    }
+    write_u16(buffer, num_cells);
+    return offset;
+}
+
+auto decode_sparse_cells(const uint8_t* data, std::size_t size, Element* board, std::size_t cells) -> std::size_t {
+    if (size < sizeof(uint16_t)) {
+        throw std::invalid_argument("Sparse board encoding is truncated.");
+    }
+    const auto num_cells = read_u16(data);
+    const auto bytes = sizeof(uint16_t) + num_cells * kSparseCellSize;
+    if (size < bytes) {
+        throw std::invalid_argument("Sparse board encoding is truncated.");
+    }
+    std::fill_n(board, cells, Element::kEmpty);
+    std::size_t next_idx = 0;
+    for (const auto* cell = data + sizeof(uint16_t); cell != data + bytes; cell += kSparseCellSize) {
+        const auto idx = read_u16(cell);
+        const auto el = cell[sizeof(uint16_t)];
+        // Increasing indices, so each cell is set at most once
+        if (idx < next_idx || idx >= cells || el >= kNumElements || static_cast<Element>(el) == Element::kEmpty) {
+            throw std::invalid_argument("Malformed sparse board encoding.");
+        }
+        board[idx] = static_cast<Element>(el);
+        next_idx = idx + 1;
+    }
+    return bytes;
+}
+
+auto sparse_level_size(const Level& level) noexcept -> std::size_t {
+    return kSparseLevelHeaderSize + sparse_cells_size(level.board.data(), level.board.size());
+}
+
+auto encode_sparse_level(const Level& level, uint8_t* buffer, std::size_t capacity) -> std::size_t {
+    validate_level(level);
+    if (capacity < kSparseLevelHeaderSize) {
+        throw std::invalid_argument("Buffer too small to encode level.");
+    }
+    write_u16(buffer, level.rows);
+    write_u16(buffer + sizeof(uint16_t), level.cols);
+    return kSparseLevelHeaderSize + encode_sparse_cells(level.board.data(), level.board.size(),
+                                                        buffer + kSparseLevelHeaderSize,
+                                                        capacity - kSparseLevelHeaderSize);
+}
+
+auto encode_sparse_level(const Level& level) -> std::vector<uint8_t> {
+    std::vector<uint8_t> bytes(sparse_level_size(level));
+    bytes.resize(encode_sparse_level(level, bytes.data(), bytes.size()));
+    return bytes;
+}
+
+auto decode_sparse_level(const uint8_t* data, std::size_t size, std::size_t* bytes_read) -> Level {
+    if (size < kSparseLevelHeaderSize) {
+        throw std::invalid_argument("Sparse level encoding is truncated.");
+    }
+    Level level;
+    level.rows = read_u16(data);
+    level.cols = read_u16(data + sizeof(uint16_t));
+    if (level.rows * level.cols > kMaxBoardCells) {
+        throw std::invalid_argument("Board is too large.");
+    }
+    level.board.resize(level.rows * level.cols);
+    const auto bytes = kSparseLevelHeaderSize + decode_sparse_cells(data + kSparseLevelHeaderSize,
+                                                                     size - kSparseLevelHeaderSize,
+                                                                     level.board.data(), level.board.size());
+    if (bytes_read != nullptr) {
+        *bytes_read = bytes;
+    }
+    return level;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,135 @@
+#ifndef BOXWORLD_LEVEL_H_
+#define BOXWORLD_LEVEL_H_
+
+#include <nop/structure.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "definitions.h"
+
+namespace boxworld {
+
+// Starting board of a level, independent of any game state
+struct Level {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::size_t rows = 0;            // Rows of the board
+    std::size_t cols = 0;            // Cols of the board
+    std::vector<Element> board{};    // Element of each cell, row major
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator==(const Level &other) const noexcept -> bool {
+        return rows == other.rows && cols == other.cols && board == other.board;
+    }
+    NOP_STRUCTURE(Level, rows, cols, board);
+};
+
+/**
+ * Parse a board string, in the format of the game_board_str game parameter.
+ * The string is parsed in a single pass without allocating, other than for the returned board.
+ * @note Throws std::invalid_argument if the board string is malformed
+ * @param board_str The board string, rows|cols|cell|cell|...
+ * @return The parsed level
+ */
+[[nodiscard]] auto parse_board(std::string_view board_str) -> Level;
+
+/**
+ * Parse a board string of known dimensions into the given buffer, without allocating.
+ * @note Throws std::invalid_argument if the board string is malformed or its dimensions differ
+ * @param board_str The board string, rows|cols|cell|cell|...
+ * @param rows Expected rows of the board
+ * @param cols Expected cols of the board
+ * @param board Start of the rows * cols elements to write the board into
+ */
+void parse_board_into(std::string_view board_str, std::size_t rows, std::size_t cols, Element *board);
+
+/**
+ * Check the level dimensions and elements are valid.
+ * @note Throws std::invalid_argument if the level is invalid
+ * @param level The level to check
+ */
+void validate_level(const Level &level);
+
+/**
+ * Format a level as a board string, in the same format as scripts/generate_levelset.py.
+ * @param level The level to format
+ * @return Board string usable as the game_board_str game parameter
+ */
+[[nodiscard]] auto to_board_str(const Level &level) -> std::string;
+
+// Sparse encoding of a board, which stores only the non-empty cells, in native byte order:
+//   uint16_t num_cells, then num_cells of (uint16_t index, uint8_t element) in increasing index order
+
+/**
+ * Get the number of bytes encode_sparse_cells() writes for the board.
+ * @param board Start of the board elements
+ * @param cells Number of cells of the board
+ * @return Size of the encoding in bytes
+ */
+[[nodiscard]] auto sparse_cells_size(const Element *board, std::size_t cells) noexcept -> std::size_t;
+
+/**
+ * Write the non-empty cells of the board into the given buffer.
+ * @note Throws std::invalid_argument if the buffer is too small or the board has more than kMaxBoardCells cells
+ * @param board Start of the board elements
+ * @param cells Number of cells of the board
+ * @param buffer Start of the buffer to write into
+ * @param capacity Size of the buffer in bytes, should be at least sparse_cells_size()
+ * @return Number of bytes written
+ */
+auto encode_sparse_cells(const Element *board, std::size_t cells, uint8_t *buffer, std::size_t capacity)
+    -> std::size_t;
+
+/**
+ * Read the cells written by encode_sparse_cells() into the given board, setting every other cell to empty.
+ * @note Throws std::invalid_argument if the encoding is truncated, or has cells out of order or out of range
+ * @param data Start of the encoded bytes
+ * @param size Number of encoded bytes available
+ * @param board Start of the board elements to write into
+ * @param cells Number of cells of the board
+ * @return Number of bytes read
+ */
+auto decode_sparse_cells(const uint8_t *data, std::size_t size, Element *board, std::size_t cells) -> std::size_t;
+
+/**
+ * Get the number of bytes encode_sparse_level() writes for the level.
+ * @param level The level to encode
+ * @return Size of the encoding in bytes
+ */
+[[nodiscard]] auto sparse_level_size(const Level &level) noexcept -> std::size_t;
+
+/**
+ * Write the level as uint16_t rows, uint16_t cols, then the sparse encoding of its board.
+ * Generated boards are mostly empty, so this is several times smaller than a board string or the board itself.
+ * @note Throws std::invalid_argument if the level is invalid or the buffer is too small
+ * @param level The level to encode
+ * @param buffer Start of the buffer to write into
+ * @param capacity Size of the buffer in bytes, should be at least sparse_level_size()
+ * @return Number of bytes written
+ */
+auto encode_sparse_level(const Level &level, uint8_t *buffer, std::size_t capacity) -> std::size_t;
+
+/**
+ * Encode the level, see encode_sparse_level(const Level &, uint8_t *, std::size_t).
+ * @note Throws std::invalid_argument if the level is invalid
+ * @param level The level to encode
+ * @return The encoded bytes
+ */
+[[nodiscard]] auto encode_sparse_level(const Level &level) -> std::vector<uint8_t>;
+
+/**
+ * Read a level written by encode_sparse_level().
+ * @note Throws std::invalid_argument if the encoding is malformed
+ * @param data Start of the encoded bytes
+ * @param size Number of encoded bytes available, which may continue past the level
+ * @param bytes_read Set to the number of bytes of the level if not nullptr
+ * @return The decoded level
+ */
+[[nodiscard]] auto decode_sparse_level(const uint8_t *data, std::size_t size, std::size_t *bytes_read = nullptr)
+    -> Level;
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_LEVEL_H_
@@ -0,0 +1,159 @@
+#include "level_generator.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "parallel.h"
+#include "rng.h"
+
+namespace boxworld {
+
+namespace {
+
+constexpr std::size_t kNumKeyColours = kNumColours - 1;    // Colours which are not the goal
+
+// Remove and return a uniformly sampled value
+template <typename T>
+auto sample_remove(std::vector<T> &values, SplitMix64 &rng) -> T {
+    const auto idx = static_cast<std::size_t>(rng.next_below(values.size()));
+    const T value = values[idx];
+    values.erase(values.begin() + static_cast<std::ptrdiff_t>(idx));
+    return value;
+}
+
+// Sample n distinct values from the given values
+template <typename T>
+auto sample_distinct(std::vector<T> values, std::size_t n, SplitMix64 &rng) -> std::vector<T> {
+    std::vector<T> samples;
+    samples.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        samples.push_back(sample_remove(values, rng));
+    }
+    return samples;
+}
+
+}    // namespace
+
+LevelGenerator::LevelGenerator(const GeneratorConfig &config) : config(config) {
+    if (config.map_size < 3) {
+        throw std::invalid_argument("Map size must be at least 3.");
+    }
+    if (config.goal_length < 2) {
+        throw std::invalid_argument("Goal length must be at least 2.");
+    }
+    if (config.num_distractor > 0 && config.distractor_length == 0) {
+        throw std::invalid_argument("Distractor length must be positive.");
+    }
+    if (config.goal_length - 1 + (config.num_distractor > 0 ? config.distractor_length : 0) > kNumKeyColours) {
+        throw std::invalid_argument("Not enough colours for the goal and distractor lengths.");
+    }
+}
+
+auto LevelGenerator::get_config() const noexcept -> const GeneratorConfig & {
+    return config;
+}
+
+auto LevelGenerator::generate(uint64_t seed) const -> Level {
+    SplitMix64 rng(seed);
+    const std::size_t n = config.map_size;
+    const std::size_t num_pairs = config.goal_length - 1 + config.distractor_length * config.num_distractor;
+
+    // Colours of the goal path and distractor paths
+    std::vector<std::size_t> colours(kNumKeyColours);
+    std::iota(colours.begin(), colours.end(), 0);
+    const auto goal_colours = sample_distinct(colours, config.goal_length - 1, rng);
+    std::vector<std::size_t> distractor_possible_colours;
+    for (const auto &c : colours) {
+        if (std::find(goal_colours.begin(), goal_colours.end(), c) == goal_colours.end()) {
+            distractor_possible_colours.push_back(c);
+        }
+    }
+    std::vector<std::vector<std::size_t>> distractor_colours;
+    std::vector<std::size_t> distractor_roots;
+    for (std::size_t i = 0; i < config.num_distractor; ++i) {
+        distractor_colours.push_back(sample_distinct(distractor_possible_colours, config.distractor_length, rng));
+        distractor_roots.push_back(static_cast<std::size_t>(rng.next_below(config.goal_length - 1)));
+    }
+
+    // Positions of (key, lock) pairs, agent and first key.
+    // Positions index a n x (n - 1) grid so the lock always fits to the right of the key, and cells next to a pair
+    // are removed so no two pairs are horizontally adjacent.
+    std::vector<std::size_t> possibilities(n * (n - 1) - 1);
+    std::iota(possibilities.begin(), possibilities.end(), 1);
+    const auto remove = [&](std::size_t p) {
+        const auto it = std::lower_bound(possibilities.begin(), possibilities.end(), p);
+        if (it != possibilities.end() && *it == p) {
+            possibilities.erase(it);
+        }
+    };
+    std::vector<std::pair<std::size_t, std::size_t>> keys;
+    keys.reserve(num_pairs);
+    for (std::size_t i = 0; i < num_pairs; ++i) {
+        if (possibilities.empty()) {
+            throw std::invalid_argument("Map size too small for the number of keys and locks.");
+        }
+        const auto key = possibilities[static_cast<std::size_t>(rng.next_below(possibilities.size()))];
+        const auto key_x = key / (n - 1);
+        const auto key_y = key % (n - 1);
+        remove(key);
+        for (std::size_t j = 1; j <= std::min<std::size_t>(2, n - 2 - key_y); ++j) {
+            remove(key + j);
+        }
+        for (std::size_t j = 1; j <= std::min<std::size_t>(2, key_y); ++j) {
+            remove(key - j);
+        }
+        keys.emplace_back(key_x, key_y);
+    }
+    if (possibilities.size() < 2) {
+        throw std::invalid_argument("Map size too small for the number of keys and locks.");
+    }
+    const auto agent_pos = sample_remove(possibilities, rng);
+    const auto first_key = sample_remove(possibilities, rng);
+
+    Level level{n, n, std::vector<Element>(n * n, Element::kEmpty)};
+    const auto set = [&](std::size_t x, std::size_t y, std::size_t el) {
+        level.board[x * n + y] = static_cast<Element>(el);
+    };
+    const auto set_pair = [&](std::size_t pair_idx, std::size_t key_colour, std::size_t lock_colour) {
+        set(keys[pair_idx].first, keys[pair_idx].second, key_colour);
+        set(keys[pair_idx].first, keys[pair_idx].second + 1, lock_colour);
+    };
+
+    // First, create the goal path
+    const auto goal_length = config.goal_length;
+    for (std::size_t i = 1; i < goal_length; ++i) {
+        const auto c = (i == goal_length - 1) ? static_cast<std::size_t>(Element::kColourGoal) : goal_colours[i];
+        set_pair(i - 1, c, goal_colours[i - 1]);
+    }
+    // Orphaned key which opens the first box
+    set(first_key / (n - 1), first_key % (n - 1), goal_colours[0]);
+
+    // Place distractors, each branching off a lock of the goal path
+    for (std::size_t i = 0; i < config.num_distractor; ++i) {
+        const auto first_pair = goal_length - 1 + i * config.distractor_length;
+        const auto &distractor_colour = distractor_colours[i];
+        set_pair(first_pair, distractor_colour[0], goal_colours[distractor_roots[i]]);
+        for (std::size_t k = 1; k < config.distractor_length; ++k) {
+            set_pair(first_pair + k, distractor_colour[k], distractor_colour[k - 1]);
+        }
+    }
+
+    // Place an agent
+    set(agent_pos / (n - 1), agent_pos % (n - 1), static_cast<std::size_t>(Element::kAgent));
+    return level;
+}
+
+auto LevelGenerator::generate(uint64_t first_seed, std::size_t count, std::size_t num_threads) const
+    -> std::vector<Level> {
+    std::vector<Level> levels(count);
+    parallel_for(count, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            levels[i] = generate(first_seed + i);
+        }
+    });
+    return levels;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,62 @@
+#ifndef BOXWORLD_LEVEL_GENERATOR_H_
+#define BOXWORLD_LEVEL_GENERATOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "level.h"
+
+namespace boxworld {
+
+// Parameters of generated levels, same as those of scripts/generate_levelset.py
+struct GeneratorConfig {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::size_t map_size = 10;             // Size of map width/height
+    std::size_t goal_length = 3;           // Length of the goal path, including the goal
+    std::size_t num_distractor = 2;        // Number of distractor paths
+    std::size_t distractor_length = 2;     // Length of distractor paths
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Generates random levels with a goal path of keys/boxes, and distractor paths branching off of the goal path.
+// Levels are deterministic for a given config and seed.
+class LevelGenerator {
+public:
+    /**
+     * @param config Parameters of generated levels, which are validated on construction
+     */
+    explicit LevelGenerator(const GeneratorConfig &config);
+
+    /**
+     * Get the parameters of generated levels
+     * @return The generator config
+     */
+    [[nodiscard]] auto get_config() const noexcept -> const GeneratorConfig &;
+
+    /**
+     * Generate a single level.
+     * @note Throws std::invalid_argument if the keys and locks of the seed do not fit on the map, which only depends on
+     * the seed for a crowded map
+     * @param seed Seed of the level
+     * @return The generated level
+     */
+    [[nodiscard]] auto generate(uint64_t seed) const -> Level;
+
+    /**
+     * Generate the level for each seed in [first_seed, first_seed + count).
+     * @note Throws std::invalid_argument if the level of any seed cannot be generated, see generate(uint64_t)
+     * @param first_seed Seed of the first level
+     * @param count Number of levels
+     * @param num_threads Number of threads to generate with, 0 to use the hardware concurrency
+     * @return The generated levels, in order of seed
+     */
+    [[nodiscard]] auto generate(uint64_t first_seed, std::size_t count, std::size_t num_threads = 0) const
+        -> std::vector<Level>;
+
+private:
+    GeneratorConfig config;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_LEVEL_GENERATOR_H_
@@ -0,0 +1,180 @@
+#include "level_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "parallel.h"
+#include "zobrist.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kHashGrainSize = 1024;
+
+// Boards of a pack are not validated when mapped, so elements are checked before they index the tables
+auto hash_board(const Element* board, std::size_t cells, const ZobristTable& zobrist) -> uint64_t {
+    uint64_t hash = 0;
+    for (std::size_t i = 0; i < cells; ++i) {
+        const auto el = static_cast<std::size_t>(board[i]);
+        if (el >= kNumElements) {
+            throw std::invalid_argument("Board has an unknown element.");
+        }
+        hash ^= zobrist.board[el * cells + i];
+    }
+    return hash;
+}
+}    // namespace
+
+auto compute_board_hash(const Element* board, std::size_t rows, std::size_t cols) -> uint64_t {
+    return hash_board(board, rows * cols, *get_zobrist_table(rows, cols));
+}
+
+LevelIndex::LevelIndex(std::size_t rows, std::size_t cols, std::vector<LevelIndexEntry> entries)
+    : num_rows(rows), num_cols(cols), entries(std::move(entries)) {
+    std::sort(this->entries.begin(), this->entries.end());
+}
+
+LevelIndex::LevelIndex(const LevelPack& pack, std::size_t num_threads) : num_rows(pack.rows()), num_cols(pack.cols()) {
+    const auto zobrist = get_zobrist_table(num_rows, num_cols);
+    const auto cells = num_rows * num_cols;
+    entries.resize(pack.size());
+    parallel_for_dynamic(pack.size(), num_threads, kHashGrainSize, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            entries[i] = {hash_board(pack.get_record(i).board, cells, *zobrist), i};
+        }
+    });
+    std::sort(entries.begin(), entries.end());
+}
+
+LevelIndex::LevelIndex(const std::vector<Level>& levels) : num_rows(0), num_cols(0) {
+    if (levels.empty()) {
+        throw std::invalid_argument("Cannot index an empty set of levels.");
+    }
+    num_rows = levels.front().rows;
+    num_cols = levels.front().cols;
+    const auto zobrist = get_zobrist_table(num_rows, num_cols);
+    const auto cells = num_rows * num_cols;
+    entries.reserve(levels.size());
+    for (const auto& level : levels) {
+        if (level.rows != num_rows || level.cols != num_cols || level.board.size() != cells) {
+            throw std::invalid_argument("All indexed levels must have the same board dimensions.");
+        }
+        entries.push_back({hash_board(level.board.data(), cells, *zobrist), entries.size()});
+    }
+    std::sort(entries.begin(), entries.end());
+}
+
+auto LevelIndex::read(const std::string& path) -> LevelIndex {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open level index: " + path);
+    }
+    const std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad()) {
+        throw std::runtime_error("Unable to read level index: " + path);
+    }
+    LevelIndexHeader header{};
+    if (buffer.size() < sizeof(header)) {
+        throw std::invalid_argument("Level index is too small: " + path);
+    }
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (std::memcmp(header.magic, kLevelIndexMagic, sizeof(header.magic)) != 0) {
+        throw std::invalid_argument("Not a level index: " + path);
+    }
+    if (header.version != kLevelIndexVersion) {
+        throw std::invalid_argument("Unsupported level index version: " + path);
+    }
+    if ((buffer.size() - sizeof(header)) / sizeof(LevelIndexEntry) != header.count ||
+        (buffer.size() - sizeof(header)) % sizeof(LevelIndexEntry) != 0) {
+        throw std::invalid_argument("Level index is truncated: " + path);
+    }
+    std::vector<LevelIndexEntry> entries(header.count);
+    std::memcpy(entries.data(), buffer.data() + sizeof(header), entries.size() * sizeof(LevelIndexEntry));
+    if (!std::is_sorted(entries.begin(), entries.end())) {
+        throw std::invalid_argument("Level index is not sorted: " + path);
+    }
+    return {header.rows, header.cols, std::move(entries)};
+}
+
+void LevelIndex::write(const std::string& path) const {
+    LevelIndexHeader header{};
+    std::memcpy(header.magic, kLevelIndexMagic, sizeof(header.magic));
+    header.version = kLevelIndexVersion;
+    header.rows = static_cast<uint32_t>(num_rows);
+    header.cols = static_cast<uint32_t>(num_cols);
+    header.count = entries.size();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Unable to open level index for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(LevelIndexEntry)));
+    if (!file) {
+        throw std::runtime_error("Unable to write level index: " + path);
+    }
+}
+
+auto LevelIndex::size() const noexcept -> std::size_t {
+    return entries.size();
+}
+
+auto LevelIndex::rows() const noexcept -> std::size_t {
+    return num_rows;
+}
+
+auto LevelIndex::cols() const noexcept -> std::size_t {
+    return num_cols;
+}
+
+auto LevelIndex::contains(uint64_t hash) const noexcept -> bool {
+    const auto it = std::lower_bound(entries.begin(), entries.end(), LevelIndexEntry{hash, 0});
+    return it != entries.end() && it->hash == hash;
+}
+
+auto LevelIndex::contains(const Level& level) const -> bool {
+    if (level.rows != num_rows || level.cols != num_cols || level.board.size() != num_rows * num_cols) {
+        return false;
+    }
+    return contains(compute_board_hash(level.board.data(), num_rows, num_cols));
+}
+
+auto LevelIndex::unique_indices() const -> std::vector<std::size_t> {
+    // Entries of equal hashes are sorted by level index, so the first of each run is the first occurrence
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (i == 0 || entries[i].hash != entries[i - 1].hash) {
+            indices.push_back(static_cast<std::size_t>(entries[i].index));
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+auto LevelIndex::overlap(const LevelIndex& other) const -> std::vector<std::size_t> {
+    if (num_rows != other.num_rows || num_cols != other.num_cols) {
+        throw std::invalid_argument("Level indices have different board dimensions.");
+    }
+    std::vector<std::size_t> indices;
+    auto other_it = other.entries.begin();
+    for (const auto& entry : entries) {
+        while (other_it != other.entries.end() && other_it->hash < entry.hash) {
+            ++other_it;
+        }
+        if (other_it != other.entries.end() && other_it->hash == entry.hash) {
+            indices.push_back(static_cast<std::size_t>(entry.index));
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+auto LevelIndex::get_entries() const noexcept -> const std::vector<LevelIndexEntry>& {
+    return entries;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,152 @@
+#ifndef BOXWORLD_LEVEL_INDEX_H_
+#define BOXWORLD_LEVEL_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "level.h"
+#include "level_pack.h"
+
+namespace boxworld {
+
+// Header at the start of a level index file.
+// The header is followed by count LevelIndexEntry, sorted by hash then level index, in native byte order.
+struct LevelIndexHeader {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    char magic[4];        // Always kLevelIndexMagic
+    uint32_t version;     // Always kLevelIndexVersion
+    uint32_t rows;        // Rows of every indexed board
+    uint32_t cols;        // Cols of every indexed board
+    uint64_t count;       // Number of indexed levels
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+constexpr char kLevelIndexMagic[4] = {'B', 'W', 'L', 'I'};
+constexpr uint32_t kLevelIndexVersion = 1;
+
+// Hash of an indexed level and its index in the levels the index was built from
+struct LevelIndexEntry {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t hash = 0;
+    uint64_t index = 0;
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator<(const LevelIndexEntry &other) const noexcept -> bool {
+        return hash < other.hash || (hash == other.hash && index < other.index);
+    }
+};
+
+/**
+ * Hash a starting board with the Zobrist tables of its size, which is get_hash() of a state reset to the board
+ * without collect_first_key.
+ * @note Throws std::invalid_argument if the board has an unknown element
+ * @param board rows * cols elements of the board
+ * @param rows Rows of the board
+ * @param cols Cols of the board
+ * @return The Zobrist hash of the board
+ */
+[[nodiscard]] auto compute_board_hash(const Element *board, std::size_t rows, std::size_t cols) -> uint64_t;
+
+// Sorted index of the board hashes of a set of levels of one board size, for membership checks, deduplication,
+// and overlap detection between level sets without comparing boards.
+// @note Boards are compared by their 64-bit hash only, so distinct boards collide with negligible probability
+class LevelIndex {
+public:
+    LevelIndex() = delete;
+
+    /**
+     * Hash every level of the pack in parallel and sort the hashes.
+     * @note Throws std::invalid_argument if a record of the pack is malformed or has an unknown element
+     * @param pack The levels to index
+     * @param num_threads Number of threads to hash with, 0 to use the hardware concurrency
+     */
+    explicit LevelIndex(const LevelPack &pack, std::size_t num_threads = 0);
+
+    /**
+     * Index the levels, which must all have the same board dimensions.
+     * @note Throws std::invalid_argument if the levels are empty, differ in dimensions, or have an unknown element
+     * @param levels The levels to index
+     */
+    explicit LevelIndex(const std::vector<Level> &levels);
+
+    /**
+     * Read a level index written by write(), with a single read of the whole file.
+     * @note Throws std::runtime_error if the file cannot be read, or std::invalid_argument if it is malformed
+     * @param path Path of the index file
+     * @return The index
+     */
+    [[nodiscard]] static auto read(const std::string &path) -> LevelIndex;
+
+    /**
+     * Write the index to a file.
+     * @note Throws std::runtime_error if the file cannot be written
+     * @param path Path of the file to write
+     */
+    void write(const std::string &path) const;
+
+    /**
+     * Get the number of indexed levels, including duplicates
+     * @return Count of levels
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the rows of every indexed board
+     * @return Board rows
+     */
+    [[nodiscard]] auto rows() const noexcept -> std::size_t;
+
+    /**
+     * Get the cols of every indexed board
+     * @return Board cols
+     */
+    [[nodiscard]] auto cols() const noexcept -> std::size_t;
+
+    /**
+     * Check if a board with the given hash is indexed, with a binary search.
+     * @param hash Hash of the board, see compute_board_hash()
+     * @return True if a level with the hash is indexed
+     */
+    [[nodiscard]] auto contains(uint64_t hash) const noexcept -> bool;
+
+    /**
+     * Check if the level is indexed.
+     * @note Throws std::invalid_argument if the level has an unknown element
+     * @param level The level to look up
+     * @return True if the level has the indexed board dimensions and its board is indexed
+     */
+    [[nodiscard]] auto contains(const Level &level) const -> bool;
+
+    /**
+     * Get the indices of the first level of each distinct board, so the first occurrence of every duplicate is kept.
+     * @return Level indices in increasing order
+     */
+    [[nodiscard]] auto unique_indices() const -> std::vector<std::size_t>;
+
+    /**
+     * Get the indices of the levels whose board is also in the other index, such as of a train set against its test
+     * set, with a single merge of both sorted indices.
+     * @note Throws std::invalid_argument if the indices are of different board dimensions
+     * @param other The index to check against
+     * @return Level indices of this index in increasing order
+     */
+    [[nodiscard]] auto overlap(const LevelIndex &other) const -> std::vector<std::size_t>;
+
+    /**
+     * Get the sorted entries of the index
+     * @return Entries sorted by hash then level index
+     */
+    [[nodiscard]] auto get_entries() const noexcept -> const std::vector<LevelIndexEntry> &;
+
+private:
+    LevelIndex(std::size_t rows, std::size_t cols, std::vector<LevelIndexEntry> entries);
+
+    std::size_t num_rows;
+    std::size_t num_cols;
+    std::vector<LevelIndexEntry> entries;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_LEVEL_INDEX_H_
@@ -0,0 +1,462 @@
+#include "level_pack.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "boxworld_base.h"
+#include "parallel.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kRecordFixedFields = 4;    // agent_idx, num_keys, num_locks, reserved
+constexpr std::size_t kRecordAlignment = 8;
+
+auto get_record_size(std::size_t cells, std::size_t max_indices) noexcept -> std::size_t {
+    const auto size = (kRecordFixedFields + max_indices) * sizeof(uint16_t) + cells;
+    return (size + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+}
+
+// Append the single key then lock indices of the board to indices, with the same rules as the game state.
+// Locks are gathered in the reused locks buffer, and the counts of keys and locks are returned.
+auto append_keys_and_locks(const Element* board, std::size_t rows, std::size_t cols, std::vector<uint16_t>& indices,
+                           std::vector<uint16_t>& locks) -> std::pair<std::size_t, std::size_t> {
+    const auto is_colour = [&](std::size_t idx) {
+        return board[idx] != Element::kEmpty && board[idx] != Element::kAgent;
+    };
+    const auto num_indices = indices.size();
+    locks.clear();
+    for (std::size_t idx = 0; idx < rows * cols; ++idx) {
+        if (!is_colour(idx)) {
+            continue;
+        }
+        const auto col = idx % cols;
+        const bool is_left_colour = col > 0 && is_colour(idx - 1);
+        const bool is_right_colour = col + 1 < cols && is_colour(idx + 1);
+        if (is_left_colour) {
+            locks.push_back(static_cast<uint16_t>(idx));
+        } else if (!is_right_colour) {
+            indices.push_back(static_cast<uint16_t>(idx));
+        }
+    }
+    const auto num_keys = indices.size() - num_indices;
+    indices.insert(indices.end(), locks.begin(), locks.end());
+    return {num_keys, locks.size()};
+}
+
+// Read only mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open level file: " + path);
+        }
+        struct stat file_stat {};
+        if (::fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Unable to read level file: " + path);
+        }
+        size = static_cast<std::size_t>(file_stat.st_size);
+        void* mapped = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Unable to map level file: " + path);
+        }
+        data = static_cast<const char*>(mapped);
+    }
+    ~MappedFile() {
+        if (data != nullptr) {
+            ::munmap(const_cast<char*>(data), size);    // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+    auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+    [[nodiscard]] auto view() const noexcept -> std::string_view {
+        return {data, size};
+    }
+
+private:
+    const char* data = nullptr;
+    std::size_t size = 0;
+};
+}    // namespace
+
+void write_level_pack(const std::string& path, const std::vector<Level>& levels) {
+    if (levels.empty()) {
+        throw std::invalid_argument("Level pack must contain at least one level.");
+    }
+    const auto rows = levels.front().rows;
+    const auto cols = levels.front().cols;
+    for (const auto& level : levels) {
+        if (level.rows != rows || level.cols != cols) {
+            throw std::invalid_argument("All levels in a pack must have the same board dimensions.");
+        }
+    }
+
+    // Precompute the agent and key/lock indices with the same rules as the game state
+    BoxWorldGameState state(kDefaultGameParams);
+    std::vector<std::vector<uint16_t>> records;
+    records.reserve(levels.size());
+    std::size_t max_indices = 0;
+    for (const auto& level : levels) {
+        state.reset(level);
+        const auto& keys = state.get_key_indices();
+        const auto& locks = state.get_lock_indices();
+        std::vector<uint16_t> fields{static_cast<uint16_t>(state.get_agent_index()),
+                                     static_cast<uint16_t>(keys.size()), static_cast<uint16_t>(locks.size()), 0};
+        fields.insert(fields.end(), keys.begin(), keys.end());
+        fields.insert(fields.end(), locks.begin(), locks.end());
+        max_indices = std::max(max_indices, keys.size() + locks.size());
+        records.push_back(std::move(fields));
+    }
+
+    const auto cells = rows * cols;
+    LevelPackHeader header{};
+    std::memcpy(header.magic, kLevelPackMagic, sizeof(header.magic));
+    header.version = kLevelPackVersion;
+    header.rows = static_cast<uint32_t>(rows);
+    header.cols = static_cast<uint32_t>(cols);
+    header.max_indices = static_cast<uint32_t>(max_indices);
+    header.record_size = static_cast<uint32_t>(get_record_size(cells, max_indices));
+    header.count = levels.size();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Unable to open level pack for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<uint8_t> buffer(header.record_size);
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        std::memcpy(buffer.data(), records[i].data(), records[i].size() * sizeof(uint16_t));
+        std::memcpy(buffer.data() + (kRecordFixedFields + max_indices) * sizeof(uint16_t), levels[i].board.data(),
+                    cells);
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    }
+    if (!file) {
+        throw std::runtime_error("Unable to write level pack: " + path);
+    }
+}
+
+auto read_level_file(const std::string& path) -> std::vector<Level> {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Unable to open level file: " + path);
+    }
+    std::vector<Level> levels;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            levels.push_back(parse_board(line));
+        }
+    }
+    return levels;
+}
+
+void write_sparse_level_file(const std::string& path, const std::vector<Level>& levels) {
+    SparseLevelFileHeader header{};
+    std::memcpy(header.magic, kSparseLevelFileMagic, sizeof(header.magic));
+    header.version = kSparseLevelFileVersion;
+    header.count = levels.size();
+    std::size_t size = sizeof(header);
+    for (const auto& level : levels) {
+        size += sparse_level_size(level);
+    }
+    std::vector<uint8_t> buffer(size);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::size_t offset = sizeof(header);
+    for (const auto& level : levels) {
+        offset += encode_sparse_level(level, buffer.data() + offset, buffer.size() - offset);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Unable to open sparse level file for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(offset));
+    if (!file) {
+        throw std::runtime_error("Unable to write sparse level file: " + path);
+    }
+}
+
+auto read_sparse_level_file(const std::string& path) -> std::vector<Level> {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Unable to open sparse level file: " + path);
+    }
+    std::vector<uint8_t> buffer(static_cast<std::size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!file) {
+        throw std::runtime_error("Unable to read sparse level file: " + path);
+    }
+
+    SparseLevelFileHeader header{};
+    if (buffer.size() < sizeof(header)) {
+        throw std::invalid_argument("Sparse level file is too small: " + path);
+    }
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (std::memcmp(header.magic, kSparseLevelFileMagic, sizeof(header.magic)) != 0) {
+        throw std::invalid_argument("Not a sparse level file: " + path);
+    }
+    if (header.version != kSparseLevelFileVersion) {
+        throw std::invalid_argument("Unsupported sparse level file version: " + path);
+    }
+    // Every level takes at least its dimensions and cell count, so the count is bounded before reserving
+    constexpr std::size_t kMinLevelSize = 3 * sizeof(uint16_t);
+    if (header.count > (buffer.size() - sizeof(header)) / kMinLevelSize) {
+        throw std::invalid_argument("Sparse level file is truncated: " + path);
+    }
+    std::vector<Level> levels;
+    levels.reserve(header.count);
+    std::size_t offset = sizeof(header);
+    for (uint64_t i = 0; i < header.count; ++i) {
+        std::size_t bytes_read = 0;
+        levels.push_back(decode_sparse_level(buffer.data() + offset, buffer.size() - offset, &bytes_read));
+        offset += bytes_read;
+    }
+    return levels;
+}
+
+LevelPack::LevelPack(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open level pack: " + path);
+    }
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) != 0 || static_cast<std::size_t>(file_stat.st_size) < sizeof(LevelPackHeader)) {
+        ::close(fd);
+        throw std::invalid_argument("Level pack is too small: " + path);
+    }
+    mapped_size = static_cast<std::size_t>(file_stat.st_size);
+    void* mapped = ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        mapped_size = 0;
+        throw std::runtime_error("Unable to map level pack: " + path);
+    }
+    data = static_cast<const uint8_t*>(mapped);
+
+    // Validate header
+    std::memcpy(&header, data, sizeof(header));
+    const auto cells = static_cast<std::size_t>(header.rows) * header.cols;
+    std::string error;
+    if (std::memcmp(header.magic, kLevelPackMagic, sizeof(header.magic)) != 0) {
+        error = "Not a level pack: ";
+    } else if (header.version != kLevelPackVersion) {
+        error = "Unsupported level pack version: ";
+    } else if (cells == 0 || cells > kMaxBoardCells ||
+               header.record_size != get_record_size(cells, header.max_indices)) {
+        error = "Malformed level pack header: ";
+    } else if ((mapped_size - sizeof(header)) / header.record_size < header.count) {
+        error = "Level pack is truncated: ";
+    }
+    if (!error.empty()) {
+        Unmap();
+        throw std::invalid_argument(error + path);
+    }
+}
+
+auto LevelPack::load_level_file(const std::string& path, std::size_t num_threads) -> LevelPack {
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    const MappedFile file(path);
+    const auto text = file.view();
+
+    // Split into chunks ending on line boundaries, several per thread to balance uneven lines
+    const auto max_chunks = std::max<std::size_t>(std::min(num_threads * 4, text.size() / 4096), 1);
+    std::vector<std::size_t> chunk_starts{0};
+    for (std::size_t c = 1; c < max_chunks; ++c) {
+        const auto newline = text.find('\n', std::max(c * text.size() / max_chunks, chunk_starts.back()));
+        if (newline == std::string_view::npos) {
+            break;
+        }
+        chunk_starts.push_back(newline + 1);
+    }
+    chunk_starts.push_back(text.size());
+
+    // Chunks are taken in order, so the error rethrown is that of the first malformed chunk
+    const auto num_chunks = chunk_starts.size() - 1;
+    const auto run_chunks = [&](auto&& func) {
+        parallel_for_dynamic(num_chunks, num_threads, 1, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t c = begin; c < end; ++c) {
+                func(c);
+            }
+        });
+    };
+    const auto for_each_line = [&](std::size_t chunk, auto&& func) {
+        auto rest = text.substr(chunk_starts[chunk], chunk_starts[chunk + 1] - chunk_starts[chunk]);
+        while (!rest.empty()) {
+            const auto newline = std::min(rest.find('\n'), rest.size());
+            if (newline > 0) {
+                func(rest.substr(0, newline));
+            }
+            rest.remove_prefix(std::min(newline + 1, rest.size()));
+        }
+    };
+
+    // Count the lines of each chunk, to place each level without storing the lines
+    std::vector<std::size_t> level_starts(chunk_starts.size(), 0);
+    run_chunks([&](std::size_t chunk) {
+        for_each_line(chunk, [&](std::string_view) { ++level_starts[chunk + 1]; });
+    });
+    for (std::size_t c = 1; c < level_starts.size(); ++c) {
+        level_starts[c] += level_starts[c - 1];
+    }
+    const auto count = level_starts.back();
+    if (count == 0) {
+        throw std::invalid_argument("Level file has no levels: " + path);
+    }
+    std::size_t first_line = 0;
+    while (text[first_line] == '\n') {
+        ++first_line;
+    }
+    const auto first_level = parse_board(text.substr(first_line, text.find('\n', first_line) - first_line));
+    const auto rows = first_level.rows;
+    const auto cols = first_level.cols;
+    const auto cells = rows * cols;
+
+    // Parse the boards, and find the key/lock indices of each, the largest of which sets the record size
+    std::vector<Element> boards(count * cells);
+    std::vector<std::array<uint16_t, kRecordFixedFields>> fields(count);
+    std::vector<std::vector<uint16_t>> chunk_indices(num_chunks);
+    std::vector<std::size_t> chunk_max_indices(num_chunks, 0);
+    run_chunks([&](std::size_t chunk) {
+        auto level = level_starts[chunk];
+        std::vector<uint16_t> locks;
+        for_each_line(chunk, [&](std::string_view line) {
+            auto* board = boards.data() + level * cells;
+            parse_board_into(line, rows, cols, board);
+            const auto [num_keys, num_locks] = append_keys_and_locks(board, rows, cols, chunk_indices[chunk], locks);
+            chunk_max_indices[chunk] = std::max(chunk_max_indices[chunk], num_keys + num_locks);
+            // Boards without an agent get index 0, as the game state gives them
+            const auto agent = std::find(board, board + cells, Element::kAgent);
+            fields[level] = {static_cast<uint16_t>(agent == board + cells ? 0 : agent - board),
+                             static_cast<uint16_t>(num_keys), static_cast<uint16_t>(num_locks), 0};
+            ++level;
+        });
+    });
+    const auto max_indices = *std::max_element(chunk_max_indices.begin(), chunk_max_indices.end());
+
+    // Write the header and records into anonymous memory, laid out as a level pack file
+    LevelPack pack;
+    pack.header = LevelPackHeader{};
+    std::memcpy(pack.header.magic, kLevelPackMagic, sizeof(pack.header.magic));
+    pack.header.version = kLevelPackVersion;
+    pack.header.rows = static_cast<uint32_t>(rows);
+    pack.header.cols = static_cast<uint32_t>(cols);
+    pack.header.max_indices = static_cast<uint32_t>(max_indices);
+    pack.header.record_size = static_cast<uint32_t>(get_record_size(cells, max_indices));
+    pack.header.count = count;
+    const auto mapped_size = sizeof(LevelPackHeader) + count * pack.header.record_size;
+    void* mapped = ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Unable to allocate level pack for: " + path);
+    }
+    pack.data = static_cast<const uint8_t*>(mapped);
+    pack.mapped_size = mapped_size;
+    auto* bytes = static_cast<uint8_t*>(mapped);
+    std::memcpy(bytes, &pack.header, sizeof(pack.header));
+    // The anonymous mapping is zero filled, so only the used fields are written
+    run_chunks([&](std::size_t chunk) {
+        const auto* indices = chunk_indices[chunk].data();
+        for (auto i = level_starts[chunk]; i < level_starts[chunk + 1]; ++i) {
+            auto* record = reinterpret_cast<uint16_t*>(bytes + sizeof(LevelPackHeader) + i * pack.header.record_size);
+            const std::size_t num_indices = fields[i][1] + fields[i][2];
+            std::copy(fields[i].begin(), fields[i].end(), record);
+            std::copy_n(indices, num_indices, record + kRecordFixedFields);
+            std::memcpy(record + kRecordFixedFields + max_indices, boards.data() + i * cells, cells);
+            indices += num_indices;
+        }
+    });
+    ::mprotect(mapped, mapped_size, PROT_READ);
+    return pack;
+}
+
+LevelPack::~LevelPack() {
+    Unmap();
+}
+
+LevelPack::LevelPack(LevelPack&& other) noexcept
+    : data(other.data), mapped_size(other.mapped_size), header(other.header) {
+    other.data = nullptr;
+    other.mapped_size = 0;
+}
+
+auto LevelPack::operator=(LevelPack&& other) noexcept -> LevelPack& {
+    if (this != &other) {
+        Unmap();
+        data = other.data;
+        mapped_size = other.mapped_size;
+        header = other.header;
+        other.data = nullptr;
+        other.mapped_size = 0;
+    }
+    return *this;
+}
+
+void LevelPack::Unmap() noexcept {
+    if (data != nullptr) {
+        ::munmap(const_cast<uint8_t*>(data), mapped_size);    // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        data = nullptr;
+        mapped_size = 0;
+    }
+}
+
+auto LevelPack::size() const noexcept -> std::size_t {
+    return header.count;
+}
+
+auto LevelPack::rows() const noexcept -> std::size_t {
+    return header.rows;
+}
+
+auto LevelPack::cols() const noexcept -> std::size_t {
+    return header.cols;
+}
+
+auto LevelPack::get_record(std::size_t index) const -> Record {
+    if (index >= header.count) {
+        throw std::out_of_range("Level pack index out of range.");
+    }
+    // Records are 8 byte aligned within the page aligned mapping
+    const auto* fields =
+        reinterpret_cast<const uint16_t*>(data + sizeof(header) + index * header.record_size);
+    const auto cells = rows() * cols();
+    const std::size_t num_keys = fields[1];
+    const std::size_t num_locks = fields[2];
+    const auto* indices = fields + kRecordFixedFields;
+    if (fields[0] >= cells || num_keys + num_locks > header.max_indices ||
+        std::any_of(indices, indices + num_keys + num_locks, [&](uint16_t idx) { return idx >= cells; })) {
+        throw std::invalid_argument("Malformed level pack record.");
+    }
+    return {fields[0],
+            indices,
+            num_keys,
+            indices + num_keys,
+            num_locks,
+            reinterpret_cast<const Element*>(indices + header.max_indices)};
+}
+
+auto LevelPack::get_level(std::size_t index) const -> Level {
+    const auto record = get_record(index);
+    const auto cells = rows() * cols();
+    return {rows(), cols(), std::vector<Element>(record.board, record.board + cells)};
+}
+
+}    // namespace boxworld
@@ -0,0 +1,161 @@
+#ifndef BOXWORLD_LEVEL_PACK_H_
+#define BOXWORLD_LEVEL_PACK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "level.h"
+
+namespace boxworld {
+
+// Header at the start of a level pack file.
+// The header is followed by count fixed size records of record_size bytes, in native byte order:
+//   uint16_t agent_idx, uint16_t num_keys, uint16_t num_locks, uint16_t reserved,
+//   uint16_t indices[max_indices] (single keys then locks), uint8_t board[rows * cols], padding to 8 bytes
+struct LevelPackHeader {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    char magic[4];           // Always kLevelPackMagic
+    uint32_t version;        // Always kLevelPackVersion
+    uint32_t rows;           // Rows of every board in the pack
+    uint32_t cols;           // Cols of every board in the pack
+    uint32_t max_indices;    // Capacity of the key/lock index list of each record
+    uint32_t record_size;    // Size of each record in bytes
+    uint64_t count;          // Number of levels in the pack
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+constexpr char kLevelPackMagic[4] = {'B', 'W', 'L', 'P'};
+constexpr uint32_t kLevelPackVersion = 1;
+
+// Header at the start of a sparse level file.
+// The header is followed by count levels of encode_sparse_level(), back to back, so levels may differ in dimensions.
+struct SparseLevelFileHeader {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    char magic[4];        // Always kSparseLevelFileMagic
+    uint32_t version;     // Always kSparseLevelFileVersion
+    uint64_t count;       // Number of levels in the file
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+constexpr char kSparseLevelFileMagic[4] = {'B', 'W', 'S', 'L'};
+constexpr uint32_t kSparseLevelFileVersion = 1;
+
+/**
+ * Write the levels as a binary level pack.
+ * @note Throws std::invalid_argument if the levels are empty, differ in dimensions, or are invalid
+ * @param path Path of the file to write
+ * @param levels Levels to write, all of the same board dimensions
+ */
+void write_level_pack(const std::string &path, const std::vector<Level> &levels);
+
+/**
+ * Read a text level file of one board string per line, such as those written by scripts/generate_levelset.py.
+ * @param path Path of the file to read
+ * @return The parsed levels
+ */
+[[nodiscard]] auto read_level_file(const std::string &path) -> std::vector<Level>;
+
+/**
+ * Write the levels as a sparse level file, storing only the non-empty cells of each board.
+ * @note Throws std::invalid_argument if a level is invalid, or std::runtime_error if the file cannot be written
+ * @param path Path of the file to write
+ * @param levels Levels to write
+ */
+void write_sparse_level_file(const std::string &path, const std::vector<Level> &levels);
+
+/**
+ * Read a sparse level file written by write_sparse_level_file(), with a single read of the whole file.
+ * @note Throws std::runtime_error if the file cannot be read, or std::invalid_argument if it is malformed
+ * @param path Path of the file to read
+ * @return The decoded levels
+ */
+[[nodiscard]] auto read_sparse_level_file(const std::string &path) -> std::vector<Level>;
+
+// Read only memory-mapped level pack.
+// Processes mapping the same file share a single page-cached copy, and levels are read without any parsing.
+class LevelPack {
+public:
+    // View of a single level within the mapped file
+    struct Record {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        std::size_t agent_idx;          // Index of the agent
+        const uint16_t *key_indices;    // Indices of the single keys
+        std::size_t num_keys;           // Number of single keys
+        const uint16_t *lock_indices;   // Indices of the locks
+        std::size_t num_locks;          // Number of locks
+        const Element *board;           // rows * cols elements of the board
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    /**
+     * Map the level pack at the given path.
+     * @note Throws std::runtime_error if the file cannot be mapped, or std::invalid_argument if it is malformed
+     * @param path Path of the level pack
+     */
+    explicit LevelPack(const std::string &path);
+    ~LevelPack();
+
+    /**
+     * Load a text level file, see read_level_file(), into a level pack held in anonymous memory.
+     * The file is memory-mapped and split into chunks on line boundaries, which are parsed in parallel straight into
+     * the contiguous records, so the pack can be used in place of a converted level pack file.
+     * @note Throws std::runtime_error if the file cannot be mapped, or std::invalid_argument if it has no levels,
+     * boards of different dimensions, or a malformed board
+     * @param path Path of the text level file
+     * @param num_threads Number of threads to parse with, 0 to use the hardware concurrency
+     * @return The loaded pack
+     */
+    [[nodiscard]] static auto load_level_file(const std::string &path, std::size_t num_threads = 0) -> LevelPack;
+
+    LevelPack(const LevelPack &) = delete;
+    LevelPack(LevelPack &&other) noexcept;
+    auto operator=(const LevelPack &) -> LevelPack & = delete;
+    auto operator=(LevelPack &&other) noexcept -> LevelPack &;
+
+    /**
+     * Get the number of levels in the pack
+     * @return Count of levels
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the rows of every board in the pack
+     * @return Board rows
+     */
+    [[nodiscard]] auto rows() const noexcept -> std::size_t;
+
+    /**
+     * Get the cols of every board in the pack
+     * @return Board cols
+     */
+    [[nodiscard]] auto cols() const noexcept -> std::size_t;
+
+    /**
+     * Get the record of the level at the given index.
+     * @note Throws std::out_of_range if index is not less than size(), or std::invalid_argument if it is malformed
+     * @param index Index of the level in the pack
+     * @return View into the mapped file, valid for the lifetime of the pack
+     */
+    [[nodiscard]] auto get_record(std::size_t index) const -> Record;
+
+    /**
+     * Get the level at the given index.
+     * @param index Index of the level in the pack
+     * @return Copy of the level
+     */
+    [[nodiscard]] auto get_level(std::size_t index) const -> Level;
+
+private:
+    LevelPack() = default;
+
+    void Unmap() noexcept;
+
+    const uint8_t *data = nullptr;
+    std::size_t mapped_size = 0;
+    LevelPackHeader header{};
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_LEVEL_PACK_H_
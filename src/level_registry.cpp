@@ -0,0 +1,86 @@
+#include "level_registry.h"
+
+#include <stdexcept>
+
+#include "boxworld_base.h"
+#include "stats.h"
+
+namespace boxworld {
+
+auto compute_level_id(const Level& level, bool collect_first_key) noexcept -> uint64_t {
+    constexpr uint64_t kFNVOffset = 14695981039346656037ULL;
+    constexpr uint64_t kFNVPrime = 1099511628211ULL;
+    uint64_t hash = kFNVOffset;
+    const auto hash_value = [&](uint64_t value) { hash = (hash ^ value) * kFNVPrime; };
+    hash_value(level.rows);
+    hash_value(level.cols);
+    for (const auto& el : level.board) {
+        hash_value(static_cast<uint64_t>(el));
+    }
+    hash_value(static_cast<uint64_t>(collect_first_key));
+    return hash;
+}
+
+auto LevelRegistry::get_instance() -> LevelRegistry& {
+    static LevelRegistry registry;
+    return registry;
+}
+
+auto LevelRegistry::find(uint64_t level_id) const -> std::shared_ptr<SharedStateInfo> {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = levels.find(level_id);
+    return it == levels.end() ? nullptr : it->second;
+}
+
+auto LevelRegistry::insert(std::shared_ptr<SharedStateInfo> info) -> std::shared_ptr<SharedStateInfo> {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto [it, inserted] = levels.try_emplace(info->level_id, info);
+    if (!inserted &&
+        (!(it->second->level == info->level) || it->second->collect_first_key != info->collect_first_key)) {
+        throw std::runtime_error("Level id collision between different levels.");
+    }
+    const auto registered_epoch = current_epoch.load();
+    it->second->is_registered.store(1);
+    it->second->registered_epoch.store(registered_epoch);
+    info->registered_epoch.store(registered_epoch);
+    return it->second;
+}
+
+void LevelRegistry::erase(uint64_t level_id) {
+    const std::lock_guard<std::mutex> lock(mutex);
+    const auto it = levels.find(level_id);
+    if (it != levels.end()) {
+        it->second->is_registered.store(0);
+        levels.erase(it);
+        current_epoch.fetch_add(1);
+    }
+}
+
+void LevelRegistry::clear() {
+    const std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [level_id, info] : levels) {
+        info->is_registered.store(0);
+    }
+    levels.clear();
+    current_epoch.fetch_add(1);
+}
+
+auto LevelRegistry::size() const -> std::size_t {
+    const std::lock_guard<std::mutex> lock(mutex);
+    return levels.size();
+}
+
+auto LevelRegistry::epoch() const noexcept -> uint64_t {
+    return current_epoch.load();
+}
+
+auto LevelRegistry::memory_usage() const -> std::size_t {
+    const std::lock_guard<std::mutex> lock(mutex);
+    std::size_t bytes = heap_bytes(levels);
+    for (const auto& [level_id, info] : levels) {
+        bytes += info->memory_usage();
+    }
+    return bytes;
+}
+
+}    // namespace boxworld
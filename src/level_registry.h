@@ -0,0 +1,99 @@
+#ifndef BOXWORLD_LEVEL_REGISTRY_H_
+#define BOXWORLD_LEVEL_REGISTRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "level.h"
+
+namespace boxworld {
+
+struct SharedStateInfo;
+
+/**
+ * Get the identifier of a level, which is stable across processes.
+ * @param level The starting board of the level
+ * @param collect_first_key Flag to collect the first key from the start
+ * @return 64-bit FNV-1a hash of the level parameters
+ */
+[[nodiscard]] auto compute_level_id(const Level &level, bool collect_first_key) noexcept -> uint64_t;
+
+// Process wide registry of parsed levels, so states of the same level share one SharedStateInfo.
+// Levels are registered by BoxWorldGameState::serialize_local() and borrow_level() rather than on construction, so
+// the registry only grows with the levels which need it. They are kept alive until removed, so states can be
+// restored from just their LocalState and level id.
+class LevelRegistry {
+public:
+    LevelRegistry(const LevelRegistry &) = delete;
+    LevelRegistry(LevelRegistry &&) = delete;
+    auto operator=(const LevelRegistry &) -> LevelRegistry & = delete;
+    auto operator=(LevelRegistry &&) -> LevelRegistry & = delete;
+    ~LevelRegistry() = default;
+
+    /**
+     * Get the process wide registry
+     * @return Reference to the registry
+     */
+    [[nodiscard]] static auto get_instance() -> LevelRegistry &;
+
+    /**
+     * Find a registered level
+     * @param level_id Identifier of the level, as given by compute_level_id()
+     * @return Shared info of the level, or nullptr if not registered
+     */
+    [[nodiscard]] auto find(uint64_t level_id) const -> std::shared_ptr<SharedStateInfo>;
+
+    /**
+     * Register a level, if not already registered.
+     * @param info Shared info of the level with its level id set
+     * @return The registered shared info, which is the existing one if the level was already registered
+     */
+    auto insert(std::shared_ptr<SharedStateInfo> info) -> std::shared_ptr<SharedStateInfo>;
+
+    /**
+     * Remove a level from the registry. States already holding the level are unaffected, other than registering
+     * it again on their next serialize_local(), see epoch().
+     * @param level_id Identifier of the level
+     */
+    void erase(uint64_t level_id);
+
+    /**
+     * Remove all levels from the registry. States already holding a level are unaffected, other than registering
+     * it again on their next serialize_local(), see epoch().
+     */
+    void clear();
+
+    /**
+     * Get the number of registered levels
+     * @return Count of registered levels
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /**
+     * Get the epoch of the registry, which starts at 1 and changes whenever levels are removed, so a state which
+     * registered its level in the current epoch knows it is still registered without taking the lock.
+     * @return Current epoch
+     */
+    [[nodiscard]] auto epoch() const noexcept -> uint64_t;
+
+    /**
+     * Get the memory held by the registry, as the registered shared infos and an estimate of the map holding them.
+     * @note Registered levels also held by states are counted, as they are shared rather than copied
+     * @return Bytes held by the registry
+     */
+    [[nodiscard]] auto memory_usage() const -> std::size_t;
+
+private:
+    LevelRegistry() = default;
+
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<SharedStateInfo>> levels;
+    std::atomic<uint64_t> current_epoch{1};
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_LEVEL_REGISTRY_H_
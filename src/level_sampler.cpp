@@ -0,0 +1,137 @@
+#include "level_sampler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace boxworld {
+
+LevelSampler::LevelSampler(LevelPack pack, LevelSamplerConfig config)
+    : pack(std::move(pack)), config(std::move(config)), rng(this->config.seed) {
+    if (this->pack.size() == 0) {
+        throw std::invalid_argument("Level pack is empty.");
+    }
+    if (this->config.world_size == 0 || this->config.rank >= this->config.world_size) {
+        throw std::invalid_argument("Shard rank must be less than the world size.");
+    }
+    if (this->config.prefetch == 0) {
+        throw std::invalid_argument("Prefetch must be positive.");
+    }
+    shard_begin = this->config.rank;
+    shard_count = shard_begin < this->pack.size()
+                      ? (this->pack.size() - shard_begin + this->config.world_size - 1) / this->config.world_size
+                      : 0;
+    if (shard_count == 0) {
+        throw std::invalid_argument("Shard has no levels.");
+    }
+    if (this->config.mode == SamplingMode::kWeighted) {
+        cumulative_weights = BuildCumulativeWeights(this->config.weights);
+    }
+    // States reset from the pack reuse the hashing tables of the state they are copied from
+    scratch.emplace(this->pack.get_level(shard_begin), this->config.collect_first_key);
+    worker = std::thread(&LevelSampler::Run, this);
+}
+
+LevelSampler::~LevelSampler() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    space_cv.notify_all();
+    worker.join();
+}
+
+auto LevelSampler::reset(BoxWorldGameState& state) -> std::size_t {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready_cv.wait(lock, [this]() { return !ready.empty(); });
+    auto prepared = std::move(ready.front());
+    ready.pop_front();
+    lock.unlock();
+    space_cv.notify_one();
+    if (prepared.error) {
+        std::rethrow_exception(prepared.error);
+    }
+    state = std::move(prepared.state);
+    return prepared.index;
+}
+
+void LevelSampler::set_weights(std::vector<double> weights) {
+    auto cumulative = BuildCumulativeWeights(weights);
+    const std::lock_guard<std::mutex> lock(mutex);
+    config.weights = std::move(weights);
+    cumulative_weights = std::move(cumulative);
+}
+
+auto LevelSampler::shard_size() const noexcept -> std::size_t {
+    return shard_count;
+}
+
+auto LevelSampler::shard_index(std::size_t position) const noexcept -> std::size_t {
+    return shard_begin + position * config.world_size;
+}
+
+void LevelSampler::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        space_cv.wait(lock, [this]() { return stopping || ready.size() < config.prefetch; });
+        if (stopping) {
+            return;
+        }
+        const auto index = DrawIndex();
+        // Reading and preparing the level is done unlocked, only this thread touches the scratch state
+        lock.unlock();
+        auto state = *scratch;
+        // Exceptions cannot leave the worker thread, so a malformed record is handed to reset() to rethrow
+        std::exception_ptr error;
+        try {
+            state.reset(pack, index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        ready.push_back({index, std::move(state), error});
+        ready_cv.notify_one();
+    }
+}
+
+auto LevelSampler::DrawIndex() -> std::size_t {
+    switch (config.mode) {
+        case SamplingMode::kSequential: {
+            const auto position = next_position;
+            next_position = (next_position + 1) % shard_count;
+            return shard_index(position);
+        }
+        case SamplingMode::kWeighted: {
+            // Uniform double in [0, total) with the top 53 bits
+            const auto u = static_cast<double>(rng() >> 11U) * 0x1.0p-53 * cumulative_weights.back();
+            const auto it = std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), u);
+            const auto position = std::min(static_cast<std::size_t>(it - cumulative_weights.begin()), shard_count - 1);
+            return shard_index(position);
+        }
+        case SamplingMode::kUniform:
+        default:
+            return shard_index((rng() >> 11U) % shard_count);
+    }
+}
+
+auto LevelSampler::BuildCumulativeWeights(const std::vector<double>& weights) const -> std::vector<double> {
+    if (weights.size() != pack.size()) {
+        throw std::invalid_argument("Number of weights does not match the level pack.");
+    }
+    std::vector<double> cumulative;
+    cumulative.reserve(shard_count);
+    double total = 0;
+    for (std::size_t position = 0; position < shard_count; ++position) {
+        const auto weight = weights[shard_index(position)];
+        if (!(weight >= 0)) {
+            throw std::invalid_argument("Level weights must be non-negative.");
+        }
+        total += weight;
+        cumulative.push_back(total);
+    }
+    if (!(total > 0)) {
+        throw std::invalid_argument("Shard has no level with a positive weight.");
+    }
+    return cumulative;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,123 @@
+#ifndef BOXWORLD_LEVEL_SAMPLER_H_
+#define BOXWORLD_LEVEL_SAMPLER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "level_pack.h"
+#include "rng.h"
+
+namespace boxworld {
+
+// Order levels are drawn from the shard of a level pack
+enum class SamplingMode {
+    kUniform,       // Uniformly at random, with replacement
+    kSequential,    // In pack order, wrapping around at the end of the shard
+    kWeighted,      // At random in proportion to the level weights, such as for a curriculum
+};
+
+// Options of a LevelSampler
+struct LevelSamplerConfig {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    SamplingMode mode = SamplingMode::kUniform;    // Order levels are drawn in
+    std::size_t rank = 0;                          // Index of this shard, in [0, world_size)
+    std::size_t world_size = 1;                    // Number of shards, level i belongs to shard i % world_size
+    uint64_t seed = 0;                             // Seed of the random modes
+    std::size_t prefetch = 64;                     // Number of levels prepared ahead of reset()
+    bool collect_first_key = false;                // Flag to collect the first key from the start
+    std::vector<double> weights;                   // Weight of each level in the pack, used by kWeighted
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Draws levels from a shard of a level pack, with a background thread preparing the next levels as ready to play
+// states, so reset() only moves a prepared state and never reads or parses a level.
+// Prepared states hold their own unregistered level, so the LevelRegistry does not grow with the number of levels.
+class LevelSampler {
+public:
+    LevelSampler() = delete;
+
+    /**
+     * Start preparing levels from the pack.
+     * @note Throws std::invalid_argument if the pack is empty, the shard is empty or out of range, prefetch is 0,
+     * or the weights are invalid for kWeighted, see set_weights()
+     * @param pack The level pack to draw from
+     * @param config The sampling options
+     */
+    LevelSampler(LevelPack pack, LevelSamplerConfig config);
+    ~LevelSampler();
+
+    LevelSampler(const LevelSampler &) = delete;
+    LevelSampler(LevelSampler &&) = delete;
+    auto operator=(const LevelSampler &) -> LevelSampler & = delete;
+    auto operator=(LevelSampler &&) -> LevelSampler & = delete;
+
+    /**
+     * Reset the state to the next drawn level.
+     * @note Only blocks if the background thread has fallen behind, and is safe to call from multiple threads.
+     * Throws std::invalid_argument if the drawn record of the pack is malformed, leaving the state unchanged, and
+     * later calls continue with the next drawn level
+     * @param state The state to reset, of any board dimensions
+     * @return Index in the pack of the level
+     */
+    auto reset(BoxWorldGameState &state) -> std::size_t;
+
+    /**
+     * Set the weights of the levels for kWeighted, such as to advance a curriculum.
+     * @note Levels already prepared were drawn with the previous weights.
+     * Throws std::invalid_argument if the size does not match the pack, a weight is negative, or the shard has no
+     * positive weight
+     * @param weights Weight of each level in the pack, only those of the shard are used
+     */
+    void set_weights(std::vector<double> weights);
+
+    /**
+     * Get the number of levels in the shard
+     * @return Count of shard levels
+     */
+    [[nodiscard]] auto shard_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the index in the pack of the level at the given position within the shard
+     * @param position Position within the shard, less than shard_size()
+     * @return Index in the pack
+     */
+    [[nodiscard]] auto shard_index(std::size_t position) const noexcept -> std::size_t;
+
+private:
+    struct PreparedLevel {
+        std::size_t index;
+        BoxWorldGameState state;
+        std::exception_ptr error;    // Error preparing the level, rethrown by reset() in place of the state
+    };
+
+    void Run();
+    auto DrawIndex() -> std::size_t;
+    [[nodiscard]] auto BuildCumulativeWeights(const std::vector<double> &weights) const -> std::vector<double>;
+
+    LevelPack pack;
+    LevelSamplerConfig config;
+    std::size_t shard_begin;
+    std::size_t shard_count;
+    Xoshiro256 rng;
+    std::size_t next_position = 0;
+    std::vector<double> cumulative_weights;
+
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::condition_variable space_cv;
+    std::deque<PreparedLevel> ready;
+    bool stopping = false;
+    std::optional<BoxWorldGameState> scratch;
+    std::thread worker;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_LEVEL_SAMPLER_H_
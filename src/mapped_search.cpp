@@ -0,0 +1,423 @@
+#include "mapped_search.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+#include "successors.h"
+
+namespace boxworld {
+
+namespace {
+constexpr char kCheckpointMagic[8] = {'B', 'W', 'C', 'K', 'P', 'T', '0', '1'};
+constexpr std::size_t kGrainSize = 64;
+constexpr std::size_t kBatchSize = std::size_t{1} << 14;    // Frontier states expanded between merges
+constexpr std::size_t kInitialRecords = std::size_t{1} << 16;
+constexpr std::size_t kInitialSlots = std::size_t{1} << 17;
+constexpr uint64_t kNoParent = ~uint64_t{0};
+
+// Searched state, in order of depth
+struct SearchRecord {
+    uint64_t hash = 0;
+    uint64_t remaining = 0;           // PackedStateKey::remaining
+    uint64_t parent = kNoParent;      // Index of the record the state was generated from
+    uint16_t agent_idx = 0;
+    uint8_t inventory = 0;
+    uint8_t action = 0;
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(SearchRecord) == 32, "Records are 32 bytes");
+
+// Progress of a search, valid for the records before num_records
+struct CheckpointHeader {
+    char magic[sizeof(kCheckpointMagic)] = {};
+    uint64_t level_id = 0;
+    uint64_t start_hash = 0;
+    uint64_t num_records = 0;
+    uint64_t frontier_end = 0;    // End of the records of the depth being expanded
+    uint64_t next_expand = 0;     // Index of the next record of the depth to expand
+    uint64_t expanded = 0;
+};
+
+// Read and write mapping of a file, resized by remapping
+class MappedFile {
+public:
+    MappedFile(const std::string& path, bool truncate) : path(path) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open search file: " + path);
+        }
+        struct stat file_stat {};
+        if (::fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Unable to read search file: " + path);
+        }
+        Map(static_cast<std::size_t>(file_stat.st_size));
+    }
+    ~MappedFile() {
+        Unmap();
+        ::close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+    auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+    [[nodiscard]] auto data() const noexcept -> uint8_t* {
+        return mapped;
+    }
+    [[nodiscard]] auto size() const noexcept -> std::size_t {
+        return mapped_size;
+    }
+
+    void resize(std::size_t size) {
+        Unmap();
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            throw std::runtime_error("Unable to grow search file: " + path);
+        }
+        Map(size);
+    }
+
+    // Write the first bytes of the mapping back to the file
+    void sync(std::size_t size) const {
+        if (size > 0 && ::msync(mapped, std::min(size, mapped_size), MS_SYNC) != 0) {
+            throw std::runtime_error("Unable to sync search file: " + path);
+        }
+    }
+
+private:
+    void Map(std::size_t size) {
+        mapped_size = size;
+        if (size == 0) {
+            return;
+        }
+        void* result = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (result == MAP_FAILED) {
+            mapped_size = 0;
+            throw std::runtime_error("Unable to map search file: " + path);
+        }
+        mapped = static_cast<uint8_t*>(result);
+    }
+    void Unmap() noexcept {
+        if (mapped != nullptr) {
+            ::munmap(mapped, mapped_size);
+        }
+        mapped = nullptr;
+        mapped_size = 0;
+    }
+
+    std::string path;
+    int fd = -1;
+    uint8_t* mapped = nullptr;
+    std::size_t mapped_size = 0;
+};
+
+// Open addressing set of hashes in a mapped file, only written by one thread.
+// Lookups are safe from any number of threads while nothing is inserted.
+class MappedHashSet {
+public:
+    explicit MappedHashSet(const std::string& path) : file(path, true) {
+        file.resize(kInitialSlots * sizeof(uint64_t));
+    }
+
+    [[nodiscard]] auto contains(uint64_t hash) const noexcept -> bool {
+        if (hash == 0) {
+            return has_zero;
+        }
+        const auto* slots = reinterpret_cast<const uint64_t*>(file.data());
+        const auto mask = num_slots() - 1;
+        for (auto slot = Mix(hash) & mask;; slot = (slot + 1) & mask) {
+            if (slots[slot] == hash) {
+                return true;
+            }
+            if (slots[slot] == 0) {
+                return false;
+            }
+        }
+    }
+
+    auto insert(uint64_t hash) -> bool {
+        if (hash == 0) {
+            return !std::exchange(has_zero, true);
+        }
+        // Grow at half full, so probes stay short
+        if (2 * (num_hashes + 1) > num_slots()) {
+            Grow();
+        }
+        if (!Insert(reinterpret_cast<uint64_t*>(file.data()), num_slots(), hash)) {
+            return false;
+        }
+        ++num_hashes;
+        return true;
+    }
+
+private:
+    [[nodiscard]] auto num_slots() const noexcept -> std::size_t {
+        return file.size() / sizeof(uint64_t);
+    }
+
+    static auto Mix(uint64_t hash) noexcept -> std::size_t {
+        // Hashes are already uniform, but the high half spreads the buckets of similar low bits
+        return static_cast<std::size_t>(hash ^ (hash >> 32));
+    }
+
+    static auto Insert(uint64_t* slots, std::size_t num_slots, uint64_t hash) noexcept -> bool {
+        const auto mask = num_slots - 1;
+        for (auto slot = Mix(hash) & mask;; slot = (slot + 1) & mask) {
+            if (slots[slot] == hash) {
+                return false;
+            }
+            if (slots[slot] == 0) {
+                slots[slot] = hash;
+                return true;
+            }
+        }
+    }
+
+    // Rehash in place: the doubled table is rebuilt from a copy of the old slots spilled to the end of the file
+    void Grow() {
+        const auto old_slots = num_slots();
+        file.resize(3 * old_slots * sizeof(uint64_t));
+        auto* slots = reinterpret_cast<uint64_t*>(file.data());
+        std::memcpy(slots + 2 * old_slots, slots, old_slots * sizeof(uint64_t));
+        std::fill_n(slots, 2 * old_slots, uint64_t{0});
+        for (std::size_t i = 0; i < old_slots; ++i) {
+            const auto hash = slots[2 * old_slots + i];
+            if (hash != 0) {
+                Insert(slots, 2 * old_slots, hash);
+            }
+        }
+        file.resize(2 * old_slots * sizeof(uint64_t));
+    }
+
+    MappedFile file;
+    std::size_t num_hashes = 0;
+    bool has_zero = false;
+};
+
+// Records of the search in a mapped file, grown by doubling
+class RecordFile {
+public:
+    RecordFile(const std::string& path, bool truncate) : file(path, truncate) {
+        if (file.size() < kInitialRecords * sizeof(SearchRecord)) {
+            file.resize(kInitialRecords * sizeof(SearchRecord));
+        }
+    }
+
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t {
+        return file.size() / sizeof(SearchRecord);
+    }
+
+    [[nodiscard]] auto get(std::size_t index) const noexcept -> SearchRecord {
+        SearchRecord record;
+        std::memcpy(&record, file.data() + index * sizeof(SearchRecord), sizeof(record));
+        return record;
+    }
+
+    void set(std::size_t index, const SearchRecord& record) {
+        if (index >= capacity()) {
+            file.resize(2 * file.size());
+        }
+        std::memcpy(file.data() + index * sizeof(SearchRecord), &record, sizeof(record));
+    }
+
+    void sync(std::size_t num_records) const {
+        file.sync(num_records * sizeof(SearchRecord));
+    }
+
+private:
+    MappedFile file;
+};
+
+auto to_key(const SearchRecord& record) noexcept -> PackedStateKey {
+    PackedStateKey key;
+    key.agent_idx = record.agent_idx;
+    key.inventory = static_cast<Element>(record.inventory);
+    key.remaining = record.remaining;
+    return key;
+}
+
+auto to_record(uint64_t hash, const PackedStateKey& key, uint64_t parent, Action action) noexcept -> SearchRecord {
+    SearchRecord record;
+    record.hash = hash;
+    record.remaining = key.remaining;
+    record.parent = parent;
+    record.agent_idx = key.agent_idx;
+    record.inventory = static_cast<uint8_t>(key.inventory);
+    record.action = static_cast<uint8_t>(action);
+    return record;
+}
+
+auto read_checkpoint(const std::string& path, CheckpointHeader& header) -> bool {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    const auto is_read = std::fread(&header, sizeof(header), 1, file) == 1;
+    std::fclose(file);
+    return is_read && std::memcmp(header.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) == 0;
+}
+
+// Replace the checkpoint by renaming a synced temporary file over it, so a crash leaves the old or the new one
+void write_checkpoint(const std::string& path, const CheckpointHeader& header) {
+    const auto temp_path = path + ".tmp";
+    const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to write checkpoint: " + temp_path);
+    }
+    const auto is_written = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+                            ::fsync(fd) == 0;
+    ::close(fd);
+    if (!is_written || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Unable to write checkpoint: " + path);
+    }
+}
+
+auto build_path(const RecordFile& records, uint64_t index) -> std::vector<Action> {
+    std::vector<Action> actions;
+    for (auto record = records.get(index); record.parent != kNoParent; record = records.get(record.parent)) {
+        actions.push_back(static_cast<Action>(record.action));
+    }
+    std::reverse(actions.begin(), actions.end());
+    return actions;
+}
+}    // namespace
+
+MappedSearch::MappedSearch(std::string directory, std::size_t num_threads, std::size_t max_expansions,
+                           std::size_t checkpoint_every)
+    : directory(std::move(directory)),
+      num_threads(num_threads),
+      max_expansions(max_expansions),
+      checkpoint_every(checkpoint_every) {}
+
+auto MappedSearch::has_checkpoint(const BoxWorldGameState& state) const -> bool {
+    CheckpointHeader header;
+    return read_checkpoint(directory + "/checkpoint", header) && header.level_id == state.get_level_id() &&
+           header.start_hash == state.get_hash();
+}
+
+auto MappedSearch::bfs(const BoxWorldGameState& state) const -> SolverResult {
+    SolverResult result;
+    const auto start_key = state.packed_key();
+    if (state.is_solution()) {
+        result.solved = true;
+        return result;
+    }
+
+    const auto checkpoint_path = directory + "/checkpoint";
+    CheckpointHeader checkpoint;
+    const auto is_resumed = read_checkpoint(checkpoint_path, checkpoint);
+    if (is_resumed && (checkpoint.level_id != state.get_level_id() || checkpoint.start_hash != state.get_hash())) {
+        throw std::invalid_argument("Checkpoint in " + directory + " is of a search from another state.");
+    }
+    RecordFile records(directory + "/records.bin", !is_resumed);
+    if (is_resumed && checkpoint.num_records > records.capacity()) {
+        throw std::invalid_argument("Records in " + directory + " are shorter than their checkpoint.");
+    }
+    MappedHashSet closed(directory + "/closed.bin");
+    if (is_resumed) {
+        // Records after the checkpoint are of an interrupted batch, and are overwritten as it is expanded again
+        for (std::size_t i = 0; i < checkpoint.num_records; ++i) {
+            closed.insert(records.get(i).hash);
+        }
+    } else {
+        std::memcpy(checkpoint.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+        checkpoint.level_id = state.get_level_id();
+        checkpoint.start_hash = state.get_hash();
+        records.set(0, to_record(state.get_hash(), start_key, kNoParent, Action::kUp));
+        closed.insert(state.get_hash());
+        checkpoint.num_records = 1;
+        checkpoint.frontier_end = 1;
+        checkpoint.next_expand = 0;
+    }
+    result.expanded = checkpoint.expanded;
+
+    const auto save = [&]() {
+        records.sync(checkpoint.num_records);
+        checkpoint.expanded = result.expanded;
+        write_checkpoint(checkpoint_path, checkpoint);
+    };
+
+    struct Child {
+        uint64_t hash;
+        uint64_t parent;
+        Action action;
+        PackedStateKey key;
+        bool is_solution;
+    };
+    std::vector<std::vector<Child>> buffers;
+    auto last_checkpoint = result.expanded;
+    while (checkpoint.next_expand < checkpoint.num_records) {
+        if (checkpoint.next_expand == checkpoint.frontier_end) {
+            checkpoint.frontier_end = checkpoint.num_records;
+        }
+        if (max_expansions > 0 && result.expanded >= max_expansions) {
+            save();
+            return result;
+        }
+        if (checkpoint_every > 0 && result.expanded - last_checkpoint >= checkpoint_every) {
+            save();
+            last_checkpoint = result.expanded;
+        }
+        // Expand a batch of the depth, each chunk writing its children into its own buffer, merged in order
+        const auto begin = checkpoint.next_expand;
+        const auto batch_size = std::min<std::size_t>(kBatchSize, checkpoint.frontier_end - begin);
+        buffers.clear();
+        buffers.resize((batch_size + kGrainSize - 1) / kGrainSize);
+        parallel_for_dynamic(batch_size, num_threads, kGrainSize, [&](std::size_t chunk_begin, std::size_t chunk_end) {
+            auto& buffer = buffers[chunk_begin / kGrainSize];
+            auto scratch = state;
+            std::array<uint64_t, kNumActions> hashes{};
+            uint8_t valid_mask = 0;
+            for (std::size_t i = chunk_begin; i < chunk_end; ++i) {
+                const auto index = begin + i;
+                scratch.reset(to_key(records.get(index)));
+                scratch.successor_hashes(hashes, valid_mask);
+                for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+                    const auto a = static_cast<std::size_t>(action);
+                    const auto hash = hashes[a];    // NOLINT(*-bounds-constant-array-index)
+                    if ((valid_mask & (1U << a)) == 0 || closed.contains(hash)) {
+                        continue;
+                    }
+                    const auto undo = scratch.apply_action_with_undo(action);
+                    if (!reached_dead_end(scratch)) {
+                        buffer.push_back({hash, index, action, scratch.packed_key(), scratch.is_solution()});
+                    }
+                    scratch.undo_action(undo);
+                }
+            }
+        });
+        result.expanded += batch_size;
+
+        for (const auto& buffer : buffers) {
+            for (const auto& child : buffer) {
+                if (!closed.insert(child.hash)) {
+                    continue;
+                }
+                records.set(checkpoint.num_records, to_record(child.hash, child.key, child.parent, child.action));
+                if (child.is_solution) {
+                    result.solved = true;
+                    result.actions = build_path(records, checkpoint.num_records);
+                    result.cost = result.actions.size();
+                    return result;
+                }
+                ++checkpoint.num_records;
+            }
+        }
+        checkpoint.next_expand += batch_size;
+    }
+    save();
+    return result;
+}
+
+}    // namespace boxworld
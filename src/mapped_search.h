@@ -0,0 +1,64 @@
+#ifndef BOXWORLD_MAPPED_SEARCH_H_
+#define BOXWORLD_MAPPED_SEARCH_H_
+
+#include <cstdint>
+#include <string>
+
+#include "boxworld_base.h"
+#include "solver.h"
+
+namespace boxworld {
+
+// Breadth first search which keeps its searched states and closed set in memory mapped files of a directory, so
+// searches larger than RAM page out to disk instead of running out of memory, and can be resumed after preemption.
+// Each searched state is a 32 byte record of its hash, packed key, parent record and action, appended in order of
+// depth, so the frontier is the range of records of the deepest depth.
+// Records are only ever appended, so a checkpoint is the count of records and the progress through the frontier,
+// written once the records it covers are synced. Resuming drops the records after the checkpoint and rebuilds the
+// closed set from the records before it.
+// @note The directory holds a single search, and searching a different state in it throws. POSIX only
+class MappedSearch {
+public:
+    // Default number of expansions between checkpoints
+    static constexpr std::size_t kDefaultCheckpointEvery = std::size_t{1} << 20;
+
+    MappedSearch() = delete;
+
+    /**
+     * @param directory Existing directory for the files of the search
+     * @param num_threads Number of threads to search with, 0 to use the hardware concurrency
+     * @param max_expansions Number of states to expand before giving up, 0 for no limit. Counts the expansions before
+     * a resume, and is checked between batches of the frontier
+     * @param checkpoint_every Number of expansions between checkpoints, 0 to only checkpoint when giving up
+     */
+    explicit MappedSearch(std::string directory, std::size_t num_threads = 0, std::size_t max_expansions = 0,
+                          std::size_t checkpoint_every = kDefaultCheckpointEvery);
+
+    /**
+     * Breadth first search as ParallelSearch::bfs(), resuming from the checkpoint of the directory if it has one.
+     * Children which are dead ends are pruned, see BoxWorldGameState::is_dead_end().
+     * @note Throws std::runtime_error if the files cannot be written, or std::invalid_argument if the checkpoint of
+     * the directory is of another state or the level has more single keys and locks than a packed key holds
+     * @param state The state to search from
+     * @return The optimal solution, with solved set to false if none is found within the expansion limit, and
+     * expanded counting the expansions before a resume
+     */
+    [[nodiscard]] auto bfs(const BoxWorldGameState &state) const -> SolverResult;
+
+    /**
+     * Check if the directory has a checkpoint of a search from the given state, which bfs() resumes from
+     * @param state The state to search from
+     * @return True if bfs() would resume
+     */
+    [[nodiscard]] auto has_checkpoint(const BoxWorldGameState &state) const -> bool;
+
+private:
+    std::string directory;
+    std::size_t num_threads;
+    std::size_t max_expansions;
+    std::size_t checkpoint_every;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_MAPPED_SEARCH_H_
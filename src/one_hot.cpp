@@ -0,0 +1,179 @@
+#include "one_hot.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BOXWORLD_ONE_HOT_AVX2
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define BOXWORLD_ONE_HOT_NEON
+#include <arm_neon.h>
+#endif
+
+#include <cstring>
+
+namespace boxworld {
+
+void write_one_hot_scalar(const Element* board, std::size_t num_cells, std::size_t num_planes, float* out) noexcept {
+    for (std::size_t plane = 0; plane < num_planes; ++plane) {
+        const auto el = static_cast<Element>(plane);
+        float* plane_out = out + plane * num_cells;
+        for (std::size_t i = 0; i < num_cells; ++i) {
+            plane_out[i] = board[i] == el ? 1.0F : 0.0F;
+        }
+    }
+}
+
+void write_bit_planes_scalar(const uint64_t* bits, std::size_t words_per_plane, std::size_t num_cells,
+                             std::size_t num_planes, float* out) noexcept {
+    for (std::size_t plane = 0; plane < num_planes; ++plane) {
+        const uint64_t* words = bits + plane * words_per_plane;
+        float* plane_out = out + plane * num_cells;
+        for (std::size_t i = 0; i < num_cells; ++i) {
+            plane_out[i] = ((words[i / 64] >> (i % 64)) & 1) != 0 ? 1.0F : 0.0F;
+        }
+    }
+}
+
+namespace {
+
+#ifdef BOXWORLD_ONE_HOT_AVX2
+// Compiled for AVX2 regardless of the target flags, and only called once the CPU is known to support it.
+// Compares 8 cells as bytes, then sign extends the all-ones lanes to the 32-bit mask of 1.0F.
+__attribute__((target("avx2"))) inline auto one_hot_avx2(uint64_t bytes, __m128i el, __m256 ones) noexcept -> __m256 {
+    const __m128i hit = _mm_cmpeq_epi8(_mm_cvtsi64_si128(static_cast<int64_t>(bytes)), el);
+    return _mm256_and_ps(_mm256_castsi256_ps(_mm256_cvtepi8_epi32(hit)), ones);
+}
+
+__attribute__((target("avx2"))) void write_one_hot_avx2(const Element* board, std::size_t num_cells,
+                                                         std::size_t num_planes, float* out) noexcept {
+    constexpr std::size_t kWidth = 8;
+    const __m256 ones = _mm256_set1_ps(1.0F);
+    const std::size_t num_full = num_cells - num_cells % kWidth;
+    // Lanes of the tail which are within the board, stored with a masked store
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i tail_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(num_cells - num_full)), lanes);
+    uint64_t tail_bytes = 0;
+    std::memcpy(&tail_bytes, board + num_full, num_cells - num_full);
+    for (std::size_t plane = 0; plane < num_planes; ++plane) {
+        const __m128i el = _mm_set1_epi8(static_cast<char>(plane));
+        float* plane_out = out + plane * num_cells;
+        for (std::size_t i = 0; i < num_full; i += kWidth) {
+            uint64_t bytes = 0;
+            std::memcpy(&bytes, board + i, kWidth);
+            _mm256_storeu_ps(plane_out + i, one_hot_avx2(bytes, el, ones));
+        }
+        if (num_full != num_cells) {
+            _mm256_maskstore_ps(plane_out + num_full, tail_mask, one_hot_avx2(tail_bytes, el, ones));
+        }
+    }
+}
+
+// Broadcasts 8 bits to each lane, then compares against the lane's own bit for the 32-bit mask of 1.0F
+__attribute__((target("avx2"))) inline auto bit_planes_avx2(uint64_t byte, __m256i lane_bits, __m256 ones) noexcept
+    -> __m256 {
+    const __m256i selected = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(byte)), lane_bits);
+    return _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(selected, lane_bits)), ones);
+}
+
+__attribute__((target("avx2"))) void write_bit_planes_avx2(const uint64_t* bits, std::size_t words_per_plane,
+                                                            std::size_t num_cells, std::size_t num_planes,
+                                                            float* out) noexcept {
+    constexpr std::size_t kWidth = 8;
+    const __m256 ones = _mm256_set1_ps(1.0F);
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const std::size_t num_full = num_cells - num_cells % kWidth;
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i tail_mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(num_cells - num_full)), lanes);
+    for (std::size_t plane = 0; plane < num_planes; ++plane) {
+        const uint64_t* words = bits + plane * words_per_plane;
+        float* plane_out = out + plane * num_cells;
+        for (std::size_t i = 0; i < num_full; i += kWidth) {
+            _mm256_storeu_ps(plane_out + i, bit_planes_avx2((words[i / 64] >> (i % 64)) & 0xFF, lane_bits, ones));
+        }
+        if (num_full != num_cells) {
+            const auto tail = (words[num_full / 64] >> (num_full % 64)) & 0xFF;
+            _mm256_maskstore_ps(plane_out + num_full, tail_mask, bit_planes_avx2(tail, lane_bits, ones));
+        }
+    }
+}
+#endif
+
+#ifdef BOXWORLD_ONE_HOT_NEON
+void write_one_hot_neon(const Element* board, std::size_t num_cells, std::size_t num_planes, float* out) noexcept {
+    constexpr std::size_t kWidth = 8;
+    const uint32x4_t ones = vreinterpretq_u32_f32(vdupq_n_f32(1.0F));
+    const std::size_t num_full = num_cells - num_cells % kWidth;
+    for (std::size_t plane = 0; plane < num_planes; ++plane) {
+        const uint8x8_t el = vdup_n_u8(static_cast<uint8_t>(plane));
+        float* plane_out = out + plane * num_cells;
+        for (std::size_t i = 0; i < num_full; i += kWidth) {
+            // Compare as bytes, then sign extend the all-ones lanes to 32 bits
+            const uint8x8_t hit = vceq_u8(vld1_u8(reinterpret_cast<const uint8_t*>(board + i)), el);
+            const int16x8_t hit_16 = vmovl_s8(vreinterpret_s8_u8(hit));
+            const uint32x4_t low = vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(hit_16)));
+            const uint32x4_t high = vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(hit_16)));
+            vst1q_f32(plane_out + i, vreinterpretq_f32_u32(vandq_u32(low, ones)));
+            vst1q_f32(plane_out + i + 4, vreinterpretq_f32_u32(vandq_u32(high, ones)));
+        }
+        for (std::size_t i = num_full; i < num_cells; ++i) {
+            plane_out[i] = board[i] == static_cast<Element>(plane) ? 1.0F : 0.0F;
+        }
+    }
+}
+#endif
+
+using OneHotFunc = void (*)(const Element*, std::size_t, std::size_t, float*) noexcept;
+using BitPlanesFunc = void (*)(const uint64_t*, std::size_t, std::size_t, std::size_t, float*) noexcept;
+
+auto resolve_one_hot_kernel() noexcept -> OneHotKernel {
+#if defined(BOXWORLD_ONE_HOT_AVX2)
+    return __builtin_cpu_supports("avx2") ? OneHotKernel::kAVX2 : OneHotKernel::kScalar;
+#elif defined(BOXWORLD_ONE_HOT_NEON)
+    return OneHotKernel::kNEON;
+#else
+    return OneHotKernel::kScalar;
+#endif
+}
+
+auto resolve_one_hot_func() noexcept -> OneHotFunc {
+    switch (get_one_hot_kernel()) {
+#ifdef BOXWORLD_ONE_HOT_AVX2
+        case OneHotKernel::kAVX2:
+            return write_one_hot_avx2;
+#endif
+#ifdef BOXWORLD_ONE_HOT_NEON
+        case OneHotKernel::kNEON:
+            return write_one_hot_neon;
+#endif
+        default:
+            return write_one_hot_scalar;
+    }
+}
+
+auto resolve_bit_planes_func() noexcept -> BitPlanesFunc {
+#ifdef BOXWORLD_ONE_HOT_AVX2
+    if (get_one_hot_kernel() == OneHotKernel::kAVX2) {
+        return write_bit_planes_avx2;
+    }
+#endif
+    return write_bit_planes_scalar;
+}
+
+}    // namespace
+
+auto get_one_hot_kernel() noexcept -> OneHotKernel {
+    static const OneHotKernel kernel = resolve_one_hot_kernel();
+    return kernel;
+}
+
+void write_one_hot(const Element* board, std::size_t num_cells, std::size_t num_planes, float* out) noexcept {
+    static const OneHotFunc func = resolve_one_hot_func();
+    func(board, num_cells, num_planes, out);
+}
+
+void write_bit_planes(const uint64_t* bits, std::size_t words_per_plane, std::size_t num_cells, std::size_t num_planes,
+                      float* out) noexcept {
+    static const BitPlanesFunc func = resolve_bit_planes_func();
+    func(bits, words_per_plane, num_cells, num_planes, out);
+}
+
+}    // namespace boxworld
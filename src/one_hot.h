@@ -0,0 +1,68 @@
+#ifndef BOXWORLD_ONE_HOT_H_
+#define BOXWORLD_ONE_HOT_H_
+
+#include <cstdint>
+
+#include "definitions.h"
+
+namespace boxworld {
+
+// Instruction set used by write_one_hot() and write_bit_planes()
+enum class OneHotKernel {
+    kScalar,
+    kAVX2,
+    kNEON,
+};
+
+/**
+ * Write one float plane per element value [0, num_planes) of the board, 1 where the cell holds the value and 0
+ * elsewhere, so every value of the output is written exactly once without zero filling first.
+ * Uses the widest kernel supported by the CPU, see get_one_hot_kernel().
+ * @param board Elements of the board
+ * @param num_cells Number of cells of the board
+ * @param num_planes Number of planes to write, one per element value starting from 0
+ * @param out Buffer of num_planes * num_cells values to write into
+ */
+void write_one_hot(const Element *board, std::size_t num_cells, std::size_t num_planes, float *out) noexcept;
+
+/**
+ * Portable version of write_one_hot(), which the vector kernels match exactly.
+ * @param board Elements of the board
+ * @param num_cells Number of cells of the board
+ * @param num_planes Number of planes to write, one per element value starting from 0
+ * @param out Buffer of num_planes * num_cells values to write into
+ */
+void write_one_hot_scalar(const Element *board, std::size_t num_cells, std::size_t num_planes, float *out) noexcept;
+
+/**
+ * Write one float plane per bit plane, 1 where the bit of the cell is set and 0 elsewhere, such as to expand
+ * bitboards into an observation. Uses the same kernel as write_one_hot().
+ * @param bits Bit planes, plane p at bits + p * words_per_plane with cell i at bit i % 64 of word i / 64
+ * @param words_per_plane Stride of the bit planes in 64-bit words, at least (num_cells + 63) / 64
+ * @param num_cells Number of cells of each plane
+ * @param num_planes Number of planes to write
+ * @param out Buffer of num_planes * num_cells values to write into
+ */
+void write_bit_planes(const uint64_t *bits, std::size_t words_per_plane, std::size_t num_cells, std::size_t num_planes,
+                      float *out) noexcept;
+
+/**
+ * Portable version of write_bit_planes(), which the vector kernels match exactly.
+ * @param bits Bit planes, plane p at bits + p * words_per_plane with cell i at bit i % 64 of word i / 64
+ * @param words_per_plane Stride of the bit planes in 64-bit words, at least (num_cells + 63) / 64
+ * @param num_cells Number of cells of each plane
+ * @param num_planes Number of planes to write
+ * @param out Buffer of num_planes * num_cells values to write into
+ */
+void write_bit_planes_scalar(const uint64_t *bits, std::size_t words_per_plane, std::size_t num_cells,
+                             std::size_t num_planes, float *out) noexcept;
+
+/**
+ * Get the kernel write_one_hot() dispatches to on this CPU
+ * @return The kernel
+ */
+[[nodiscard]] auto get_one_hot_kernel() noexcept -> OneHotKernel;
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_ONE_HOT_H_
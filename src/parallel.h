@@ -0,0 +1,146 @@
+#ifndef BOXWORLD_PARALLEL_H_
+#define BOXWORLD_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace boxworld {
+
+namespace detail {
+// Error of the lowest chunk which threw in a parallel loop, so the error rethrown does not depend on the threads
+class ParallelError {
+public:
+    void capture(std::size_t begin) noexcept {
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (!error || begin < error_begin) {
+            error = std::current_exception();
+            error_begin = begin;
+        }
+        has_error.store(true, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto is_set() const noexcept -> bool {
+        return has_error.load(std::memory_order_relaxed);
+    }
+
+    void rethrow() const {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::exception_ptr error;
+    std::size_t error_begin = 0;
+    std::atomic<bool> has_error{false};
+};
+}    // namespace detail
+
+/**
+ * Run func(begin, end) over contiguous chunks of [0, n), split evenly across num_threads threads.
+ * The calling thread processes the first chunk, and the call returns once all chunks are done.
+ * @note If func throws, the call still waits for every chunk and then rethrows the error of the lowest chunk which
+ * threw. Chunks are run on the calling thread if a thread cannot be started
+ * @param n Number of items
+ * @param num_threads Number of threads to use, 0 to use the hardware concurrency
+ * @param func Callable taking the begin and end index of its chunk
+ */
+template <typename Func>
+void parallel_for(std::size_t n, std::size_t num_threads, Func &&func) {
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    num_threads = std::min(num_threads, n);
+    if (num_threads <= 1) {
+        if (n > 0) {
+            func(std::size_t{0}, n);
+        }
+        return;
+    }
+    const std::size_t chunk_size = (n + num_threads - 1) / num_threads;
+    detail::ParallelError error;
+    const auto run = [&func, &error](std::size_t begin, std::size_t end) noexcept {
+        try {
+            func(begin, end);
+        } catch (...) {
+            error.capture(begin);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (std::size_t begin = chunk_size; begin < n; begin += chunk_size) {
+        const auto end = std::min(begin + chunk_size, n);
+        try {
+            threads.emplace_back([&run, begin, end]() { run(begin, end); });
+        } catch (const std::system_error &) {
+            run(begin, end);
+        }
+    }
+    run(std::size_t{0}, std::min(chunk_size, n));
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    error.rethrow();
+}
+
+/**
+ * Run func(begin, end) over chunks of [0, n) of grain_size items, which threads take from a shared counter as they
+ * finish their previous chunk. Use over parallel_for() when items vary in cost.
+ * The calling thread also takes chunks, and the call returns once all chunks are done.
+ * @note If func throws, no further chunks are taken, and once the running chunks are done the error of the lowest
+ * chunk which threw is rethrown. As chunks are taken in order, this is the first chunk to throw for any thread count
+ * @param n Number of items
+ * @param num_threads Number of threads to use, 0 to use the hardware concurrency
+ * @param grain_size Number of items in each chunk, chunk c covers [c * grain_size, (c + 1) * grain_size)
+ * @param func Callable taking the begin and end index of its chunk
+ */
+template <typename Func>
+void parallel_for_dynamic(std::size_t n, std::size_t num_threads, std::size_t grain_size, Func &&func) {
+    grain_size = std::max<std::size_t>(grain_size, 1);
+    const std::size_t num_chunks = (n + grain_size - 1) / grain_size;
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    num_threads = std::min(num_threads, num_chunks);
+    std::atomic<std::size_t> next_chunk{0};
+    detail::ParallelError error;
+    const auto worker = [&]() noexcept {
+        // Every chunk taken is run, so the chunks below one which threw are always run
+        while (!error.is_set()) {
+            const auto chunk = next_chunk.fetch_add(1);
+            if (chunk >= num_chunks) {
+                return;
+            }
+            try {
+                func(chunk * grain_size, std::min((chunk + 1) * grain_size, n));
+            } catch (...) {
+                error.capture(chunk * grain_size);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads > 0 ? num_threads - 1 : 0);
+    try {
+        for (std::size_t i = 1; i < num_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+    } catch (const std::system_error &) {
+        // The calling thread takes the chunks of the threads which could not be started
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    error.rethrow();
+}
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_PARALLEL_H_
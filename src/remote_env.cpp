@@ -0,0 +1,428 @@
+#include "remote_env.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <nop/rpc/interface.h>
+#include <nop/rpc/simple_method_receiver.h>
+#include <nop/serializer.h>
+#include <nop/structure.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kBufferSize = 1 << 16;
+
+struct RemoteEnvInfo {
+    uint64_t num_envs = 0;
+    uint64_t rows = 0;
+    uint64_t cols = 0;
+    NOP_STRUCTURE(RemoteEnvInfo, num_envs, rows, cols);
+};
+
+struct RemoteStepResult {
+    std::vector<uint8_t> obs;    // Element index observations of every environment, concatenated
+    std::vector<uint64_t> reward_signals;
+    std::vector<uint8_t> dones;
+    NOP_STRUCTURE(RemoteStepResult, obs, reward_signals, dones);
+};
+
+// Calls of the protocol, each over the whole batch
+struct RemoteEnvInterface : nop::Interface<RemoteEnvInterface> {
+    NOP_INTERFACE("boxworld.RemoteEnv");
+    NOP_METHOD(GetInfo, RemoteEnvInfo());
+    NOP_METHOD(Reset, std::vector<uint8_t>());
+    NOP_METHOD(Step, RemoteStepResult(std::vector<uint8_t> actions, bool use_colour));
+    NOP_METHOD(Observe, std::vector<uint8_t>());
+    NOP_INTERFACE_API(GetInfo, Reset, Step, Observe);
+};
+
+// libnop writer which buffers writes to a socket until flushed, as the library writers make a call per byte
+class SocketWriter {
+public:
+    explicit SocketWriter(int fd) : fd(fd) {
+        buffer.reserve(kBufferSize);
+    }
+
+    auto Prepare(std::size_t /*size*/) -> nop::Status<void> {
+        return {};
+    }
+
+    auto Write(uint8_t byte) -> nop::Status<void> {
+        buffer.push_back(byte);
+        return {};
+    }
+
+    auto Write(const void* begin, const void* end) -> nop::Status<void> {
+        buffer.insert(buffer.end(), static_cast<const uint8_t*>(begin), static_cast<const uint8_t*>(end));
+        return {};
+    }
+
+    auto Skip(std::size_t padding_bytes, uint8_t padding_value = 0x00) -> nop::Status<void> {
+        buffer.insert(buffer.end(), padding_bytes, padding_value);
+        return {};
+    }
+
+    auto Flush() -> nop::Status<void> {
+        std::size_t sent = 0;
+        while (sent < buffer.size()) {
+            const auto ret = ::send(fd, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                buffer.clear();
+                return nop::ErrorStatus::IOError;
+            }
+            sent += static_cast<std::size_t>(ret);
+        }
+        buffer.clear();
+        return {};
+    }
+
+private:
+    int fd;
+    std::vector<uint8_t> buffer;
+};
+
+// libnop reader which reads from a socket in blocks
+class SocketReader {
+public:
+    explicit SocketReader(int fd) : fd(fd), buffer(kBufferSize) {}
+
+    auto Ensure(std::size_t /*size*/) -> nop::Status<void> {
+        return {};
+    }
+
+    auto Read(uint8_t* byte) -> nop::Status<void> {
+        return Read(byte, byte + 1);
+    }
+
+    auto Read(void* begin, void* end) -> nop::Status<void> {
+        auto* out = static_cast<uint8_t*>(begin);
+        const auto* out_end = static_cast<uint8_t*>(end);
+        while (out < out_end) {
+            if (pos == size) {
+                auto status = Fill();
+                if (!status) {
+                    return status;
+                }
+            }
+            const auto count = std::min(size - pos, static_cast<std::size_t>(out_end - out));
+            std::memcpy(out, buffer.data() + pos, count);
+            pos += count;
+            out += count;
+        }
+        return {};
+    }
+
+    auto Skip(std::size_t padding_bytes) -> nop::Status<void> {
+        uint8_t byte = 0;
+        for (std::size_t i = 0; i < padding_bytes; ++i) {
+            auto status = Read(&byte);
+            if (!status) {
+                return status;
+            }
+        }
+        return {};
+    }
+
+private:
+    auto Fill() -> nop::Status<void> {
+        while (true) {
+            const auto ret = ::recv(fd, buffer.data(), buffer.size(), 0);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret == 0) {
+                return nop::ErrorStatus::ReadLimitReached;
+            }
+            if (ret < 0) {
+                return nop::ErrorStatus::IOError;
+            }
+            pos = 0;
+            size = static_cast<std::size_t>(ret);
+            return {};
+        }
+    }
+
+    int fd;
+    std::vector<uint8_t> buffer;
+    std::size_t pos = 0;
+    std::size_t size = 0;
+};
+
+// libnop sender which flushes the call before waiting for its return value
+class SocketSender {
+public:
+    explicit SocketSender(int fd) : writer(fd), reader(fd), serializer(&writer), deserializer(&reader) {}
+
+    template <typename MethodSelector, typename Return, typename... Args>
+    void SendMethod(MethodSelector method_selector, nop::Status<Return>* return_value,
+                    const std::tuple<Args...>& args) {
+        auto status = serializer.Write(method_selector);
+        if (status) {
+            status = serializer.Write(args);
+        }
+        if (status) {
+            status = writer.Flush();
+        }
+        if (!status) {
+            *return_value = status.error();
+            return;
+        }
+        Return value;
+        status = deserializer.Read(&value);
+        if (!status) {
+            *return_value = status.error();
+        } else {
+            *return_value = std::move(value);
+        }
+    }
+
+private:
+    SocketWriter writer;
+    SocketReader reader;
+    nop::Serializer<SocketWriter*> serializer;
+    nop::Deserializer<SocketReader*> deserializer;
+};
+
+void set_no_delay(int fd) noexcept {
+    // Calls are small and answered immediately, so do not wait to coalesce packets
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+template <typename T>
+auto check_call(nop::Status<T> status) -> T {
+    if (!status) {
+        throw std::runtime_error(std::string("Remote environment call failed: ") + status.GetErrorMessage());
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(status.get());
+    }
+}
+
+void write_observations(const BoxWorldVecEnv& vec_env, std::vector<uint8_t>& obs) {
+    const auto obs_size = vec_env.get_state(0).observation_index_size();
+    obs.resize(vec_env.num_envs() * obs_size);
+    for (std::size_t i = 0; i < vec_env.num_envs(); ++i) {
+        vec_env.get_state(i).get_observation_index(obs.data() + i * obs_size);
+    }
+}
+}    // namespace
+
+struct RemoteEnvClient::Connection {
+    explicit Connection(int fd) : fd(fd), sender(fd) {}
+    ~Connection() {
+        close(fd);
+    }
+    Connection(const Connection&) = delete;
+    Connection(Connection&&) = delete;
+    auto operator=(const Connection&) -> Connection& = delete;
+    auto operator=(Connection&&) -> Connection& = delete;
+
+    int fd;
+    SocketSender sender;
+};
+
+RemoteEnvServer::RemoteEnvServer(BoxWorldVecEnv vec_env, uint16_t port)
+    : vec_env(std::move(vec_env)),
+      actions(this->vec_env.num_envs()),
+      reward_signals(this->vec_env.num_envs()),
+      dones(this->vec_env.num_envs()) {
+    // The element index encoding has no padding, so every served board must have the same dimensions
+    if (this->vec_env.is_padded()) {
+        throw std::invalid_argument("Padded environments cannot be served.");
+    }
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        throw std::runtime_error("Cannot create the server socket.");
+    }
+    int flag = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    socklen_t length = sizeof(address);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd, 1) != 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        close(listen_fd);
+        throw std::runtime_error("Cannot listen on port " + std::to_string(port) + ".");
+    }
+    listen_port = ntohs(address.sin_port);
+}
+
+RemoteEnvServer::~RemoteEnvServer() {
+    close(listen_fd);
+}
+
+auto RemoteEnvServer::port() const noexcept -> uint16_t {
+    return listen_port;
+}
+
+void RemoteEnvServer::serve_connection() {
+    int fd = -1;
+    do {
+        fd = accept(listen_fd, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot accept a connection.");
+    }
+    set_no_delay(fd);
+    SocketWriter writer(fd);
+    SocketReader reader(fd);
+    nop::Serializer<SocketWriter*> serializer(&writer);
+    nop::Deserializer<SocketReader*> deserializer(&reader);
+    auto receiver = nop::MakeSimpleMethodReceiver(&serializer, &deserializer);
+
+    // Replies are returned by value, so the buffers of each reply are reused between calls
+    std::vector<uint8_t> obs;
+    RemoteStepResult result;
+    auto dispatcher = nop::BindInterface(
+        RemoteEnvInterface::GetInfo::Bind([&]() {
+            const auto shape = vec_env.get_state(0).observation_shape();
+            return RemoteEnvInfo{vec_env.num_envs(), shape[2], shape[1]};
+        }),
+        RemoteEnvInterface::Reset::Bind([&]() {
+            vec_env.reset();
+            write_observations(vec_env, obs);
+            return obs;
+        }),
+        RemoteEnvInterface::Step::Bind([&](const std::vector<uint8_t>& step_actions, bool use_colour) {
+            // Invalid calls end the connection, as the client can only send them by not following the protocol
+            if (step_actions.size() != actions.size()) {
+                throw std::invalid_argument("Step call has the wrong number of actions.");
+            }
+            for (std::size_t i = 0; i < actions.size(); ++i) {
+                if (step_actions[i] >= kNumActions) {
+                    throw std::invalid_argument("Step call has an unknown action.");
+                }
+                actions[i] = static_cast<Action>(step_actions[i]);
+            }
+            vec_env.step(actions.data(), nullptr, reward_signals.data(), dones.data(), use_colour);
+            write_observations(vec_env, result.obs);
+            result.reward_signals = reward_signals;
+            result.dones = dones;
+            return result;
+        }),
+        RemoteEnvInterface::Observe::Bind([&]() {
+            write_observations(vec_env, obs);
+            return obs;
+        }));
+    try {
+        while (dispatcher(&receiver) && writer.Flush()) {
+        }
+    } catch (const std::invalid_argument&) {
+    }
+    close(fd);
+}
+
+void RemoteEnvServer::serve() {
+    while (true) {
+        serve_connection();
+    }
+}
+
+auto RemoteEnvServer::get_vec_env() const noexcept -> const BoxWorldVecEnv& {
+    return vec_env;
+}
+
+RemoteEnvClient::RemoteEnvClient(const std::string& host, uint16_t port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        throw std::runtime_error("Cannot resolve " + host + ".");
+    }
+    int fd = -1;
+    for (auto* address = addresses; address != nullptr && fd < 0; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot connect to " + host + ":" + std::to_string(port) + ".");
+    }
+    set_no_delay(fd);
+    connection = std::make_unique<Connection>(fd);
+    const auto info = check_call(RemoteEnvInterface::GetInfo::Invoke(&connection->sender));
+    env_count = info.num_envs;
+    num_rows = info.rows;
+    num_cols = info.cols;
+}
+
+RemoteEnvClient::~RemoteEnvClient() = default;
+
+auto RemoteEnvClient::num_envs() const noexcept -> std::size_t {
+    return env_count;
+}
+
+auto RemoteEnvClient::rows() const noexcept -> std::size_t {
+    return num_rows;
+}
+
+auto RemoteEnvClient::cols() const noexcept -> std::size_t {
+    return num_cols;
+}
+
+auto RemoteEnvClient::observation_size() const noexcept -> std::size_t {
+    return num_rows * num_cols + 1;
+}
+
+void RemoteEnvClient::reset(uint8_t* obs) {
+    const auto values = check_call(RemoteEnvInterface::Reset::Invoke(&connection->sender));
+    CheckObservations(values);
+    if (obs != nullptr) {
+        std::copy(values.begin(), values.end(), obs);
+    }
+}
+
+void RemoteEnvClient::step(const Action* actions, uint8_t* obs, uint64_t* reward_signals, uint8_t* dones,
+                           bool use_colour) {
+    std::vector<uint8_t> step_actions(env_count);
+    std::transform(actions, actions + env_count, step_actions.begin(),
+                   [](Action action) { return static_cast<uint8_t>(action); });
+    const auto result = check_call(RemoteEnvInterface::Step::Invoke(&connection->sender, step_actions, use_colour));
+    CheckObservations(result.obs);
+    if (result.reward_signals.size() != env_count || result.dones.size() != env_count) {
+        throw std::runtime_error("Remote environment returned the wrong number of values.");
+    }
+    if (obs != nullptr) {
+        std::copy(result.obs.begin(), result.obs.end(), obs);
+    }
+    if (reward_signals != nullptr) {
+        std::copy(result.reward_signals.begin(), result.reward_signals.end(), reward_signals);
+    }
+    if (dones != nullptr) {
+        std::copy(result.dones.begin(), result.dones.end(), dones);
+    }
+}
+
+void RemoteEnvClient::observe(uint8_t* obs) {
+    const auto values = check_call(RemoteEnvInterface::Observe::Invoke(&connection->sender));
+    CheckObservations(values);
+    std::copy(values.begin(), values.end(), obs);
+}
+
+void RemoteEnvClient::CheckObservations(const std::vector<uint8_t>& obs) const {
+    if (obs.size() != env_count * observation_size()) {
+        throw std::runtime_error("Remote environment returned the wrong number of values.");
+    }
+}
+
+}    // namespace boxworld
@@ -0,0 +1,153 @@
+#ifndef BOXWORLD_REMOTE_ENV_H_
+#define BOXWORLD_REMOTE_ENV_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+#include "vec_env.h"
+
+namespace boxworld {
+
+// Serves a batch of environments over TCP, with the RPC protocol of the vendored libnop.
+// Each call carries the whole batch, so a step is one round trip however many environments are served, and
+// observations are sent as the element index encoding of BoxWorldGameState::get_observation_index().
+// @note Connections are served one at a time. POSIX only
+class RemoteEnvServer {
+public:
+    RemoteEnvServer() = delete;
+
+    /**
+     * Listen for connections on the given port of every interface.
+     * @note Throws std::runtime_error if the socket cannot be bound, or std::invalid_argument if vec_env is padded
+     * @param vec_env The environments to serve
+     * @param port The TCP port to listen on, 0 to pick a free port
+     */
+    explicit RemoteEnvServer(BoxWorldVecEnv vec_env, uint16_t port = 0);
+    ~RemoteEnvServer();
+
+    RemoteEnvServer(const RemoteEnvServer &) = delete;
+    RemoteEnvServer(RemoteEnvServer &&) = delete;
+    auto operator=(const RemoteEnvServer &) -> RemoteEnvServer & = delete;
+    auto operator=(RemoteEnvServer &&) -> RemoteEnvServer & = delete;
+
+    /**
+     * Get the port the server listens on
+     * @return The TCP port
+     */
+    [[nodiscard]] auto port() const noexcept -> uint16_t;
+
+    /**
+     * Accept a single connection, and answer its calls until the client disconnects or sends an invalid call.
+     * @note Throws std::runtime_error if a connection cannot be accepted
+     */
+    void serve_connection();
+
+    /**
+     * Serve connections one after another, forever.
+     * @note Throws std::runtime_error if a connection cannot be accepted
+     */
+    [[noreturn]] void serve();
+
+    /**
+     * Get the served environments, which are only safe to read while no connection is being served
+     * @return Reference to the environments
+     */
+    [[nodiscard]] auto get_vec_env() const noexcept -> const BoxWorldVecEnv &;
+
+private:
+    BoxWorldVecEnv vec_env;
+    int listen_fd = -1;
+    uint16_t listen_port = 0;
+    std::vector<Action> actions;          // Reused buffers of a step
+    std::vector<uint64_t> reward_signals;
+    std::vector<uint8_t> dones;
+};
+
+// Client of a RemoteEnvServer, stepping the remote batch with one round trip per call.
+// Observations are written in the element index encoding, observation_size() bytes per environment.
+// @note Not thread safe, use one client per thread
+class RemoteEnvClient {
+public:
+    RemoteEnvClient() = delete;
+
+    /**
+     * Connect to a server.
+     * @note Throws std::runtime_error if the server cannot be reached
+     * @param host Name or address of the server
+     * @param port TCP port of the server
+     */
+    RemoteEnvClient(const std::string &host, uint16_t port);
+    ~RemoteEnvClient();
+
+    RemoteEnvClient(const RemoteEnvClient &) = delete;
+    RemoteEnvClient(RemoteEnvClient &&) = delete;
+    auto operator=(const RemoteEnvClient &) -> RemoteEnvClient & = delete;
+    auto operator=(RemoteEnvClient &&) -> RemoteEnvClient & = delete;
+
+    /**
+     * Get the number of environments served
+     * @return Count of environments
+     */
+    [[nodiscard]] auto num_envs() const noexcept -> std::size_t;
+
+    /**
+     * Get the rows of the served boards
+     * @return Number of rows
+     */
+    [[nodiscard]] auto rows() const noexcept -> std::size_t;
+
+    /**
+     * Get the cols of the served boards
+     * @return Number of cols
+     */
+    [[nodiscard]] auto cols() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of bytes of a single environment observation, see BoxWorldGameState::observation_index_size()
+     * @return rows * cols + 1
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Reset every environment, see BoxWorldVecEnv::reset().
+     * @note Throws std::runtime_error if the call fails
+     * @param obs Buffer of num_envs() * observation_size() bytes to write the observations into, or nullptr to skip
+     */
+    void reset(uint8_t *obs = nullptr);
+
+    /**
+     * Step every environment, see BoxWorldVecEnv::step().
+     * @note Throws std::runtime_error if the call fails
+     * @param actions Buffer of num_envs() actions, one per environment
+     * @param obs Buffer of num_envs() * observation_size() bytes to write the observations into, or nullptr to skip
+     * @param reward_signals Buffer of num_envs() reward signals for the applied action, or nullptr to skip
+     * @param dones Buffer of num_envs() done values, or nullptr to skip
+     * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+     */
+    void step(const Action *actions, uint8_t *obs = nullptr, uint64_t *reward_signals = nullptr,
+              uint8_t *dones = nullptr, bool use_colour = false);
+
+    /**
+     * Get the current observations without stepping.
+     * @note Throws std::runtime_error if the call fails
+     * @param obs Buffer of num_envs() * observation_size() bytes to write the observations into
+     */
+    void observe(uint8_t *obs);
+
+private:
+    struct Connection;
+
+    void CheckObservations(const std::vector<uint8_t> &obs) const;
+
+    std::unique_ptr<Connection> connection;
+    std::size_t env_count = 0;
+    std::size_t num_rows = 0;
+    std::size_t num_cols = 0;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_REMOTE_ENV_H_
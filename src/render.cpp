@@ -0,0 +1,236 @@
+#include "render.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "parallel.h"
+
+namespace boxworld {
+
+namespace {
+// Colour maps for state to image
+constexpr Pixel WHITE = {0xff, 0xff, 0xff};
+constexpr Pixel BLACK = {0x00, 0x00, 0x00};
+constexpr std::array<Pixel, kNumElements> kElementToPixel{{
+    {0xfe, 0x00, 0x00},    // kColour0, light red
+    {0x80, 0x00, 0x01},    // kColour1, dark red
+    {0xff, 0xb7, 0x32},    // kColour2, orange
+    {0x80, 0x34, 0x00},    // kColour3, brown
+    {0xff, 0xff, 0x00},    // kColour4, yellow
+    {0x00, 0xfe, 0x21},    // kColour5, light green
+    {0x00, 0x7f, 0x0e},    // kColour6, dark green
+    {0x32, 0xa9, 0xfe},    // kColour7, light blue
+    {0x00, 0x26, 0xff},    // kColour8, blue
+    {0x00, 0xe6, 0x66},    // kColour9, dark blue
+    {0xb1, 0x00, 0xfe},    // kColour10, light purple
+    {0x47, 0x00, 0x66},    // kColour11, dark purple
+    WHITE,                 // kColourGoal
+    BLACK,                 // kAgent
+    {0xb4, 0xb4, 0xb4},    // kEmpty
+}};
+
+// Colours of the palette indices, the element colours then the border
+constexpr auto kPalette = []() {
+    std::array<Pixel, kPaletteSize> palette{};
+    for (std::size_t el = 0; el < kNumElements; ++el) {
+        palette[el] = kElementToPixel[el];    // NOLINT(*-bounds-constant-array-index)
+    }
+    palette[kBorderPaletteIndex] = BLACK;
+    return palette;
+}();
+
+// Draw the padded board with one sprite row of row_len bytes per palette index, where each row of sprites is drawn
+// one pixel line cell by cell and then copied down the sprite
+void draw_image(const Element* board, std::size_t rows, std::size_t cols, bool has_key, Element inventory,
+                const uint8_t* sprite_rows, std::size_t row_len, std::size_t sprite_size, uint8_t* img) noexcept {
+    const auto img_row_len = cols * row_len;
+    const auto* border_row = sprite_rows + kBorderPaletteIndex * row_len;
+    for (std::size_t h = 0; h < rows; ++h) {
+        auto* line = img + h * sprite_size * img_row_len;
+        const bool is_border_row = h == 0 || h == rows - 1;
+        for (std::size_t w = 0; w < cols; ++w) {
+            const bool is_border = is_border_row || w == 0 || w == cols - 1;
+            const auto* sprite_row = border_row;
+            if (!is_border) {
+                sprite_row = sprite_rows + static_cast<std::size_t>(*board++) * row_len;
+            }
+            std::memcpy(line + w * row_len, sprite_row, row_len);
+        }
+        // Top left item is the key held by the agent
+        if (h == 0 && has_key) {
+            std::memcpy(line, sprite_rows + static_cast<std::size_t>(inventory) * row_len, row_len);
+        }
+        for (std::size_t r = 1; r < sprite_size; ++r) {
+            std::memcpy(line + r * img_row_len, line, img_row_len);
+        }
+    }
+}
+}    // namespace
+
+auto get_palette() noexcept -> const std::array<Pixel, kPaletteSize>& {
+    return kPalette;
+}
+
+auto get_element_pixel(Element element) noexcept -> const Pixel& {
+    assert(BoxWorldGameState::is_valid_element(element));
+    return kElementToPixel[static_cast<std::size_t>(element)];    // NOLINT(*-bounds-constant-array-index)
+}
+
+ImageRenderer::ImageRenderer(std::size_t sprite_size)
+    : sprite_size_px(sprite_size), sprite_row_len(sprite_size * SPRITE_CHANNELS) {
+    if (sprite_size == 0) {
+        throw std::invalid_argument("Sprite size must be positive.");
+    }
+    // One row of a sprite for each palette index, in colour and indexed, so sprites are drawn a row at a time
+    sprite_rows.resize(kPaletteSize * sprite_row_len);
+    index_sprite_rows.resize(kPaletteSize * sprite_size);
+    for (std::size_t idx = 0; idx < kPaletteSize; ++idx) {
+        const auto& pixel = kPalette[idx];    // NOLINT(*-bounds-constant-array-index)
+        for (std::size_t c = 0; c < sprite_size; ++c) {
+            sprite_rows[idx * sprite_row_len + SPRITE_CHANNELS * c + 0] = pixel.r;
+            sprite_rows[idx * sprite_row_len + SPRITE_CHANNELS * c + 1] = pixel.g;
+            sprite_rows[idx * sprite_row_len + SPRITE_CHANNELS * c + 2] = pixel.b;
+        }
+        std::fill_n(index_sprite_rows.begin() + static_cast<std::ptrdiff_t>(idx * sprite_size), sprite_size,
+                    static_cast<uint8_t>(idx));
+    }
+}
+
+auto ImageRenderer::sprite_size() const noexcept -> std::size_t {
+    return sprite_size_px;
+}
+
+auto ImageRenderer::image_shape(const BoxWorldGameState& state) const noexcept -> std::array<std::size_t, 3> {
+    const auto rows = state.shared_state->rows + 2;
+    const auto cols = state.shared_state->cols + 2;
+    return {rows * sprite_size_px, cols * sprite_size_px, SPRITE_CHANNELS};
+}
+
+auto ImageRenderer::render(const BoxWorldGameState& state) const -> std::vector<uint8_t> {
+    const auto shape = image_shape(state);
+    std::vector<uint8_t> img(shape[0] * shape[1] * shape[2]);
+    render(state, img.data());
+    return img;
+}
+
+void ImageRenderer::render(const BoxWorldGameState& state, uint8_t* img) const noexcept {
+    // Pad board with black border
+    draw_image(state.local_state.board.data(), state.shared_state->rows + 2, state.shared_state->cols + 2,
+               state.has_key(), state.local_state.inventory, sprite_rows.data(), sprite_row_len, sprite_size_px, img);
+}
+
+auto ImageRenderer::indexed_image_shape(const BoxWorldGameState& state) const noexcept
+    -> std::array<std::size_t, 3> {
+    const auto shape = image_shape(state);
+    return {shape[0], shape[1], 1};
+}
+
+auto ImageRenderer::render_indexed(const BoxWorldGameState& state) const -> std::vector<uint8_t> {
+    const auto shape = indexed_image_shape(state);
+    std::vector<uint8_t> img(shape[0] * shape[1]);
+    render_indexed(state, img.data());
+    return img;
+}
+
+void ImageRenderer::render_indexed(const BoxWorldGameState& state, uint8_t* img) const noexcept {
+    draw_image(state.local_state.board.data(), state.shared_state->rows + 2, state.shared_state->cols + 2,
+               state.has_key(), state.local_state.inventory, index_sprite_rows.data(), sprite_size_px,
+               sprite_size_px, img);
+}
+
+void ImageRenderer::render_batch(const BoxWorldGameState* states, std::size_t num_states, uint8_t* imgs,
+                                 std::size_t num_threads) const {
+    if (num_states == 0) {
+        return;
+    }
+    const auto shape = image_shape(states[0]);
+    for (std::size_t i = 1; i < num_states; ++i) {
+        if (image_shape(states[i]) != shape) {
+            throw std::invalid_argument("All states of a batch must have the same board dimensions.");
+        }
+    }
+    const auto img_size = shape[0] * shape[1] * shape[2];
+    parallel_for(num_states, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            render(states[i], imgs + i * img_size);
+        }
+    });
+}
+
+void ImageRenderer::draw_cell(uint8_t* img, std::size_t h, std::size_t w, std::size_t cols,
+                              Element element) const noexcept {
+    const std::size_t img_row_len = sprite_row_len * cols;
+    const std::size_t img_idx_top_left = (h * sprite_size_px * img_row_len) + (w * sprite_row_len);
+    const auto* sprite_row = &sprite_rows[static_cast<std::size_t>(element) * sprite_row_len];
+    for (std::size_t r = 0; r < sprite_size_px; ++r) {
+        std::memcpy(img + img_idx_top_left + r * img_row_len, sprite_row, sprite_row_len);
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+IncrementalRenderer::IncrementalRenderer(std::size_t sprite_size) : renderer(sprite_size) {}
+
+auto IncrementalRenderer::render(const BoxWorldGameState& state) -> const std::vector<uint8_t>& {
+    const auto shape = renderer.image_shape(state);
+    const auto num_cells = (shape[0] / renderer.sprite_size() - 2) * (shape[1] / renderer.sprite_size() - 2);
+    if (drawn_board.size() != num_cells || img.size() != shape[0] * shape[1] * shape[2]) {
+        // Full repaint
+        img.resize(shape[0] * shape[1] * shape[2]);
+        renderer.render(state, img.data());
+        cols = shape[1] / renderer.sprite_size();
+        drawn_board.resize(num_cells);
+        for (std::size_t i = 0; i < num_cells; ++i) {
+            drawn_board[i] = state.get_item(i);
+        }
+        drawn_inventory = state.get_inventory();
+        return img;
+    }
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        if (drawn_board[i] != state.get_item(i)) {
+            DrawBoardCell(state, i);
+        }
+    }
+    DrawInventory(state);
+    return img;
+}
+
+auto IncrementalRenderer::update(const BoxWorldGameState& state, const UndoRecord& record)
+    -> const std::vector<uint8_t>& {
+    if (drawn_board.empty()) {
+        return render(state);
+    }
+    for (std::size_t i = 0; i < record.num_cell_changes; ++i) {
+        DrawBoardCell(state, record.cell_changes[i].index);
+    }
+    DrawInventory(state);
+    return img;
+}
+
+auto IncrementalRenderer::get_image() const noexcept -> const std::vector<uint8_t>& {
+    return img;
+}
+
+void IncrementalRenderer::invalidate() noexcept {
+    drawn_board.clear();
+}
+
+void IncrementalRenderer::DrawBoardCell(const BoxWorldGameState& state, std::size_t index) {
+    const auto el = state.get_item(index);
+    const auto board_cols = cols - 2;
+    renderer.draw_cell(img.data(), index / board_cols + 1, index % board_cols + 1, cols, el);
+    drawn_board[index] = el;
+}
+
+void IncrementalRenderer::DrawInventory(const BoxWorldGameState& state) {
+    const auto inventory = state.get_inventory();
+    if (inventory != drawn_inventory) {
+        // No key is drawn as the black border
+        renderer.draw_cell(img.data(), 0, 0, cols, inventory);
+        drawn_inventory = inventory;
+    }
+}
+
+}    // namespace boxworld
@@ -0,0 +1,173 @@
+#ifndef BOXWORLD_RENDER_H_
+#define BOXWORLD_RENDER_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+// RGB colour of a pixel
+struct Pixel {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+// Number of colours of indexed images, one per element then the border
+constexpr std::size_t kPaletteSize = kNumElements + 1;
+// Palette index of the border of indexed images, the element values are their own indices
+constexpr std::size_t kBorderPaletteIndex = kNumElements;
+
+/**
+ * Get the colours of the palette indices of indexed images, see ImageRenderer::render_indexed()
+ * @return Colour of each palette index
+ */
+[[nodiscard]] auto get_palette() noexcept -> const std::array<Pixel, kPaletteSize> &;
+
+/**
+ * Get the colour elements are drawn with
+ * @param element The element
+ * @return Colour of the element
+ */
+[[nodiscard]] auto get_element_pixel(Element element) noexcept -> const Pixel &;
+
+// Renders states as HWC RGB images, where each cell is drawn as a square sprite of sprite_size pixels.
+// The board is padded with a one cell black border, and the held key is drawn in the top left corner.
+class ImageRenderer {
+public:
+    /**
+     * @param sprite_size Width and height in pixels of each cell, 1 draws one pixel per cell
+     */
+    explicit ImageRenderer(std::size_t sprite_size = SPRITE_WIDTH);
+
+    /**
+     * Get the width and height in pixels of each cell.
+     * @return sprite size
+     */
+    [[nodiscard]] auto sprite_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the shape the image of the given state should be viewed as.
+     * @param state The state to render
+     * @return array indicating image HWC
+     */
+    [[nodiscard]] auto image_shape(const BoxWorldGameState &state) const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Get the flat (HWC) image of the given state
+     * @param state The state to render
+     * @return flattened byte vector represending RGB values (HWC)
+     */
+    [[nodiscard]] auto render(const BoxWorldGameState &state) const -> std::vector<uint8_t>;
+
+    /**
+     * Write the flat (HWC) image of the given state into the given buffer.
+     * @param state The state to render
+     * @param img Pointer to the start of a buffer of image_shape() bytes to write into
+     */
+    void render(const BoxWorldGameState &state, uint8_t *img) const noexcept;
+
+    /**
+     * Write the images of a batch of states into one buffer, viewed as [num_states, H, W, C], rendering in parallel.
+     * @note Throws std::invalid_argument if the states differ in board dimensions
+     * @param states Pointer to the first of the states to render
+     * @param num_states Number of states to render
+     * @param imgs Pointer to the start of a buffer of num_states images of image_shape() bytes to write into
+     * @param num_threads Number of threads to use, 0 to use the hardware concurrency
+     */
+    void render_batch(const BoxWorldGameState *states, std::size_t num_states, uint8_t *imgs,
+                      std::size_t num_threads = 0) const;
+
+    /**
+     * Get the shape the indexed image of the given state should be viewed as.
+     * @param state The state to render
+     * @return array indicating image HWC, with a single channel
+     */
+    [[nodiscard]] auto indexed_image_shape(const BoxWorldGameState &state) const noexcept
+        -> std::array<std::size_t, 3>;
+
+    /**
+     * Get the flat (HW) indexed image of the given state, with one palette index per pixel, see get_palette().
+     * A sprite size of 1 gives one index per cell of the padded board.
+     * @param state The state to render
+     * @return flattened byte vector of palette indices (HW)
+     */
+    [[nodiscard]] auto render_indexed(const BoxWorldGameState &state) const -> std::vector<uint8_t>;
+
+    /**
+     * Write the flat (HW) indexed image of the given state into the given buffer.
+     * @param state The state to render
+     * @param img Pointer to the start of a buffer of indexed_image_shape() bytes to write into
+     */
+    void render_indexed(const BoxWorldGameState &state, uint8_t *img) const noexcept;
+
+    /**
+     * Draw a single cell of the padded board.
+     * @param img Pointer to the start of the image
+     * @param h Row of the cell in the padded board
+     * @param w Column of the cell in the padded board
+     * @param cols Columns of the padded board
+     * @param element Element to draw, kAgent draws black
+     */
+    void draw_cell(uint8_t *img, std::size_t h, std::size_t w, std::size_t cols, Element element) const noexcept;
+
+private:
+    std::size_t sprite_size_px;
+    std::size_t sprite_row_len;
+    std::vector<uint8_t> sprite_rows;          // One sprite row of RGB values per palette index
+    std::vector<uint8_t> index_sprite_rows;    // One sprite row of palette indices per palette index
+};
+
+// Stateful renderer which keeps the last image, and only repaints the cells changed since the previous frame.
+class IncrementalRenderer {
+public:
+    /**
+     * @param sprite_size Width and height in pixels of each cell, 1 draws one pixel per cell
+     */
+    explicit IncrementalRenderer(std::size_t sprite_size = SPRITE_WIDTH);
+
+    /**
+     * Render the given state, repainting only the cells which differ from the last rendered frame.
+     * @param state The state to render, the full image is drawn if the board dimensions changed
+     * @return Reference to the image, viewed as image_shape() of the state
+     */
+    auto render(const BoxWorldGameState &state) -> const std::vector<uint8_t> &;
+
+    /**
+     * Repaint only the cells changed by an action applied via apply_action_with_undo() or undone via undo_action().
+     * @note The last rendered frame must be of the state before the action
+     * @param state The state after the action was applied (or undone)
+     * @param record The record of the action
+     * @return Reference to the image, viewed as image_shape() of the state
+     */
+    auto update(const BoxWorldGameState &state, const UndoRecord &record) -> const std::vector<uint8_t> &;
+
+    /**
+     * Get the last rendered image
+     * @return Reference to the image
+     */
+    [[nodiscard]] auto get_image() const noexcept -> const std::vector<uint8_t> &;
+
+    /**
+     * Force the next render() to repaint the full image.
+     */
+    void invalidate() noexcept;
+
+private:
+    void DrawBoardCell(const BoxWorldGameState &state, std::size_t index);
+    void DrawInventory(const BoxWorldGameState &state);
+
+    ImageRenderer renderer;
+    std::vector<uint8_t> img;
+    std::vector<Element> drawn_board;    // Elements drawn in the current image
+    Element drawn_inventory = Element::kAgent;
+    std::size_t cols = 0;    // Columns of the padded board
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_RENDER_H_
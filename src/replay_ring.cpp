@@ -0,0 +1,147 @@
+#include "replay_ring.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "parallel.h"
+#include "rng.h"
+
+namespace boxworld {
+
+namespace {
+// Bit offsets of the fields packed after the level index and the reward signal
+constexpr uint32_t kAgentShift = 32;
+constexpr uint32_t kInventoryShift = 48;
+constexpr uint32_t kFlagShift = 56;
+
+auto pack_word(uint32_t value, const PackedStateKey& key, uint8_t flag) noexcept -> uint64_t {
+    return uint64_t{value} | (uint64_t{key.agent_idx} << kAgentShift) |
+           (uint64_t{static_cast<uint8_t>(key.inventory)} << kInventoryShift) | (uint64_t{flag} << kFlagShift);
+}
+
+auto unpack_word(uint64_t word, PackedStateKey& key) noexcept -> std::pair<uint32_t, uint8_t> {
+    key.agent_idx = static_cast<uint16_t>(word >> kAgentShift);
+    key.inventory = static_cast<Element>(static_cast<uint8_t>(word >> kInventoryShift));
+    return {static_cast<uint32_t>(word), static_cast<uint8_t>(word >> kFlagShift)};
+}
+}    // namespace
+
+ReplayRing::ReplayRing(std::vector<BoxWorldGameState> levels, std::size_t capacity)
+    : levels(std::move(levels)), slots(capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Replay ring capacity must be positive.");
+    }
+    if (this->levels.empty()) {
+        throw std::invalid_argument("Replay ring needs at least one level.");
+    }
+    const auto shape = this->levels.front().observation_shape();
+    for (const auto& level : this->levels) {
+        if (level.observation_shape() != shape) {
+            throw std::invalid_argument("All levels must have the same board dimensions.");
+        }
+        // Throws if the level cannot be packed
+        [[maybe_unused]] const auto key = level.packed_key();
+    }
+    obs_size = shape[0] * shape[1] * shape[2];
+}
+
+void ReplayRing::push(const ReplayTransition& transition) {
+    if (transition.level_index >= levels.size()) {
+        throw std::invalid_argument("Transition level index is not of a level of the ring.");
+    }
+    const auto ticket = head.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = slots[ticket % slots.size()];
+    const auto lap = ticket / slots.size();
+    // Wait for the previous lap of the slot to be written, which only happens when pushes lap the whole ring
+    auto expected = 2 * lap;
+    while (!slot.sequence.compare_exchange_weak(expected, 2 * lap + 1, std::memory_order_relaxed)) {
+        expected = 2 * lap;
+        std::this_thread::yield();
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.words[0].store(transition.state.remaining, std::memory_order_relaxed);
+    slot.words[1].store(transition.next_state.remaining, std::memory_order_relaxed);
+    slot.words[2].store(pack_word(transition.level_index, transition.state, static_cast<uint8_t>(transition.action)),
+                        std::memory_order_relaxed);
+    slot.words[3].store(pack_word(transition.reward_signal, transition.next_state, transition.done ? 1 : 0),
+                        std::memory_order_relaxed);
+    slot.sequence.store(2 * lap + 2, std::memory_order_release);
+}
+
+auto ReplayRing::Read(uint64_t slot_index, ReplayTransition& transition) const noexcept -> bool {
+    const auto& slot = slots[slot_index];
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence % 2 == 1) {
+        return false;
+    }
+    std::array<uint64_t, kNumWords> words{};
+    for (std::size_t i = 0; i < kNumWords; ++i) {
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+        return false;
+    }
+    transition.state.remaining = words[0];
+    transition.next_state.remaining = words[1];
+    const auto [level_index, action] = unpack_word(words[2], transition.state);
+    const auto [reward_signal, done] = unpack_word(words[3], transition.next_state);
+    transition.level_index = level_index;
+    transition.action = static_cast<Action>(action);
+    transition.reward_signal = reward_signal;
+    transition.done = done != 0;
+    return true;
+}
+
+void ReplayRing::sample(std::size_t n, uint64_t seed, ReplayTransition* transitions, float* obs, float* next_obs,
+                        std::size_t num_threads) const {
+    const auto num_held = size();
+    if (num_held == 0) {
+        throw std::invalid_argument("Cannot sample from an empty replay ring.");
+    }
+    parallel_for(n, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            // Each sample has its own stream, so the results do not depend on the threads.
+            // Slots being written or overwritten are skipped by drawing again.
+            SplitMix64 rng(seed + i);
+            ReplayTransition transition;
+            while (!Read(rng.next_below(num_held), transition)) {
+                std::this_thread::yield();
+            }
+            const auto& level = levels[transition.level_index];
+            if (obs != nullptr) {
+                level.decode_observation(transition.state, obs + i * obs_size);
+            }
+            if (next_obs != nullptr) {
+                level.decode_observation(transition.next_state, next_obs + i * obs_size);
+            }
+            if (transitions != nullptr) {
+                transitions[i] = transition;
+            }
+        }
+    });
+}
+
+auto ReplayRing::size() const noexcept -> std::size_t {
+    return static_cast<std::size_t>(std::min<uint64_t>(head.load(std::memory_order_relaxed), slots.size()));
+}
+
+auto ReplayRing::capacity() const noexcept -> std::size_t {
+    return slots.size();
+}
+
+auto ReplayRing::num_pushed() const noexcept -> uint64_t {
+    return head.load(std::memory_order_relaxed);
+}
+
+auto ReplayRing::observation_size() const noexcept -> std::size_t {
+    return obs_size;
+}
+
+auto ReplayRing::get_levels() const noexcept -> const std::vector<BoxWorldGameState>& {
+    return levels;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,118 @@
+#ifndef BOXWORLD_REPLAY_RING_H_
+#define BOXWORLD_REPLAY_RING_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+// Transition stored in a ReplayRing, with both states held as packed keys of their level
+struct ReplayTransition {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint32_t level_index = 0;           // Index of the level in the levels of the ring
+    PackedStateKey state;               // State the action was applied to
+    Action action = Action::kUp;        // Action applied
+    uint32_t reward_signal = 0;         // get_reward_signal() after the action
+    PackedStateKey next_state;          // State after the action, before any reset
+    bool done = false;                  // Flag if the episode ended with the action
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator==(const ReplayTransition &other) const noexcept -> bool {
+        return level_index == other.level_index && state == other.state && action == other.action &&
+               reward_signal == other.reward_signal && next_state == other.next_state && done == other.done;
+    }
+};
+
+// Fixed capacity ring of transitions for replay, overwriting the oldest once full.
+// Each transition is packed into 32 bytes of its own cache line, so any number of actor threads push() without
+// locks, and sample() decodes observations straight from the level starts without building states or allocating.
+// Slots are guarded by a sequence number, so a sample never sees a transition which is being overwritten.
+class ReplayRing {
+public:
+    ReplayRing() = delete;
+
+    /**
+     * @note Throws std::invalid_argument if capacity is 0, there are no levels, the levels have different board
+     * dimensions, or a level has more single keys and locks than a packed key holds
+     * @param levels A state of each level the transitions are of, such as from BoxWorldGameState::make_states()
+     * @param capacity Number of transitions held
+     */
+    ReplayRing(std::vector<BoxWorldGameState> levels, std::size_t capacity);
+
+    /**
+     * Add a transition, overwriting the oldest if full. Safe to call from multiple threads at once, and
+     * concurrently with sample().
+     * @note Throws std::invalid_argument if the level index is not of a level of the ring
+     * @param transition The transition to add
+     */
+    void push(const ReplayTransition &transition);
+
+    /**
+     * Sample transitions uniformly with replacement, and write their observations.
+     * Results only depend on the seed and the transitions held, not on the number of threads.
+     * @note Throws std::invalid_argument if the ring is empty
+     * @param n Number of transitions to sample
+     * @param seed Seed of the sampling
+     * @param transitions Buffer of n transitions to write into, or nullptr to skip
+     * @param obs Buffer of n * observation_size() values for the observations of the states, or nullptr to skip
+     * @param next_obs Buffer of n * observation_size() values for the observations of the next states, or nullptr
+     * @param num_threads Number of threads to decode with, 0 to use the hardware concurrency
+     */
+    void sample(std::size_t n, uint64_t seed, ReplayTransition *transitions, float *obs = nullptr,
+                float *next_obs = nullptr, std::size_t num_threads = 1) const;
+
+    /**
+     * Get the number of transitions held
+     * @return Count of transitions, at most capacity()
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of transitions which can be held
+     * @return Count of transitions
+     */
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of transitions pushed since construction, including those overwritten
+     * @return Count of pushes
+     */
+    [[nodiscard]] auto num_pushed() const noexcept -> uint64_t;
+
+    /**
+     * Get the number of values in the observation of a single transition state
+     * @return kNumChannels * rows * cols
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the levels of the ring
+     * @return A state of each level, indexed by ReplayTransition::level_index
+     */
+    [[nodiscard]] auto get_levels() const noexcept -> const std::vector<BoxWorldGameState> &;
+
+private:
+    // Words of a packed transition
+    static constexpr std::size_t kNumWords = 4;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};    // 2 * lap + 1 while being written in that lap, 2 * lap + 2 once written
+        std::array<std::atomic<uint64_t>, kNumWords> words{};
+    };
+
+    [[nodiscard]] auto Read(uint64_t slot_index, ReplayTransition &transition) const noexcept -> bool;
+
+    std::vector<BoxWorldGameState> levels;
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> head{0};    // Pushes claimed, the next push writes slot head % capacity
+    std::size_t obs_size = 0;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_REPLAY_RING_H_
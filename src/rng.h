@@ -0,0 +1,97 @@
+#ifndef BOXWORLD_RNG_H_
+#define BOXWORLD_RNG_H_
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace boxworld {
+
+// SplitMix64 generator, small and fast with output which is identical on every platform
+class SplitMix64 {
+public:
+    using result_type = uint64_t;
+
+    explicit constexpr SplitMix64(uint64_t seed = 0) noexcept : state(seed) {}
+
+    [[nodiscard]] static constexpr auto min() noexcept -> result_type {
+        return std::numeric_limits<result_type>::min();
+    }
+    [[nodiscard]] static constexpr auto max() noexcept -> result_type {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr auto operator()() noexcept -> result_type {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31U);
+    }
+
+    /**
+     * Sample uniformly from [0, bound)
+     * @param bound Exclusive upper bound, must be positive
+     * @return sampled value
+     */
+    constexpr auto next_below(uint64_t bound) noexcept -> uint64_t {
+        return (*this)() % bound;
+    }
+
+private:
+    uint64_t state;
+};
+
+// xoshiro256** generator, fast with a 256 bit state for long independent playout streams
+class Xoshiro256 {
+public:
+    using result_type = uint64_t;
+
+    /**
+     * @param seed Seed which is expanded into the full state with SplitMix64
+     */
+    explicit constexpr Xoshiro256(uint64_t seed = 0) noexcept {
+        SplitMix64 seeder(seed);
+        for (auto &word : state) {
+            word = seeder();
+        }
+    }
+
+    [[nodiscard]] static constexpr auto min() noexcept -> result_type {
+        return std::numeric_limits<result_type>::min();
+    }
+    [[nodiscard]] static constexpr auto max() noexcept -> result_type {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr auto operator()() noexcept -> result_type {
+        const uint64_t result = Rotl(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17U;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = Rotl(state[3], 45);
+        return result;
+    }
+
+    /**
+     * Sample uniformly from [0, bound) with a multiply and shift instead of a division
+     * @param bound Exclusive upper bound, must be positive and below 2^32
+     * @return sampled value
+     */
+    constexpr auto next_below(uint64_t bound) noexcept -> uint64_t {
+        return (((*this)() >> 32U) * bound) >> 32U;
+    }
+
+private:
+    static constexpr auto Rotl(uint64_t x, unsigned int k) noexcept -> uint64_t {
+        return (x << k) | (x >> (64U - k));
+    }
+
+    std::array<uint64_t, 4> state{};
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_RNG_H_
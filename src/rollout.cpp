@@ -0,0 +1,115 @@
+#include "rollout.h"
+
+#include <array>
+#include <mutex>
+
+#include "parallel.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kGrainSize = 64;
+constexpr std::size_t kNumMasks = 1 << kNumActions;
+
+// Number of actions set in each productive action mask
+constexpr auto MakeMaskCounts() noexcept -> std::array<uint8_t, kNumMasks> {
+    std::array<uint8_t, kNumMasks> counts{};
+    for (std::size_t mask = 0; mask < kNumMasks; ++mask) {
+        for (std::size_t a = 0; a < kNumActions; ++a) {
+            counts[mask] += static_cast<uint8_t>((mask >> a) & 1);
+        }
+    }
+    return counts;
+}
+
+// The k-th action set in each productive action mask, at mask * kNumActions + k
+constexpr auto MakeMaskActions() noexcept -> std::array<uint8_t, kNumMasks * kNumActions> {
+    std::array<uint8_t, kNumMasks * kNumActions> actions{};
+    for (std::size_t mask = 0; mask < kNumMasks; ++mask) {
+        std::size_t k = 0;
+        for (std::size_t a = 0; a < kNumActions; ++a) {
+            if ((mask >> a) & 1) {
+                actions[mask * kNumActions + k++] = static_cast<uint8_t>(a);
+            }
+        }
+    }
+    return actions;
+}
+
+constexpr std::array<uint8_t, kNumMasks> kMaskCounts = MakeMaskCounts();
+constexpr std::array<uint8_t, kNumMasks * kNumActions> kMaskActions = MakeMaskActions();
+}    // namespace
+
+void RolloutStats::add(const RolloutResult& result) noexcept {
+    ++num_rollouts;
+    total_depth += result.depth;
+    total_reward_signals += result.num_reward_signals;
+    num_rewarded += static_cast<std::size_t>(result.num_reward_signals > 0);
+    if (result.solved) {
+        ++num_solved;
+        total_solved_depth += result.depth;
+    }
+}
+
+void RolloutStats::merge(const RolloutStats& other) noexcept {
+    num_rollouts += other.num_rollouts;
+    num_solved += other.num_solved;
+    total_depth += other.total_depth;
+    total_solved_depth += other.total_solved_depth;
+    total_reward_signals += other.total_reward_signals;
+    num_rewarded += other.num_rewarded;
+}
+
+auto RolloutStats::solve_rate() const noexcept -> double {
+    return num_rollouts > 0 ? static_cast<double>(num_solved) / static_cast<double>(num_rollouts) : 0;
+}
+
+auto RolloutStats::mean_solved_depth() const noexcept -> double {
+    return num_solved > 0 ? static_cast<double>(total_solved_depth) / static_cast<double>(num_solved) : 0;
+}
+
+auto RolloutStats::mean_reward_signals() const noexcept -> double {
+    return num_rollouts > 0 ? static_cast<double>(total_reward_signals) / static_cast<double>(num_rollouts) : 0;
+}
+
+auto rollout(BoxWorldGameState& state, std::size_t max_depth, Xoshiro256& rng) noexcept -> RolloutResult {
+    RolloutResult result;
+    while (!state.is_solution() && result.depth < max_depth) {
+        const auto mask = state.productive_actions_mask();
+        if (mask == 0) {
+            break;
+        }
+        const auto k = rng.next_below(kMaskCounts[mask]);
+        state.apply_action(static_cast<Action>(kMaskActions[mask * kNumActions + k]));
+        ++result.depth;
+        if (state.get_reward_signal() != 0) {
+            if (result.num_reward_signals++ == 0) {
+                result.first_reward_depth = result.depth;
+            }
+        }
+    }
+    result.solved = state.is_solution();
+    return result;
+}
+
+auto rollouts(const BoxWorldGameState& state, std::size_t num_rollouts, std::size_t max_depth, uint64_t seed,
+              std::size_t num_threads) -> RolloutStats {
+    const auto snapshot = state.snapshot();
+    RolloutStats stats;
+    std::mutex stats_mutex;
+    parallel_for_dynamic(num_rollouts, num_threads, kGrainSize, [&](std::size_t begin, std::size_t end) {
+        // Generators are seeded by chunk rather than by thread so the playouts do not depend on the scheduling
+        Xoshiro256 rng(SplitMix64(seed)() ^ SplitMix64(begin)());
+        auto scratch = state;
+        RolloutStats chunk_stats;
+        for (std::size_t i = begin; i < end; ++i) {
+            scratch.restore(snapshot);
+            chunk_stats.add(rollout(scratch, max_depth, rng));
+        }
+        const std::lock_guard<std::mutex> lock(stats_mutex);
+        stats.merge(chunk_stats);
+    });
+    return stats;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,91 @@
+#ifndef BOXWORLD_ROLLOUT_H_
+#define BOXWORLD_ROLLOUT_H_
+
+#include <cstdint>
+
+#include "boxworld_base.h"
+#include "rng.h"
+
+namespace boxworld {
+
+// Outcome of a single random playout
+struct RolloutResult {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    bool solved = false;                 // Flag if the playout reached the solution
+    std::size_t depth = 0;               // Number of actions applied
+    std::size_t num_reward_signals = 0;  // Number of actions which collected a key or opened a lock
+    std::size_t first_reward_depth = 0;  // Actions applied up to the first reward signal, 0 if none was given
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Statistics accumulated over a batch of random playouts
+struct RolloutStats {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::size_t num_rollouts = 0;          // Number of playouts
+    std::size_t num_solved = 0;            // Number of playouts which reached the solution
+    std::size_t total_depth = 0;           // Sum of the actions applied over all playouts
+    std::size_t total_solved_depth = 0;    // Sum of the actions applied over the solved playouts
+    std::size_t total_reward_signals = 0;  // Sum of the reward signals over all playouts
+    std::size_t num_rewarded = 0;          // Number of playouts given at least one reward signal
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    /**
+     * Add the outcome of a playout
+     * @param result The playout outcome
+     */
+    void add(const RolloutResult &result) noexcept;
+
+    /**
+     * Add the statistics of another batch
+     * @param other The batch statistics
+     */
+    void merge(const RolloutStats &other) noexcept;
+
+    /**
+     * Get the fraction of playouts which reached the solution
+     * @return Solve rate in [0, 1], 0 if there are no playouts
+     */
+    [[nodiscard]] auto solve_rate() const noexcept -> double;
+
+    /**
+     * Get the mean number of actions of the solved playouts
+     * @return Mean solution length, 0 if no playout was solved
+     */
+    [[nodiscard]] auto mean_solved_depth() const noexcept -> double;
+
+    /**
+     * Get the mean number of reward signals per playout
+     * @return Mean reward signal count, 0 if there are no playouts
+     */
+    [[nodiscard]] auto mean_reward_signals() const noexcept -> double;
+};
+
+/**
+ * Play uniformly random productive actions in place until the solution, the depth limit, or no action changes the
+ * state.
+ * @note The state is left where the playout ended, restore it from a snapshot() to play again without allocating
+ * @param state The state to play from, which is modified
+ * @param max_depth Maximum number of actions to apply
+ * @param rng Generator to sample actions from
+ * @return The outcome of the playout
+ */
+auto rollout(BoxWorldGameState &state, std::size_t max_depth, Xoshiro256 &rng) noexcept -> RolloutResult;
+
+/**
+ * Run a batch of random playouts from the state, see rollout().
+ * Each chunk of playouts restores a scratch state from a snapshot and samples from its own generator, so the
+ * statistics are identical for any number of threads.
+ * @note Throws std::invalid_argument if the board does not fit in a StateSnapshot
+ * @param state The state to play from
+ * @param num_rollouts Number of playouts
+ * @param max_depth Maximum number of actions to apply in each playout
+ * @param seed Seed for the generators of the playouts
+ * @param num_threads Number of threads to use, 0 to use the hardware concurrency
+ * @return The statistics over all playouts
+ */
+[[nodiscard]] auto rollouts(const BoxWorldGameState &state, std::size_t num_rollouts, std::size_t max_depth,
+                            uint64_t seed = 0, std::size_t num_threads = 1) -> RolloutStats;
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_ROLLOUT_H_
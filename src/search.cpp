@@ -0,0 +1,380 @@
+#include "search.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "parallel.h"
+#include "successors.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kNoParent = std::numeric_limits<std::size_t>::max();
+constexpr std::size_t kNumShards = 64;
+constexpr std::size_t kGrainSize = 64;
+
+// Set of state hashes split into independently locked shards
+class ConcurrentHashSet {
+public:
+    auto insert(uint64_t hash) -> bool {
+        // High bits pick the shard, as the low bits pick the bucket within the shard
+        auto& shard = shards[(hash >> 32) % kNumShards];
+        const std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.hashes.insert(hash).second;
+    }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<uint64_t> hashes;
+    };
+    std::array<Shard, kNumShards> shards;
+};
+
+// Parent of a searched state and the action which generated it
+struct Record {
+    std::size_t parent;
+    Action action;
+};
+
+auto build_path(const std::vector<Record>& records, std::size_t index) -> std::vector<Action> {
+    std::vector<Action> actions;
+    for (; records[index].parent != kNoParent; index = records[index].parent) {
+        actions.push_back(records[index].action);
+    }
+    std::reverse(actions.begin(), actions.end());
+    return actions;
+}
+
+// Add the actions to the next collect or open, at least the distance to the nearest single key or lock which opens
+// with the held key, to the remaining chain length, which already counts one action for that event
+template <typename DistanceFn>
+auto add_event_distance(const BoxWorldGameState& state, DistanceFn distance_to) -> std::size_t {
+    const auto chain_length = state.get_remaining_chain_length();
+    if (chain_length == 0 || chain_length == kDeadEnd) {
+        return chain_length;
+    }
+    std::size_t distance = kDeadEnd;
+    for (const auto& idx : state.get_key_indices()) {
+        distance = std::min(distance, distance_to(idx));
+    }
+    if (state.has_key()) {
+        for (const auto& idx : state.get_lock_indices()) {
+            if (state.get_item(idx) == state.get_inventory()) {
+                distance = std::min(distance, distance_to(idx));
+            }
+        }
+    }
+    // No event is reachable, so the board can never change
+    return distance == kDeadEnd ? kDeadEnd : chain_length - 1 + distance;
+}
+
+auto resolve_num_threads(std::size_t num_threads) -> std::size_t {
+    return num_threads == 0 ? std::max<std::size_t>(std::thread::hardware_concurrency(), 1) : num_threads;
+}
+}    // namespace
+
+auto zero_heuristic([[maybe_unused]] const BoxWorldGameState& state) -> std::size_t {
+    return 0;
+}
+
+auto key_chain_heuristic(const BoxWorldGameState& state) -> std::size_t {
+    return state.get_remaining_chain_length();
+}
+
+auto key_chain_distance_heuristic(const BoxWorldGameState& state) -> std::size_t {
+    const auto cols = state.observation_shape()[1];    // Shape is {channels, cols, rows}
+    const auto agent_index = state.get_agent_index();
+    return add_event_distance(state, [&](std::size_t target_index) -> std::size_t {
+        const auto row_distance = std::max(agent_index / cols, target_index / cols) -
+                                  std::min(agent_index / cols, target_index / cols);
+        const auto col_distance = std::max(agent_index % cols, target_index % cols) -
+                                  std::min(agent_index % cols, target_index % cols);
+        return row_distance + col_distance;
+    });
+}
+
+auto key_chain_path_heuristic(const BoxWorldGameState& state) -> std::size_t {
+    const auto agent_index = state.get_agent_index();
+    return add_event_distance(state, [&](std::size_t target_index) -> std::size_t {
+        const auto distance = state.get_distance_map(target_index)[agent_index];
+        return distance == BoxWorldGameState::kUnreachable ? kDeadEnd : distance;
+    });
+}
+
+ParallelSearch::ParallelSearch(std::size_t num_threads, std::size_t max_expansions)
+    : num_threads(resolve_num_threads(num_threads)), max_expansions(max_expansions) {}
+
+auto ParallelSearch::bfs(const BoxWorldGameState& state) const -> SolverResult {
+    SolverResult result;
+    if (state.is_solution()) {
+        result.solved = true;
+        return result;
+    }
+
+    struct FrontierNode {
+        BoxWorldGameState state;
+        std::size_t record;
+    };
+    struct Child {
+        BoxWorldGameState state;
+        Record record;
+    };
+    std::vector<Record> records{{kNoParent, Action::kUp}};
+    ConcurrentHashSet closed;
+    closed.insert(state.get_hash());
+    std::vector<FrontierNode> frontier{{state, 0}};
+    std::vector<std::vector<Child>> buffers;
+
+    while (!frontier.empty()) {
+        if (max_expansions > 0 && result.expanded >= max_expansions) {
+            break;
+        }
+        // Each chunk writes its children into its own buffer, merged in order after the depth is expanded
+        buffers.clear();
+        buffers.resize((frontier.size() + kGrainSize - 1) / kGrainSize);
+        parallel_for_dynamic(frontier.size(), num_threads, kGrainSize, [&](std::size_t begin, std::size_t end) {
+            auto& buffer = buffers[begin / kGrainSize];
+            std::array<uint64_t, kNumActions> hashes{};
+            uint8_t valid_mask = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto& node = frontier[i];
+                // Only children not seen before are copied
+                node.state.successor_hashes(hashes, valid_mask);
+                for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+                    const auto a = static_cast<std::size_t>(action);
+                    const auto is_new = (valid_mask & (1U << a)) != 0 &&
+                                        closed.insert(hashes[a]);    // NOLINT(*-bounds-constant-array-index)
+                    if (!is_new) {
+                        continue;
+                    }
+                    auto child = node.state;
+                    child.apply_action(action);
+                    if (reached_dead_end(child)) {
+                        continue;
+                    }
+                    buffer.push_back({std::move(child), {node.record, action}});
+                }
+            }
+        });
+        result.expanded += frontier.size();
+
+        std::vector<FrontierNode> next_frontier;
+        for (auto& buffer : buffers) {
+            for (auto& child : buffer) {
+                records.push_back(child.record);
+                if (child.state.is_solution()) {
+                    result.solved = true;
+                    result.actions = build_path(records, records.size() - 1);
+                    result.cost = result.actions.size();
+                    return result;
+                }
+                next_frontier.push_back({std::move(child.state), records.size() - 1});
+            }
+        }
+        frontier = std::move(next_frontier);
+    }
+    return result;
+}
+
+auto ParallelSearch::astar(const BoxWorldGameState& state, const Heuristic& heuristic) const -> SolverResult {
+    // Reference to a record owned by a worker
+    struct NodeRef {
+        std::size_t worker;
+        std::size_t index;
+    };
+    struct AStarRecord {
+        NodeRef parent;
+        Action action;
+    };
+    struct Message {
+        BoxWorldGameState state;
+        std::size_t g;
+        std::size_t h;
+        NodeRef parent;
+        Action action;
+    };
+    struct OpenNode {
+        std::size_t f;
+        std::size_t g;
+        std::size_t record;
+        BoxWorldGameState state;
+    };
+    // Min heap on f, breaking ties towards deeper nodes
+    const auto open_compare = [](const OpenNode& lhs, const OpenNode& rhs) {
+        return lhs.f > rhs.f || (lhs.f == rhs.f && lhs.g < rhs.g);
+    };
+    struct Worker {
+        std::mutex inbox_mutex;
+        std::vector<Message> inbox;
+        std::vector<OpenNode> open;
+        std::unordered_map<uint64_t, std::size_t> best_g;
+        std::vector<AStarRecord> records;
+    };
+
+    SolverResult result;
+    const auto root_h = heuristic(state);
+    if (root_h == kDeadEnd) {
+        return result;
+    }
+    const auto n = num_threads;
+    const auto owner = [n](uint64_t hash) -> std::size_t { return (hash >> 32) % n; };
+    std::vector<Worker> workers(n);
+
+    // Add the state to the open list of its owner if it improves on the best known cost
+    const auto accept = [&](Worker& worker, Message& message) {
+        const auto hash = message.state.get_hash();
+        const auto [it, inserted] = worker.best_g.try_emplace(hash, message.g);
+        if (!inserted) {
+            if (it->second <= message.g) {
+                return;
+            }
+            it->second = message.g;
+        }
+        worker.records.push_back({message.parent, message.action});
+        worker.open.push_back({message.g + message.h, message.g, worker.records.size() - 1, std::move(message.state)});
+        std::push_heap(worker.open.begin(), worker.open.end(), open_compare);
+    };
+    {
+        Message root{state, 0, root_h, {kNoParent, kNoParent}, Action::kUp};
+        accept(workers[owner(state.get_hash())], root);
+    }
+
+    std::atomic<std::size_t> best_cost{kDeadEnd};
+    std::mutex solution_mutex;
+    NodeRef solution{kNoParent, kNoParent};
+    std::atomic<std::size_t> in_flight{0};
+    std::atomic<std::size_t> num_idle{0};
+    std::atomic<std::size_t> expanded{0};
+    std::atomic<bool> done{false};
+    std::atomic<bool> limit_reached{false};
+
+    const auto run_worker = [&](std::size_t t) {
+        auto& worker = workers[t];
+        bool idle = false;
+        std::vector<Message> messages;
+        std::array<uint64_t, kNumActions> hashes{};
+        uint8_t valid_mask = 0;
+        while (!done.load()) {
+            // Receive the states owned by this worker, marking as busy before the messages count as delivered
+            messages.clear();
+            {
+                const std::lock_guard<std::mutex> lock(worker.inbox_mutex);
+                std::swap(messages, worker.inbox);
+            }
+            if (!messages.empty()) {
+                if (idle) {
+                    idle = false;
+                    --num_idle;
+                }
+                for (auto& message : messages) {
+                    accept(worker, message);
+                }
+                in_flight -= messages.size();
+            }
+
+            if (!worker.open.empty() && worker.open.front().f < best_cost.load()) {
+                if (idle) {
+                    idle = false;
+                    --num_idle;
+                }
+                std::pop_heap(worker.open.begin(), worker.open.end(), open_compare);
+                OpenNode node = std::move(worker.open.back());
+                worker.open.pop_back();
+                if (worker.best_g.at(node.state.get_hash()) < node.g) {
+                    continue;
+                }
+                if (node.state.is_solution()) {
+                    const std::lock_guard<std::mutex> lock(solution_mutex);
+                    if (node.g < best_cost.load()) {
+                        best_cost = node.g;
+                        solution = {t, node.record};
+                    }
+                    continue;
+                }
+                if (expanded.fetch_add(1) >= max_expansions && max_expansions > 0) {
+                    limit_reached = true;
+                    done = true;
+                    break;
+                }
+                node.state.successor_hashes(hashes, valid_mask);
+                for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+                    const auto a = static_cast<std::size_t>(action);
+                    if ((valid_mask & (1U << a)) == 0) {
+                        continue;
+                    }
+                    // Children owned by this worker are only copied if they improve on the best known cost
+                    const auto child_hash = hashes[a];    // NOLINT(*-bounds-constant-array-index)
+                    const auto child_owner = owner(child_hash);
+                    if (child_owner == t) {
+                        const auto it = worker.best_g.find(child_hash);
+                        if (it != worker.best_g.end() && it->second <= node.g + 1) {
+                            continue;
+                        }
+                    }
+                    auto child = node.state;
+                    child.apply_action(action);
+                    const auto h = heuristic(child);
+                    if (h == kDeadEnd) {
+                        continue;
+                    }
+                    Message message{std::move(child), node.g + 1, h, {t, node.record}, action};
+                    if (child_owner == t) {
+                        accept(worker, message);
+                    } else {
+                        ++in_flight;
+                        const std::lock_guard<std::mutex> lock(workers[child_owner].inbox_mutex);
+                        workers[child_owner].inbox.push_back(std::move(message));
+                    }
+                }
+                continue;
+            }
+
+            // Nothing left below the best solution, done once every worker is idle with no states in flight
+            if (!idle) {
+                idle = true;
+                ++num_idle;
+            }
+            if (num_idle.load() == n && in_flight.load() == 0) {
+                done = true;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n - 1);
+    for (std::size_t t = 1; t < n; ++t) {
+        threads.emplace_back(run_worker, t);
+    }
+    run_worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    result.expanded = max_expansions > 0 ? std::min(expanded.load(), max_expansions) : expanded.load();
+    // The best solution found is only known to be optimal if the search was not cut short
+    if (solution.worker != kNoParent && !limit_reached.load()) {
+        result.solved = true;
+        result.cost = best_cost.load();
+        for (auto ref = solution; ref.worker != kNoParent;) {
+            const auto& record = workers[ref.worker].records[ref.index];
+            if (record.parent.worker != kNoParent) {
+                result.actions.push_back(record.action);
+            }
+            ref = record.parent;
+        }
+        std::reverse(result.actions.begin(), result.actions.end());
+    }
+    return result;
+}
+
+}    // namespace boxworld
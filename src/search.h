@@ -0,0 +1,84 @@
+#ifndef BOXWORLD_SEARCH_H_
+#define BOXWORLD_SEARCH_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "boxworld_base.h"
+#include "solver.h"
+
+namespace boxworld {
+
+// Heuristic estimate of the number of actions to the solution, kDeadEnd if the state cannot be solved
+using Heuristic = std::function<std::size_t(const BoxWorldGameState &)>;
+
+/**
+ * Heuristic which always returns 0, turning A* into uniform cost search.
+ * @param state The state to evaluate
+ * @return 0
+ */
+[[nodiscard]] auto zero_heuristic(const BoxWorldGameState &state) -> std::size_t;
+
+/**
+ * Admissible heuristic of the fewest keys to collect and locks to open before holding kColourGoal,
+ * following the remaining chain of boxes from the held key and single keys.
+ * @param state The state to evaluate
+ * @return Remaining chain length, or kDeadEnd if no chain reaches the goal
+ */
+[[nodiscard]] auto key_chain_heuristic(const BoxWorldGameState &state) -> std::size_t;
+
+/**
+ * Admissible heuristic of the remaining chain length plus the Manhattan distance from the agent to the nearest single
+ * key or lock opened by the held key, less the one action of the first collect or open counted by the chain.
+ * @param state The state to evaluate
+ * @return Lower bound on the actions to the solution, or kDeadEnd if no chain reaches the goal
+ */
+[[nodiscard]] auto key_chain_distance_heuristic(const BoxWorldGameState &state) -> std::size_t;
+
+/**
+ * Admissible heuristic as key_chain_distance_heuristic, using the walking distance of the cached distance maps in
+ * place of the Manhattan distance, see BoxWorldGameState::get_distance_map().
+ * @note Copies of a state do not share distance maps, so each searched state runs a BFS per key and lock it can use
+ * @param state The state to evaluate
+ * @return Lower bound on the actions to the solution, or kDeadEnd if no chain reaches the goal or the agent cannot
+ * walk to a key or lock it can use
+ */
+[[nodiscard]] auto key_chain_path_heuristic(const BoxWorldGameState &state) -> std::size_t;
+
+// Multithreaded optimal search over full game states, using the state hash to detect duplicates.
+class ParallelSearch {
+public:
+    /**
+     * @param num_threads Number of threads to search with, 0 to use the hardware concurrency
+     * @param max_expansions Number of states to expand before giving up, 0 for no limit
+     */
+    explicit ParallelSearch(std::size_t num_threads = 0, std::size_t max_expansions = 0);
+
+    /**
+     * Breadth first search, expanding each depth of the frontier in parallel against a shared closed set.
+     * Threads take chunks of the frontier as they finish their previous chunk, so uneven chunks balance out.
+     * Children which are dead ends are pruned, see BoxWorldGameState::is_dead_end().
+     * @param state The state to search from
+     * @return The optimal solution, with solved set to false if none is found within the expansion limit
+     */
+    [[nodiscard]] auto bfs(const BoxWorldGameState &state) const -> SolverResult;
+
+    /**
+     * Hash distributed A*, where each thread owns the states whose hash maps to it, with its own open and closed
+     * lists, and generated states are sent to their owner.
+     * @param state The state to search from
+     * @param heuristic Admissible heuristic, such as key_chain_heuristic
+     * @return The optimal solution for an admissible heuristic, with solved set to false if none is found within
+     * the expansion limit
+     */
+    [[nodiscard]] auto astar(const BoxWorldGameState &state, const Heuristic &heuristic = key_chain_heuristic) const
+        -> SolverResult;
+
+private:
+    std::size_t num_threads;
+    std::size_t max_expansions;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_SEARCH_H_
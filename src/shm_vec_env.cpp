@@ -0,0 +1,275 @@
+#include "shm_vec_env.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace boxworld {
+
+namespace {
+constexpr uint32_t kCommandStep = 0;
+constexpr uint32_t kCommandReset = 1;
+constexpr uint32_t kCommandStop = 2;
+
+constexpr std::size_t kAlignment = 64;
+constexpr int kNumSpins = 64;
+constexpr int kNumYields = 1024;
+constexpr auto kSleep = std::chrono::microseconds(50);
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Atomics shared between processes must be lock free");
+
+auto align_up(std::size_t bytes) noexcept -> std::size_t {
+    return (bytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Wait for the condition by spinning, then yielding, then sleeping and calling on_sleep, which can give up by throwing
+template <typename Condition, typename OnSleep>
+void wait_until(Condition&& condition, OnSleep&& on_sleep) {
+    for (int i = 0; !condition(); ++i) {
+        if (i < kNumSpins) {
+            continue;
+        }
+        if (i < kNumSpins + kNumYields) {
+            std::this_thread::yield();
+        } else {
+            on_sleep();
+            std::this_thread::sleep_for(kSleep);
+        }
+    }
+}
+}    // namespace
+
+ShmVecEnv::ShmVecEnv(const GameParameters& params, std::size_t num_envs, std::size_t num_workers, bool use_colour,
+                     bool terminate_dead_ends) {
+    if (num_envs == 0) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    Start(std::vector<GameParameters>(num_envs, params), num_workers, use_colour, terminate_dead_ends);
+}
+
+ShmVecEnv::ShmVecEnv(const std::vector<GameParameters>& params_list, std::size_t num_workers, bool use_colour,
+                     bool terminate_dead_ends) {
+    Start(params_list, num_workers, use_colour, terminate_dead_ends);
+}
+
+ShmVecEnv::~ShmVecEnv() {
+    Shutdown();
+}
+
+void ShmVecEnv::Start(const std::vector<GameParameters>& params_list, std::size_t num_workers, bool use_colour,
+                      bool terminate_dead_ends) {
+    if (params_list.empty()) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    if (num_workers == 0 || num_workers > params_list.size()) {
+        throw std::invalid_argument("Number of workers must be positive and at most the number of environments.");
+    }
+
+    // Environments are built before forking, so construction errors are thrown here rather than in a worker
+    env_count = params_list.size();
+    std::vector<BoxWorldVecEnv> vec_envs;
+    vec_envs.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        const auto begin = i * env_count / num_workers;
+        const auto end = (i + 1) * env_count / num_workers;
+        vec_envs.emplace_back(std::vector<GameParameters>(params_list.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                          params_list.begin() + static_cast<std::ptrdiff_t>(end)));
+        vec_envs.back().set_terminate_dead_ends(terminate_dead_ends);
+        if (vec_envs.back().observation_shape() != vec_envs.front().observation_shape()) {
+            throw std::invalid_argument("All environments must have the same board dimensions.");
+        }
+        workers.push_back({0, begin, end});
+    }
+    obs_shape = vec_envs.front().observation_shape();
+    obs_size = vec_envs.front().observation_size();
+
+    // Control block, then a completion per worker, then the slots of actions, observations, rewards and dones
+    slots_offset = align_up(sizeof(Control)) + num_workers * sizeof(Completion);
+    obs_offset = align_up(env_count * sizeof(Action));
+    reward_offset = obs_offset + align_up(env_count * obs_size * sizeof(float));
+    done_offset = reward_offset + align_up(env_count * sizeof(uint64_t));
+    slot_bytes = done_offset + align_up(env_count * sizeof(uint8_t));
+    mapping_bytes = slots_offset + kNumSlots * slot_bytes;
+    mapping = mmap(nullptr, mapping_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error("Cannot map shared memory for the environments.");
+    }
+    auto* bytes = static_cast<std::byte*>(mapping);
+    control = new (bytes) Control();
+    completions = reinterpret_cast<Completion*>(bytes + align_up(sizeof(Control)));
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        new (completions + i) Completion();
+    }
+
+    const auto parent = getpid();
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        const auto pid = fork();
+        if (pid == 0) {
+            WorkLoop(vec_envs[i], i, use_colour, parent);
+        }
+        if (pid < 0) {
+            Shutdown();
+            throw std::runtime_error("Cannot start a worker process.");
+        }
+        workers[i].pid = pid;
+    }
+}
+
+auto ShmVecEnv::reset() -> StepResult {
+    Wait();
+    is_pending = false;
+    Request(kCommandReset);
+    Wait();
+    return GetResult(num_steps % kNumSlots);
+}
+
+void ShmVecEnv::step_async(const Action* actions) {
+    if (is_pending) {
+        throw std::invalid_argument("step_wait() must be called before the next step_async().");
+    }
+    std::copy_n(actions, env_count, reinterpret_cast<Action*>(SlotData((num_steps + 1) % kNumSlots)));
+    Request(kCommandStep);
+    is_pending = true;
+}
+
+auto ShmVecEnv::step_wait() -> StepResult {
+    if (!is_pending) {
+        throw std::invalid_argument("step_async() must be called before step_wait().");
+    }
+    Wait();
+    is_pending = false;
+    return GetResult(num_steps % kNumSlots);
+}
+
+auto ShmVecEnv::num_envs() const noexcept -> std::size_t {
+    return env_count;
+}
+
+auto ShmVecEnv::num_workers() const noexcept -> std::size_t {
+    return workers.size();
+}
+
+auto ShmVecEnv::observation_shape() const noexcept -> std::array<std::size_t, 3> {
+    return obs_shape;
+}
+
+auto ShmVecEnv::observation_size() const noexcept -> std::size_t {
+    return obs_size;
+}
+
+auto ShmVecEnv::worker_pids() const -> std::vector<pid_t> {
+    std::vector<pid_t> pids;
+    pids.reserve(workers.size());
+    for (const auto& worker : workers) {
+        pids.push_back(worker.pid);
+    }
+    return pids;
+}
+
+void ShmVecEnv::Request(uint32_t command) {
+    CheckWorkers();
+    ++num_steps;
+    control->command.store(command, std::memory_order_relaxed);
+    control->requested.store(num_steps, std::memory_order_release);
+}
+
+void ShmVecEnv::Wait() {
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        const auto& completed = completions[i].completed;
+        wait_until([&]() { return completed.load(std::memory_order_acquire) == num_steps; },
+                   [&]() {
+                       // Reap workers which exited, so a crashed worker is reported instead of waited on forever
+                       int status = 0;
+                       if (workers[i].pid != 0 && waitpid(workers[i].pid, &status, WNOHANG) == workers[i].pid) {
+                           workers[i].pid = 0;
+                       }
+                       CheckWorkers();
+                   });
+    }
+}
+
+void ShmVecEnv::CheckWorkers() const {
+    for (const auto& worker : workers) {
+        if (worker.pid == 0) {
+            throw std::runtime_error("A worker process of the environments has exited.");
+        }
+    }
+}
+
+void ShmVecEnv::Shutdown() noexcept {
+    if (control != nullptr) {
+        control->command.store(kCommandStop, std::memory_order_relaxed);
+        control->requested.store(num_steps + 1, std::memory_order_release);
+        for (auto& worker : workers) {
+            if (worker.pid != 0) {
+                int status = 0;
+                waitpid(worker.pid, &status, 0);
+                worker.pid = 0;
+            }
+        }
+    }
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_bytes);
+    }
+    mapping = nullptr;
+    control = nullptr;
+    completions = nullptr;
+}
+
+void ShmVecEnv::WorkLoop(BoxWorldVecEnv& vec_env, std::size_t worker_index, bool use_colour, pid_t parent) noexcept {
+    const auto& worker = workers[worker_index];
+    uint64_t step = 0;
+    try {
+        while (true) {
+            // Exit if the parent died without shutting down, by checking while sleeping between steps
+            wait_until([&]() { return control->requested.load(std::memory_order_acquire) != step; },
+                       [&]() {
+                           if (getppid() != parent) {
+                               _exit(1);
+                           }
+                       });
+            step = control->requested.load(std::memory_order_acquire);
+            const auto command = control->command.load(std::memory_order_relaxed);
+            if (command == kCommandStop) {
+                _exit(0);
+            }
+            auto* slot = SlotData(step % kNumSlots);
+            auto* obs = reinterpret_cast<float*>(slot + obs_offset) + worker.begin * obs_size;
+            auto* reward_signals = reinterpret_cast<uint64_t*>(slot + reward_offset) + worker.begin;
+            auto* dones = reinterpret_cast<uint8_t*>(slot + done_offset) + worker.begin;
+            if (command == kCommandReset) {
+                vec_env.reset(obs);
+                std::fill_n(reward_signals, worker.end - worker.begin, 0);
+                std::fill_n(dones, worker.end - worker.begin, 0);
+            } else {
+                const auto* actions = reinterpret_cast<const Action*>(slot) + worker.begin;
+                vec_env.step(actions, obs, reward_signals, dones, use_colour);
+            }
+            completions[worker_index].completed.store(step, std::memory_order_release);
+        }
+    } catch (const std::exception&) {
+        // The parent sees the exit instead of the completion
+        _exit(1);
+    }
+}
+
+auto ShmVecEnv::GetResult(std::size_t slot) const noexcept -> StepResult {
+    const auto* data = SlotData(slot);
+    return {reinterpret_cast<const float*>(data + obs_offset), reinterpret_cast<const uint64_t*>(data + reward_offset),
+            reinterpret_cast<const uint8_t*>(data + done_offset)};
+}
+
+auto ShmVecEnv::SlotData(std::size_t slot) const noexcept -> std::byte* {
+    return static_cast<std::byte*>(mapping) + slots_offset + slot * slot_bytes;
+}
+
+}    // namespace boxworld
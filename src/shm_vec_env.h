@@ -0,0 +1,168 @@
+#ifndef BOXWORLD_SHM_VEC_ENV_H_
+#define BOXWORLD_SHM_VEC_ENV_H_
+
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "definitions.h"
+#include "vec_env.h"
+
+namespace boxworld {
+
+// Batch of environments stepped by worker processes, for fault isolation from the learner process.
+// Each worker steps a contiguous slice of the environments and writes observations, reward signals and dones into
+// fixed-layout slots of a shared memory mapping, which the caller reads in place, so nothing is serialized or
+// copied through pipes. Slots alternate each step as in AsyncVecEnv, and the handoff uses atomics in the mapping.
+// @note Workers are forked in the constructor, so construct before starting other threads. POSIX only
+class ShmVecEnv {
+public:
+    // Number of result slots in the ring, so the results of a step stay valid while the next is written
+    static constexpr std::size_t kNumSlots = 2;
+
+    // View of the results of a step in shared memory, valid until the kNumSlots-th step_async() after it
+    struct StepResult {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        const float *obs;                 // num_envs() * observation_size() observations
+        const uint64_t *reward_signals;   // num_envs() reward signals
+        const uint8_t *dones;             // num_envs() done values, see BoxWorldVecEnv::step()
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    ShmVecEnv() = delete;
+
+    /**
+     * Construct num_envs copies of the environment given by the GameParameters.
+     * @note Throws std::invalid_argument if num_envs or num_workers is 0, std::runtime_error if the shared memory
+     * cannot be mapped or a worker cannot be started
+     * @param params The game parameters shared by each environment
+     * @param num_envs Number of environments in the batch
+     * @param num_workers Number of worker processes, at most num_envs
+     * @param use_colour Flag if using colour collected reward signal, or index of key/lock collected if false
+     * @param terminate_dead_ends Flag to end dead end episodes, see BoxWorldVecEnv::set_terminate_dead_ends()
+     */
+    ShmVecEnv(const GameParameters &params, std::size_t num_envs, std::size_t num_workers, bool use_colour = false,
+              bool terminate_dead_ends = false);
+
+    /**
+     * Construct one environment for each of the given GameParameters.
+     * @note Throws as the constructor from a single GameParameters
+     * @param params_list The game parameters for each environment, all of the same board dimensions
+     * @param num_workers Number of worker processes, at most the number of environments
+     * @param use_colour Flag if using colour collected reward signal, or index of key/lock collected if false
+     * @param terminate_dead_ends Flag to end dead end episodes, see BoxWorldVecEnv::set_terminate_dead_ends()
+     */
+    ShmVecEnv(const std::vector<GameParameters> &params_list, std::size_t num_workers, bool use_colour = false,
+              bool terminate_dead_ends = false);
+
+    ~ShmVecEnv();
+
+    ShmVecEnv(const ShmVecEnv &) = delete;
+    ShmVecEnv(ShmVecEnv &&) = delete;
+    auto operator=(const ShmVecEnv &) -> ShmVecEnv & = delete;
+    auto operator=(ShmVecEnv &&) -> ShmVecEnv & = delete;
+
+    /**
+     * Reset every environment, waiting for any step in progress first.
+     * @note Throws std::runtime_error if a worker process has exited
+     * @return The starting observations, with reward signals and dones of 0
+     */
+    auto reset() -> StepResult;
+
+    /**
+     * Start stepping each environment with the given actions, and return without waiting for the step to finish.
+     * @note Throws std::invalid_argument if the previous step has not been waited on
+     * @param actions Buffer of num_envs() actions, copied into shared memory before returning
+     */
+    void step_async(const Action *actions);
+
+    /**
+     * Wait for the step started by step_async() to finish.
+     * @note Throws std::invalid_argument if no step is in progress, std::runtime_error if a worker process has exited
+     * @return The results of the step
+     */
+    auto step_wait() -> StepResult;
+
+    /**
+     * Get the number of environments in the batch
+     * @return Count of environments
+     */
+    [[nodiscard]] auto num_envs() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of worker processes
+     * @return Count of workers
+     */
+    [[nodiscard]] auto num_workers() const noexcept -> std::size_t;
+
+    /**
+     * Get the shape a single environment observation should be viewed as.
+     * @return array indicating observation CHW
+     */
+    [[nodiscard]] auto observation_shape() const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Get the number of values in a single environment observation.
+     * @return Flat observation size for one environment
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the process ids of the workers, for monitoring them
+     * @return Process id of each worker, 0 for workers which have exited
+     */
+    [[nodiscard]] auto worker_pids() const -> std::vector<pid_t>;
+
+private:
+    struct Worker {
+        pid_t pid;
+        std::size_t begin;    // First environment of the slice
+        std::size_t end;      // One past the last environment of the slice
+    };
+
+    // Requests from the caller, in shared memory
+    struct Control {
+        std::atomic<uint64_t> requested{0};    // Requests made, the latest reading the slot requested % kNumSlots
+        std::atomic<uint32_t> command{0};      // Command of the latest request
+    };
+
+    // Progress of a worker, in shared memory on its own cache line
+    struct alignas(64) Completion {
+        std::atomic<uint64_t> completed{0};    // Requests finished by the worker
+    };
+
+    void Start(const std::vector<GameParameters> &params_list, std::size_t num_workers, bool use_colour,
+               bool terminate_dead_ends);
+    void Request(uint32_t command);
+    void Wait();
+    void CheckWorkers() const;
+    void Shutdown() noexcept;
+    [[noreturn]] void WorkLoop(BoxWorldVecEnv &vec_env, std::size_t worker_index, bool use_colour,
+                               pid_t parent) noexcept;
+    [[nodiscard]] auto GetResult(std::size_t slot) const noexcept -> StepResult;
+    [[nodiscard]] auto SlotData(std::size_t slot) const noexcept -> std::byte *;
+
+    std::size_t env_count = 0;
+    std::array<std::size_t, 3> obs_shape{};
+    std::size_t obs_size = 0;
+    std::vector<Worker> workers;
+    void *mapping = nullptr;    // Shared memory holding the control block, completions, and result slots
+    std::size_t mapping_bytes = 0;
+    Control *control = nullptr;
+    Completion *completions = nullptr;
+    std::size_t slots_offset = 0;    // Offsets in bytes of the slots in the mapping, and of the arrays in a slot
+    std::size_t slot_bytes = 0;
+    std::size_t obs_offset = 0;
+    std::size_t reward_offset = 0;
+    std::size_t done_offset = 0;
+    std::size_t num_steps = 0;    // Requests made by the caller, steps and resets
+    bool is_pending = false;      // Flag if the last step started has not been waited on
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_SHM_VEC_ENV_H_
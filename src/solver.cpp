@@ -0,0 +1,188 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace boxworld {
+
+namespace {
+constexpr std::size_t kNoParent = std::numeric_limits<std::size_t>::max();
+constexpr uint32_t kUnreached = std::numeric_limits<uint32_t>::max();
+
+// Single key or lock the agent can interact with
+struct Target {
+    std::size_t index;        // Cell of the target
+    std::size_t box_index;    // Cell holding the element added to the inventory
+    bool is_lock;             // Flag if the target needs the matching key
+};
+
+// Key/lock state of the search, with the agent standing on the last target interacted with
+struct Node {
+    uint64_t removed;           // Bitmask of targets already collected or opened
+    std::size_t agent_idx;      // Cell of the agent
+    Element inventory;          // Key held by the agent
+    std::size_t parent;         // Index of the parent node, or kNoParent for the root
+    std::vector<Action> path;   // Actions taken from the parent node
+};
+
+struct NodeKey {
+    uint64_t removed;
+    std::size_t agent_idx;
+    Element inventory;
+    auto operator==(const NodeKey& other) const noexcept -> bool {
+        return removed == other.removed && agent_idx == other.agent_idx && inventory == other.inventory;
+    }
+};
+
+struct NodeKeyHash {
+    auto operator()(const NodeKey& key) const noexcept -> std::size_t {
+        auto hash = std::hash<uint64_t>{}(key.removed);
+        hash ^= std::hash<std::size_t>{}((key.agent_idx << 8) | static_cast<std::size_t>(key.inventory)) +
+                0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
+
+constexpr auto opposite_action(std::size_t action) noexcept -> Action {
+    return static_cast<Action>((action + 2) % kNumActions);
+}
+}    // namespace
+
+BoxWorldSolver::BoxWorldSolver(std::size_t max_expansions) : max_expansions(max_expansions) {}
+
+auto BoxWorldSolver::solve(const BoxWorldGameState& state) const -> SolverResult {
+    const auto& board = state.local_state.board;
+    const auto& neighbours = state.shared_state->neighbours;
+    const auto num_cells = board.size();
+    const auto neighbour = [&](std::size_t index, std::size_t action) -> std::size_t {
+        return neighbours[index * kNumActions + action];
+    };
+
+    std::vector<Target> targets;
+    for (const auto& idx : state.local_state.key_indices) {
+        targets.push_back({idx, idx, false});
+    }
+    const auto& graph = state.shared_state->key_lock_graph;
+    for (const auto& idx : state.local_state.lock_indices) {
+        const auto* box = graph.box_at(idx);
+        assert(box != nullptr);
+        targets.push_back({idx, box->key_index, true});
+    }
+    if (targets.size() > kMaxTargets) {
+        throw std::invalid_argument("Solver supports at most 64 single keys and locks.");
+    }
+
+    std::vector<Node> nodes;
+    std::unordered_map<NodeKey, std::size_t, NodeKeyHash> best_costs;
+    using QueueItem = std::pair<std::size_t, std::size_t>;    // cost, node index
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<>> open_list;
+    nodes.push_back({0, state.local_state.agent_idx, state.local_state.inventory, kNoParent, {}});
+    best_costs[{0, state.local_state.agent_idx, state.local_state.inventory}] = 0;
+    open_list.emplace(0, 0);
+
+    SolverResult result;
+    std::vector<uint8_t> is_open(num_cells);
+    std::vector<uint32_t> distances(num_cells);
+    std::vector<uint8_t> arrive_actions(num_cells);
+    std::vector<std::size_t> queue;
+    queue.reserve(num_cells);
+    while (!open_list.empty()) {
+        const auto [cost, node_idx] = open_list.top();
+        open_list.pop();
+        // Copy as nodes may be reallocated during the expansion
+        const auto removed = nodes[node_idx].removed;
+        const auto agent_idx = nodes[node_idx].agent_idx;
+        const auto inventory = nodes[node_idx].inventory;
+        if (cost > best_costs.at({removed, agent_idx, inventory})) {
+            continue;
+        }
+        if (inventory == Element::kColourGoal) {
+            result.solved = true;
+            result.cost = cost;
+            for (auto idx = node_idx; idx != kNoParent; idx = nodes[idx].parent) {
+                result.actions.insert(result.actions.begin(), nodes[idx].path.begin(), nodes[idx].path.end());
+            }
+            return result;
+        }
+        if (max_expansions > 0 && result.expanded >= max_expansions) {
+            break;
+        }
+        ++result.expanded;
+
+        // Cells the agent can walk through without interacting with anything
+        for (std::size_t i = 0; i < num_cells; ++i) {
+            is_open[i] = static_cast<uint8_t>(board[i] == Element::kEmpty || board[i] == Element::kAgent);
+        }
+        for (std::size_t t = 0; t < targets.size(); ++t) {
+            if ((removed >> t) & 1) {
+                is_open[targets[t].index] = 1;
+                is_open[targets[t].box_index] = 1;
+            }
+        }
+
+        // Grid distances from the agent
+        std::fill(distances.begin(), distances.end(), kUnreached);
+        queue.clear();
+        queue.push_back(agent_idx);
+        distances[agent_idx] = 0;
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            const auto idx = queue[head];
+            for (std::size_t a = 0; a < kNumActions; ++a) {
+                const auto next = neighbour(idx, a);
+                if (next != kNoNeighbour && is_open[next] && distances[next] == kUnreached) {
+                    distances[next] = distances[idx] + 1;
+                    arrive_actions[next] = static_cast<uint8_t>(a);
+                    queue.push_back(next);
+                }
+            }
+        }
+
+        for (std::size_t t = 0; t < targets.size(); ++t) {
+            const auto& target = targets[t];
+            if (((removed >> t) & 1) || (target.is_lock && board[target.index] != inventory)) {
+                continue;
+            }
+            // Closest reachable cell next to the target to step in from
+            std::size_t best_from = kNoNeighbour;
+            std::size_t best_action = 0;
+            for (std::size_t a = 0; a < kNumActions; ++a) {
+                const auto from = neighbour(target.index, a);
+                if (from != kNoNeighbour && distances[from] != kUnreached &&
+                    (best_from == kNoNeighbour || distances[from] < distances[best_from])) {
+                    best_from = from;
+                    best_action = a;
+                }
+            }
+            if (best_from == kNoNeighbour) {
+                continue;
+            }
+
+            const NodeKey key{removed | (uint64_t{1} << t), target.index, board[target.box_index]};
+            const auto child_cost = cost + distances[best_from] + 1;
+            const auto it = best_costs.find(key);
+            if (it != best_costs.end() && it->second <= child_cost) {
+                continue;
+            }
+            best_costs[key] = child_cost;
+
+            std::vector<Action> path(distances[best_from] + 1);
+            path.back() = opposite_action(best_action);
+            // Walk back from the cell next to the target to the agent
+            auto path_idx = path.size() - 1;
+            for (auto idx = best_from; idx != agent_idx;) {
+                path[--path_idx] = static_cast<Action>(arrive_actions[idx]);
+                idx = neighbour(idx, static_cast<std::size_t>(opposite_action(arrive_actions[idx])));
+            }
+            nodes.push_back({key.removed, key.agent_idx, key.inventory, node_idx, std::move(path)});
+            open_list.emplace(child_cost, nodes.size() - 1);
+        }
+    }
+    return result;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,49 @@
+#ifndef BOXWORLD_SOLVER_H_
+#define BOXWORLD_SOLVER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+// Result of solving a state
+struct SolverResult {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    bool solved = false;              // Flag if a solution was found
+    std::size_t cost = 0;             // Number of actions in the solution
+    std::vector<Action> actions{};    // Optimal sequence of actions which reaches the solution
+    std::size_t expanded = 0;         // Number of key/lock states expanded
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Optimal solver which searches over the key/lock dependency graph instead of single steps.
+// Each edge of the search picks up a single key or opens a lock with the held key, costing the grid distance to
+// the target through the currently empty cells, so only the order of the targets is searched over.
+class BoxWorldSolver {
+public:
+    // Most single keys and locks a level can have
+    static constexpr std::size_t kMaxTargets = 64;
+
+    /**
+     * @param max_expansions Number of key/lock states to expand before giving up, 0 for no limit
+     */
+    explicit BoxWorldSolver(std::size_t max_expansions = 0);
+
+    /**
+     * Find the optimal solution from the given state.
+     * @note Throws std::invalid_argument if the state has more than kMaxTargets single keys and locks
+     * @param state The state to solve from
+     * @return The solution, with solved set to false if the state cannot be solved within the expansion limit
+     */
+    [[nodiscard]] auto solve(const BoxWorldGameState &state) const -> SolverResult;
+
+private:
+    std::size_t max_expansions;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_SOLVER_H_
@@ -0,0 +1,301 @@
+#include "sparse_boxworld.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace boxworld {
+
+namespace {
+auto is_colour(Element el) noexcept -> bool {
+    return el != Element::kEmpty && el != Element::kAgent;
+}
+}    // namespace
+
+SparseBoxWorld::SparseBoxWorld(const Level& level, bool collect_first_key)
+    : num_rows(static_cast<uint32_t>(level.rows)), num_cols(static_cast<uint32_t>(level.cols)) {
+    validate_level(level);
+    zobrist = get_zobrist_table(level.rows, level.cols).get();
+    const auto& board = level.board;
+    for (std::size_t idx = 0; idx < board.size(); ++idx) {
+        const auto el = board[idx];
+        if (el == Element::kAgent) {
+            agent_idx = static_cast<uint32_t>(idx);
+        }
+        if (!is_colour(el)) {
+            continue;
+        }
+        // Same classification as BoxWorldGameState, a lock has a colour to its left and a single key has neither
+        const auto col = idx % level.cols;
+        const bool is_left_colour = col > 0 && is_colour(board[idx - 1]);
+        const bool is_right_colour = col + 1 < level.cols && is_colour(board[idx + 1]);
+        if (!is_left_colour && !is_right_colour) {
+            if (collect_first_key) {
+                inventory = el;
+                continue;
+            }
+            entities.push_back({static_cast<uint32_t>(idx), el, EntityKind::kKey});
+        } else {
+            const auto kind = is_left_colour ? EntityKind::kLock : EntityKind::kBlocked;
+            entities.push_back({static_cast<uint32_t>(idx), el, kind});
+        }
+    }
+    InitHash();
+}
+
+SparseBoxWorld::SparseBoxWorld(const BoxWorldGameState& state)
+    : zobrist(get_zobrist_table(state.observation_shape()[2], state.observation_shape()[1]).get()),
+      zorb_hash(state.get_hash()),
+      reward_signal_index(state.get_reward_signal(false)),
+      reward_signal_colour(state.get_reward_signal(true)),
+      num_rows(static_cast<uint32_t>(state.observation_shape()[2])),
+      num_cols(static_cast<uint32_t>(state.observation_shape()[1])),
+      agent_idx(static_cast<uint32_t>(state.get_agent_index())),
+      inventory(state.get_inventory()) {
+    const auto& key_indices = state.get_key_indices();
+    const auto& lock_indices = state.get_lock_indices();
+    for (std::size_t idx = 0; idx < static_cast<std::size_t>(num_rows) * num_cols; ++idx) {
+        const auto el = state.get_item(idx);
+        if (!is_colour(el)) {
+            continue;
+        }
+        auto kind = EntityKind::kBlocked;
+        if (key_indices.contains(idx)) {
+            kind = EntityKind::kKey;
+        } else if (lock_indices.contains(idx)) {
+            kind = EntityKind::kLock;
+        }
+        entities.push_back({static_cast<uint32_t>(idx), el, kind});
+    }
+}
+
+void SparseBoxWorld::apply_action(Action action) noexcept {
+    reward_signal_colour = 0;
+    reward_signal_index = 0;
+    // Do nothing if move puts agent out of bounds
+    const auto row = agent_idx / num_cols;
+    const auto col = agent_idx % num_cols;
+    uint32_t new_index = 0;
+    switch (action) {
+        case Action::kUp:
+            if (row == 0) {
+                return;
+            }
+            new_index = agent_idx - num_cols;
+            break;
+        case Action::kRight:
+            if (col + 1 == num_cols) {
+                return;
+            }
+            new_index = agent_idx + 1;
+            break;
+        case Action::kDown:
+            if (row + 1 == num_rows) {
+                return;
+            }
+            new_index = agent_idx + num_cols;
+            break;
+        case Action::kLeft:
+            if (col == 0) {
+                return;
+            }
+            new_index = agent_idx - 1;
+            break;
+    }
+
+    // If empty, just move
+    const auto entity = FindEntity(new_index);
+    if (entity == entities.end()) {
+        MoveAgent(new_index);
+        return;
+    }
+
+    // Single key not part of a lock/box
+    if (entity->kind == EntityKind::kKey) {
+        reward_signal_colour = static_cast<uint64_t>(entity->element) + 1;
+        AddToInventory(entity);
+        MoveAgent(new_index);
+        reward_signal_index = static_cast<uint64_t>(agent_idx) + 1;
+        return;
+    }
+
+    // Lock/box pair and we have the corresponding key
+    // Key is consumed, and we add the box colour to our inventory
+    if (entity->kind == EntityKind::kLock && inventory == entity->element) {
+        reward_signal_colour = static_cast<uint64_t>(entity->element) + 1;
+        XorInventoryHash(inventory);
+        inventory = Element::kAgent;
+        XorCellHash(entity->element, new_index);
+        XorCellHash(Element::kEmpty, new_index);
+        // The key inside the box is the entity before the lock, as entities are sorted by index
+        const auto box_key = entities.erase(entity);
+        if (box_key != entities.begin() && std::prev(box_key)->index + 1 == new_index) {
+            AddToInventory(std::prev(box_key));
+        }
+        MoveAgent(new_index);
+        reward_signal_index = static_cast<uint64_t>(agent_idx) + 1;
+    }
+}
+
+auto SparseBoxWorld::is_solution() const noexcept -> bool {
+    return inventory == Element::kColourGoal;
+}
+
+auto SparseBoxWorld::get_reward_signal(bool use_colour) const noexcept -> uint64_t {
+    return use_colour ? reward_signal_colour : reward_signal_index;
+}
+
+auto SparseBoxWorld::get_hash() const noexcept -> uint64_t {
+    return zorb_hash;
+}
+
+auto SparseBoxWorld::get_agent_index() const noexcept -> std::size_t {
+    return agent_idx;
+}
+
+auto SparseBoxWorld::get_inventory() const noexcept -> Element {
+    return inventory;
+}
+
+auto SparseBoxWorld::has_key() const noexcept -> bool {
+    return inventory != Element::kAgent;
+}
+
+auto SparseBoxWorld::get_item(std::size_t index) const noexcept -> Element {
+    if (index == agent_idx) {
+        return Element::kAgent;
+    }
+    const auto entity = FindEntity(index);
+    return entity == entities.end() ? Element::kEmpty : entity->element;
+}
+
+auto SparseBoxWorld::get_entities() const noexcept -> const std::vector<Entity>& {
+    return entities;
+}
+
+auto SparseBoxWorld::rows() const noexcept -> std::size_t {
+    return num_rows;
+}
+
+auto SparseBoxWorld::cols() const noexcept -> std::size_t {
+    return num_cols;
+}
+
+auto SparseBoxWorld::observation_shape() const noexcept -> std::array<std::size_t, 3> {
+    return {kNumChannels, num_cols, num_rows};
+}
+
+auto SparseBoxWorld::observation_size() const noexcept -> std::size_t {
+    return kNumChannels * static_cast<std::size_t>(num_rows) * num_cols;
+}
+
+auto SparseBoxWorld::get_observation() const noexcept -> std::vector<float> {
+    std::vector<float> obs(observation_size());
+    get_observation(obs.data());
+    return obs;
+}
+
+void SparseBoxWorld::get_observation(float* obs) const noexcept {
+    const auto cells = static_cast<std::size_t>(num_rows) * num_cols;
+    std::fill_n(obs, observation_size(), static_cast<float>(0));
+    for (const auto& entity : entities) {
+        obs[static_cast<std::size_t>(entity.element) * cells + entity.index] = 1;
+    }
+    obs[static_cast<std::size_t>(Element::kAgent) * cells + agent_idx] = 1;
+    if (has_key()) {
+        const auto inventory_channel = static_cast<std::size_t>(inventory) + kNumElements - 1;
+        std::fill_n(obs + inventory_channel * cells, cells, static_cast<float>(1));
+    }
+}
+
+auto SparseBoxWorld::get_observation_entities() const noexcept -> std::vector<uint16_t> {
+    std::vector<uint16_t> obs((entities.size() + 2) * BoxWorldGameState::kEntitySize);
+    obs.resize(get_observation_entities(obs.data(), entities.size() + 2) * BoxWorldGameState::kEntitySize);
+    return obs;
+}
+
+auto SparseBoxWorld::get_observation_entities(uint16_t* obs, std::size_t max_entities) const noexcept
+    -> std::size_t {
+    constexpr auto kEntitySize = BoxWorldGameState::kEntitySize;
+    std::size_t count = 0;
+    const auto add_entity = [&](uint16_t row, uint16_t col, Element element) {
+        if (count < max_entities) {
+            obs[count * kEntitySize] = row;
+            obs[count * kEntitySize + 1] = col;
+            obs[count * kEntitySize + 2] = static_cast<uint16_t>(element);
+        }
+        ++count;
+    };
+    const auto add_cell = [&](uint32_t index, Element element) {
+        add_entity(static_cast<uint16_t>(index / num_cols), static_cast<uint16_t>(index % num_cols), element);
+    };
+    add_entity(BoxWorldGameState::kInventoryEntityPos, BoxWorldGameState::kInventoryEntityPos, inventory);
+    // Merge the agent into the entities, so cells are in board order
+    bool is_agent_added = false;
+    for (const auto& entity : entities) {
+        if (!is_agent_added && agent_idx < entity.index) {
+            add_cell(agent_idx, Element::kAgent);
+            is_agent_added = true;
+        }
+        add_cell(entity.index, entity.element);
+    }
+    if (!is_agent_added) {
+        add_cell(agent_idx, Element::kAgent);
+    }
+    return count;
+}
+
+auto SparseBoxWorld::operator==(const SparseBoxWorld& other) const noexcept -> bool {
+    return zorb_hash == other.zorb_hash && agent_idx == other.agent_idx && inventory == other.inventory &&
+           num_rows == other.num_rows && num_cols == other.num_cols && entities == other.entities;
+}
+
+auto SparseBoxWorld::operator!=(const SparseBoxWorld& other) const noexcept -> bool {
+    return !(*this == other);
+}
+
+void SparseBoxWorld::InitHash() {
+    // Hash every cell as empty, then swap in the non-empty cells, matching the hash of the dense board
+    const auto cells = static_cast<std::size_t>(num_rows) * num_cols;
+    zorb_hash = 0;
+    for (std::size_t i = 0; i < cells; ++i) {
+        XorCellHash(Element::kEmpty, i);
+    }
+    for (const auto& entity : entities) {
+        XorCellHash(Element::kEmpty, entity.index);
+        XorCellHash(entity.element, entity.index);
+    }
+    XorCellHash(Element::kEmpty, agent_idx);
+    XorCellHash(Element::kAgent, agent_idx);
+}
+
+auto SparseBoxWorld::FindEntity(std::size_t index) const noexcept -> std::vector<Entity>::const_iterator {
+    const auto it = std::lower_bound(entities.begin(), entities.end(), index,
+                                     [](const Entity& entity, std::size_t idx) { return entity.index < idx; });
+    return it != entities.end() && it->index == index ? it : entities.end();
+}
+
+void SparseBoxWorld::XorCellHash(Element element, std::size_t index) noexcept {
+    zorb_hash ^= zobrist->board[static_cast<std::size_t>(element) * num_rows * num_cols + index];
+}
+
+void SparseBoxWorld::XorInventoryHash(Element element) noexcept {
+    zorb_hash ^= zobrist->inventory[static_cast<std::size_t>(element)];
+}
+
+void SparseBoxWorld::MoveAgent(uint32_t new_index) noexcept {
+    XorCellHash(Element::kAgent, agent_idx);
+    XorCellHash(Element::kEmpty, agent_idx);
+    XorCellHash(Element::kEmpty, new_index);
+    XorCellHash(Element::kAgent, new_index);
+    agent_idx = new_index;
+}
+
+void SparseBoxWorld::AddToInventory(std::vector<Entity>::const_iterator entity) noexcept {
+    inventory = entity->element;
+    XorCellHash(inventory, entity->index);
+    XorInventoryHash(inventory);
+    XorCellHash(Element::kEmpty, entity->index);
+    entities.erase(entity);
+}
+
+}    // namespace boxworld
@@ -0,0 +1,188 @@
+#ifndef BOXWORLD_SPARSE_BOXWORLD_H_
+#define BOXWORLD_SPARSE_BOXWORLD_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+#include "level.h"
+#include "zobrist.h"
+
+namespace boxworld {
+
+// Game state which stores only the non-empty cells, with the same rules and observation as BoxWorldGameState.
+// Keys, locks, and the keys inside boxes are kept in a small array sorted by board index, so the state size and the
+// cost of copying and stepping scale with the number of entities rather than the board area, for large boards.
+// Hashes equal BoxWorldGameState::get_hash() for the same level and actions.
+class SparseBoxWorld {
+public:
+    // Role of an entity, fixed when the state is constructed as entities are only ever removed
+    enum class EntityKind : uint8_t {
+        kKey,       // Single key, collected by stepping onto it
+        kLock,      // Lock of a box, opened by stepping onto it holding a key of its colour
+        kBlocked    // Key inside a box, collected when the lock to its right is opened
+    };
+
+    // Non-empty cell other than the agent
+    struct Entity {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        uint32_t index = 0;                     // Board index
+        Element element = Element::kEmpty;      // Element of the cell
+        EntityKind kind = EntityKind::kKey;     // Role of the cell
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+        auto operator==(const Entity &other) const noexcept -> bool {
+            return index == other.index && element == other.element && kind == other.kind;
+        }
+    };
+
+    SparseBoxWorld() = delete;
+
+    /**
+     * Construct at the start of a level, as BoxWorldGameState(level, collect_first_key) would.
+     * @note Throws std::invalid_argument if the level is invalid
+     * @param level The level to start
+     * @param collect_first_key Flag to start with the single key in the inventory
+     */
+    explicit SparseBoxWorld(const Level &level, bool collect_first_key = false);
+
+    /**
+     * Construct from a state, keeping its keys, locks, inventory, hash, and reward signals.
+     * @param state The state to copy
+     */
+    explicit SparseBoxWorld(const BoxWorldGameState &state);
+
+    /**
+     * Apply the action to the current state, see BoxWorldGameState::apply_action().
+     * @param action The action to apply
+     */
+    void apply_action(Action action) noexcept;
+
+    /**
+     * Check if the state is in the solution state.
+     * @return True if holding the goal, false otherwise
+     */
+    [[nodiscard]] auto is_solution() const noexcept -> bool;
+
+    /**
+     * Get the reward signal of the last action, see BoxWorldGameState::get_reward_signal().
+     * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+     * @return reward signal
+     */
+    [[nodiscard]] auto get_reward_signal(bool use_colour = false) const noexcept -> uint64_t;
+
+    /**
+     * Get the hash of the current state.
+     * @return hash value
+     */
+    [[nodiscard]] auto get_hash() const noexcept -> uint64_t;
+
+    /**
+     * Get the current agent index
+     * @return agent index
+     */
+    [[nodiscard]] auto get_agent_index() const noexcept -> std::size_t;
+
+    /**
+     * Get the current key in the inventory
+     * @return Element of the key held, or kAgent if no key is held
+     */
+    [[nodiscard]] auto get_inventory() const noexcept -> Element;
+
+    /**
+     * Check if key is being held in inventory
+     * @return True if holding key of any colour, false otherwise
+     */
+    [[nodiscard]] auto has_key() const noexcept -> bool;
+
+    /**
+     * Get the item at the given index, by binary search of the entities
+     * @param index Board index
+     * @return Element at the index
+     */
+    [[nodiscard]] auto get_item(std::size_t index) const noexcept -> Element;
+
+    /**
+     * Get the entities, sorted by board index
+     * @return The keys, locks, and keys inside boxes remaining on the board
+     */
+    [[nodiscard]] auto get_entities() const noexcept -> const std::vector<Entity> &;
+
+    /**
+     * Get the rows of the board
+     * @return Number of rows
+     */
+    [[nodiscard]] auto rows() const noexcept -> std::size_t;
+
+    /**
+     * Get the cols of the board
+     * @return Number of cols
+     */
+    [[nodiscard]] auto cols() const noexcept -> std::size_t;
+
+    /**
+     * Get the shape the observations should be viewed as.
+     * @return array indicating observation CHW
+     */
+    [[nodiscard]] auto observation_shape() const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Get the number of values in the observation.
+     * @return kNumChannels * rows * cols
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Get the observation, see BoxWorldGameState::get_observation().
+     * @return vector of observation_size() values
+     */
+    [[nodiscard]] auto get_observation() const noexcept -> std::vector<float>;
+
+    /**
+     * Write the observation into the given buffer, see BoxWorldGameState::get_observation().
+     * @param obs Buffer of observation_size() values
+     */
+    void get_observation(float *obs) const noexcept;
+
+    /**
+     * Get the entity observation, see BoxWorldGameState::get_observation_entities().
+     * Costs one step per entity, so this is the observation to use for large boards.
+     * @return vector of 3 values per entity
+     */
+    [[nodiscard]] auto get_observation_entities() const noexcept -> std::vector<uint16_t>;
+
+    /**
+     * Write the entity observation into the given buffer, see BoxWorldGameState::get_observation_entities().
+     * @param obs Pointer to the start of the buffer of 3 * max_entities values to write into
+     * @param max_entities Capacity of the buffer in entities, entities past the capacity are not written
+     * @return Number of entities in the observation, which may be more than max_entities
+     */
+    auto get_observation_entities(uint16_t *obs, std::size_t max_entities) const noexcept -> std::size_t;
+
+    auto operator==(const SparseBoxWorld &other) const noexcept -> bool;
+    auto operator!=(const SparseBoxWorld &other) const noexcept -> bool;
+
+private:
+    void InitHash();
+    [[nodiscard]] auto FindEntity(std::size_t index) const noexcept -> std::vector<Entity>::const_iterator;
+    void XorCellHash(Element element, std::size_t index) noexcept;
+    void XorInventoryHash(Element element) noexcept;
+    void MoveAgent(uint32_t new_index) noexcept;
+    void AddToInventory(std::vector<Entity>::const_iterator entity) noexcept;
+
+    std::vector<Entity> entities;
+    const ZobristTable *zobrist = nullptr;    // Kept alive by the process wide cache, see get_zobrist_table()
+    uint64_t zorb_hash = 0;
+    uint64_t reward_signal_index = 0;
+    uint64_t reward_signal_colour = 0;
+    uint32_t num_rows = 0;
+    uint32_t num_cols = 0;
+    uint32_t agent_idx = 0;
+    Element inventory = Element::kAgent;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_SPARSE_BOXWORLD_H_
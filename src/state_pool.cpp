@@ -0,0 +1,107 @@
+#include "state_pool.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+#include "stats.h"
+
+namespace boxworld {
+
+StatePool::StatePool(std::size_t block_size, std::pmr::memory_resource* resource)
+    : block_size(block_size), resource(resource) {
+    if (block_size == 0) {
+        throw std::invalid_argument("State pool block size must be positive.");
+    }
+}
+
+StatePool::~StatePool() {
+    release();
+}
+
+StatePool::StatePool(StatePool&& other) noexcept
+    : block_size(other.block_size),
+      resource(other.resource),
+      blocks(std::exchange(other.blocks, {})),
+      free_handles(std::exchange(other.free_handles, {})),
+      num_slots_used(std::exchange(other.num_slots_used, 0)) {}
+
+auto StatePool::operator=(StatePool&& other) noexcept -> StatePool& {
+    if (this != &other) {
+        release();
+        block_size = other.block_size;
+        resource = other.resource;
+        blocks = std::exchange(other.blocks, {});
+        free_handles = std::exchange(other.free_handles, {});
+        num_slots_used = std::exchange(other.num_slots_used, 0);
+    }
+    return *this;
+}
+
+auto StatePool::store(const BoxWorldGameState& state) -> Handle {
+    Handle handle = 0;
+    if (!free_handles.empty()) {
+        handle = free_handles.back();
+        state.snapshot(Slot(handle));
+        free_handles.pop_back();
+        return handle;
+    }
+    if (num_slots_used == blocks.size() * block_size) {
+        // Snapshots are trivially copyable, so the block needs no construction
+        void* block = resource->allocate(block_size * sizeof(StateSnapshot), alignof(StateSnapshot));
+        blocks.push_back(static_cast<StateSnapshot*>(block));
+        record_memory(MemoryKind::kStatePools, 1, static_cast<int64_t>(block_size * sizeof(StateSnapshot)));
+    }
+    handle = num_slots_used;
+    state.snapshot(Slot(handle));
+    ++num_slots_used;
+    return handle;
+}
+
+void StatePool::load(Handle handle, BoxWorldGameState& state) const {
+    state.restore(get(handle));
+}
+
+auto StatePool::get(Handle handle) const noexcept -> const StateSnapshot& {
+    return Slot(handle);
+}
+
+void StatePool::free(Handle handle) {
+    assert(handle < num_slots_used);
+    free_handles.push_back(handle);
+}
+
+void StatePool::clear() noexcept {
+    free_handles.clear();
+    num_slots_used = 0;
+}
+
+void StatePool::release() noexcept {
+    for (auto* block : blocks) {
+        resource->deallocate(block, block_size * sizeof(StateSnapshot), alignof(StateSnapshot));
+    }
+    record_memory(MemoryKind::kStatePools, -static_cast<int64_t>(blocks.size()),
+                  -static_cast<int64_t>(blocks.size() * block_size * sizeof(StateSnapshot)));
+    blocks.clear();
+    clear();
+}
+
+auto StatePool::size() const noexcept -> std::size_t {
+    return num_slots_used - free_handles.size();
+}
+
+auto StatePool::capacity() const noexcept -> std::size_t {
+    return blocks.size() * block_size - size();
+}
+
+auto StatePool::memory_usage() const noexcept -> std::size_t {
+    return sizeof(*this) + blocks.size() * block_size * sizeof(StateSnapshot) + heap_bytes(blocks) +
+           heap_bytes(free_handles);
+}
+
+auto StatePool::Slot(Handle handle) const noexcept -> StateSnapshot& {
+    assert(handle < blocks.size() * block_size);
+    return blocks[handle / block_size][handle % block_size];
+}
+
+}    // namespace boxworld
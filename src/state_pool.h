@@ -0,0 +1,104 @@
+#ifndef BOXWORLD_STATE_POOL_H_
+#define BOXWORLD_STATE_POOL_H_
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "boxworld_base.h"
+
+namespace boxworld {
+
+// Arena of state snapshots for searches which store many states of a single level.
+// Snapshots are allocated in blocks from a caller supplied memory resource, such as a
+// std::pmr::monotonic_buffer_resource, with no reference counting or per-state heap allocations. States are
+// materialised by restoring into a working state of the same level.
+// @note Not thread safe, use one pool per searching thread to avoid contention
+class StatePool {
+public:
+    // Handle of a stored state, valid until it is freed or the pool is cleared
+    using Handle = std::size_t;
+
+    /**
+     * @note Throws std::invalid_argument if block_size is 0
+     * @param block_size Number of snapshots allocated from the resource at a time
+     * @param resource Memory resource the blocks are allocated from, which must outlive the pool
+     */
+    explicit StatePool(std::size_t block_size = 1024,
+                       std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    ~StatePool();
+
+    StatePool(const StatePool &) = delete;
+    StatePool(StatePool &&other) noexcept;
+    auto operator=(const StatePool &) -> StatePool & = delete;
+    auto operator=(StatePool &&other) noexcept -> StatePool &;
+
+    /**
+     * Store a snapshot of the state, reusing the slot of a freed state if any.
+     * @note Throws std::invalid_argument if the state exceeds the StateSnapshot capacity
+     * @param state The state to store
+     * @return Handle of the stored state
+     */
+    auto store(const BoxWorldGameState &state) -> Handle;
+
+    /**
+     * Restore a stored state into the given state of the same level.
+     * @param handle Handle of the stored state
+     * @param state The state to restore into
+     */
+    void load(Handle handle, BoxWorldGameState &state) const;
+
+    /**
+     * Get the snapshot of a stored state.
+     * @param handle Handle of the stored state
+     * @return The snapshot, valid until the state is freed or the pool is cleared
+     */
+    [[nodiscard]] auto get(Handle handle) const noexcept -> const StateSnapshot &;
+
+    /**
+     * Free a stored state, so its slot can be reused by the next store.
+     * @param handle Handle of the stored state
+     */
+    void free(Handle handle);
+
+    /**
+     * Free every stored state at once, keeping the allocated blocks for reuse.
+     */
+    void clear() noexcept;
+
+    /**
+     * Free every stored state and return all blocks to the memory resource.
+     */
+    void release() noexcept;
+
+    /**
+     * Get the number of stored states
+     * @return Count of states
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the number of states which can be stored without allocating
+     * @return Count of states
+     */
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    /**
+     * Get the memory held by the pool, including freed slots and blocks kept for reuse by clear()
+     * @return Bytes of the pool, its blocks and handle lists
+     */
+    [[nodiscard]] auto memory_usage() const noexcept -> std::size_t;
+
+private:
+    [[nodiscard]] auto Slot(Handle handle) const noexcept -> StateSnapshot &;
+
+    std::size_t block_size;
+    std::pmr::memory_resource *resource;
+    std::vector<StateSnapshot *> blocks;
+    std::vector<Handle> free_handles;
+    std::size_t num_slots_used = 0;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_STATE_POOL_H_
@@ -0,0 +1,65 @@
+#include "state_tree.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace boxworld {
+
+StateTree::StateTree(const BoxWorldGameState& root) : root(root), nodes{{kRoot, Action::kUp}} {}
+
+auto StateTree::add_child(Handle parent, Action action) -> Handle {
+    CheckHandle(parent);
+    nodes.push_back({parent, action});
+    return nodes.size() - 1;
+}
+
+void StateTree::load(Handle handle, BoxWorldGameState& state) {
+    CheckHandle(handle);
+    path.clear();
+    for (; handle != kRoot; handle = nodes[handle].parent) {
+        path.push_back(nodes[handle].action);
+    }
+    state = root;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        state.apply_action(*it);
+    }
+}
+
+auto StateTree::get_path(Handle handle) const -> std::vector<Action> {
+    CheckHandle(handle);
+    std::vector<Action> actions;
+    for (; handle != kRoot; handle = nodes[handle].parent) {
+        actions.push_back(nodes[handle].action);
+    }
+    std::reverse(actions.begin(), actions.end());
+    return actions;
+}
+
+auto StateTree::get_node(Handle handle) const -> const Node& {
+    CheckHandle(handle);
+    return nodes[handle];
+}
+
+auto StateTree::get_root() const noexcept -> const BoxWorldGameState& {
+    return root;
+}
+
+void StateTree::clear() noexcept {
+    nodes.resize(1);
+}
+
+auto StateTree::size() const noexcept -> std::size_t {
+    return nodes.size();
+}
+
+auto StateTree::node_bytes() const noexcept -> std::size_t {
+    return nodes.size() * sizeof(Node);
+}
+
+void StateTree::CheckHandle(Handle handle) const {
+    if (handle >= nodes.size()) {
+        throw std::invalid_argument("Handle is not a node of the state tree.");
+    }
+}
+
+}    // namespace boxworld
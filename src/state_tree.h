@@ -0,0 +1,107 @@
+#ifndef BOXWORLD_STATE_TREE_H_
+#define BOXWORLD_STATE_TREE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+// Persistent tree of states reached from a single root state, for searches which keep many live nodes.
+// Each node stores only its parent and the action from the parent, as the action determines every cell the child
+// changes, so a node costs sizeof(Node) bytes however large the board is. States are materialised by replaying the
+// actions from the root into a working state.
+// @note Not thread safe, use one tree per searching thread
+class StateTree {
+public:
+    // Handle of a node, valid until the tree is cleared
+    using Handle = std::size_t;
+
+    // Handle of the root node
+    static constexpr Handle kRoot = 0;
+
+    // Stored node of the tree
+    struct Node {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        Handle parent = kRoot;          // Parent node, the root is its own parent
+        Action action = Action::kUp;    // Action applied to the parent state
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    StateTree() = delete;
+
+    /**
+     * @param root The state at the root of the tree, copied into the tree
+     */
+    explicit StateTree(const BoxWorldGameState &root);
+
+    /**
+     * Add the child reached by applying the action to the state of the parent node.
+     * @note Throws std::invalid_argument if parent is not a node of the tree
+     * @param parent Handle of the parent node
+     * @param action The action applied to the parent state
+     * @return Handle of the child node
+     */
+    auto add_child(Handle parent, Action action) -> Handle;
+
+    /**
+     * Materialise the state of a node into the given state, reusing its buffers.
+     * @note Costs one apply_action per level of depth, so prefer applying the action directly when stepping from a
+     * parent which is already materialised. Throws std::invalid_argument if handle is not a node of the tree
+     * @param handle Handle of the node
+     * @param state The state to write into
+     */
+    void load(Handle handle, BoxWorldGameState &state);
+
+    /**
+     * Get the actions from the root to a node.
+     * @note Throws std::invalid_argument if handle is not a node of the tree
+     * @param handle Handle of the node
+     * @return Actions in the order they are applied from the root
+     */
+    [[nodiscard]] auto get_path(Handle handle) const -> std::vector<Action>;
+
+    /**
+     * Get a stored node.
+     * @note Throws std::invalid_argument if handle is not a node of the tree
+     * @param handle Handle of the node
+     * @return The node
+     */
+    [[nodiscard]] auto get_node(Handle handle) const -> const Node &;
+
+    /**
+     * Get the state at the root of the tree
+     * @return The root state
+     */
+    [[nodiscard]] auto get_root() const noexcept -> const BoxWorldGameState &;
+
+    /**
+     * Remove every node below the root, keeping the allocated storage.
+     */
+    void clear() noexcept;
+
+    /**
+     * Get the number of nodes, including the root
+     * @return Count of nodes
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the bytes used by the stored nodes, excluding the root state
+     * @return Bytes of node storage
+     */
+    [[nodiscard]] auto node_bytes() const noexcept -> std::size_t;
+
+private:
+    void CheckHandle(Handle handle) const;
+
+    BoxWorldGameState root;
+    std::vector<Node> nodes;
+    std::vector<Action> path;    // Reused buffer of the actions replayed by load()
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_STATE_TREE_H_
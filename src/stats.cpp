@@ -0,0 +1,234 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "level_registry.h"
+#include "zobrist.h"
+
+namespace boxworld {
+
+namespace {
+constexpr std::array<const char*, kNumStatsEvents> kEventNames{
+    "apply_action", "reset", "get_observation", "to_image", "serialize", "deserialize", "level", "buffer",
+};
+
+constexpr std::array<const char*, kNumMemoryKinds> kMemoryKindNames{
+    "registered_levels",
+    "zobrist_tables",
+    "state_pools",
+};
+
+constexpr auto is_allocation(std::size_t event) noexcept -> bool {
+    return event >= static_cast<std::size_t>(StatsEvent::kLevelAllocation);
+}
+
+// Counters written only by their owning thread, and read by get_stats() from any thread
+struct ThreadStats {
+    ThreadStats();
+    ~ThreadStats();
+    ThreadStats(const ThreadStats&) = delete;
+    ThreadStats(ThreadStats&&) = delete;
+    auto operator=(const ThreadStats&) -> ThreadStats& = delete;
+    auto operator=(ThreadStats&&) -> ThreadStats& = delete;
+
+    void AddTo(Stats& stats) const noexcept {
+        for (std::size_t i = 0; i < kNumStatsEvents; ++i) {
+            stats.entries[i].count += counts[i].load(std::memory_order_relaxed);
+            stats.entries[i].nanoseconds += nanoseconds[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void Clear() noexcept {
+        for (std::size_t i = 0; i < kNumStatsEvents; ++i) {
+            counts[i].store(0, std::memory_order_relaxed);
+            nanoseconds[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::array<std::atomic<uint64_t>, kNumStatsEvents> counts{};
+    std::array<std::atomic<uint64_t>, kNumStatsEvents> nanoseconds{};
+};
+
+// Counters of the live threads, and the totals of the threads which have exited
+struct StatsRegistry {
+    std::mutex mutex;
+    std::vector<ThreadStats*> threads;
+    Stats retired;
+};
+
+auto get_registry() -> StatsRegistry& {
+    // Never destroyed, as thread_local counters may exit after static destruction
+    static auto* registry = new StatsRegistry();
+    return *registry;
+}
+
+ThreadStats::ThreadStats() {
+    auto& registry = get_registry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+ThreadStats::~ThreadStats() {
+    auto& registry = get_registry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    AddTo(registry.retired);
+    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+}
+
+// Gauges of the memory which is tracked as it is allocated rather than measured
+struct TrackedMemory {
+    std::array<std::atomic<int64_t>, kNumMemoryKinds> counts{};
+    std::array<std::atomic<int64_t>, kNumMemoryKinds> bytes{};
+};
+
+auto get_tracked_memory() -> TrackedMemory& {
+    // Never destroyed, as pools may be freed after static destruction
+    static auto* memory = new TrackedMemory();
+    return *memory;
+}
+
+auto get_thread_stats() -> ThreadStats& {
+    thread_local ThreadStats stats;
+    return stats;
+}
+}    // namespace
+
+auto stats_enabled() noexcept -> bool {
+#ifdef BOXWORLD_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto stats_event_name(StatsEvent event) noexcept -> const char* {
+    const auto i = static_cast<std::size_t>(event);
+    if (is_allocation(i)) {
+        return i == static_cast<std::size_t>(StatsEvent::kLevelAllocation) ? "level_allocation" : "buffer_allocation";
+    }
+    return kEventNames[i];
+}
+
+void record_stats_event(StatsEvent event, uint64_t nanoseconds) noexcept {
+    auto& stats = get_thread_stats();
+    const auto i = static_cast<std::size_t>(event);
+    // Single writer, so a relaxed load and store avoids the locked read-modify-write
+    stats.counts[i].store(stats.counts[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    stats.nanoseconds[i].store(stats.nanoseconds[i].load(std::memory_order_relaxed) + nanoseconds,
+                               std::memory_order_relaxed);
+}
+
+auto get_stats() -> Stats {
+    auto& registry = get_registry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    Stats stats = registry.retired;
+    for (const auto* thread : registry.threads) {
+        thread->AddTo(stats);
+    }
+    return stats;
+}
+
+void reset_stats() {
+    auto& registry = get_registry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired = Stats{};
+    for (auto* thread : registry.threads) {
+        thread->Clear();
+    }
+}
+
+auto stats_to_json(const Stats& stats) -> std::string {
+    std::ostringstream os;
+    os << "{";
+    for (std::size_t i = 0; i < kNumStatsEvents; ++i) {
+        os << (i > 0 ? "," : "") << "\"" << stats_event_name(static_cast<StatsEvent>(i)) << "\":{\"count\":"
+           << stats.entries[i].count << ",\"nanoseconds\":" << stats.entries[i].nanoseconds << "}";
+    }
+    os << "}";
+    return os.str();
+}
+
+auto stats_to_prometheus(const Stats& stats) -> std::string {
+    std::ostringstream os;
+    os << "# HELP boxworld_calls_total Number of calls of instrumented library functions.\n"
+       << "# TYPE boxworld_calls_total counter\n";
+    for (std::size_t i = 0; i < kNumStatsEvents && !is_allocation(i); ++i) {
+        os << "boxworld_calls_total{function=\"" << kEventNames[i] << "\"} " << stats.entries[i].count << "\n";
+    }
+    os << "# HELP boxworld_call_seconds_total Time spent in instrumented library functions.\n"
+       << "# TYPE boxworld_call_seconds_total counter\n" << std::setprecision(9) << std::fixed;
+    for (std::size_t i = 0; i < kNumStatsEvents && !is_allocation(i); ++i) {
+        os << "boxworld_call_seconds_total{function=\"" << kEventNames[i] << "\"} "
+           << static_cast<double>(stats.entries[i].nanoseconds) * 1e-9 << "\n";
+    }
+    os << "# HELP boxworld_allocations_total Number of heap allocations made by the library.\n"
+       << "# TYPE boxworld_allocations_total counter\n";
+    for (std::size_t i = 0; i < kNumStatsEvents; ++i) {
+        if (is_allocation(i)) {
+            os << "boxworld_allocations_total{kind=\"" << kEventNames[i] << "\"} " << stats.entries[i].count << "\n";
+        }
+    }
+    return os.str();
+}
+
+auto memory_kind_name(MemoryKind kind) noexcept -> const char* {
+    return kMemoryKindNames[static_cast<std::size_t>(kind)];
+}
+
+void record_memory(MemoryKind kind, int64_t count, int64_t bytes) noexcept {
+    auto& memory = get_tracked_memory();
+    const auto i = static_cast<std::size_t>(kind);
+    memory.counts[i].fetch_add(count, std::memory_order_relaxed);
+    memory.bytes[i].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+auto get_memory_stats() -> MemoryStats {
+    MemoryStats stats;
+    auto& memory = get_tracked_memory();
+    for (std::size_t i = 0; i < kNumMemoryKinds; ++i) {
+        stats.gauges[i].count = static_cast<uint64_t>(std::max<int64_t>(memory.counts[i].load(), 0));
+        stats.gauges[i].bytes = static_cast<uint64_t>(std::max<int64_t>(memory.bytes[i].load(), 0));
+    }
+    const auto& registry = LevelRegistry::get_instance();
+    auto& levels = stats.gauges[static_cast<std::size_t>(MemoryKind::kRegisteredLevels)];
+    levels.count += registry.size();
+    levels.bytes += registry.memory_usage();
+    const auto tables = get_zobrist_cache_usage();
+    auto& zobrist = stats.gauges[static_cast<std::size_t>(MemoryKind::kZobristTables)];
+    zobrist.count += tables.count;
+    zobrist.bytes += tables.bytes;
+    return stats;
+}
+
+auto memory_stats_to_json(const MemoryStats& stats) -> std::string {
+    std::ostringstream os;
+    os << "{";
+    for (std::size_t i = 0; i < kNumMemoryKinds; ++i) {
+        os << (i > 0 ? "," : "") << "\"" << kMemoryKindNames[i] << "\":{\"count\":" << stats.gauges[i].count
+           << ",\"bytes\":" << stats.gauges[i].bytes << "}";
+    }
+    os << "}";
+    return os.str();
+}
+
+auto memory_stats_to_prometheus(const MemoryStats& stats) -> std::string {
+    std::ostringstream os;
+    os << "# HELP boxworld_memory_bytes Bytes of memory held by the library.\n"
+       << "# TYPE boxworld_memory_bytes gauge\n";
+    for (std::size_t i = 0; i < kNumMemoryKinds; ++i) {
+        os << "boxworld_memory_bytes{kind=\"" << kMemoryKindNames[i] << "\"} " << stats.gauges[i].bytes << "\n";
+    }
+    os << "# HELP boxworld_memory_objects Number of objects holding the memory of the library.\n"
+       << "# TYPE boxworld_memory_objects gauge\n";
+    for (std::size_t i = 0; i < kNumMemoryKinds; ++i) {
+        os << "boxworld_memory_objects{kind=\"" << kMemoryKindNames[i] << "\"} " << stats.gauges[i].count << "\n";
+    }
+    return os.str();
+}
+
+}    // namespace boxworld
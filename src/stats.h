@@ -0,0 +1,224 @@
+#ifndef BOXWORLD_STATS_H_
+#define BOXWORLD_STATS_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace boxworld {
+
+// Instrumented library events, counted and timed when built with the BOXWORLD_STATS CMake option
+enum class StatsEvent : uint8_t {
+    kApplyAction = 0,
+    kReset,
+    kGetObservation,
+    kToImage,
+    kSerialize,
+    kDeserialize,
+    kLevelAllocation,     // Shared level info allocated on construction, reset or deserialization
+    kBufferAllocation,    // Vector returned by an observation, image, or serialization getter
+};
+constexpr std::size_t kNumStatsEvents = 8;
+
+// Calls of an event and the time spent in them
+struct StatsEntry {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t count = 0;
+    uint64_t nanoseconds = 0;    // Always 0 for allocation events, which are only counted
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Totals of every event over all threads
+struct Stats {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::array<StatsEntry, kNumStatsEvents> entries{};
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    [[nodiscard]] auto operator[](StatsEvent event) const noexcept -> const StatsEntry & {
+        return entries[static_cast<std::size_t>(event)];
+    }
+};
+
+/**
+ * Check if the library was built with stats, otherwise no events are recorded and get_stats() is all zero.
+ * @return True if built with the BOXWORLD_STATS CMake option
+ */
+[[nodiscard]] auto stats_enabled() noexcept -> bool;
+
+/**
+ * Get the name of an event, as used in the stats dumps
+ * @param event The event
+ * @return snake_case name of the event
+ */
+[[nodiscard]] auto stats_event_name(StatsEvent event) noexcept -> const char *;
+
+/**
+ * Record an event on the calling thread.
+ * @note Each thread writes its own counters, so recording never contends with other threads
+ * @param event The event
+ * @param nanoseconds Time spent in the event
+ */
+void record_stats_event(StatsEvent event, uint64_t nanoseconds = 0) noexcept;
+
+/**
+ * Sum the counters of every live thread and of the threads which have exited.
+ * @return The totals
+ */
+[[nodiscard]] auto get_stats() -> Stats;
+
+/**
+ * Zero the counters of every thread.
+ * @note Events recorded concurrently with the reset may be partially kept
+ */
+void reset_stats();
+
+/**
+ * Format the stats as a JSON object keyed by event name, each with a count and nanoseconds.
+ * @param stats The stats to format
+ * @return JSON text
+ */
+[[nodiscard]] auto stats_to_json(const Stats &stats) -> std::string;
+
+/**
+ * Format the stats in the Prometheus text exposition format, as the counters boxworld_calls_total and
+ * boxworld_call_seconds_total labelled by function, and boxworld_allocations_total labelled by kind.
+ * @param stats The stats to format
+ * @return Prometheus text
+ */
+[[nodiscard]] auto stats_to_prometheus(const Stats &stats) -> std::string;
+
+// Kinds of memory held process wide by the library, reported by get_memory_stats()
+enum class MemoryKind : uint8_t {
+    kRegisteredLevels = 0,    // Shared level info held by the LevelRegistry, counted in levels
+    kZobristTables,           // Zobrist tables cached per board size, counted in tables
+    kStatePools,              // Blocks of every live StatePool, counted in blocks
+};
+constexpr std::size_t kNumMemoryKinds = 3;
+
+// Objects of a kind of memory and the bytes they hold
+struct MemoryGauge {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// Memory held by the library at the time of get_memory_stats()
+struct MemoryStats {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::array<MemoryGauge, kNumMemoryKinds> gauges{};
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    [[nodiscard]] auto operator[](MemoryKind kind) const noexcept -> const MemoryGauge & {
+        return gauges[static_cast<std::size_t>(kind)];
+    }
+
+    [[nodiscard]] auto total_bytes() const noexcept -> uint64_t {
+        uint64_t bytes = 0;
+        for (const auto &gauge : gauges) {
+            bytes += gauge.bytes;
+        }
+        return bytes;
+    }
+};
+
+/**
+ * Get the name of a kind of memory, as used in the memory dumps
+ * @param kind The kind of memory
+ * @return snake_case name of the kind
+ */
+[[nodiscard]] auto memory_kind_name(MemoryKind kind) noexcept -> const char *;
+
+/**
+ * Adjust the tracked gauge of a kind of memory, for memory which is not measured on demand, see get_memory_stats().
+ * @note Safe to call from multiple threads
+ * @param kind The kind of memory
+ * @param count Change in the number of objects
+ * @param bytes Change in the number of bytes
+ */
+void record_memory(MemoryKind kind, int64_t count, int64_t bytes) noexcept;
+
+/**
+ * Get the memory held process wide by the library. Registered levels and Zobrist tables are measured on demand,
+ * and state pools are tracked as their blocks are allocated and freed. Unlike get_stats(), the gauges are
+ * maintained whether or not the library was built with stats, and are not zeroed by reset_stats().
+ * @note Levels held only by states, such as augmented levels, are not registered and are reported by
+ * BoxWorldGameState::memory_usage() instead
+ * @return The gauges
+ */
+[[nodiscard]] auto get_memory_stats() -> MemoryStats;
+
+/**
+ * Format the memory stats as a JSON object keyed by kind, each with a count and bytes.
+ * @param stats The memory stats to format
+ * @return JSON text
+ */
+[[nodiscard]] auto memory_stats_to_json(const MemoryStats &stats) -> std::string;
+
+/**
+ * Format the memory stats in the Prometheus text exposition format, as the gauges boxworld_memory_bytes and
+ * boxworld_memory_objects labelled by kind.
+ * @param stats The memory stats to format
+ * @return Prometheus text
+ */
+[[nodiscard]] auto memory_stats_to_prometheus(const MemoryStats &stats) -> std::string;
+
+/**
+ * Get the heap memory of a vector, which is its capacity rather than its size.
+ * @param values The vector
+ * @return Bytes allocated by the vector
+ */
+template <typename T, typename Allocator>
+[[nodiscard]] auto heap_bytes(const std::vector<T, Allocator> &values) noexcept -> std::size_t {
+    return values.capacity() * sizeof(T);
+}
+
+/**
+ * Estimate the heap memory of a hash map, as its bucket array and one node per element, without the heap memory
+ * of the elements themselves.
+ * @param values The hash map
+ * @return Estimated bytes allocated by the map
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+[[nodiscard]] auto heap_bytes(const std::unordered_map<Key, T, Hash, KeyEqual, Allocator> &values) noexcept
+    -> std::size_t {
+    using Value = typename std::unordered_map<Key, T, Hash, KeyEqual, Allocator>::value_type;
+    return values.bucket_count() * sizeof(void *) + values.size() * (sizeof(void *) + sizeof(Value));
+}
+
+// Records an event with the time from construction to destruction
+class ScopedStatsTimer {
+public:
+    explicit ScopedStatsTimer(StatsEvent event) noexcept : event(event), start(std::chrono::steady_clock::now()) {}
+    ~ScopedStatsTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        record_stats_event(event, static_cast<uint64_t>(std::chrono::nanoseconds(elapsed).count()));
+    }
+    ScopedStatsTimer(const ScopedStatsTimer &) = delete;
+    ScopedStatsTimer(ScopedStatsTimer &&) = delete;
+    auto operator=(const ScopedStatsTimer &) -> ScopedStatsTimer & = delete;
+    auto operator=(ScopedStatsTimer &&) -> ScopedStatsTimer & = delete;
+
+private:
+    StatsEvent event;
+    std::chrono::steady_clock::time_point start;
+};
+
+}    // namespace boxworld
+
+// Instrumentation of the hot paths, which compiles to nothing unless built with stats
+#ifdef BOXWORLD_STATS
+#define BOXWORLD_STATS_CONCAT_IMPL(a, b) a##b
+#define BOXWORLD_STATS_CONCAT(a, b) BOXWORLD_STATS_CONCAT_IMPL(a, b)
+#define BOXWORLD_STATS_SCOPE(event) \
+    const ::boxworld::ScopedStatsTimer BOXWORLD_STATS_CONCAT(boxworld_stats_timer_, __LINE__)(event)
+#define BOXWORLD_STATS_COUNT(event) ::boxworld::record_stats_event(event)
+#else
+#define BOXWORLD_STATS_SCOPE(event) static_cast<void>(0)
+#define BOXWORLD_STATS_COUNT(event) static_cast<void>(0)
+#endif
+
+#endif    // BOXWORLD_STATS_H_
@@ -0,0 +1,39 @@
+#include "successors.h"
+
+namespace boxworld {
+
+SuccessorRange::SuccessorRange(const BoxWorldGameState& state, BoxWorldGameState& scratch, bool use_colour)
+    : scratch(&scratch), use_colour(use_colour), valid_mask(state.productive_actions_mask()) {
+    // Assigning reuses the buffers of the scratch state
+    scratch = state;
+}
+
+auto SuccessorRange::begin() noexcept -> Iterator {
+    Advance();
+    return Iterator(this);
+}
+
+auto SuccessorRange::end() noexcept -> Iterator {
+    return Iterator(nullptr);
+}
+
+void SuccessorRange::Advance() noexcept {
+    if (is_applied) {
+        scratch->undo_action(record);
+        is_applied = false;
+    }
+    for (; next_action < kNumActions; ++next_action) {
+        if ((valid_mask & (1U << next_action)) == 0) {
+            continue;
+        }
+        const auto action = static_cast<Action>(next_action);
+        record = scratch->apply_action_with_undo(action);
+        is_applied = true;
+        current = {action, scratch, scratch->get_hash(), scratch->get_reward_signal(use_colour)};
+        ++next_action;
+        return;
+    }
+    next_action = kNumActions + 1;
+}
+
+}    // namespace boxworld
@@ -0,0 +1,129 @@
+#ifndef BOXWORLD_SUCCESSORS_H_
+#define BOXWORLD_SUCCESSORS_H_
+
+#include <cstdint>
+#include <iterator>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+// Single pass range over the children of a state, generated one at a time in a scratch state.
+// Each child is made by applying its action to the scratch state and undone when the range advances, so no state is
+// copied per child and breaking out of the loop skips the children not yet reached.
+// @note The scratch state is reused across ranges, and only allocates when copying a larger level into it
+class SuccessorRange {
+public:
+    // Child of the state, valid until the range advances
+    struct Successor {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        Action action = Action::kUp;                // Action which generated the child
+        const BoxWorldGameState *state = nullptr;   // The child, held in the scratch state
+        uint64_t hash = 0;                          // Hash of the child
+        uint64_t reward_signal = 0;                 // Reward signal of the action
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Successor;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Successor *;
+        using reference = const Successor &;
+
+        [[nodiscard]] auto operator*() const noexcept -> reference {
+            return range->current;
+        }
+        [[nodiscard]] auto operator->() const noexcept -> pointer {
+            return &range->current;
+        }
+        auto operator++() noexcept -> Iterator & {
+            range->Advance();
+            return *this;
+        }
+        [[nodiscard]] auto operator==(const Iterator &other) const noexcept -> bool {
+            return is_end() == other.is_end();
+        }
+        [[nodiscard]] auto operator!=(const Iterator &other) const noexcept -> bool {
+            return !(*this == other);
+        }
+
+    private:
+        friend class SuccessorRange;
+        explicit Iterator(SuccessorRange *range) noexcept : range(range) {}
+        [[nodiscard]] auto is_end() const noexcept -> bool {
+            return range == nullptr || range->next_action > kNumActions;
+        }
+
+        SuccessorRange *range;
+    };
+
+    SuccessorRange() = delete;
+
+    /**
+     * Copy the state into the scratch state, without generating any child.
+     * @param state The state to generate the children of
+     * @param scratch State the children are generated in, left as the state once every child has been visited
+     * @param use_colour Flag if using colour collected reward signal, or index of key/lock collected if false
+     */
+    SuccessorRange(const BoxWorldGameState &state, BoxWorldGameState &scratch, bool use_colour = false);
+
+    SuccessorRange(const SuccessorRange &) = delete;
+    SuccessorRange(SuccessorRange &&) = delete;
+    auto operator=(const SuccessorRange &) -> SuccessorRange & = delete;
+    auto operator=(SuccessorRange &&) -> SuccessorRange & = delete;
+    ~SuccessorRange() = default;
+
+    /**
+     * Generate the first child, the child of the first action which changes the state.
+     * @note Call once, as the range is single pass
+     * @return Iterator to the first child
+     */
+    [[nodiscard]] auto begin() noexcept -> Iterator;
+
+    /**
+     * Get the iterator past the last child
+     * @return End iterator
+     */
+    [[nodiscard]] auto end() noexcept -> Iterator;
+
+private:
+    void Advance() noexcept;
+
+    BoxWorldGameState *scratch;
+    bool use_colour;
+    uint8_t valid_mask;              // Actions which change the state
+    std::size_t next_action = 0;     // Next action to try, kNumActions + 1 once past the last child
+    bool is_applied = false;         // Flag if record holds the child currently in the scratch state
+    UndoRecord record;
+    Successor current;
+};
+
+/**
+ * Get the children of a state, see SuccessorRange.
+ * @param state The state to generate the children of
+ * @param scratch State the children are generated in
+ * @param use_colour Flag if using colour collected reward signal, or index of key/lock collected if false
+ * @return Range over the children
+ */
+[[nodiscard]] inline auto successors(const BoxWorldGameState &state, BoxWorldGameState &scratch,
+                                     bool use_colour = false) -> SuccessorRange {
+    return {state, scratch, use_colour};
+}
+
+/**
+ * Check if the last action made the state a dead end, so nothing below it can be solved and it can be pruned.
+ * @note Only collecting a key or opening a lock, which gives a reward signal, can make one, so is_dead_end() is
+ * only checked after those actions
+ * @param state The state after the action
+ * @return True if the action led to a dead end, false otherwise
+ */
+[[nodiscard]] inline auto reached_dead_end(const BoxWorldGameState &state) noexcept -> bool {
+    return state.get_reward_signal() != 0 && state.is_dead_end();
+}
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_SUCCESSORS_H_
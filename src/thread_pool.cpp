@@ -0,0 +1,95 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace boxworld {
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+    : num_workers(num_threads == 0 ? std::max<std::size_t>(std::thread::hardware_concurrency(), 1) : num_threads) {
+    ranges = std::make_unique<ChunkRange[]>(num_workers);
+    threads.reserve(num_workers - 1);
+    for (std::size_t i = 1; i < num_workers; ++i) {
+        threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start_cv.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t n, std::size_t grain_size, const ChunkFunc& func) {
+    grain_size = std::max<std::size_t>(grain_size, 1);
+    const std::size_t num_chunks = (n + grain_size - 1) / grain_size;
+    if (num_workers == 1 || num_chunks <= 1) {
+        for (std::size_t begin = 0; begin < n; begin += grain_size) {
+            func(begin, std::min(begin + grain_size, n));
+        }
+        return;
+    }
+    // Contiguous ranges of chunks, so each thread starts on the same items every loop
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        ranges[i].next.store(i * num_chunks / num_workers, std::memory_order_relaxed);
+        ranges[i].end = (i + 1) * num_chunks / num_workers;
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        loop_func = &func;
+        loop_n = n;
+        loop_grain_size = grain_size;
+        num_pending = num_workers - 1;
+        ++generation;
+    }
+    start_cv.notify_all();
+    RunChunks(0);
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this]() { return num_pending == 0; });
+    loop_func = nullptr;
+}
+
+auto ThreadPool::num_threads() const noexcept -> std::size_t {
+    return num_workers;
+}
+
+void ThreadPool::WorkerLoop(std::size_t thread_index) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&]() { return stop || generation != seen_generation; });
+            if (stop) {
+                return;
+            }
+            seen_generation = generation;
+        }
+        RunChunks(thread_index);
+        bool is_last = false;
+        {
+            const std::lock_guard<std::mutex> lock(mutex);
+            is_last = --num_pending == 0;
+        }
+        if (is_last) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunChunks(std::size_t thread_index) noexcept {
+    const auto& func = *loop_func;
+    // Own range first, then steal from the following threads in turn
+    for (std::size_t offset = 0; offset < num_workers; ++offset) {
+        auto& range = ranges[(thread_index + offset) % num_workers];
+        for (auto chunk = range.next.fetch_add(1); chunk < range.end; chunk = range.next.fetch_add(1)) {
+            const auto begin = chunk * loop_grain_size;
+            func(begin, std::min(begin + loop_grain_size, loop_n));
+        }
+    }
+}
+
+}    // namespace boxworld
@@ -0,0 +1,76 @@
+#ifndef BOXWORLD_THREAD_POOL_H_
+#define BOXWORLD_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boxworld {
+
+// Persistent pool of worker threads for repeated parallel loops, avoiding the thread start up of parallel_for().
+// Each loop is split into chunks which are statically assigned to the threads in contiguous ranges, and threads
+// which finish their own range steal the remaining chunks of the others.
+class ThreadPool {
+public:
+    // Function run over each chunk [begin, end) of a loop, which must not throw
+    using ChunkFunc = std::function<void(std::size_t, std::size_t)>;
+
+    /**
+     * @param num_threads Number of threads including the calling thread, 0 to use the hardware concurrency
+     */
+    explicit ThreadPool(std::size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+    auto operator=(ThreadPool &&) -> ThreadPool & = delete;
+
+    /**
+     * Run func(begin, end) over chunks of [0, n) of grain_size items on the pool and the calling thread.
+     * Returns once all chunks are done. Not safe to call from multiple threads at once.
+     * @param n Number of items
+     * @param grain_size Number of items in each chunk, chunk c covers [c * grain_size, (c + 1) * grain_size)
+     * @param func Callable taking the begin and end index of its chunk
+     */
+    void parallel_for(std::size_t n, std::size_t grain_size, const ChunkFunc &func);
+
+    /**
+     * Get the number of threads, including the calling thread
+     * @return Count of threads
+     */
+    [[nodiscard]] auto num_threads() const noexcept -> std::size_t;
+
+private:
+    // Chunks assigned to a thread, padded so threads claiming chunks do not share cache lines
+    struct alignas(64) ChunkRange {
+        std::atomic<std::size_t> next{0};
+        std::size_t end = 0;
+    };
+
+    void WorkerLoop(std::size_t thread_index);
+    void RunChunks(std::size_t thread_index) noexcept;
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<ChunkRange[]> ranges;
+    std::size_t num_workers;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    uint64_t generation = 0;
+    std::size_t num_pending = 0;
+    bool stop = false;
+    // Current loop, only read by workers between the start and end of parallel_for()
+    const ChunkFunc *loop_func = nullptr;
+    std::size_t loop_n = 0;
+    std::size_t loop_grain_size = 1;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_THREAD_POOL_H_
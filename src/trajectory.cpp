@@ -0,0 +1,162 @@
+#include "trajectory.h"
+
+#include <nop/serializer.h>
+#include <nop/utility/buffer_reader.h>
+#include <nop/utility/buffer_writer.h>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "parallel.h"
+
+namespace boxworld {
+
+namespace {
+// Plans are of uneven length, so threads take small chunks as they finish
+constexpr std::size_t kPlanGrainSize = 16;
+}    // namespace
+
+auto serialize_trajectory(const Trajectory& trajectory) -> std::vector<uint8_t> {
+    std::vector<uint8_t> bytes(nop::Encoding<Trajectory>::Size(trajectory));
+    nop::Serializer<nop::BufferWriter> serializer{bytes.data(), bytes.size()};
+    if (!serializer.Write(trajectory)) {
+        throw std::invalid_argument("Unable to serialize trajectory.");
+    }
+    bytes.resize(serializer.writer().size());
+    return bytes;
+}
+
+auto deserialize_trajectory(const uint8_t* data, std::size_t size) -> Trajectory {
+    nop::Deserializer<nop::BufferReader> deserializer{data, size};
+    Trajectory trajectory;
+    if (!deserializer.Read(&trajectory)) {
+        throw std::invalid_argument("Unable to deserialize trajectory from bytes.");
+    }
+    return trajectory;
+}
+
+void write_trajectory(const std::string& path, const Trajectory& trajectory) {
+    const auto bytes = serialize_trajectory(trajectory);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Unable to open trajectory for writing: " + path);
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!file) {
+        throw std::runtime_error("Unable to write trajectory: " + path);
+    }
+}
+
+auto read_trajectory(const std::string& path) -> Trajectory {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open trajectory: " + path);
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return deserialize_trajectory(bytes.data(), bytes.size());
+}
+
+TrajectoryRecorder::TrajectoryRecorder(const BoxWorldGameState& start) {
+    trajectory.start_state = start.serialize();
+}
+
+void TrajectoryRecorder::record(Action action, const BoxWorldGameState& next_state) {
+    const auto signal_index = next_state.get_reward_signal(false);
+    const auto signal_colour = next_state.get_reward_signal(true);
+    if (signal_index != 0 || signal_colour != 0) {
+        trajectory.reward_events.push_back({static_cast<uint32_t>(trajectory.actions.size()),
+                                            static_cast<uint16_t>(signal_index), static_cast<uint8_t>(signal_colour)});
+    }
+    trajectory.actions.push_back(static_cast<uint8_t>(action));
+}
+
+auto TrajectoryRecorder::size() const noexcept -> std::size_t {
+    return trajectory.actions.size();
+}
+
+auto TrajectoryRecorder::get_trajectory() const noexcept -> const Trajectory& {
+    return trajectory;
+}
+
+TrajectoryReader::TrajectoryReader(Trajectory trajectory, std::size_t checkpoint_interval)
+    : trajectory(std::move(trajectory)), checkpoint_interval(checkpoint_interval) {
+    if (checkpoint_interval == 0) {
+        throw std::invalid_argument("Checkpoint interval must be positive.");
+    }
+    BoxWorldGameState state(this->trajectory.start_state);
+    checkpoints.push_back(state);
+    const auto& actions = this->trajectory.actions;
+    for (std::size_t step = 0; step < actions.size(); ++step) {
+        if (actions[step] >= kNumActions) {
+            throw std::invalid_argument("Trajectory has an unknown action.");
+        }
+        state.apply_action(static_cast<Action>(actions[step]));
+        if ((step + 1) % checkpoint_interval == 0) {
+            checkpoints.push_back(state);
+        }
+    }
+}
+
+auto TrajectoryReader::size() const noexcept -> std::size_t {
+    return trajectory.actions.size();
+}
+
+auto TrajectoryReader::get_action(std::size_t step) const -> Action {
+    return static_cast<Action>(trajectory.actions.at(step));
+}
+
+auto TrajectoryReader::get_state(std::size_t step) const -> BoxWorldGameState {
+    if (step > trajectory.actions.size()) {
+        throw std::out_of_range("Step is past the end of the trajectory.");
+    }
+    const auto checkpoint = step / checkpoint_interval;
+    auto state = checkpoints[checkpoint];
+    for (std::size_t i = checkpoint * checkpoint_interval; i < step; ++i) {
+        state.apply_action(static_cast<Action>(trajectory.actions[i]));
+    }
+    return state;
+}
+
+auto TrajectoryReader::get_reward_events() const noexcept -> const std::vector<RewardEvent>& {
+    return trajectory.reward_events;
+}
+
+void execute_plans(const std::vector<BoxWorldGameState>& levels, const std::vector<std::vector<Action>>& plans,
+                   std::vector<PlanResult>& out_results, std::size_t num_threads) {
+    if (levels.size() != plans.size()) {
+        throw std::invalid_argument("Need one level per plan.");
+    }
+    out_results.resize(plans.size());
+    parallel_for_dynamic(plans.size(), num_threads, kPlanGrainSize, [&](std::size_t begin, std::size_t end) {
+        // Copy assignment reuses the board of the scratch state
+        auto state = levels[begin];
+        for (std::size_t i = begin; i < end; ++i) {
+            state = levels[i];
+            auto& result = out_results[i];
+            result.reward_events.clear();
+            result.num_steps = 0;
+            for (const auto action : plans[i]) {
+                if (state.is_solution()) {
+                    break;
+                }
+                if (!BoxWorldGameState::is_valid_action(action)) {
+                    throw std::invalid_argument("Plan has an unknown action.");
+                }
+                state.apply_action(action);
+                const auto signal_index = state.get_reward_signal(false);
+                const auto signal_colour = state.get_reward_signal(true);
+                if (signal_index != 0 || signal_colour != 0) {
+                    result.reward_events.push_back({static_cast<uint32_t>(result.num_steps),
+                                                    static_cast<uint16_t>(signal_index),
+                                                    static_cast<uint8_t>(signal_colour)});
+                }
+                ++result.num_steps;
+            }
+            result.final_hash = state.get_hash();
+            result.solved = state.is_solution();
+        }
+    });
+}
+
+}    // namespace boxworld
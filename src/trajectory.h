@@ -0,0 +1,179 @@
+#ifndef BOXWORLD_TRAJECTORY_H_
+#define BOXWORLD_TRAJECTORY_H_
+
+#include <nop/structure.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+// Non-zero reward signal of an action within a trajectory
+struct RewardEvent {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint32_t step = 0;                // Index of the action which gave the signal
+    uint16_t signal_index = 0;        // get_reward_signal(false) after the action
+    uint8_t signal_colour = 0;        // get_reward_signal(true) after the action
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator==(const RewardEvent &other) const noexcept -> bool {
+        return step == other.step && signal_index == other.signal_index && signal_colour == other.signal_colour;
+    }
+    NOP_STRUCTURE(RewardEvent, step, signal_index, signal_colour);
+};
+
+// Compact record of an episode: the starting state once, then one byte per action and the reward signal events.
+// Any step is reconstructed by replaying the actions from the starting state.
+struct Trajectory {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::vector<uint8_t> start_state;           // BoxWorldGameState::serialize() of the starting state
+    std::vector<uint8_t> actions;               // Action applied at each step
+    std::vector<RewardEvent> reward_events;     // Steps with a non-zero reward signal, in order
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    NOP_STRUCTURE(Trajectory, start_state, actions, reward_events);
+};
+
+/**
+ * Serialize a trajectory into bytes.
+ * @param trajectory The trajectory to serialize
+ * @return The serialized bytes
+ */
+[[nodiscard]] auto serialize_trajectory(const Trajectory &trajectory) -> std::vector<uint8_t>;
+
+/**
+ * Deserialize a trajectory from bytes given by serialize_trajectory().
+ * @note Throws std::invalid_argument if the bytes are not a trajectory
+ * @param data Pointer to the start of the bytes
+ * @param size Number of bytes
+ * @return The trajectory
+ */
+[[nodiscard]] auto deserialize_trajectory(const uint8_t *data, std::size_t size) -> Trajectory;
+
+/**
+ * Write a trajectory to a file.
+ * @note Throws std::runtime_error if the file cannot be written
+ * @param path Path of the file
+ * @param trajectory The trajectory to write
+ */
+void write_trajectory(const std::string &path, const Trajectory &trajectory);
+
+/**
+ * Read a trajectory written by write_trajectory().
+ * @note Throws std::runtime_error if the file cannot be read, or std::invalid_argument if it is malformed
+ * @param path Path of the file
+ * @return The trajectory
+ */
+[[nodiscard]] auto read_trajectory(const std::string &path) -> Trajectory;
+
+// Records the actions applied to a state into a Trajectory.
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder() = delete;
+
+    /**
+     * @param start The state the trajectory starts from
+     */
+    explicit TrajectoryRecorder(const BoxWorldGameState &start);
+
+    /**
+     * Record an action applied to the state.
+     * @param action The action applied
+     * @param next_state The state after the action was applied, to read the reward signals from
+     */
+    void record(Action action, const BoxWorldGameState &next_state);
+
+    /**
+     * Get the number of actions recorded
+     * @return Count of actions
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the recorded trajectory
+     * @return Reference to the trajectory
+     */
+    [[nodiscard]] auto get_trajectory() const noexcept -> const Trajectory &;
+
+private:
+    Trajectory trajectory;
+};
+
+// Random access to the states of a Trajectory, replaying from the closest of the states checkpointed every
+// checkpoint_interval steps.
+class TrajectoryReader {
+public:
+    TrajectoryReader() = delete;
+
+    /**
+     * Replay the trajectory once to build the checkpoints.
+     * @note Throws std::invalid_argument if checkpoint_interval is 0 or the trajectory has an unknown action
+     * @param trajectory The trajectory to read
+     * @param checkpoint_interval Number of steps between checkpointed states
+     */
+    explicit TrajectoryReader(Trajectory trajectory, std::size_t checkpoint_interval = 64);
+
+    /**
+     * Get the number of actions in the trajectory
+     * @return Count of actions
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+    /**
+     * Get the action applied at the given step.
+     * @note Throws std::out_of_range if step is not less than size()
+     * @param step Index of the action
+     * @return The action
+     */
+    [[nodiscard]] auto get_action(std::size_t step) const -> Action;
+
+    /**
+     * Get the state after the given number of actions, 0 for the starting state.
+     * @note Throws std::out_of_range if step is more than size()
+     * @param step Number of actions applied
+     * @return The state
+     */
+    [[nodiscard]] auto get_state(std::size_t step) const -> BoxWorldGameState;
+
+    /**
+     * Get the reward signal events of the trajectory
+     * @return Events in order of their step
+     */
+    [[nodiscard]] auto get_reward_events() const noexcept -> const std::vector<RewardEvent> &;
+
+private:
+    Trajectory trajectory;
+    std::size_t checkpoint_interval;
+    std::vector<BoxWorldGameState> checkpoints;
+};
+
+// Outcome of a plan applied by execute_plans()
+struct PlanResult {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t final_hash = 0;                    // get_hash() of the state the plan ended in
+    bool solved = false;                        // Flag if the plan reached the solution
+    std::size_t num_steps = 0;                  // Actions applied, up to the one which reached the solution
+    std::vector<RewardEvent> reward_events;     // Steps with a non-zero reward signal, in order
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+/**
+ * Apply each plan to the state of its level, stopping at the end of the plan or once the solution is reached.
+ * Each thread copies the levels into a single scratch state, so no state is allocated per plan, and the reward
+ * event buffers of out_results are reused between calls.
+ * @note Throws std::invalid_argument if there is not one level per plan or a plan has an unknown action
+ * @param levels The state each plan starts from, such as from BoxWorldGameState::make_states()
+ * @param plans The actions of each plan
+ * @param out_results Resized to one result per plan, in order
+ * @param num_threads Number of threads to use, 0 to use the hardware concurrency
+ */
+void execute_plans(const std::vector<BoxWorldGameState> &levels, const std::vector<std::vector<Action>> &plans,
+                   std::vector<PlanResult> &out_results, std::size_t num_threads = 0);
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_TRAJECTORY_H_
@@ -0,0 +1,136 @@
+#include "transposition_table.h"
+
+#include <stdexcept>
+
+namespace boxworld {
+
+namespace {
+constexpr uint64_t kOccupiedBit = uint64_t{1} << 63;
+constexpr unsigned int kPriorityShift = 48;
+constexpr uint64_t kPriorityMask = 0x7FFF;
+
+constexpr auto pack_data(uint64_t value, uint16_t priority) noexcept -> uint64_t {
+    return kOccupiedBit | ((priority & kPriorityMask) << kPriorityShift) | (value & TranspositionTable::kMaxValue);
+}
+
+constexpr auto get_priority(uint64_t data) noexcept -> uint16_t {
+    return static_cast<uint16_t>((data >> kPriorityShift) & kPriorityMask);
+}
+}    // namespace
+
+TranspositionTable::TranspositionTable(std::size_t size_mb, ReplacementPolicy policy) : policy(policy) {
+    if (size_mb == 0) {
+        throw std::invalid_argument("Transposition table size must be positive.");
+    }
+    const std::size_t max_buckets = size_mb * 1024 * 1024 / sizeof(Bucket);
+    std::size_t num_buckets = 1;
+    while (num_buckets * 2 <= max_buckets) {
+        num_buckets *= 2;
+    }
+    buckets = std::vector<Bucket>(num_buckets);
+    bucket_mask = num_buckets - 1;
+}
+
+auto TranspositionTable::find(uint64_t key) const noexcept -> std::optional<Entry> {
+    const auto& bucket = buckets[BucketIndex(key)];
+    for (const auto& slot : bucket.slots) {
+        const auto data = slot.data.load(std::memory_order_relaxed);
+        if (data != 0 && (slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            return Entry{data & kMaxValue, get_priority(data)};
+        }
+    }
+    return std::nullopt;
+}
+
+auto TranspositionTable::insert(uint64_t key, uint64_t value, uint16_t priority) noexcept -> InsertResult {
+    return Insert<false>(key, value, priority);
+}
+
+auto TranspositionTable::insert_concurrent(uint64_t key, uint64_t value, uint16_t priority) noexcept
+    -> InsertResult {
+    return Insert<true>(key, value, priority);
+}
+
+template <bool kConcurrent>
+auto TranspositionTable::Insert(uint64_t key, uint64_t value, uint16_t priority) noexcept -> InsertResult {
+    auto& bucket = buckets[BucketIndex(key)];
+    const auto new_data = pack_data(value, priority);
+    // Writes the data before the check, so readers never match a key to another key's data.
+    // Concurrent writers claim the slot through the data word, and give up if another writer got there first.
+    const auto write_slot = [&](Slot& slot, uint64_t old_data) -> bool {
+        if constexpr (kConcurrent) {
+            if (!slot.data.compare_exchange_strong(old_data, new_data, std::memory_order_relaxed)) {
+                return false;
+            }
+        } else {
+            slot.data.store(new_data, std::memory_order_relaxed);
+        }
+        slot.check.store(key ^ new_data, std::memory_order_relaxed);
+        return true;
+    };
+
+    // Key already present
+    for (auto& slot : bucket.slots) {
+        const auto data = slot.data.load(std::memory_order_relaxed);
+        if (data != 0 && (slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+            if (policy == ReplacementPolicy::kKeep ||
+                (policy == ReplacementPolicy::kPriority && get_priority(new_data) < get_priority(data))) {
+                return InsertResult::kExists;
+            }
+            return write_slot(slot, data) ? InsertResult::kUpdated : InsertResult::kExists;
+        }
+    }
+
+    // Empty slot
+    for (auto& slot : bucket.slots) {
+        if (slot.data.load(std::memory_order_relaxed) == 0 && write_slot(slot, 0)) {
+            return InsertResult::kInserted;
+        }
+    }
+
+    // Replace the lowest priority entry
+    if (policy == ReplacementPolicy::kKeep) {
+        return InsertResult::kDropped;
+    }
+    Slot* victim = nullptr;
+    uint64_t victim_data = 0;
+    for (auto& slot : bucket.slots) {
+        const auto data = slot.data.load(std::memory_order_relaxed);
+        if (victim == nullptr || get_priority(data) < get_priority(victim_data)) {
+            victim = &slot;
+            victim_data = data;
+        }
+    }
+    if (policy == ReplacementPolicy::kPriority && get_priority(victim_data) > get_priority(new_data)) {
+        return InsertResult::kDropped;
+    }
+    return write_slot(*victim, victim_data) ? InsertResult::kInserted : InsertResult::kDropped;
+}
+
+void TranspositionTable::clear() noexcept {
+    for (auto& bucket : buckets) {
+        for (auto& slot : bucket.slots) {
+            slot.data.store(0, std::memory_order_relaxed);
+            slot.check.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+auto TranspositionTable::capacity() const noexcept -> std::size_t {
+    return buckets.size() * kBucketSize;
+}
+
+auto TranspositionTable::size_bytes() const noexcept -> std::size_t {
+    return buckets.size() * sizeof(Bucket);
+}
+
+auto TranspositionTable::get_policy() const noexcept -> ReplacementPolicy {
+    return policy;
+}
+
+auto TranspositionTable::BucketIndex(uint64_t key) const noexcept -> std::size_t {
+    // Zobrist hashes are uniform, so the low bits index the bucket directly
+    return static_cast<std::size_t>(key & bucket_mask);
+}
+
+}    // namespace boxworld
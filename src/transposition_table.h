@@ -0,0 +1,124 @@
+#ifndef BOXWORLD_TRANSPOSITION_TABLE_H_
+#define BOXWORLD_TRANSPOSITION_TABLE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace boxworld {
+
+// How an insert chooses the slot to overwrite when the bucket of the key is full
+enum class ReplacementPolicy {
+    kKeep,        // Never overwrite other keys, existing keys are left as is (BFS closed lists)
+    kPriority,    // Overwrite the lowest priority entry if not higher than the new one (MCTS node sharing)
+    kAlways,      // Always overwrite the lowest priority entry, keeping the most recent entries
+};
+
+// Result of inserting into the table
+enum class InsertResult {
+    kInserted,    // Key was not present and is now stored
+    kUpdated,     // Key was present and its entry was overwritten
+    kExists,      // Key was present and its entry was kept
+    kDropped,     // Key was not present and could not be stored
+};
+
+// Fixed size open addressing hash table from state hashes (BoxWorldGameState::get_hash()) to 48-bit values.
+// Each key maps to a single cache line bucket of kBucketSize entries, so lookups touch one cache line.
+// Entries are stored as (key ^ data, data) pairs, so find() and insert_concurrent() are lock-free and a torn
+// concurrent write is seen as a missing entry rather than a wrong value.
+class TranspositionTable {
+public:
+    // Entries in each bucket
+    static constexpr std::size_t kBucketSize = 4;
+    // Largest storable value
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << 48) - 1;
+
+    // Value stored for a key
+    struct Entry {
+        // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+        uint64_t value;       // Value of the key, at most kMaxValue
+        uint16_t priority;    // Priority used for replacement, such as search depth or visit count
+        // NOLINTEND(misc-non-private-member-variables-in-classes)
+    };
+
+    TranspositionTable() = delete;
+
+    /**
+     * @note Throws std::invalid_argument if size_mb is 0
+     * @param size_mb Size of the table in megabytes, rounded down to a power of two number of buckets
+     * @param policy Replacement policy used by insertions
+     */
+    TranspositionTable(std::size_t size_mb, ReplacementPolicy policy);
+
+    /**
+     * Find the entry of the given key.
+     * @param key Hash of the state
+     * @return The entry if present
+     */
+    [[nodiscard]] auto find(uint64_t key) const noexcept -> std::optional<Entry>;
+
+    /**
+     * Insert an entry from a single writer thread, concurrent with any number of find() calls.
+     * @param key Hash of the state
+     * @param value Value to store, at most kMaxValue
+     * @param priority Priority used for replacement, at most 32767
+     * @return Result of the insert
+     */
+    auto insert(uint64_t key, uint64_t value, uint16_t priority = 0) noexcept -> InsertResult;
+
+    /**
+     * Insert an entry, safe to call from multiple threads at once.
+     * @note Racing inserts of the same new key can each report kInserted, so a key may be expanded twice
+     * @param key Hash of the state
+     * @param value Value to store, at most kMaxValue
+     * @param priority Priority used for replacement, at most 32767
+     * @return Result of the insert
+     */
+    auto insert_concurrent(uint64_t key, uint64_t value, uint16_t priority = 0) noexcept -> InsertResult;
+
+    /**
+     * Remove all entries, not safe to call concurrently with other methods.
+     */
+    void clear() noexcept;
+
+    /**
+     * Get the number of entries the table can hold
+     * @return Count of entries
+     */
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    /**
+     * Get the memory used by the entries
+     * @return Size in bytes
+     */
+    [[nodiscard]] auto size_bytes() const noexcept -> std::size_t;
+
+    /**
+     * Get the replacement policy used by insertions
+     * @return The policy
+     */
+    [[nodiscard]] auto get_policy() const noexcept -> ReplacementPolicy;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check{0};    // key ^ data
+        std::atomic<uint64_t> data{0};     // occupied bit | priority | value, 0 if empty
+    };
+    struct alignas(64) Bucket {
+        std::array<Slot, kBucketSize> slots;
+    };
+
+    template <bool kConcurrent>
+    auto Insert(uint64_t key, uint64_t value, uint16_t priority) noexcept -> InsertResult;
+    [[nodiscard]] auto BucketIndex(uint64_t key) const noexcept -> std::size_t;
+
+    std::vector<Bucket> buckets;
+    uint64_t bucket_mask = 0;
+    ReplacementPolicy policy;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_TRANSPOSITION_TABLE_H_
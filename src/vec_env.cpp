@@ -0,0 +1,258 @@
+#include "vec_env.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "successors.h"
+#include "thread_pool.h"
+
+namespace boxworld {
+
+BoxWorldVecEnv::BoxWorldVecEnv(const GameParameters& params, std::size_t num_envs) {
+    if (num_envs == 0) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    // Copies share the same parsed level
+    states.reserve(num_envs);
+    states.emplace_back(params);
+    for (std::size_t i = 1; i < num_envs; ++i) {
+        states.push_back(states.front());
+    }
+    InitShape();
+}
+
+BoxWorldVecEnv::BoxWorldVecEnv(const std::vector<GameParameters>& params_list) {
+    if (params_list.empty()) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    states.reserve(params_list.size());
+    for (const auto& params : params_list) {
+        states.emplace_back(params);
+    }
+    InitShape();
+}
+
+BoxWorldVecEnv::BoxWorldVecEnv(const std::vector<GameParameters>& params_list, std::size_t max_rows,
+                               std::size_t max_cols)
+    : padded_rows(max_rows), padded_cols(max_cols) {
+    if (params_list.empty()) {
+        throw std::invalid_argument("Number of environments must be positive.");
+    }
+    if (max_rows == 0 || max_cols == 0) {
+        throw std::invalid_argument("Padded shape must be positive.");
+    }
+    states.reserve(params_list.size());
+    for (const auto& params : params_list) {
+        states.emplace_back(params);
+    }
+    InitShape();
+}
+
+BoxWorldVecEnv::~BoxWorldVecEnv() = default;
+BoxWorldVecEnv::BoxWorldVecEnv(BoxWorldVecEnv&&) noexcept = default;
+auto BoxWorldVecEnv::operator=(BoxWorldVecEnv&&) noexcept -> BoxWorldVecEnv& = default;
+
+void BoxWorldVecEnv::InitShape() {
+    const auto shape = states.front().observation_shape();
+    for (const auto& state : states) {
+        const auto state_shape = state.observation_shape();
+        if (is_padded() ? state_shape[2] > padded_rows || state_shape[1] > padded_cols : state_shape != shape) {
+            throw std::invalid_argument(is_padded() ? "All environments must fit in the padded board dimensions."
+                                                    : "All environments must have the same board dimensions.");
+        }
+    }
+    const auto config_shape = observation_shape();
+    obs_size = config_shape[0] * config_shape[1] * config_shape[2];
+}
+
+void BoxWorldVecEnv::WriteObservation(std::size_t index, float* obs) const {
+    const auto& state = states[index];
+    if (!is_padded()) {
+        state.get_observation(obs_config, obs);
+        return;
+    }
+    // Write the observation at its own size, then copy it row by row into the padded buffer
+    const auto shape = state.observation_shape();
+    const auto rows = shape[2];
+    const auto cols = shape[1];
+    const auto num_channels = obs_config.num_channels();
+    thread_local std::vector<float> native_obs;
+    native_obs.resize(num_channels * rows * cols);
+    state.get_observation(obs_config, native_obs.data());
+    std::fill_n(obs, obs_size, 0.0F);
+    if (obs_config.layout == ObservationLayout::kCHW) {
+        const auto plane_size = padded_rows * padded_cols;
+        for (std::size_t channel = 0; channel < num_channels; ++channel) {
+            for (std::size_t row = 0; row < rows; ++row) {
+                std::copy_n(native_obs.data() + (channel * rows + row) * cols, cols,
+                            obs + channel * plane_size + row * padded_cols);
+            }
+        }
+        for (std::size_t row = 0; row < rows; ++row) {
+            std::fill_n(obs + num_channels * plane_size + row * padded_cols, cols, 1.0F);
+        }
+        return;
+    }
+    for (std::size_t row = 0; row < rows; ++row) {
+        for (std::size_t col = 0; col < cols; ++col) {
+            float* cell = obs + (row * padded_cols + col) * (num_channels + 1);
+            std::copy_n(native_obs.data() + (row * cols + col) * num_channels, num_channels, cell);
+            cell[num_channels] = 1.0F;
+        }
+    }
+}
+
+void BoxWorldVecEnv::set_num_threads(std::size_t num_threads) {
+    thread_pool = num_threads == 1 ? nullptr : std::make_unique<ThreadPool>(num_threads);
+}
+
+auto BoxWorldVecEnv::num_threads() const noexcept -> std::size_t {
+    return thread_pool == nullptr ? 1 : thread_pool->num_threads();
+}
+
+void BoxWorldVecEnv::set_observation_config(const ObservationConfig& config) {
+    for (const auto& el : config.board_channels) {
+        if (!BoxWorldGameState::is_valid_element(el) || el == Element::kEmpty) {
+            throw std::invalid_argument("Observation channels must be non-empty elements.");
+        }
+    }
+    obs_config = config;
+    InitShape();
+}
+
+void BoxWorldVecEnv::set_terminate_dead_ends(bool terminate) noexcept {
+    terminate_dead_ends = terminate;
+}
+
+auto BoxWorldVecEnv::get_terminate_dead_ends() const noexcept -> bool {
+    return terminate_dead_ends;
+}
+
+auto BoxWorldVecEnv::get_observation_config() const noexcept -> const ObservationConfig& {
+    return obs_config;
+}
+
+template <typename Func>
+void BoxWorldVecEnv::ForEachEnv(Func&& func) const {
+    if (thread_pool == nullptr) {
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            func(i);
+        }
+        return;
+    }
+    // Several chunks per thread, so threads which finish early have chunks to steal
+    constexpr std::size_t kChunksPerThread = 4;
+    const auto grain_size = std::max<std::size_t>(states.size() / (thread_pool->num_threads() * kChunksPerThread), 1);
+    thread_pool->parallel_for(states.size(), grain_size, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            func(i);
+        }
+    });
+}
+
+auto BoxWorldVecEnv::num_envs() const noexcept -> std::size_t {
+    return states.size();
+}
+
+auto BoxWorldVecEnv::is_padded() const noexcept -> bool {
+    return padded_rows != 0;
+}
+
+auto BoxWorldVecEnv::observation_shape() const noexcept -> std::array<std::size_t, 3> {
+    if (!is_padded()) {
+        return states.front().observation_shape(obs_config);
+    }
+    // Same order of the dimensions as BoxWorldGameState::observation_shape()
+    const auto num_channels = obs_config.num_channels() + 1;
+    if (obs_config.layout == ObservationLayout::kHWC) {
+        return {padded_cols, padded_rows, num_channels};
+    }
+    return {num_channels, padded_cols, padded_rows};
+}
+
+auto BoxWorldVecEnv::observation_size() const noexcept -> std::size_t {
+    return obs_size;
+}
+
+void BoxWorldVecEnv::reset(float* obs) {
+    ForEachEnv([&](std::size_t i) {
+        states[i].reset();
+        if (obs != nullptr) {
+            WriteObservation(i, obs + i * obs_size);
+        }
+    });
+}
+
+void BoxWorldVecEnv::step(const Action* actions, float* obs, uint64_t* reward_signals, uint8_t* dones,
+                          bool use_colour) {
+    // Each environment only writes its own slots of the buffers, so the results do not depend on the threads
+    ForEachEnv([&](std::size_t i) {
+        auto& state = states[i];
+        state.apply_action(actions[i]);
+        if (reward_signals != nullptr) {
+            reward_signals[i] = state.get_reward_signal(use_colour);
+        }
+        auto done = state.is_solution() ? kDoneSolved : kNotDone;
+        if (done == kNotDone && terminate_dead_ends && reached_dead_end(state)) {
+            done = kDoneDeadEnd;
+        }
+        if (dones != nullptr) {
+            dones[i] = done;
+        }
+        if (done != kNotDone) {
+            state.reset();
+        }
+        if (obs != nullptr) {
+            WriteObservation(i, obs + i * obs_size);
+        }
+    });
+}
+
+void BoxWorldVecEnv::get_action_masks(uint8_t* masks) const noexcept {
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        masks[i] = states[i].productive_actions_mask();
+    }
+}
+
+void BoxWorldVecEnv::get_inventories(float* inventories) const noexcept {
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        states[i].get_inventory_one_hot(inventories + i * kNumColours);
+    }
+}
+
+auto BoxWorldVecEnv::image_shape() const noexcept -> std::array<std::size_t, 3> {
+    const auto shape = states.front().image_shape();
+    if (!is_padded()) {
+        return shape;
+    }
+    // Images have a sprite per cell of the board and of its border
+    const auto sprite_size = shape[0] / (states.front().observation_shape()[2] + 2);
+    return {(padded_rows + 2) * sprite_size, (padded_cols + 2) * sprite_size, shape[2]};
+}
+
+void BoxWorldVecEnv::render(uint8_t* imgs) const {
+    const auto shape = image_shape();
+    const auto img_size = shape[0] * shape[1] * shape[2];
+    if (!is_padded()) {
+        ForEachEnv([&](std::size_t i) { states[i].to_image(imgs + i * img_size); });
+        return;
+    }
+    ForEachEnv([&](std::size_t i) {
+        const auto native_shape = states[i].image_shape();
+        const auto row_size = native_shape[1] * native_shape[2];
+        thread_local std::vector<uint8_t> native_img;
+        native_img.resize(native_shape[0] * row_size);
+        states[i].to_image(native_img.data());
+        uint8_t* img = imgs + i * img_size;
+        std::fill_n(img, img_size, uint8_t{0});
+        for (std::size_t row = 0; row < native_shape[0]; ++row) {
+            std::copy_n(native_img.data() + row * row_size, row_size, img + row * shape[1] * shape[2]);
+        }
+    });
+}
+
+auto BoxWorldVecEnv::get_state(std::size_t index) const -> const BoxWorldGameState& {
+    return states.at(index);
+}
+
+}    // namespace boxworld
@@ -0,0 +1,198 @@
+#ifndef BOXWORLD_VEC_ENV_H_
+#define BOXWORLD_VEC_ENV_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "boxworld_base.h"
+#include "definitions.h"
+
+namespace boxworld {
+
+class ThreadPool;
+
+// Values written to the dones buffer of BoxWorldVecEnv::step()
+constexpr uint8_t kNotDone = 0;        // Episode continues
+constexpr uint8_t kDoneSolved = 1;     // Episode solved, and the environment reset
+constexpr uint8_t kDoneDeadEnd = 2;    // Episode reached a dead end, and the environment reset
+
+// Batch of environments stepped together, writing results into caller owned contiguous buffers.
+// All environments must have the same board dimensions so observations can be batched, unless constructed with a
+// padded shape, in which case each environment keeps its own board and observations are padded to the shape.
+// Environments can be stepped in parallel on a persistent thread pool, with results identical for any thread count.
+// Environments are stored as an array of full BoxWorldGameState rather than separate arrays of boards, agent indices,
+// inventories and hashes, so stepping reuses apply_action(), dead end detection, auto-reset and get_state() unchanged,
+// and environments of the same level keep sharing it. The cost is one heap board and index sets per environment, so
+// stepping touches a few scattered allocations per environment instead of streaming through contiguous arrays.
+class BoxWorldVecEnv {
+public:
+    BoxWorldVecEnv() = delete;
+    ~BoxWorldVecEnv();
+
+    BoxWorldVecEnv(const BoxWorldVecEnv &) = delete;
+    BoxWorldVecEnv(BoxWorldVecEnv &&) noexcept;
+    auto operator=(const BoxWorldVecEnv &) -> BoxWorldVecEnv & = delete;
+    auto operator=(BoxWorldVecEnv &&) noexcept -> BoxWorldVecEnv &;
+
+    /**
+     * Construct num_envs copies of the environment given by the GameParameters.
+     * @param params The game parameters shared by each environment
+     * @param num_envs Number of environments in the batch
+     */
+    BoxWorldVecEnv(const GameParameters &params, std::size_t num_envs);
+
+    /**
+     * Construct one environment for each of the given GameParameters.
+     * @param params_list The game parameters for each environment, all of the same board dimensions
+     */
+    BoxWorldVecEnv(const std::vector<GameParameters> &params_list);
+
+    /**
+     * Construct one environment for each of the given GameParameters, of mixed board dimensions.
+     * Observations and images are padded to max_rows x max_cols with zeros, and observations gain a last channel
+     * which is 1 over the cells of the environment board and 0 over the padding.
+     * @note Throws std::invalid_argument if a board is larger than max_rows x max_cols
+     * @param params_list The game parameters for each environment
+     * @param max_rows Rows every observation is padded to
+     * @param max_cols Cols every observation is padded to
+     */
+    BoxWorldVecEnv(const std::vector<GameParameters> &params_list, std::size_t max_rows, std::size_t max_cols);
+
+    /**
+     * Get the number of environments in the batch
+     * @return Count of environments
+     */
+    [[nodiscard]] auto num_envs() const noexcept -> std::size_t;
+
+    /**
+     * Set the number of threads reset() and step() split the environments across.
+     * Each thread starts on a fixed contiguous share of the environments, and steals from the others when done.
+     * @param num_threads Number of threads including the calling thread, 0 to use the hardware concurrency
+     */
+    void set_num_threads(std::size_t num_threads);
+
+    /**
+     * Get the number of threads reset() and step() split the environments across
+     * @return Count of threads, 1 if stepping serially
+     */
+    [[nodiscard]] auto num_threads() const noexcept -> std::size_t;
+
+    /**
+     * Set the channels and layout of the observations written by reset() and step().
+     * @note Throws std::invalid_argument if a board channel is kEmpty or not an element
+     * @param config Channels and layout of the observation
+     */
+    void set_observation_config(const ObservationConfig &config);
+
+    /**
+     * Get the channels and layout of the observations written by reset() and step()
+     * @return The observation config
+     */
+    [[nodiscard]] auto get_observation_config() const noexcept -> const ObservationConfig &;
+
+    /**
+     * Set if step() ends episodes which reach a dead end, see BoxWorldGameState::is_dead_end().
+     * Ended environments are reset as if solved, with kDoneDeadEnd written to their dones slot.
+     * @param terminate Flag to end dead end episodes, off by default
+     */
+    void set_terminate_dead_ends(bool terminate) noexcept;
+
+    /**
+     * Get if step() ends episodes which reach a dead end
+     * @return True if dead end episodes are ended, false otherwise
+     */
+    [[nodiscard]] auto get_terminate_dead_ends() const noexcept -> bool;
+
+    /**
+     * Check if observations are padded to a shape, so the environments may have mixed board dimensions
+     * @return True if constructed with a padded shape, false otherwise
+     */
+    [[nodiscard]] auto is_padded() const noexcept -> bool;
+
+    /**
+     * Get the shape a single environment observation should be viewed as.
+     * When padded, the shape is that of the padded board and includes the validity mask channel.
+     * @return array indicating observation CHW, or HWC if set by the observation config
+     */
+    [[nodiscard]] auto observation_shape() const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Get the number of values in a single environment observation.
+     * @return Flat observation size for one environment
+     */
+    [[nodiscard]] auto observation_size() const noexcept -> std::size_t;
+
+    /**
+     * Reset every environment, and write the starting observations.
+     * @param obs Buffer of num_envs() * observation_size() values to write the observations into, or nullptr to skip
+     */
+    void reset(float *obs = nullptr);
+
+    /**
+     * Apply one action to each environment, and write the results into the given buffers.
+     * Environments which reach the solution are reset, and the observation written is that of the reset state.
+     * If set_terminate_dead_ends() is on, environments which reach a dead end are reset in the same way.
+     * @param actions Buffer of num_envs() actions, one per environment
+     * @param obs Buffer of num_envs() * observation_size() values to write the observations into, or nullptr to skip
+     * @param reward_signals Buffer of num_envs() reward signals for the applied action, or nullptr to skip
+     * @param dones Buffer of num_envs() flags set to kDoneSolved if the environment was solved (and reset),
+     * kDoneDeadEnd if it reached a dead end (and was reset), else kNotDone, or nullptr to skip
+     * @param use_colour Flag if using colour collected signal, or index of key/lock collected if false
+     */
+    void step(const Action *actions, float *obs = nullptr, uint64_t *reward_signals = nullptr,
+              uint8_t *dones = nullptr, bool use_colour = false);
+
+    /**
+     * Write the action mask of each environment, see BoxWorldGameState::productive_actions_mask().
+     * @param masks Buffer of num_envs() masks to write into
+     */
+    void get_action_masks(uint8_t *masks) const noexcept;
+
+    /**
+     * Write the held key of each environment as a one-hot vector, see BoxWorldGameState::get_inventory_one_hot().
+     * Used as the side output of the inventory when the observation config drops the inventory planes.
+     * @param inventories Buffer of num_envs() * kNumColours values to write into
+     */
+    void get_inventories(float *inventories) const noexcept;
+
+    /**
+     * Get the shape each environment image should be viewed as, see BoxWorldGameState::image_shape().
+     * When padded, the shape is that of an image of the padded board, with the padding black as the border.
+     * @return array indicating image HWC
+     */
+    [[nodiscard]] auto image_shape() const noexcept -> std::array<std::size_t, 3>;
+
+    /**
+     * Write the image of each environment into one buffer, viewed as [num_envs(), H, W, C], see
+     * BoxWorldGameState::to_image(). Environments are rendered in parallel on the thread pool of step().
+     * @param imgs Buffer of num_envs() images of image_shape() bytes to write into
+     */
+    void render(uint8_t *imgs) const;
+
+    /**
+     * Get the environment at the given index
+     * @param index Index of the environment in the batch
+     * @return Reference to the environment state
+     */
+    [[nodiscard]] auto get_state(std::size_t index) const -> const BoxWorldGameState &;
+
+private:
+    void InitShape();
+    void WriteObservation(std::size_t index, float *obs) const;
+    template <typename Func>
+    void ForEachEnv(Func &&func) const;
+
+    std::vector<BoxWorldGameState> states;    // Array of states rather than of fields, see the class comment
+    ObservationConfig obs_config;
+    std::size_t obs_size = 0;
+    std::size_t padded_rows = 0;    // Rows observations are padded to, 0 if not padded
+    std::size_t padded_cols = 0;    // Cols observations are padded to, 0 if not padded
+    bool terminate_dead_ends = false;
+    std::unique_ptr<ThreadPool> thread_pool;
+};
+
+}    // namespace boxworld
+
+#endif    // BOXWORLD_VEC_ENV_H_
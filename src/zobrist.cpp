@@ -0,0 +1,72 @@
+#include "zobrist.h"
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "rng.h"
+
+namespace boxworld {
+
+auto make_zobrist_table(std::size_t rows, std::size_t cols) -> ZobristTable {
+    const auto cells = rows * cols;
+    ZobristTable table;
+    table.board.resize(kNumElements * cells);
+    SplitMix64 board_rng(cells);
+    for (auto& value : table.board) {
+        value = board_rng();
+    }
+    SplitMix64 inventory_rng(~static_cast<uint64_t>(cells));
+    for (auto& value : table.inventory) {
+        value = inventory_rng();
+    }
+#ifdef BOXWORLD_HASH128
+    // High tables continue the same streams, so the low tables are unchanged
+    table.board_high.resize(kNumElements * cells);
+    for (auto& value : table.board_high) {
+        value = board_rng();
+    }
+    for (auto& value : table.inventory_high) {
+        value = inventory_rng();
+    }
+#endif
+    return table;
+}
+
+namespace {
+struct ZobristCache {
+    std::mutex mutex;
+    std::map<std::pair<std::size_t, std::size_t>, std::shared_ptr<const ZobristTable>> tables;
+};
+
+auto get_cache() -> ZobristCache& {
+    static ZobristCache cache;
+    return cache;
+}
+}    // namespace
+
+auto get_zobrist_table(std::size_t rows, std::size_t cols) -> std::shared_ptr<const ZobristTable> {
+    auto& cache = get_cache();
+    const std::lock_guard<std::mutex> lock(cache.mutex);
+    auto& table = cache.tables[{rows, cols}];
+    if (table == nullptr) {
+        table = std::make_shared<const ZobristTable>(make_zobrist_table(rows, cols));
+    }
+    return table;
+}
+
+auto get_zobrist_cache_usage() -> MemoryGauge {
+    auto& cache = get_cache();
+    const std::lock_guard<std::mutex> lock(cache.mutex);
+    MemoryGauge gauge;
+    for (const auto& [size, table] : cache.tables) {
+        ++gauge.count;
+        gauge.bytes += sizeof(*table) + heap_bytes(table->board);
+#ifdef BOXWORLD_HASH128
+        gauge.bytes += heap_bytes(table->board_high);
+#endif
+    }
+    return gauge;
+}
+
+}    // namespace boxworld
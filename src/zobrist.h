@@ -0,0 +1,81 @@
+#ifndef BOXWORLD_ZOBRIST_H_
+#define BOXWORLD_ZOBRIST_H_
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "definitions.h"
+#include "stats.h"
+
+namespace boxworld {
+
+// Zobrist hashing tables for a board size, shared by every level of that size.
+// The high tables are only generated when built with the BOXWORLD_HASH128 CMake option.
+struct ZobristTable {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    std::vector<uint64_t> board;                           // Value per (element, cell), at element * cells + cell
+    std::array<uint64_t, kNumColours> inventory{};         // Value per held key colour
+#ifdef BOXWORLD_HASH128
+    std::vector<uint64_t> board_high;                      // Independent values of board, for Hash128::high
+    std::array<uint64_t, kNumColours> inventory_high{};    // Independent values of inventory, for Hash128::high
+#endif
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+};
+
+// 128-bit Zobrist hash, whose low half is the 64-bit hash.
+// Maintained by BoxWorldGameState when built with the BOXWORLD_HASH128 CMake option, see get_hash128().
+struct Hash128 {
+    // NOLINTBEGIN(misc-non-private-member-variables-in-classes)
+    uint64_t low = 0;     // Hash from the board and inventory tables
+    uint64_t high = 0;    // Hash from the board_high and inventory_high tables
+    // NOLINTEND(misc-non-private-member-variables-in-classes)
+
+    auto operator==(const Hash128 &other) const noexcept -> bool {
+        return low == other.low && high == other.high;
+    }
+    auto operator!=(const Hash128 &other) const noexcept -> bool {
+        return !(*this == other);
+    }
+};
+
+/**
+ * Generate the Zobrist tables for a board size with SplitMix64, seeded by the number of cells.
+ * The values match those of FixedBoxWorld for the same board size, so their hashes are comparable.
+ * @param rows Rows of the board
+ * @param cols Cols of the board
+ * @return The generated tables
+ */
+[[nodiscard]] auto make_zobrist_table(std::size_t rows, std::size_t cols) -> ZobristTable;
+
+/**
+ * Get the Zobrist tables for a board size from the process wide cache, generating them on first use.
+ * @note Safe to call from multiple threads
+ * @param rows Rows of the board
+ * @param cols Cols of the board
+ * @return Read only tables, kept alive by the cache for the lifetime of the process
+ */
+[[nodiscard]] auto get_zobrist_table(std::size_t rows, std::size_t cols) -> std::shared_ptr<const ZobristTable>;
+
+/**
+ * Get the memory held by the process wide cache of get_zobrist_table().
+ * @note Safe to call from multiple threads
+ * @return Number of cached tables and the bytes they hold
+ */
+[[nodiscard]] auto get_zobrist_cache_usage() -> MemoryGauge;
+
+}    // namespace boxworld
+
+namespace std {
+template <>
+struct hash<boxworld::Hash128> {
+    auto operator()(const boxworld::Hash128 &hash) const noexcept -> std::size_t {
+        // Both halves are already uniformly distributed
+        return static_cast<std::size_t>(hash.low ^ hash.high);
+    }
+};
+}    // namespace std
+
+#endif    // BOXWORLD_ZOBRIST_H_
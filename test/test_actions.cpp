@@ -0,0 +1,69 @@
+#include <boxworld/boxworld.h>
+
+#include <bitset>
+#include <iostream>
+#include <random>
+
+using namespace boxworld;
+
+namespace {
+// Mask of the actions which change the state hash, found by applying each action
+auto probe_mask(const BoxWorldGameState& state) -> uint8_t {
+    uint8_t mask = 0;
+    for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+        auto child = state;
+        child.apply_action(action);
+        if (child.get_hash() != state.get_hash()) {
+            mask |= static_cast<uint8_t>(1 << static_cast<int>(action));
+        }
+    }
+    return mask;
+}
+}    // namespace
+
+auto test_productive_actions() -> bool {
+    std::mt19937 rng(0);
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 8; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        for (int step = 0; step < 500 && !state.is_solution(); ++step) {
+            const auto mask = state.productive_actions_mask();
+            const auto actions = state.productive_actions();
+            if (mask != probe_mask(state) || actions.size() != std::bitset<kNumActions>(mask).count()) {
+                std::cout << "productive actions error." << std::endl;
+                return false;
+            }
+            for (const auto& action : actions) {
+                if ((mask & (1 << static_cast<int>(action))) == 0) {
+                    std::cout << "productive actions mask error." << std::endl;
+                    return false;
+                }
+            }
+            state.apply_action(BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions]);
+        }
+    }
+    return true;
+}
+
+auto test_vec_env_action_masks() -> bool {
+    constexpr std::size_t num_envs = 2;
+    BoxWorldVecEnv vec_env(kDefaultGameParams, num_envs);
+    const std::vector<Action> actions{Action::kUp, Action::kDown};
+    vec_env.step(actions.data());
+    std::vector<uint8_t> masks(num_envs);
+    vec_env.get_action_masks(masks.data());
+    for (std::size_t i = 0; i < num_envs; ++i) {
+        if (masks[i] != vec_env.get_state(i).productive_actions_mask()) {
+            std::cout << "vec env action masks error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_productive_actions() && ok;
+    ok = test_vec_env_action_masks() && ok;
+    return ok ? 0 : 1;
+}
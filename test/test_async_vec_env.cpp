@@ -0,0 +1,68 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+// Async steps match synchronous steps, and each result stays valid while the next step runs
+auto test_async_vec_env() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    constexpr std::size_t num_envs = 5;
+    constexpr std::size_t num_steps = 40;
+
+    BoxWorldVecEnv sync_env(params, num_envs);
+    AsyncVecEnv async_env(BoxWorldVecEnv(params, num_envs));
+    const auto obs_size = num_envs * sync_env.observation_size();
+    std::vector<float> obs(obs_size);
+    std::vector<uint64_t> rewards(num_envs);
+    std::vector<uint8_t> dones(num_envs);
+    sync_env.reset(obs.data());
+    auto result = async_env.reset();
+    if (!std::equal(obs.begin(), obs.end(), result.obs)) {
+        std::cout << "async vec env reset error." << std::endl;
+        return false;
+    }
+
+    std::vector<float> prev_obs(obs);
+    std::vector<Action> actions(num_envs);
+    for (std::size_t step = 0; step < num_steps; ++step) {
+        for (std::size_t i = 0; i < num_envs; ++i) {
+            actions[i] = static_cast<Action>((i + step * step) % kNumActions);
+        }
+        async_env.step_async(actions.data());
+        // Previous results are untouched by the step in progress
+        if (!std::equal(prev_obs.begin(), prev_obs.end(), result.obs)) {
+            std::cout << "async vec env double buffer error." << std::endl;
+            return false;
+        }
+        sync_env.step(actions.data(), obs.data(), rewards.data(), dones.data());
+        result = async_env.step_wait();
+        if (!std::equal(obs.begin(), obs.end(), result.obs) ||
+            !std::equal(rewards.begin(), rewards.end(), result.reward_signals) ||
+            !std::equal(dones.begin(), dones.end(), result.dones)) {
+            std::cout << "async vec env step error." << std::endl;
+            return false;
+        }
+        prev_obs = obs;
+    }
+
+    try {
+        async_env.step_async(actions.data());
+        async_env.step_async(actions.data());
+    } catch (const std::invalid_argument &) {
+        async_env.step_wait();
+        return true;
+    }
+    std::cout << "async vec env pending step error." << std::endl;
+    return false;
+}
+
+int main() {
+    return test_async_vec_env() ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+
+auto random_permutation(std::mt19937 &rng) -> ColourPermutation {
+    ColourPermutation permutation{};
+    for (std::size_t colour = 0; colour < permutation.size(); ++colour) {
+        permutation[colour] = static_cast<Element>(colour);
+    }
+    std::shuffle(permutation.begin(), permutation.end(), rng);
+    return permutation;
+}
+
+auto permuted_level(Level level, const ColourPermutation &permutation) -> Level {
+    for (auto &el : level.board) {
+        if (static_cast<std::size_t>(el) < permutation.size()) {
+            el = permutation[static_cast<std::size_t>(el)];
+        }
+    }
+    return level;
+}
+
+auto flipped_level(Level level) -> Level {
+    for (std::size_t row = 0; row < level.rows / 2; ++row) {
+        for (std::size_t col = 0; col < level.cols; ++col) {
+            std::swap(level.board[row * level.cols + col], level.board[(level.rows - 1 - row) * level.cols + col]);
+        }
+    }
+    return level;
+}
+
+// Action which moves to the mirrored cell of the action on the flipped board
+auto flipped_action(Action action) -> Action {
+    if (action == Action::kUp) {
+        return Action::kDown;
+    }
+    return action == Action::kDown ? Action::kUp : action;
+}
+
+auto is_same_state(const BoxWorldGameState &state, const BoxWorldGameState &expected) -> bool {
+    return state == expected && state.get_hash() == expected.get_hash() &&
+           state.get_key_indices() == expected.get_key_indices() &&
+           state.get_lock_indices() == expected.get_lock_indices() &&
+           state.get_reward_signal(true) == expected.get_reward_signal(true) &&
+           state.get_reward_signal(false) == expected.get_reward_signal(false) &&
+           state.get_remaining_chain_length() == expected.get_remaining_chain_length() &&
+           state.is_same_level(expected);
+}
+
+}    // namespace
+
+// Augmenting part way through a walk matches building the augmented level and walking to the same cells
+auto test_augment_state() -> bool {
+    std::mt19937 rng(0);
+    for (const bool collect_first_key : {false, true}) {
+        for (uint64_t seed = 0; seed < 8; ++seed) {
+            const auto level = LevelGenerator(GeneratorConfig{}).generate(seed);
+            const auto permutation = random_permutation(rng);
+            BoxWorldGameState state(level, collect_first_key);
+            BoxWorldGameState permuted(permuted_level(level, permutation), collect_first_key);
+            BoxWorldGameState flipped(flipped_level(level), collect_first_key);
+            for (int step = 0; step < 100 && !state.is_solution(); ++step) {
+                const auto action = static_cast<Action>(rng() % kNumActions);
+                state.apply_action(action);
+                permuted.apply_action(action);
+                flipped.apply_action(flipped_action(action));
+            }
+
+            const auto hash = state.get_hash();
+            auto state_permuted = state;
+            const auto version = state_permuted.get_version();
+            state_permuted.permute_colours(permutation);
+            auto state_flipped = state;
+            state_flipped.flip_vertical();
+            if (!is_same_state(state_permuted, permuted) || !is_same_state(state_flipped, flipped) ||
+                state_permuted.get_version() == version) {
+                std::cout << "augment state error." << std::endl;
+                return false;
+            }
+
+            // The starting level is augmented too, and the original is untouched
+            state_permuted.reset();
+            permuted.reset();
+            state_flipped.reset();
+            flipped.reset();
+            if (!is_same_state(state_permuted, permuted) || !is_same_state(state_flipped, flipped) ||
+                state.get_hash() != hash || !state.is_same_level(BoxWorldGameState(level, collect_first_key))) {
+                std::cout << "augment state reset error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Augmenting a batch of observations matches the observations of the augmented states
+auto test_augment_observations() -> bool {
+    std::mt19937 rng(1);
+    std::vector<BoxWorldGameState> states;
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        states.emplace_back(LevelGenerator(GeneratorConfig{}).generate(seed));
+        for (int step = 0; step < 20; ++step) {
+            states.back().apply_action(static_cast<Action>(rng() % kNumActions));
+        }
+    }
+    const auto shape = states[0].observation_shape();
+    const auto rows = shape[2];
+    const auto cols = shape[1];
+    const auto obs_size = shape[0] * rows * cols;
+    const auto permutation = random_permutation(rng);
+
+    std::vector<float> obs(states.size() * obs_size);
+    BoxWorldGameState::write_observations(states.data(), states.size(), obs.data());
+    BoxWorldGameState::permute_observation_colours(obs.data(), states.size(), rows, cols, permutation, 2);
+    BoxWorldGameState::flip_observation_vertical(obs.data(), states.size(), rows, cols, 2);
+    for (auto &state : states) {
+        state.permute_colours(permutation);
+        state.flip_vertical();
+    }
+    std::vector<float> expected(states.size() * obs_size);
+    BoxWorldGameState::write_observations(states.data(), states.size(), expected.data());
+    if (obs != expected) {
+        std::cout << "augment observations error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Tables which are not a permutation of the key colours are rejected
+auto test_augment_invalid() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    std::mt19937 rng(2);
+    auto permutation = random_permutation(rng);
+    permutation[0] = Element::kColourGoal;
+    try {
+        state.permute_colours(permutation);
+    } catch (const std::invalid_argument &) {
+        permutation[0] = permutation[1];
+        try {
+            state.permute_colours(permutation);
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+    }
+    std::cout << "augment invalid error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_augment_state() && ok;
+    ok = test_augment_observations() && ok;
+    ok = test_augment_invalid() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace boxworld;
+
+static_assert(std::is_trivially_copyable_v<BitboardBoxWorld>, "Bitboard state should be trivially copyable.");
+
+namespace {
+// Reachable cells and adjacent keys and locks, found with a BFS over the runtime state
+auto check_reachable(const BoxWorldGameState &state, const BitboardBoxWorld &bitboard) -> bool {
+    const auto shape = state.observation_shape();
+    const auto cols = shape[1];
+    const auto num_cells = shape[1] * shape[2];
+    std::vector<bool> reachable(num_cells, false);
+    std::vector<bool> targets(num_cells, false);
+    std::vector<std::size_t> queue{state.get_agent_index()};
+    reachable[state.get_agent_index()] = true;
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const auto idx = queue[head];
+        std::vector<std::size_t> neighbours;
+        if (idx >= cols) {
+            neighbours.push_back(idx - cols);
+        }
+        if (idx + cols < num_cells) {
+            neighbours.push_back(idx + cols);
+        }
+        if (idx % cols != 0) {
+            neighbours.push_back(idx - 1);
+        }
+        if (idx % cols != cols - 1) {
+            neighbours.push_back(idx + 1);
+        }
+        for (const auto &next : neighbours) {
+            if (state.get_key_indices().contains(next) || state.get_lock_indices().contains(next)) {
+                targets[next] = true;
+            } else if (state.get_item(next) == Element::kEmpty && !reachable[next]) {
+                reachable[next] = true;
+                queue.push_back(next);
+            }
+        }
+    }
+    const auto bitboard_targets = bitboard.reachable_targets();
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        const bool is_target = (bitboard_targets[i / 64] >> (i % 64)) & 1;
+        if (bitboard.is_reachable(i) != reachable[i] || is_target != targets[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Step the bitboard and runtime states together, checking they agree at every step
+auto check_random_walk(std::size_t map_size) -> bool {
+    std::mt19937 rng(0);
+    GeneratorConfig config;
+    config.map_size = map_size;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, config);
+        BitboardBoxWorld bitboard(state);
+        std::vector<float> obs(bitboard.observation_size());
+        for (int step = 0; step < 1000 && !state.is_solution(); ++step) {
+            const auto action = BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions];
+            state.apply_action(action);
+            bitboard.apply_action(action);
+            bitboard.get_observation(obs.data());
+            if (bitboard.get_agent_index() != state.get_agent_index() ||
+                bitboard.get_inventory() != state.get_inventory() ||
+                bitboard.get_reward_signal() != state.get_reward_signal() ||
+                bitboard.get_reward_signal(true) != state.get_reward_signal(true) ||
+                bitboard.is_solution() != state.is_solution() || bitboard.get_hash() != state.get_hash() ||
+                obs != state.get_observation() || bitboard != BitboardBoxWorld(state) ||
+                !check_reachable(state, bitboard)) {
+                std::cout << "bitboard step error." << std::endl;
+                return false;
+            }
+            for (std::size_t el = 0; el < kNumElements; ++el) {
+                const auto indices = state.get_indices(static_cast<Element>(el));
+                if (bitboard.get_indices(static_cast<Element>(el)) != indices ||
+                    bitboard.count(static_cast<Element>(el)) != indices.size()) {
+                    std::cout << "bitboard indices error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+}    // namespace
+
+auto test_bitboard() -> bool {
+    return check_random_walk(10) && check_random_walk(13) && check_random_walk(16);
+}
+
+// Boards with more than 16 rows or columns use the general flood fill, walls of locked boxes force paths with turns
+auto test_bitboard_reachable_wide() -> bool {
+    constexpr std::size_t kRows = 5;
+    constexpr std::size_t kCols = 30;
+    std::string board_str = std::to_string(kRows) + "|" + std::to_string(kCols);
+    for (std::size_t i = 0; i < kRows * kCols; ++i) {
+        const auto row = i / kCols;
+        const auto col = i % kCols;
+        // Each box is a key left of its lock, and no key to open the locks is on the board
+        const bool is_wall = (row + 1 < kRows && (col == 14 || col == 15)) || (row > 0 && (col == 21 || col == 22));
+        const bool is_lock = col == 15 || col == 22;
+        board_str += i == 0 ? "|13" : (is_wall ? (is_lock ? "|01" : "|02") : "|14");
+    }
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(board_str);
+    BoxWorldGameState state(params);
+    BitboardBoxWorld bitboard(state);
+    std::mt19937 rng(0);
+    for (int step = 0; step < 1000; ++step) {
+        if (!check_reachable(state, bitboard)) {
+            std::cout << "bitboard reachable wide error." << std::endl;
+            return false;
+        }
+        const auto action = BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions];
+        state.apply_action(action);
+        bitboard.apply_action(action);
+    }
+    return true;
+}
+
+// Boards over 256 cells are rejected
+auto test_bitboard_size() -> bool {
+    const BoxWorldGameState state(kDefaultGameParams);
+    try {
+        const BitboardBoxWorld bitboard(state);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    std::cout << "bitboard size error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_bitboard() && ok;
+    ok = test_bitboard_reachable_wide() && ok;
+    ok = test_bitboard_size() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+#ifndef BOXWORLD_TEST_BOARDS_H_
+#define BOXWORLD_TEST_BOARDS_H_
+
+#include <string>
+
+namespace boxworld::test {
+
+// Agent top left, single key below, and a goal box locked with the key's colour.
+// Solved by Down, Right, Right, Down, with the key at index 4 and the lock at index 10.
+inline const std::string kBoardStr = "3|4|13|14|14|14|00|14|14|14|14|12|00|14";
+
+}    // namespace boxworld::test
+
+#endif    // BOXWORLD_TEST_BOARDS_H_
@@ -0,0 +1,165 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+const std::string kPackPath = "boxworld_test_device_rules.bin";
+const std::string kTextPath = "boxworld_test_device_rules.txt";
+constexpr uint32_t kNumEnvs = 8;
+
+// Host copy of the state of a batch, viewed as the kernels see it
+struct HostEnvs {
+    HostEnvs(const FlatLevels& levels, uint32_t num_envs)
+        : boards(static_cast<std::size_t>(num_envs) * levels.rows * levels.cols),
+          agent_indices(num_envs),
+          inventories(num_envs),
+          level_indices(num_envs),
+          episodes(num_envs) {}
+
+    auto view() -> FlatEnvsView {
+        return {boards.data(),        agent_indices.data(), inventories.data(),
+                level_indices.data(), episodes.data(),      static_cast<uint32_t>(agent_indices.size())};
+    }
+
+    std::vector<uint8_t> boards;
+    std::vector<uint32_t> agent_indices;
+    std::vector<uint8_t> inventories;
+    std::vector<uint32_t> level_indices;
+    std::vector<uint32_t> episodes;
+};
+
+auto make_pack() -> LevelPack {
+    const LevelGenerator generator(GeneratorConfig{});
+    {
+        std::ofstream file(kTextPath);
+        for (const auto& level : generator.generate(0, 32)) {
+            file << to_board_str(level) << std::endl;
+        }
+    }
+    write_level_pack(kPackPath, read_level_file(kTextPath));
+    return LevelPack(kPackPath);
+}
+
+auto is_same(const FlatLevelsView& levels, const FlatEnvsView& envs, uint32_t env, const BoxWorldGameState& state)
+    -> bool {
+    const auto cells = levels.rows * levels.cols;
+    for (uint32_t i = 0; i < cells; ++i) {
+        if (envs.boards[static_cast<std::size_t>(env) * cells + i] != static_cast<uint8_t>(state.get_item(i))) {
+            return false;
+        }
+    }
+    std::vector<float> obs(static_cast<std::size_t>(kNumChannels) * cells);
+    for (uint32_t i = 0; i < cells; ++i) {
+        flat_write_observation_cell(levels, envs, env, i, obs.data());
+    }
+    return envs.agent_indices[env] == state.get_agent_index() &&
+           envs.inventories[env] == static_cast<uint8_t>(state.get_inventory()) && obs == state.get_observation();
+}
+}    // namespace
+
+// Flattened levels start as resetting the state to the same level of the pack
+auto test_make_flat_levels() -> bool {
+    const auto pack = make_pack();
+    for (const bool collect_first_key : {false, true}) {
+        GameParameters params = kDefaultGameParams;
+        params["collect_first_key"] = GameParameter(collect_first_key);
+        BoxWorldGameState state(params);
+        const auto flat = make_flat_levels(pack, collect_first_key);
+        if (flat.num_levels != pack.size() || flat.rows != pack.rows() || flat.cols != pack.cols()) {
+            std::cout << "make_flat_levels shape error." << std::endl;
+            return false;
+        }
+        HostEnvs host(flat, 1);
+        auto envs = host.view();
+        for (uint32_t i = 0; i < flat.num_levels; ++i) {
+            host.episodes[0] = i;
+            flat_reset(flat.view(), envs, 0);
+            state.reset(pack, i);
+            if (host.level_indices[0] != i || !is_same(flat.view(), envs, 0, state)) {
+                std::cout << "make_flat_levels reset error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Stepping a batch matches stepping states, through key pickups, lock openings, and resets to the next level
+auto test_flat_step() -> bool {
+    const auto pack = make_pack();
+    const BoxWorldSolver solver;
+    std::mt19937 rng(0);
+    for (const bool collect_first_key : {false, true}) {
+        GameParameters params = kDefaultGameParams;
+        params["collect_first_key"] = GameParameter(collect_first_key);
+        const auto flat = make_flat_levels(pack, collect_first_key);
+        const auto levels = flat.view();
+        HostEnvs host(flat, kNumEnvs);
+        auto envs = host.view();
+        std::vector<BoxWorldGameState> states(kNumEnvs, BoxWorldGameState(params));
+        std::vector<std::vector<Action>> plans(kNumEnvs);
+        for (uint32_t env = 0; env < kNumEnvs; ++env) {
+            flat_reset(levels, envs, env);
+            states[env].reset(pack, flat_level_index(env, 0, kNumEnvs, flat.num_levels));
+        }
+        std::size_t num_done = 0;
+        for (int step = 0; step < 400; ++step) {
+            for (uint32_t env = 0; env < kNumEnvs; ++env) {
+                auto& state = states[env];
+                auto& plan = plans[env];
+                // Mostly follow a solution so levels are solved, with random actions to bump into walls and locks
+                Action action = BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions];
+                if (rng() % 4 == 0) {
+                    plan.clear();
+                } else {
+                    if (plan.empty()) {
+                        plan = solver.solve(state).actions;
+                        std::reverse(plan.begin(), plan.end());
+                    }
+                    if (!plan.empty()) {
+                        action = plan.back();
+                        plan.pop_back();
+                    }
+                }
+                const bool use_colour = step % 2 == 0;
+                uint64_t reward_signal = 0;
+                uint8_t done = 0;
+                flat_step(levels, envs, env, static_cast<uint8_t>(action), use_colour, reward_signal, done);
+                state.apply_action(action);
+                const auto expected_reward_signal = state.get_reward_signal(use_colour);
+                const bool expected_done = state.is_solution();
+                if (expected_done) {
+                    ++num_done;
+                    state.reset(pack, flat_level_index(env, host.episodes[env], kNumEnvs, flat.num_levels));
+                    plan.clear();
+                }
+                if (reward_signal != expected_reward_signal || (done != 0) != expected_done ||
+                    !is_same(levels, envs, env, state)) {
+                    std::cout << "flat_step error." << std::endl;
+                    return false;
+                }
+            }
+        }
+        if (num_done < kNumEnvs) {
+            std::cout << "flat_step solved count error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_make_flat_levels() && ok;
+    ok = test_flat_step() && ok;
+    std::remove(kPackPath.c_str());
+    std::remove(kTextPath.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+auto check_solution(const BoxWorldGameState &start, const SolverResult &result, const SolverResult &expected) -> bool {
+    auto state = start;
+    for (const auto &action : result.actions) {
+        state.apply_action(action);
+    }
+    return result.solved == expected.solved && result.cost == expected.cost && result.expanded == expected.expanded &&
+           result.actions.size() == result.cost && state.is_solution() == expected.solved;
+}
+
+// Search on every node of an in process group, each node on its own thread
+auto search_local(const BoxWorldGameState &state, std::size_t num_nodes, std::size_t max_expansions = 0)
+    -> std::vector<SolverResult> {
+    LocalExchangeGroup group(num_nodes);
+    std::vector<SolverResult> results(num_nodes);
+    std::vector<std::thread> threads;
+    for (std::size_t rank = 0; rank < num_nodes; ++rank) {
+        threads.emplace_back([&, rank]() {
+            const DistributedSearch search(rank, num_nodes, group.get_exchange(rank), 2, max_expansions);
+            results[rank] = search.bfs(state);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return results;
+}
+}    // namespace
+
+// Every node returns the optimal solution, expanding the same states as the parallel search in total
+auto test_distributed_search_local() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    const ParallelSearch search(1);
+    for (const std::size_t num_nodes : {1, 3}) {
+        for (uint64_t seed = 0; seed < 8; ++seed) {
+            state.reset(seed, GeneratorConfig{});
+            const auto expected = search.bfs(state);
+            const auto results = search_local(state, num_nodes);
+            for (const auto &result : results) {
+                if (!check_solution(state, result, expected) || result.actions != results[0].actions) {
+                    std::cout << "distributed search local error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+auto test_distributed_search_socket() -> bool {
+    constexpr std::size_t kNumNodes = 3;
+    BoxWorldGameState state(kDefaultGameParams);
+    const ParallelSearch search(1);
+    std::vector<std::unique_ptr<SocketExchange>> exchanges;
+    std::vector<uint16_t> ports;
+    for (std::size_t rank = 0; rank < kNumNodes; ++rank) {
+        exchanges.push_back(std::make_unique<SocketExchange>(rank, kNumNodes));
+        ports.push_back(exchanges.back()->port());
+    }
+    const std::vector<std::string> hosts(kNumNodes, "127.0.0.1");
+    std::vector<std::thread> threads;
+    for (std::size_t rank = 0; rank < kNumNodes; ++rank) {
+        threads.emplace_back([&, rank]() { exchanges[rank]->connect(hosts, ports); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (uint64_t seed = 0; seed < 2; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        const auto expected = search.bfs(state);
+        std::vector<SolverResult> results(kNumNodes);
+        threads.clear();
+        for (std::size_t rank = 0; rank < kNumNodes; ++rank) {
+            threads.emplace_back([&, rank]() {
+                results[rank] = DistributedSearch(rank, kNumNodes, exchanges[rank]->get_exchange(), 1).bfs(state);
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (const auto &result : results) {
+            if (!check_solution(state, result, expected) || result.actions != results[0].actions) {
+                std::cout << "distributed search socket error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Unsolvable levels and the expansion limit end the search on every node at once
+auto test_distributed_search_unsolved() -> bool {
+    GameParameters params = kDefaultGameParams;
+    // Goal box locked with a colour which is never available
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|14|14|00|14|14|14|14|12|01|14"));
+    const BoxWorldGameState unsolvable(params);
+    BoxWorldGameState state(kDefaultGameParams);
+    state.reset(0, GeneratorConfig{});
+    const auto limited = ParallelSearch(1, 100).bfs(state);
+    for (const auto &result : search_local(unsolvable, 2)) {
+        if (result.solved || !result.actions.empty()) {
+            std::cout << "distributed search unsolvable error." << std::endl;
+            return false;
+        }
+    }
+    for (const auto &result : search_local(state, 2, 100)) {
+        if (result.solved != limited.solved || result.expanded != limited.expanded) {
+            std::cout << "distributed search limit error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_distributed_search_invalid() -> bool {
+    bool ok = true;
+    const auto expect_throw = [&](auto &&func) {
+        try {
+            func();
+            ok = false;
+        } catch (const std::invalid_argument &) {
+        }
+    };
+    LocalExchangeGroup group(2);
+    expect_throw([&]() { const DistributedSearch search(2, 2, group.get_exchange(0)); });
+    expect_throw([&]() { const DistributedSearch search(0, 0, group.get_exchange(0)); });
+    expect_throw([&]() { const LocalExchangeGroup empty(0); });
+    expect_throw([&]() { [[maybe_unused]] const auto exchange = group.get_exchange(2); });
+    expect_throw([&]() { group.exchange(0, std::vector<ByteBatch>(1)); });
+    expect_throw([&]() { const SocketExchange exchange(1, 1); });
+    // Batches for a search which are not of its format
+    const DistributedSearch search(0, 1, [](std::vector<ByteBatch> batches) {
+        batches[0].resize(1);
+        return batches;
+    });
+    BoxWorldGameState state(kDefaultGameParams);
+    state.reset(0, GeneratorConfig{});
+    expect_throw([&]() { [[maybe_unused]] const auto result = search.bfs(state); });
+    if (!ok) {
+        std::cout << "distributed search invalid error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_distributed_search_local() && ok;
+    ok = test_distributed_search_socket() && ok;
+    ok = test_distributed_search_unsolved() && ok;
+    ok = test_distributed_search_invalid() && ok;
+    return ok ? 0 : 1;
+}
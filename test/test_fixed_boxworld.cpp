@@ -0,0 +1,81 @@
+#include <boxworld/boxworld.h>
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+
+using namespace boxworld;
+
+static_assert(std::is_trivially_copyable_v<FixedBoxWorld<10, 10>>, "Fixed state should be trivially copyable.");
+static_assert(FixedBoxWorld<12, 12>::kObservationSize == kNumChannels * 144, "Fixed observation size error.");
+
+namespace {
+// Step the fixed and runtime states together, checking they agree at every step
+template <std::size_t Rows, std::size_t Cols>
+auto check_random_walk(std::size_t map_size) -> bool {
+    std::mt19937 rng(0);
+    GeneratorConfig config;
+    config.map_size = map_size;
+    BoxWorldGameState state(kDefaultGameParams);
+    std::vector<float> obs(FixedBoxWorld<Rows, Cols>::kObservationSize);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, config);
+        FixedBoxWorld<Rows, Cols> fixed(state);
+        for (int step = 0; step < 1000 && !state.is_solution(); ++step) {
+            const auto action = BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions];
+            state.apply_action(action);
+            fixed.apply_action(action);
+            fixed.get_observation(obs.data());
+            if (fixed.get_agent_index() != state.get_agent_index() ||
+                fixed.get_inventory() != state.get_inventory() ||
+                fixed.get_reward_signal() != state.get_reward_signal() ||
+                fixed.get_reward_signal(true) != state.get_reward_signal(true) ||
+                fixed.is_solution() != state.is_solution() || obs != state.get_observation()) {
+                std::cout << "fixed boxworld step error." << std::endl;
+                return false;
+            }
+            // Incremental hash matches the hash of the same state built from scratch, and of the dynamic state
+            const FixedBoxWorld<Rows, Cols> rebuilt(state);
+            if (fixed != rebuilt || fixed.get_hash() != rebuilt.get_hash() || fixed.get_hash() != state.get_hash()) {
+                std::cout << "fixed boxworld hash error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}    // namespace
+
+auto test_fixed_boxworld() -> bool {
+    return check_random_walk<10, 10>(10) && check_random_walk<12, 12>(12);
+}
+
+auto test_fixed_boxworld_snapshot() -> bool {
+    const BoxWorldGameState state(kDefaultGameParams);
+    FixedBoxWorld<20, 20> fixed(state);
+    fixed.apply_action(Action::kLeft);
+    alignas(FixedBoxWorld<20, 20>) unsigned char buffer[sizeof(FixedBoxWorld<20, 20>)];
+    std::memcpy(buffer, &fixed, sizeof(fixed));
+    FixedBoxWorld<20, 20> restored(state);
+    std::memcpy(&restored, buffer, sizeof(restored));
+    if (restored != fixed || restored.get_hash() != fixed.get_hash()) {
+        std::cout << "fixed boxworld snapshot error." << std::endl;
+        return false;
+    }
+    // Mismatched board dimensions are rejected
+    try {
+        const FixedBoxWorld<12, 12> wrong_size(state);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    std::cout << "fixed boxworld size error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_fixed_boxworld() && ok;
+    ok = test_fixed_boxworld_snapshot() && ok;
+    return ok ? 0 : 1;
+}
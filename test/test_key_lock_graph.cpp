@@ -0,0 +1,155 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <string>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+// Graph of the standard small board, a single key opening the box holding the goal
+auto test_key_lock_graph_small() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    const BoxWorldGameState state(params);
+    const auto &graph = state.get_key_lock_graph();
+    const auto *box = graph.box_at(10);
+    if (graph.boxes.size() != 1 || box == nullptr || graph.box_at(9) != box || graph.box_at(4) != nullptr ||
+        box->key_index != 9 || box->lock_colour != Element::kColour0 || box->key_colour != Element::kColourGoal ||
+        !box->on_goal_chain || box->is_distractor || !graph.is_goal_reachable || graph.goal_chain.size() != 1 ||
+        graph.colour_keys[0].size() != 1 || graph.colour_keys[0][0] != 4 || graph.colour_locks[0].size() != 1 ||
+        graph.colour_locks[0][0] != 10 || graph.num_distractors() != 0) {
+        std::cout << "key lock graph small error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Generated levels have a goal chain of goal_length - 1 boxes, and one distractor box branching off per distractor
+auto test_key_lock_graph_generated() -> bool {
+    GeneratorConfig config;
+    config.map_size = 14;
+    config.goal_length = 4;
+    config.num_distractor = 3;
+    config.distractor_length = 2;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 32; ++seed) {
+        state.reset(seed, config);
+        const auto &graph = state.get_key_lock_graph();
+        if (!graph.is_goal_reachable || graph.goal_chain.size() != config.goal_length - 1 ||
+            graph.num_distractors() != config.num_distractor ||
+            graph.boxes.size() != state.get_lock_indices().size()) {
+            std::cout << "key lock graph generated error." << std::endl;
+            return false;
+        }
+        // Each box of the chain is opened by the key held in the previous box
+        const auto &first = graph.boxes[graph.goal_chain.front()];
+        if (graph.colour_keys[static_cast<std::size_t>(first.lock_colour)].empty() ||
+            graph.boxes[graph.goal_chain.back()].key_colour != Element::kColourGoal) {
+            std::cout << "key lock graph chain ends error." << std::endl;
+            return false;
+        }
+        for (std::size_t i = 1; i < graph.goal_chain.size(); ++i) {
+            if (graph.boxes[graph.goal_chain[i]].lock_colour != graph.boxes[graph.goal_chain[i - 1]].key_colour) {
+                std::cout << "key lock graph chain error." << std::endl;
+                return false;
+            }
+        }
+        for (const auto &idx : state.get_lock_indices()) {
+            const auto *box = graph.box_at(idx);
+            if (box == nullptr || box->lock_index != idx || box->lock_colour != state.get_item(idx) ||
+                box->key_colour != state.get_item(idx - 1)) {
+                std::cout << "key lock graph box error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Opening the distractor box uses the only key which opens the goal box
+auto test_is_dead_end() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|01|00|00|14|14|14|14|12|00|14"));
+    BoxWorldGameState state(params);
+    auto solved = state;
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kRight}) {
+        state.apply_action(action);
+        solved.apply_action(action);
+        if (state.is_dead_end()) {
+            std::cout << "is dead end error." << std::endl;
+            return false;
+        }
+    }
+    state.apply_action(Action::kUp);
+    solved.apply_action(Action::kDown);
+    solved.apply_action(Action::kLeft);
+    if (!state.is_dead_end() || state.get_inventory() != Element::kColour1 || !solved.is_solution() ||
+        solved.is_dead_end()) {
+        std::cout << "is dead end error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Levels differing only in the colour of the key collected first share the hash the chain length is cached against
+auto test_is_dead_end_new_level() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    params["collect_first_key"] = GameParameter(true);
+    BoxWorldGameState state(params);
+    const auto other = parse_board("3|4|13|14|14|14|01|14|14|14|14|12|00|14");
+    params["game_board_str"] = GameParameter(to_board_str(other));
+    const BoxWorldGameState other_state(params);
+    if (state.is_dead_end() || !other_state.is_dead_end()) {
+        std::cout << "is dead end new level error." << std::endl;
+        return false;
+    }
+    auto reset_state = state;
+    reset_state.reset(other);
+    const auto bytes = other_state.serialize();
+    state.deserialize_from(bytes.data(), bytes.size());
+    if (!reset_state.is_dead_end() || reset_state.get_remaining_chain_length() != kDeadEnd || !state.is_dead_end()) {
+        std::cout << "is dead end new level error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// No state along an optimal solution is a dead end
+auto test_is_dead_end_generated() -> bool {
+    GeneratorConfig config;
+    config.map_size = 12;
+    config.goal_length = 3;
+    config.num_distractor = 2;
+    config.distractor_length = 2;
+    BoxWorldGameState state(kDefaultGameParams);
+    const BoxWorldSolver solver;
+    for (uint64_t seed = 0; seed < 16; ++seed) {
+        state.reset(seed, config);
+        const auto result = solver.solve(state);
+        if (!result.solved || state.is_dead_end()) {
+            std::cout << "is dead end generated error." << std::endl;
+            return false;
+        }
+        for (const auto &action : result.actions) {
+            state.apply_action(action);
+            if (state.is_dead_end()) {
+                std::cout << "is dead end generated error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_key_lock_graph_small() && ok;
+    ok = test_key_lock_graph_generated() && ok;
+    ok = test_is_dead_end() && ok;
+    ok = test_is_dead_end_new_level() && ok;
+    ok = test_is_dead_end_generated() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+auto test_parse_board() -> bool {
+    const auto level = parse_board(kBoardStr);
+    if (level.rows != 3 || level.cols != 4 || level.board.size() != 12 || level.board[0] != Element::kAgent ||
+        level.board[9] != Element::kColourGoal || !(parse_board(to_board_str(level)) == level)) {
+        std::cout << "parse board error." << std::endl;
+        return false;
+    }
+    // Levels written by the generator parse back to the same level
+    const LevelGenerator generator(GeneratorConfig{});
+    for (uint64_t seed = 0; seed < 8; ++seed) {
+        const auto generated = generator.generate(seed);
+        if (!(parse_board(to_board_str(generated)) == generated)) {
+            std::cout << "parse generated board error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_parse_board_invalid() -> bool {
+    const std::vector<std::string> invalid_boards{
+        "",                                             // Empty
+        "3",                                            // Missing cols
+        "1|2|13",                                       // Too few cells
+        "1|1|13|14",                                    // Too many cells
+        "1|2|13|15",                                    // Element out of range
+        "1|2|13|x4",                                    // Not an integer
+        "1|2|13|-1",                                    // Negative
+        "300|300|13",                                   // Too large
+    };
+    for (const auto& board_str : invalid_boards) {
+        bool thrown = false;
+        try {
+            [[maybe_unused]] const auto level = parse_board(board_str);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        if (!thrown) {
+            std::cout << "parse invalid board error: " << board_str << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_sparse_level() -> bool {
+    const auto level = parse_board(kBoardStr);
+    // Dimensions, cell count, then the agent, two keys and the goal
+    const auto bytes = encode_sparse_level(level);
+    if (bytes.size() != sparse_level_size(level) || bytes.size() != 6 + 4 * 3 ||
+        !(decode_sparse_level(bytes.data(), bytes.size()) == level)) {
+        std::cout << "sparse level error." << std::endl;
+        return false;
+    }
+    // Levels are self delimiting, so can be decoded back to back
+    const LevelGenerator generator(GeneratorConfig{});
+    std::vector<uint8_t> buffer;
+    const auto levels = generator.generate(0, 8);
+    for (const auto& generated : levels) {
+        const auto encoded = encode_sparse_level(generated);
+        if (encoded.size() * 4 > to_board_str(generated).size()) {
+            std::cout << "sparse level size error." << std::endl;
+            return false;
+        }
+        buffer.insert(buffer.end(), encoded.begin(), encoded.end());
+    }
+    std::size_t offset = 0;
+    for (const auto& generated : levels) {
+        std::size_t bytes_read = 0;
+        if (!(decode_sparse_level(buffer.data() + offset, buffer.size() - offset, &bytes_read) == generated)) {
+            std::cout << "sparse level sequence error." << std::endl;
+            return false;
+        }
+        offset += bytes_read;
+    }
+    if (offset != buffer.size()) {
+        std::cout << "sparse level sequence error." << std::endl;
+        return false;
+    }
+
+    // Truncated, out of order, and out of range cells are rejected
+    auto invalid = bytes;
+    invalid.pop_back();
+    std::vector<std::vector<uint8_t>> invalid_encodings{invalid};
+    invalid = bytes;
+    std::swap(invalid[6], invalid[9]);
+    invalid_encodings.push_back(invalid);
+    invalid = bytes;
+    invalid[6] = 12;
+    invalid_encodings.push_back(invalid);
+    invalid = bytes;
+    invalid[8] = static_cast<uint8_t>(Element::kEmpty);
+    invalid_encodings.push_back(invalid);
+    for (const auto& encoding : invalid_encodings) {
+        bool thrown = false;
+        try {
+            [[maybe_unused]] const auto decoded = decode_sparse_level(encoding.data(), encoding.size());
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        if (!thrown) {
+            std::cout << "sparse level invalid error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_parse_board() && ok;
+    ok = test_parse_board_invalid() && ok;
+    ok = test_sparse_level() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace boxworld;
+
+auto test_generate() -> bool {
+    GeneratorConfig config;
+    config.map_size = 12;
+    config.goal_length = 4;
+    config.num_distractor = 2;
+    config.distractor_length = 3;
+    const LevelGenerator generator(config);
+    const auto num_pairs = config.goal_length - 1 + config.num_distractor * config.distractor_length;
+
+    const auto levels = generator.generate(0, 64, 4);
+    for (std::size_t seed = 0; seed < levels.size(); ++seed) {
+        if (!(levels[seed] == generator.generate(seed))) {
+            std::cout << "generator determinism error." << std::endl;
+            return false;
+        }
+        GameParameters params = kDefaultGameParams;
+        params["game_board_str"] = GameParameter(to_board_str(levels[seed]));
+        const BoxWorldGameState state(params);
+        // Single first key plus one lock per pair
+        if (state.get_target_indices().size() != num_pairs + 1 || state.get_indices(Element::kAgent).size() != 1 ||
+            state.get_indices(Element::kColourGoal).size() != 1) {
+            std::cout << "generated level error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_procedural_reset() -> bool {
+    const GeneratorConfig config;
+    const LevelGenerator generator(config);
+    BoxWorldGameState state(kDefaultGameParams);
+    const BoxWorldGameState original = state;
+    for (uint64_t seed = 0; seed < 16; ++seed) {
+        state.reset(seed, config);
+        GameParameters params = kDefaultGameParams;
+        params["game_board_str"] = GameParameter(to_board_str(generator.generate(seed)));
+        const BoxWorldGameState expected(params);
+        if (!(state == expected) || state.get_hash() != expected.get_hash() ||
+            state.get_observation() != expected.get_observation()) {
+            std::cout << "procedural reset error." << std::endl;
+            return false;
+        }
+        // Plain reset returns to the generated level
+        state.apply_action(Action::kUp);
+        state.apply_action(Action::kLeft);
+        state.reset();
+        if (!(state == expected) || state.get_hash() != expected.get_hash()) {
+            std::cout << "procedural reset start error." << std::endl;
+            return false;
+        }
+    }
+    // Copies made before the reset keep their level
+    const BoxWorldGameState default_state(kDefaultGameParams);
+    if (!(original == default_state) || original.get_observation() != default_state.get_observation()) {
+        std::cout << "procedural reset shared level error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Keys and locks only fit on a crowded map for some seeds, and the error of a worker thread reaches the caller
+auto test_generate_crowded() -> bool {
+    const LevelGenerator generator(GeneratorConfig{5, 7, 0, 0});
+    std::size_t num_failed = 0;
+    for (uint64_t seed = 0; seed < 64; ++seed) {
+        try {
+            [[maybe_unused]] const auto level = generator.generate(seed);
+        } catch (const std::invalid_argument &) {
+            ++num_failed;
+        }
+    }
+    bool ok = num_failed > 0 && num_failed < 64;
+    for (const std::size_t num_threads : {1, 4}) {
+        try {
+            [[maybe_unused]] const auto levels = generator.generate(0, 64, num_threads);
+            ok = false;
+        } catch (const std::invalid_argument &) {
+        }
+    }
+    if (!ok) {
+        std::cout << "generate crowded error." << std::endl;
+    }
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_generate() && ok;
+    ok = test_procedural_reset() && ok;
+    ok = test_generate_crowded() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#include <boxworld/boxworld.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+const std::string kIndexPath = "boxworld_test_level_index.bwli";
+const std::string kPackPath = "boxworld_test_level_index.bin";
+}    // namespace
+
+auto test_level_index_hash() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    for (const auto &level : generator.generate(0, 16)) {
+        GameParameters params = kDefaultGameParams;
+        params["game_board_str"] = GameParameter(to_board_str(level));
+        const BoxWorldGameState state(params);
+        if (compute_board_hash(level.board.data(), level.rows, level.cols) != state.get_hash()) {
+            std::cout << "level index hash error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Levels 0 to 15 with levels 0 to 3 repeated at the end
+auto test_level_index_dedup() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    auto levels = generator.generate(0, 16);
+    for (std::size_t i = 0; i < 4; ++i) {
+        levels.push_back(levels[i]);
+    }
+    write_level_pack(kPackPath, levels);
+    const LevelIndex index(levels);
+    const LevelIndex pack_index(LevelPack(kPackPath), 2);
+    std::vector<std::size_t> expected(16);
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = i;
+    }
+    if (index.size() != levels.size() || index.unique_indices() != expected ||
+        pack_index.unique_indices() != expected) {
+        std::cout << "level index dedup error." << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < index.get_entries().size(); ++i) {
+        if (index.get_entries()[i].hash != pack_index.get_entries()[i].hash ||
+            index.get_entries()[i].index != pack_index.get_entries()[i].index) {
+            std::cout << "level index pack error." << std::endl;
+            return false;
+        }
+    }
+    for (const auto &level : levels) {
+        if (!index.contains(level)) {
+            std::cout << "level index contains error." << std::endl;
+            return false;
+        }
+    }
+    Level other_size = levels.front();
+    other_size.cols = other_size.rows + 1;
+    if (index.contains(generator.generate(100)) || index.contains(other_size)) {
+        std::cout << "level index not contains error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Train levels 0 to 15 against test levels 12 to 23 overlap in levels 12 to 15
+auto test_level_index_overlap() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    const LevelIndex train(generator.generate(0, 16));
+    const LevelIndex test(generator.generate(12, 12));
+    const std::vector<std::size_t> expected_train = {12, 13, 14, 15};
+    const std::vector<std::size_t> expected_test = {0, 1, 2, 3};
+    if (train.overlap(test) != expected_train || test.overlap(train) != expected_test) {
+        std::cout << "level index overlap error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_level_index_file() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    auto levels = generator.generate(0, 8);
+    levels.push_back(levels.front());
+    const LevelIndex index(levels);
+    index.write(kIndexPath);
+    const auto read = LevelIndex::read(kIndexPath);
+    if (read.size() != index.size() || read.rows() != index.rows() || read.cols() != index.cols() ||
+        read.unique_indices() != index.unique_indices() || read.overlap(index).size() != levels.size()) {
+        std::cout << "level index file error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_level_index_invalid() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    const auto level = generator.generate(0);
+    Level other_size = level;
+    other_size.rows = 1;
+    other_size.cols = level.board.size();
+    bool ok = true;
+    try {
+        [[maybe_unused]] const LevelIndex index(std::vector<Level>{});
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    try {
+        [[maybe_unused]] const LevelIndex index(std::vector<Level>{level, other_size});
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    try {
+        [[maybe_unused]] const auto overlap = LevelIndex({level}).overlap(LevelIndex({other_size}));
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    Level unknown_element = level;
+    unknown_element.board.back() = static_cast<Element>(200);
+    try {
+        [[maybe_unused]] const LevelIndex index(std::vector<Level>{level, unknown_element});
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    // Pack records are only validated when hashed, on every thread
+    write_level_pack(kPackPath, generator.generate(0, 4));
+    {
+        std::fstream file(kPackPath, std::ios::binary | std::ios::in | std::ios::out);
+        LevelPackHeader header{};
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        constexpr std::size_t kRecordFixedFields = 4;
+        file.seekp(static_cast<std::streamoff>(sizeof(header) + header.record_size +
+                                               (kRecordFixedFields + header.max_indices) * sizeof(uint16_t)));
+        file.put(static_cast<char>(200));
+    }
+    for (const std::size_t num_threads : {1, 2}) {
+        try {
+            [[maybe_unused]] const LevelIndex index(LevelPack(kPackPath), num_threads);
+            ok = false;
+        } catch (const std::invalid_argument &) {
+        }
+    }
+    {
+        std::ofstream file(kIndexPath, std::ios::binary | std::ios::trunc);
+        file << "not a level index, but long enough for a header";
+    }
+    try {
+        [[maybe_unused]] const auto index = LevelIndex::read(kIndexPath);
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    // Truncated entries
+    LevelIndex({level, level}).write(kIndexPath);
+    {
+        std::ifstream file(kIndexPath, std::ios::binary);
+        std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        buffer.resize(buffer.size() - 1);
+        std::ofstream out(kIndexPath, std::ios::binary | std::ios::trunc);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+    try {
+        [[maybe_unused]] const auto index = LevelIndex::read(kIndexPath);
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    try {
+        [[maybe_unused]] const auto index = LevelIndex::read("boxworld_test_level_index_missing.bwli");
+        ok = false;
+    } catch (const std::runtime_error &) {
+    }
+    if (!ok) {
+        std::cout << "level index invalid error." << std::endl;
+    }
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_level_index_hash() && ok;
+    ok = test_level_index_dedup() && ok;
+    ok = test_level_index_overlap() && ok;
+    ok = test_level_index_file() && ok;
+    ok = test_level_index_invalid() && ok;
+    std::remove(kIndexPath.c_str());
+    std::remove(kPackPath.c_str());
+    return ok ? 0 : 1;
+}
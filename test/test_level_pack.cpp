@@ -0,0 +1,176 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace boxworld;
+
+namespace {
+const std::string kPackPath = "boxworld_test_level_pack.bin";
+const std::string kTextPath = "boxworld_test_level_pack.txt";
+const std::string kSparsePath = "boxworld_test_level_pack.bwsl";
+}    // namespace
+
+auto test_level_pack() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    const auto levels = generator.generate(0, 32);
+    {
+        std::ofstream file(kTextPath);
+        for (const auto& level : levels) {
+            file << to_board_str(level) << std::endl;
+        }
+    }
+    write_level_pack(kPackPath, read_level_file(kTextPath));
+
+    const LevelPack pack(kPackPath);
+    if (pack.size() != levels.size() || pack.rows() != levels.front().rows || pack.cols() != levels.front().cols) {
+        std::cout << "level pack header error." << std::endl;
+        return false;
+    }
+    for (const bool collect_first_key : {false, true}) {
+        GameParameters params = kDefaultGameParams;
+        params["collect_first_key"] = GameParameter(collect_first_key);
+        BoxWorldGameState state(params);
+        for (std::size_t i = 0; i < pack.size(); ++i) {
+            if (!(pack.get_level(i) == levels[i])) {
+                std::cout << "level pack level error." << std::endl;
+                return false;
+            }
+            state.reset(pack, i);
+            params["game_board_str"] = GameParameter(to_board_str(levels[i]));
+            const BoxWorldGameState expected(params);
+            if (!(state == expected) || state.get_hash() != expected.get_hash() ||
+                state.get_inventory() != expected.get_inventory() ||
+                state.get_target_indices() != expected.get_target_indices()) {
+                std::cout << "level pack reset error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto test_level_pack_invalid() -> bool {
+    {
+        std::ofstream file(kPackPath, std::ios::binary | std::ios::trunc);
+        file << "not a level pack, but long enough for a header";
+    }
+    bool thrown = false;
+    try {
+        const LevelPack pack(kPackPath);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "level pack invalid error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_sparse_level_file() -> bool {
+    // Levels of different dimensions can share a file
+    auto levels = LevelGenerator(GeneratorConfig{}).generate(0, 16);
+    GeneratorConfig config;
+    config.map_size = 24;
+    const auto large_levels = LevelGenerator(config).generate(0, 16);
+    levels.insert(levels.end(), large_levels.begin(), large_levels.end());
+    write_sparse_level_file(kSparsePath, levels);
+    if (read_sparse_level_file(kSparsePath) != levels) {
+        std::cout << "sparse level file error." << std::endl;
+        return false;
+    }
+    write_sparse_level_file(kSparsePath, {});
+    if (!read_sparse_level_file(kSparsePath).empty()) {
+        std::cout << "sparse level file empty error." << std::endl;
+        return false;
+    }
+
+    {
+        std::ofstream file(kSparsePath, std::ios::binary | std::ios::trunc);
+        file << "not a sparse level file";
+    }
+    bool thrown = false;
+    try {
+        [[maybe_unused]] const auto invalid = read_sparse_level_file(kSparsePath);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "sparse level file invalid error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_load_level_file() -> bool {
+    // Enough levels for several chunks per thread, with blank lines between some of them
+    const auto levels = LevelGenerator(GeneratorConfig{}).generate(0, 256);
+    {
+        std::ofstream file(kTextPath);
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            file << to_board_str(levels[i]) << (i % 7 == 0 ? "\n\n" : "\n");
+        }
+    }
+    write_level_pack(kPackPath, levels);
+    const LevelPack expected(kPackPath);
+    for (const std::size_t num_threads : {1, 4}) {
+        const auto pack = LevelPack::load_level_file(kTextPath, num_threads);
+        if (pack.size() != expected.size() || pack.rows() != expected.rows() || pack.cols() != expected.cols()) {
+            std::cout << "load level file header error." << std::endl;
+            return false;
+        }
+        for (std::size_t i = 0; i < pack.size(); ++i) {
+            const auto record = pack.get_record(i);
+            const auto expected_record = expected.get_record(i);
+            if (!(pack.get_level(i) == levels[i]) || record.agent_idx != expected_record.agent_idx ||
+                !std::equal(record.key_indices, record.key_indices + record.num_keys, expected_record.key_indices,
+                            expected_record.key_indices + expected_record.num_keys) ||
+                !std::equal(record.lock_indices, record.lock_indices + record.num_locks,
+                            expected_record.lock_indices, expected_record.lock_indices + expected_record.num_locks)) {
+                std::cout << "load level file record error." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Files without levels, or with boards of different dimensions, are rejected
+    GeneratorConfig config;
+    config.map_size = 12;
+    const std::vector<std::string> invalid_files{
+        "\n\n",
+        to_board_str(levels[0]) + "\n" + to_board_str(LevelGenerator(config).generate(0)),
+    };
+    for (const auto& contents : invalid_files) {
+        {
+            std::ofstream file(kTextPath, std::ios::trunc);
+            file << contents;
+        }
+        bool thrown = false;
+        try {
+            [[maybe_unused]] const auto pack = LevelPack::load_level_file(kTextPath);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        if (!thrown) {
+            std::cout << "load level file invalid error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_level_pack() && ok;
+    ok = test_level_pack_invalid() && ok;
+    ok = test_sparse_level_file() && ok;
+    ok = test_load_level_file() && ok;
+    std::remove(kPackPath.c_str());
+    std::remove(kTextPath.c_str());
+    std::remove(kSparsePath.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+#include <boxworld/boxworld.h>
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boxworld;
+
+// Borrowed states copy without owning the level, and own it again after resetting to another level
+auto test_borrow_level() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    const auto owned = state;
+    state.borrow_level();
+    const auto copy = state;
+    if (!state.is_level_borrowed() || !copy.is_level_borrowed() || owned.is_level_borrowed() ||
+        copy.get_level_id() != owned.get_level_id() || copy != owned || copy.get_hash() != owned.get_hash()) {
+        std::cout << "borrow level error." << std::endl;
+        return false;
+    }
+
+    // Copies across threads play out the same as the owning state
+    std::vector<uint64_t> hashes(4);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < hashes.size(); ++t) {
+        threads.emplace_back([&, t]() {
+            auto thread_state = copy;
+            thread_state.apply_action(Action::kLeft);
+            thread_state.reset();
+            thread_state.apply_action(Action::kDown);
+            hashes[t] = thread_state.get_hash();
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto expected = owned;
+    expected.apply_action(Action::kDown);
+    for (const auto &hash : hashes) {
+        if (hash != expected.get_hash()) {
+            std::cout << "borrow level thread error." << std::endl;
+            return false;
+        }
+    }
+
+    state.reset(0, GeneratorConfig{});
+    if (state.is_level_borrowed()) {
+        std::cout << "borrow level reset error." << std::endl;
+        return false;
+    }
+    // Levels only held by states are registered to be borrowed
+    auto &registry = LevelRegistry::get_instance();
+    if (registry.find(state.get_level_id()) != nullptr) {
+        std::cout << "borrow level registered error." << std::endl;
+        return false;
+    }
+    state.borrow_level();
+    if (!state.is_level_borrowed() || registry.find(state.get_level_id()) == nullptr) {
+        std::cout << "borrow unregistered level error." << std::endl;
+        return false;
+    }
+    const auto borrowed_id = state.get_level_id();
+    state.reset(1, GeneratorConfig{});
+    registry.erase(borrowed_id);
+    return true;
+}
+
+// Levels are registered on the first serialize_local(), not on construction, and again after being removed
+auto test_lazy_registration() -> bool {
+    auto &registry = LevelRegistry::get_instance();
+    const auto levels = LevelGenerator(GeneratorConfig{}).generate(100, 64);
+    const auto registered = registry.size();
+    const auto states = BoxWorldGameState::make_states(levels.data(), levels.size());
+    if (registry.size() != registered) {
+        std::cout << "lazy registration construct error." << std::endl;
+        return false;
+    }
+    const auto bytes = states.front().serialize_local();
+    const auto copy = states.front();
+    BoxWorldGameState restored(kDefaultGameParams);
+    restored.deserialize_local_from(bytes.data(), bytes.size());
+    if (registry.size() != registered + 1 || restored != states.front()) {
+        std::cout << "lazy registration serialize error." << std::endl;
+        return false;
+    }
+    registry.erase(states.front().get_level_id());
+    const auto again = copy.serialize_local();
+    restored.deserialize_local_from(again.data(), again.size());
+    if (registry.size() != registered + 1 || restored != copy) {
+        std::cout << "lazy registration erase error." << std::endl;
+        return false;
+    }
+    registry.erase(copy.get_level_id());
+    return true;
+}
+
+// A registered level whose id collides with another level is not shared with states of the other level
+auto test_level_id_collision() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    const auto level = generator.generate(200);
+    const auto other_level = generator.generate(201);
+    auto &registry = LevelRegistry::get_instance();
+    auto impostor = std::make_shared<SharedStateInfo>(other_level, false);
+    impostor->level_id = compute_level_id(level, false);
+    static_cast<void>(registry.insert(impostor));
+    const BoxWorldGameState state(level);
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(to_board_str(level));
+    const BoxWorldGameState expected(params);
+    bool ok = state == expected && state.get_hash() == expected.get_hash();
+    // The level cannot be registered under its id
+    try {
+        [[maybe_unused]] const auto bytes = state.serialize_local();
+        ok = false;
+    } catch (const std::runtime_error &) {
+    }
+    registry.erase(impostor->level_id);
+    if (!ok) {
+        std::cout << "level id collision error." << std::endl;
+    }
+    return ok;
+}
+
+// States made in bulk match states constructed one at a time
+auto test_make_states() -> bool {
+    auto levels = LevelGenerator(GeneratorConfig{}).generate(0, 200);
+    for (std::size_t i = 0; i < 10; ++i) {
+        levels.push_back(levels[i]);
+    }
+    std::vector<std::string> board_strs;
+    for (const auto &level : levels) {
+        board_strs.push_back(to_board_str(level));
+    }
+    const std::string pack_path = "boxworld_test_make_states.bin";
+    write_level_pack(pack_path, levels);
+    const LevelPack pack(pack_path);
+    std::remove(pack_path.c_str());
+    for (const bool collect_first_key : {false, true}) {
+        for (const std::size_t num_threads : {1, 4}) {
+            const auto states = BoxWorldGameState::make_states(levels.data(), levels.size(), collect_first_key,
+                                                               num_threads);
+            const auto parsed_states = BoxWorldGameState::make_states(board_strs, collect_first_key, num_threads);
+            const auto pack_states = BoxWorldGameState::make_states(pack, collect_first_key, num_threads);
+            if (states.size() != levels.size() || parsed_states.size() != levels.size() ||
+                pack_states.size() != levels.size()) {
+                std::cout << "make states size error." << std::endl;
+                return false;
+            }
+            for (std::size_t i = 0; i < levels.size(); ++i) {
+                const BoxWorldGameState expected(levels[i], collect_first_key);
+                if (states[i] != expected || parsed_states[i] != expected || pack_states[i] != expected ||
+                    states[i].get_hash() != expected.get_hash() || states[i].get_version() != expected.get_version() ||
+                    states[i].get_level_id() != expected.get_level_id()) {
+                    std::cout << "make states error." << std::endl;
+                    return false;
+                }
+            }
+            for (std::size_t i = 200; i < levels.size(); ++i) {
+                if (!states[i].is_same_level(states[i - 200]) || states[i] != states[i - 200]) {
+                    std::cout << "make states repeated level error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Errors on worker threads are rethrown
+    board_strs[150] = "3|4|13|14";
+    try {
+        [[maybe_unused]] const auto states = BoxWorldGameState::make_states(board_strs, false, 4);
+    } catch (const std::invalid_argument &) {
+        return BoxWorldGameState::make_states(std::vector<std::string>{}).empty();
+    }
+    std::cout << "make states invalid error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_borrow_level() && ok;
+    ok = test_lazy_registration() && ok;
+    ok = test_level_id_collision() && ok;
+    ok = test_make_states() && ok;
+    return ok ? 0 : 1;
+}
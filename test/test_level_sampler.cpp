@@ -0,0 +1,186 @@
+#include <boxworld/boxworld.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+const std::string kPackPath = "boxworld_test_level_sampler.bin";
+const std::string kMalformedPackPath = "boxworld_test_level_sampler_malformed.bin";
+constexpr std::size_t kNumLevels = 30;
+}    // namespace
+
+// Sequential draws cycle through the shard, giving the same states as constructing from the level
+auto test_sampler_sequential(const std::vector<Level> &levels) -> bool {
+    LevelSamplerConfig config;
+    config.mode = SamplingMode::kSequential;
+    config.rank = 1;
+    config.world_size = 3;
+    config.prefetch = 4;
+    LevelSampler sampler(LevelPack(kPackPath), config);
+    if (sampler.shard_size() != kNumLevels / 3) {
+        std::cout << "level sampler shard size error." << std::endl;
+        return false;
+    }
+    BoxWorldGameState state(kDefaultGameParams);
+    BoxWorldGameState expected(kDefaultGameParams);
+    const auto registered = LevelRegistry::get_instance().size();
+    for (std::size_t i = 0; i < 2 * sampler.shard_size(); ++i) {
+        const auto index = sampler.reset(state);
+        expected.reset(levels[index]);
+        if (index != 1 + 3 * (i % sampler.shard_size()) || !(state == expected) ||
+            state.get_hash() != expected.get_hash()) {
+            std::cout << "level sampler sequential error." << std::endl;
+            return false;
+        }
+    }
+    if (LevelRegistry::get_instance().size() != registered) {
+        std::cout << "level sampler registry error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Uniform draws stay in the shard and are reproducible from the seed
+auto test_sampler_uniform() -> bool {
+    LevelSamplerConfig config;
+    config.rank = 0;
+    config.world_size = 4;
+    config.seed = 5;
+    LevelSampler sampler_a(LevelPack(kPackPath), config);
+    LevelSampler sampler_b(LevelPack(kPackPath), config);
+    BoxWorldGameState state(kDefaultGameParams);
+    std::vector<bool> seen(kNumLevels, false);
+    for (int i = 0; i < 200; ++i) {
+        const auto index = sampler_a.reset(state);
+        if (index % 4 != 0 || index >= kNumLevels || sampler_b.reset(state) != index) {
+            std::cout << "level sampler uniform error." << std::endl;
+            return false;
+        }
+        seen[index] = true;
+    }
+    for (std::size_t i = 0; i < kNumLevels; i += 4) {
+        if (!seen[i]) {
+            std::cout << "level sampler uniform coverage error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Weighted draws only give levels with a positive weight, following updated weights once prefetch is drained
+auto test_sampler_weighted() -> bool {
+    LevelSamplerConfig config;
+    config.mode = SamplingMode::kWeighted;
+    config.prefetch = 4;
+    config.weights.assign(kNumLevels, 0);
+    config.weights[3] = 1;
+    config.weights[7] = 3;
+    LevelSampler sampler(LevelPack(kPackPath), config);
+    BoxWorldGameState state(kDefaultGameParams);
+    std::size_t num_seven = 0;
+    for (int i = 0; i < 400; ++i) {
+        const auto index = sampler.reset(state);
+        if (index != 3 && index != 7) {
+            std::cout << "level sampler weighted error." << std::endl;
+            return false;
+        }
+        num_seven += static_cast<std::size_t>(index == 7);
+    }
+    if (num_seven < 250 || num_seven > 350) {
+        std::cout << "level sampler weighted ratio error." << std::endl;
+        return false;
+    }
+    std::vector<double> weights(kNumLevels, 0);
+    weights[11] = 1;
+    sampler.set_weights(weights);
+    for (int i = 0; i < 5; ++i) {
+        (void)sampler.reset(state);
+    }
+    for (int i = 0; i < 20; ++i) {
+        if (sampler.reset(state) != 11) {
+            std::cout << "level sampler set weights error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Invalid shards and weights are rejected
+auto test_sampler_invalid() -> bool {
+    const auto is_rejected = [](const LevelSamplerConfig &config) {
+        try {
+            const LevelSampler sampler(LevelPack(kPackPath), config);
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    };
+    LevelSamplerConfig bad_rank;
+    bad_rank.rank = 2;
+    bad_rank.world_size = 2;
+    LevelSamplerConfig empty_shard;
+    empty_shard.rank = kNumLevels;
+    empty_shard.world_size = kNumLevels + 1;
+    LevelSamplerConfig zero_weights;
+    zero_weights.mode = SamplingMode::kWeighted;
+    zero_weights.weights.assign(kNumLevels, 0);
+    LevelSamplerConfig missing_weights;
+    missing_weights.mode = SamplingMode::kWeighted;
+    if (!is_rejected(bad_rank) || !is_rejected(empty_shard) || !is_rejected(zero_weights) ||
+        !is_rejected(missing_weights)) {
+        std::cout << "level sampler invalid error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// A malformed record is rethrown by the reset which draws it, and later draws continue
+auto test_sampler_malformed(const std::vector<Level> &levels) -> bool {
+    write_level_pack(kMalformedPackPath, levels);
+    {
+        std::fstream file(kMalformedPackPath, std::ios::binary | std::ios::in | std::ios::out);
+        LevelPackHeader header{};
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        // Agent index of record 1 out of the board
+        file.seekp(static_cast<std::streamoff>(sizeof(header) + header.record_size));
+        const uint16_t agent_idx = std::numeric_limits<uint16_t>::max();
+        file.write(reinterpret_cast<const char *>(&agent_idx), sizeof(agent_idx));
+    }
+    LevelSamplerConfig config;
+    config.mode = SamplingMode::kSequential;
+    config.prefetch = 2;
+    LevelSampler sampler(LevelPack(kMalformedPackPath), config);
+    BoxWorldGameState state(kDefaultGameParams);
+    bool ok = sampler.reset(state) == 0;
+    try {
+        static_cast<void>(sampler.reset(state));
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    ok = sampler.reset(state) == 2 && ok;
+    if (!ok) {
+        std::cout << "level sampler malformed error." << std::endl;
+    }
+    return ok;
+}
+
+int main() {
+    const LevelGenerator generator(GeneratorConfig{});
+    const auto levels = generator.generate(0, kNumLevels);
+    write_level_pack(kPackPath, levels);
+    bool ok = true;
+    ok = test_sampler_sequential(levels) && ok;
+    ok = test_sampler_uniform() && ok;
+    ok = test_sampler_weighted() && ok;
+    ok = test_sampler_invalid() && ok;
+    ok = test_sampler_malformed(levels) && ok;
+    std::remove(kPackPath.c_str());
+    std::remove(kMalformedPackPath.c_str());
+    return ok ? 0 : 1;
+}
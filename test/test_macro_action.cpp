@@ -0,0 +1,123 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+constexpr std::size_t kKeyIndex = 4;
+constexpr std::size_t kLockIndex = 10;
+}    // namespace
+
+auto test_macro_action() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+
+    // Lock cannot be opened without the key, so the agent only walks up to it
+    auto bumped = state;
+    if (bumped.apply_macro_action(kLockIndex) != 4 || bumped.has_key() || bumped.get_agent_index() != 6) {
+        std::cout << "macro action bump error." << std::endl;
+        return false;
+    }
+
+    if (state.get_distance_map(kKeyIndex)[0] != 1 || state.apply_macro_action(kKeyIndex) != 1 ||
+        state.get_inventory() != Element::kColour0 || state.get_reward_signal() == 0) {
+        std::cout << "macro action key error." << std::endl;
+        return false;
+    }
+    // Distance map is rebuilt after the key is removed
+    const auto path = state.get_macro_path(kLockIndex);
+    if (path.size() != 3 || state.get_distance_map(kLockIndex)[state.get_agent_index()] != 3) {
+        std::cout << "macro action path error." << std::endl;
+        return false;
+    }
+    if (state.apply_macro_action(kLockIndex) != 3 || !state.is_solution()) {
+        std::cout << "macro action lock error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// The same cells as a 4x3 board, so the key and lock indices are unchanged but the key is two steps away
+auto test_macro_action_new_level() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    const auto other = parse_board("4|3|13|14|14|14|00|14|14|14|14|12|00|14");
+    if (state.get_distance_map(kKeyIndex)[0] != 1) {
+        std::cout << "macro action new level error." << std::endl;
+        return false;
+    }
+    state.reset(other);
+    if (state.get_distance_map(kKeyIndex)[0] != 2 || state.get_macro_path(kKeyIndex).size() != 2) {
+        std::cout << "macro action reset level error." << std::endl;
+        return false;
+    }
+    GameParameters other_params = kDefaultGameParams;
+    other_params["game_board_str"] = GameParameter(to_board_str(other));
+    const auto bytes = BoxWorldGameState(other_params).serialize();
+    state.reset(parse_board(kBoardStr));
+    if (state.get_distance_map(kKeyIndex)[0] != 1) {
+        std::cout << "macro action reset level error." << std::endl;
+        return false;
+    }
+    state.deserialize_from(bytes.data(), bytes.size());
+    if (state.get_distance_map(kKeyIndex)[0] != 2) {
+        std::cout << "macro action deserialize level error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_macro_action_solver() -> bool {
+    // Following the targets of the optimal solution with macro actions takes the same number of steps
+    const BoxWorldSolver solver;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 8; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        auto replay = state;
+        const auto result = solver.solve(state);
+        std::size_t num_steps = 0;
+        for (const auto& action : result.actions) {
+            const auto targets = replay.get_target_indices();
+            replay.apply_action(action);
+            const auto agent_idx = replay.get_agent_index();
+            if (std::find(targets.begin(), targets.end(), agent_idx) != targets.end()) {
+                num_steps += state.apply_macro_action(agent_idx);
+            }
+        }
+        if (!state.is_solution() || num_steps != result.cost) {
+            std::cout << "macro action solver error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_macro_action_invalid() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    try {
+        state.apply_macro_action(1);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    std::cout << "macro action invalid error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_macro_action() && ok;
+    ok = test_macro_action_new_level() && ok;
+    ok = test_macro_action_solver() && ok;
+    ok = test_macro_action_invalid() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <boxworld/boxworld.h>
+
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace boxworld;
+
+namespace {
+const std::string kDirectory = "boxworld_test_mapped_search";
+
+auto check_solution(const BoxWorldGameState &start, const SolverResult &result, std::size_t cost) -> bool {
+    auto state = start;
+    for (const auto &action : result.actions) {
+        state.apply_action(action);
+    }
+    return result.solved && result.cost == cost && result.actions.size() == cost && state.is_solution();
+}
+
+void clear_directory() {
+    std::filesystem::remove_all(kDirectory);
+    std::filesystem::create_directories(kDirectory);
+}
+}    // namespace
+
+auto test_mapped_search_optimal() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    for (const std::size_t num_threads : {1, 4}) {
+        const ParallelSearch search(num_threads);
+        const MappedSearch mapped_search(kDirectory, num_threads);
+        for (uint64_t seed = 0; seed < 8; ++seed) {
+            clear_directory();
+            state.reset(seed, GeneratorConfig{});
+            const auto expected = search.bfs(state);
+            const auto result = mapped_search.bfs(state);
+            if (!check_solution(state, result, expected.cost) || result.expanded > expected.expanded) {
+                std::cout << "mapped search error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Searches stopped by the expansion limit resume from their checkpoint, counting the expansions before the stop
+auto test_mapped_search_resume() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        clear_directory();
+        state.reset(seed, GeneratorConfig{});
+        const auto expected = MappedSearch(kDirectory, 2).bfs(state);
+        clear_directory();
+        const auto stopped = MappedSearch(kDirectory, 2, 100, 10).bfs(state);
+        const MappedSearch search(kDirectory, 2);
+        if (stopped.solved || stopped.expanded < 100 || !search.has_checkpoint(state)) {
+            std::cout << "mapped search stop error." << std::endl;
+            return false;
+        }
+        const auto resumed = search.bfs(state);
+        if (!check_solution(state, resumed, expected.cost) || resumed.expanded != expected.expanded) {
+            std::cout << "mapped search resume error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_mapped_search_unsolvable() -> bool {
+    GameParameters params = kDefaultGameParams;
+    // Goal box locked with a colour which is never available
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|14|14|00|14|14|14|14|12|01|14"));
+    const BoxWorldGameState unsolvable(params);
+    clear_directory();
+    const MappedSearch search(kDirectory, 2);
+    const auto result = search.bfs(unsolvable);
+    // A finished search keeps its checkpoint, so searching again resumes with nothing left to expand
+    const auto again = search.bfs(unsolvable);
+    if (result.solved || again.solved || again.expanded != result.expanded) {
+        std::cout << "mapped search unsolvable error." << std::endl;
+        return false;
+    }
+    // The checkpoint is of another state
+    try {
+        [[maybe_unused]] const auto other = search.bfs(BoxWorldGameState(kDefaultGameParams));
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    std::cout << "mapped search other state error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_mapped_search_optimal() && ok;
+    ok = test_mapped_search_resume() && ok;
+    ok = test_mapped_search_unsolvable() && ok;
+    std::filesystem::remove_all(kDirectory);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+
+// States along the solution path, so some hold keys in the inventory
+auto make_states() -> std::vector<BoxWorldGameState> {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    std::vector<BoxWorldGameState> states;
+    states.emplace_back(params);
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kUp, Action::kLeft}) {
+        states.push_back(states.back());
+        states.back().apply_action(action);
+    }
+    return states;
+}
+}    // namespace
+
+auto test_write_observations() -> bool {
+    const auto states = make_states();
+    const auto obs_size = states[0].get_observation().size();
+    const auto obs_env_size = states[0].get_observation_environment().size();
+    for (const std::size_t num_threads : {1, 4}) {
+        std::vector<float> obs(states.size() * obs_size, -1);
+        std::vector<float> obs_env(states.size() * obs_env_size, -1);
+        BoxWorldGameState::write_observations(states.data(), states.size(), obs.data(), num_threads);
+        BoxWorldGameState::write_observations_environment(states.data(), states.size(), obs_env.data(), num_threads);
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            const auto expected = states[i].get_observation();
+            const auto expected_env = states[i].get_observation_environment();
+            const auto obs_it = obs.begin() + static_cast<std::ptrdiff_t>(i * obs_size);
+            const auto obs_env_it = obs_env.begin() + static_cast<std::ptrdiff_t>(i * obs_env_size);
+            if (!std::equal(expected.begin(), expected.end(), obs_it) ||
+                !std::equal(expected_env.begin(), expected_env.end(), obs_env_it)) {
+                std::cout << "write observations error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto test_observation_encodings() -> bool {
+    for (const auto &state : make_states()) {
+        const auto obs = state.get_observation();
+        const auto obs_uint8 = state.get_observation_uint8();
+        const auto obs_packed = state.get_observation_packed();
+        const auto obs_index = state.get_observation_index();
+        if (obs_uint8.size() != obs.size() || obs_packed.size() != state.observation_packed_size() ||
+            obs_index.size() != state.observation_index_size()) {
+            std::cout << "observation encoding size error." << std::endl;
+            return false;
+        }
+        for (std::size_t i = 0; i < obs.size(); ++i) {
+            const auto bit = (obs_packed[i / 8] >> (i % 8)) & 1;
+            if (static_cast<float>(obs_uint8[i]) != obs[i] || static_cast<float>(bit) != obs[i]) {
+                std::cout << "observation encoding error." << std::endl;
+                return false;
+            }
+        }
+        const auto num_cells = obs_index.size() - 1;
+        for (std::size_t i = 0; i < num_cells; ++i) {
+            if (static_cast<Element>(obs_index[i]) != state.get_item(i)) {
+                std::cout << "index observation error." << std::endl;
+                return false;
+            }
+        }
+        if ((static_cast<Element>(obs_index[num_cells]) != Element::kAgent) != state.has_key()) {
+            std::cout << "index observation inventory error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Dense observation rebuilt from the entities matches get_observation()
+auto test_entity_observation() -> bool {
+    for (const auto &state : make_states()) {
+        const auto entities = state.get_observation_entities();
+        const auto cols = state.observation_shape()[1];
+        const auto num_cells = state.observation_index_size() - 1;
+        std::vector<float> obs(kNumChannels * num_cells, 0);
+        const auto inventory = static_cast<Element>(entities[2]);
+        if (entities[0] != BoxWorldGameState::kInventoryEntityPos || inventory != state.get_inventory()) {
+            std::cout << "entity observation inventory error." << std::endl;
+            return false;
+        }
+        if (inventory != Element::kAgent) {
+            const auto channel = static_cast<std::size_t>(inventory) + kNumElements - 1;
+            std::fill_n(obs.begin() + static_cast<std::ptrdiff_t>(channel * num_cells), num_cells, 1.0F);
+        }
+        for (std::size_t i = BoxWorldGameState::kEntitySize; i < entities.size(); i += BoxWorldGameState::kEntitySize) {
+            obs[entities[i + 2] * num_cells + entities[i] * cols + entities[i + 1]] = 1;
+        }
+        if (obs != state.get_observation()) {
+            std::cout << "entity observation error." << std::endl;
+            return false;
+        }
+        // Truncated buffers still report the full count
+        std::vector<uint16_t> truncated(BoxWorldGameState::kEntitySize * 2);
+        const auto count = state.get_observation_entities(truncated.data(), 2);
+        if (count * BoxWorldGameState::kEntitySize != entities.size() ||
+            !std::equal(truncated.begin(), truncated.end(), entities.begin())) {
+            std::cout << "entity observation capacity error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Observations of each layout and channel selection are a permutation of the full CHW observation
+auto test_observation_config() -> bool {
+    std::vector<ObservationConfig> configs(4);
+    configs[1].layout = ObservationLayout::kHWC;
+    configs[2].inventory_planes = false;
+    configs[2].board_channels = {Element::kAgent, Element::kColourGoal, Element::kColour0};
+    configs[3] = configs[2];
+    configs[3].layout = ObservationLayout::kHWC;
+    configs[3].inventory_planes = true;
+    for (const auto &state : make_states()) {
+        const auto full_obs = state.get_observation();
+        const auto num_cells = state.observation_index_size() - 1;
+        for (const auto &config : configs) {
+            const auto shape = state.observation_shape(config);
+            const auto num_channels = config.num_channels();
+            std::vector<float> obs(shape[0] * shape[1] * shape[2], -1);
+            std::vector<float> inventory(kNumColours, -1);
+            state.get_observation(config, obs.data(), inventory.data());
+            if (obs.size() != num_channels * num_cells) {
+                std::cout << "observation config shape error." << std::endl;
+                return false;
+            }
+            for (std::size_t channel = 0; channel < num_channels; ++channel) {
+                const auto num_board = config.board_channels.empty() ? kNumElements - 1 : config.board_channels.size();
+                std::size_t full_channel = channel;
+                if (channel >= num_board) {
+                    full_channel = kNumElements - 1 + channel - num_board;
+                } else if (!config.board_channels.empty()) {
+                    full_channel = static_cast<std::size_t>(config.board_channels[channel]);
+                }
+                for (std::size_t i = 0; i < num_cells; ++i) {
+                    const auto value = config.layout == ObservationLayout::kCHW ? obs[channel * num_cells + i]
+                                                                                : obs[i * num_channels + channel];
+                    if (value != full_obs[full_channel * num_cells + i]) {
+                        std::cout << "observation config error." << std::endl;
+                        return false;
+                    }
+                }
+            }
+            for (std::size_t colour = 0; colour < kNumColours; ++colour) {
+                const float expected = state.get_inventory() == static_cast<Element>(colour) ? 1 : 0;
+                if (inventory[colour] != expected) {
+                    std::cout << "observation config inventory error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+auto test_incremental_observation() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    IncrementalObservation incremental_obs(state);
+    std::vector<UndoRecord> records;
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kUp, Action::kDown}) {
+        records.push_back(state.apply_action_with_undo(action));
+        incremental_obs.update(state, records.back());
+        if (incremental_obs.get_observation() != state.get_observation()) {
+            std::cout << "incremental observation error." << std::endl;
+            return false;
+        }
+    }
+    // Undo back to the start
+    for (auto it = records.rbegin(); it != records.rend(); ++it) {
+        state.undo_action(*it);
+        incremental_obs.update(state, *it);
+        if (incremental_obs.get_observation() != state.get_observation()) {
+            std::cout << "incremental observation undo error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_cached_observation() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    const auto check = [&](const char *step) {
+        if (state.get_cached_observation() != state.get_observation()) {
+            std::cout << "cached observation error: " << step << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    // Unchanged states return the same buffer without rebuilding
+    const auto *cached = state.get_cached_observation().data();
+    const auto version = state.get_version();
+    if (!check("start") || state.get_cached_observation().data() != cached || state.get_version() != version) {
+        std::cout << "cached observation reuse error." << std::endl;
+        return false;
+    }
+
+    // Every change invalidates the cache
+    state.apply_action(Action::kDown);
+    if (state.get_version() == version || !check("apply_action")) {
+        return false;
+    }
+    const auto record = state.apply_action_with_undo(Action::kRight);
+    if (!check("apply_action_with_undo")) {
+        return false;
+    }
+    state.undo_action(record);
+    if (!check("undo_action")) {
+        return false;
+    }
+    const auto snapshot = state.snapshot();
+    state.reset();
+    if (!check("reset")) {
+        return false;
+    }
+    state.restore(snapshot);
+    if (!check("restore")) {
+        return false;
+    }
+    const auto bytes = state.serialize();
+    state.reset();
+    state.deserialize_from(bytes.data(), bytes.size());
+    if (!check("deserialize_from")) {
+        return false;
+    }
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|14|14|14|14|14|14|14|12|00|14"));
+    BoxWorldGameState keyless(params);
+    [[maybe_unused]] const auto &keyless_obs = keyless.get_cached_observation();
+    keyless.set_key(Element::kColour0);
+    if (keyless.get_cached_observation() != keyless.get_observation()) {
+        std::cout << "cached observation error: set_key" << std::endl;
+        return false;
+    }
+
+    // Assigning a state over another with the same version drops the cache of the old state
+    BoxWorldGameState other(kDefaultGameParams);
+    [[maybe_unused]] const auto &other_obs = other.get_cached_observation();
+    const BoxWorldGameState fresh(params);
+    other = fresh;
+    if (other.get_version() != fresh.get_version() || other.get_cached_observation() != fresh.get_observation()) {
+        std::cout << "cached observation copy error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_write_observations() && ok;
+    ok = test_observation_encodings() && ok;
+    ok = test_entity_observation() && ok;
+    ok = test_observation_config() && ok;
+    ok = test_incremental_observation() && ok;
+    ok = test_cached_observation() && ok;
+    return ok ? 0 : 1;
+}
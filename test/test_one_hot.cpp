@@ -0,0 +1,50 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/one_hot.h"
+
+using namespace boxworld;
+
+// Dispatched kernel matches the scalar kernel for boards of every tail length
+auto test_one_hot() -> bool {
+    std::mt19937 rng(0);
+    std::cout << "one hot kernel: " << static_cast<int>(get_one_hot_kernel()) << std::endl;
+    for (std::size_t num_cells = 1; num_cells <= 70; ++num_cells) {
+        std::vector<Element> board(num_cells);
+        for (auto &el : board) {
+            el = static_cast<Element>(rng() % kNumElements);
+        }
+        const auto num_planes = kNumElements - 1;
+        std::vector<float> expected(num_planes * num_cells, -1);
+        std::vector<float> obs(num_planes * num_cells + 1, -1);
+        write_one_hot_scalar(board.data(), num_cells, num_planes, expected.data());
+        write_one_hot(board.data(), num_cells, num_planes, obs.data());
+        // The value past the planes is left untouched
+        if (obs.back() != -1) {
+            std::cout << "one hot overrun error." << std::endl;
+            return false;
+        }
+        obs.pop_back();
+        if (obs != expected) {
+            std::cout << "one hot kernel error." << std::endl;
+            return false;
+        }
+        for (std::size_t i = 0; i < num_cells; ++i) {
+            for (std::size_t plane = 0; plane < num_planes; ++plane) {
+                const float value = board[i] == static_cast<Element>(plane) ? 1 : 0;
+                if (expected[plane * num_cells + i] != value) {
+                    std::cout << "one hot scalar error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    return test_one_hot() ? 0 : 1;
+}
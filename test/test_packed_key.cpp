@@ -0,0 +1,160 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+// Number of distinct states reachable from the start, using the given key for the closed set
+template <typename KeyFunc>
+auto count_reachable(const BoxWorldGameState& start, KeyFunc key_func) -> std::size_t {
+    std::unordered_set<decltype(key_func(start))> closed{key_func(start)};
+    std::queue<BoxWorldGameState> open;
+    open.push(start);
+    while (!open.empty()) {
+        const auto state = open.front();
+        open.pop();
+        for (const auto& action : state.productive_actions()) {
+            auto child = state;
+            child.apply_action(action);
+            if (closed.insert(key_func(child)).second) {
+                open.push(child);
+            }
+        }
+    }
+    return closed.size();
+}
+}    // namespace
+
+auto test_packed_key_closed_set() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        const auto num_hash = count_reachable(state, [](const BoxWorldGameState& s) { return s.get_hash(); });
+        const auto num_packed = count_reachable(state, [](const BoxWorldGameState& s) { return s.packed_key(); });
+        if (num_hash != num_packed) {
+            std::cout << "packed key closed set error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_packed_key_equality() -> bool {
+    std::mt19937 rng(0);
+    BoxWorldGameState state(kDefaultGameParams);
+    std::unordered_map<PackedStateKey, BoxWorldGameState> seen;
+    for (int step = 0; step < 2000 && !state.is_solution(); ++step) {
+        const auto key = state.packed_key();
+        const auto [it, inserted] = seen.try_emplace(key, state);
+        if (!inserted && (it->second != state || it->second.get_hash() != state.get_hash())) {
+            std::cout << "packed key equality error." << std::endl;
+            return false;
+        }
+        state.apply_action(BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions]);
+    }
+    if (sizeof(PackedStateKey) > 16) {
+        std::cout << "packed key size error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// States work as keys of standard hash containers, agreeing with packed key equality
+auto test_state_hash_set() -> bool {
+    std::mt19937 rng(0);
+    BoxWorldGameState state(kDefaultGameParams);
+    std::unordered_set<BoxWorldGameState> states;
+    std::unordered_set<PackedStateKey> keys;
+    for (int step = 0; step < 2000 && !state.is_solution(); ++step) {
+        states.insert(state);
+        keys.insert(state.packed_key());
+        if (!StateEqual{}(StateHashKey{state.get_hash()}, state) ||
+            StateHash{}(StateHashKey{state.get_hash()}) != std::hash<BoxWorldGameState>{}(state)) {
+            std::cout << "state hash key error." << std::endl;
+            return false;
+        }
+        state.apply_action(BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions]);
+    }
+    if (states.size() != keys.size()) {
+        std::cout << "state hash set error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_state_same_level() -> bool {
+    const BoxWorldGameState state(kDefaultGameParams);
+    auto other = state;
+    other.apply_action(Action::kDown);
+    BoxWorldGameState generated(kDefaultGameParams);
+    generated.reset(0, GeneratorConfig{});
+    if (!state.is_same_level(other) || !state.is_same_level(BoxWorldGameState(kDefaultGameParams)) ||
+        state.is_same_level(generated) || state == other) {
+        std::cout << "state same level error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Observations decoded from packed keys match those of the states, including after keys and boxes are taken
+auto test_packed_key_observation() -> bool {
+    std::mt19937 rng(0);
+    for (const bool collect_first_key : {false, true}) {
+        for (uint64_t seed = 0; seed < 4; ++seed) {
+            const BoxWorldGameState start(LevelGenerator(GeneratorConfig{}).generate(seed), collect_first_key);
+            auto state = start;
+            std::vector<float> obs(state.get_observation().size());
+            for (int step = 0; step < 1000 && !state.is_solution(); ++step) {
+                start.decode_observation(state.packed_key(), obs.data());
+                if (obs != state.get_observation()) {
+                    std::cout << "packed key observation error." << std::endl;
+                    return false;
+                }
+                const auto actions = state.productive_actions();
+                state.apply_action(actions.empty() ? Action::kUp : actions[rng() % actions.size()]);
+            }
+        }
+    }
+    return true;
+}
+
+// States reset to packed keys match the states of the keys, including their hashes and keys and locks left
+auto test_packed_key_reset() -> bool {
+    std::mt19937 rng(1);
+    for (const bool collect_first_key : {false, true}) {
+        for (uint64_t seed = 0; seed < 4; ++seed) {
+            const BoxWorldGameState start(LevelGenerator(GeneratorConfig{}).generate(seed), collect_first_key);
+            auto state = start;
+            auto restored = start;
+            for (int step = 0; step < 1000 && !state.is_solution(); ++step) {
+                const auto actions = state.productive_actions();
+                state.apply_action(actions.empty() ? Action::kUp : actions[rng() % actions.size()]);
+                restored.reset(state.packed_key());
+                if (restored != state || restored.get_hash() != state.get_hash() ||
+                    !(restored.get_key_indices() == state.get_key_indices()) ||
+                    !(restored.get_lock_indices() == state.get_lock_indices()) || restored.get_reward_signal() != 0) {
+                    std::cout << "packed key reset error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_packed_key_closed_set() && ok;
+    ok = test_packed_key_equality() && ok;
+    ok = test_state_hash_set() && ok;
+    ok = test_state_same_level() && ok;
+    ok = test_packed_key_observation() && ok;
+    ok = test_packed_key_reset() && ok;
+    return ok ? 0 : 1;
+}
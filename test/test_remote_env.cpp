@@ -0,0 +1,77 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+
+auto get_observations(const BoxWorldVecEnv &vec_env) -> std::vector<uint8_t> {
+    std::vector<uint8_t> obs;
+    for (std::size_t i = 0; i < vec_env.num_envs(); ++i) {
+        const auto env_obs = vec_env.get_state(i).get_observation_index();
+        obs.insert(obs.end(), env_obs.begin(), env_obs.end());
+    }
+    return obs;
+}
+}    // namespace
+
+// Remote steps match local steps, with observations in the element index encoding
+auto test_remote_env() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    constexpr std::size_t num_envs = 5;
+    constexpr std::size_t num_steps = 40;
+
+    BoxWorldVecEnv local_env(params, num_envs);
+    RemoteEnvServer server(BoxWorldVecEnv(params, num_envs));
+    std::thread server_thread([&]() { server.serve_connection(); });
+    bool ok = true;
+    {
+        RemoteEnvClient client("127.0.0.1", server.port());
+        const auto obs_size = num_envs * client.observation_size();
+        std::vector<uint8_t> obs(obs_size);
+        std::vector<uint64_t> rewards(num_envs);
+        std::vector<uint8_t> dones(num_envs);
+        std::vector<uint64_t> local_rewards(num_envs);
+        std::vector<uint8_t> local_dones(num_envs);
+        local_env.reset();
+        client.reset(obs.data());
+        if (client.num_envs() != num_envs || client.rows() != 3 || client.cols() != 4 ||
+            obs != get_observations(local_env)) {
+            std::cout << "remote env reset error." << std::endl;
+            ok = false;
+        }
+        std::vector<Action> actions(num_envs);
+        for (std::size_t step = 0; step < num_steps && ok; ++step) {
+            for (std::size_t i = 0; i < num_envs; ++i) {
+                actions[i] = static_cast<Action>((i + step * step) % kNumActions);
+            }
+            const bool use_colour = step % 2 == 0;
+            local_env.step(actions.data(), nullptr, local_rewards.data(), local_dones.data(), use_colour);
+            client.step(actions.data(), obs.data(), rewards.data(), dones.data(), use_colour);
+            if (obs != get_observations(local_env) || rewards != local_rewards || dones != local_dones) {
+                std::cout << "remote env step error." << std::endl;
+                ok = false;
+            }
+        }
+        std::fill(obs.begin(), obs.end(), 0);
+        client.observe(obs.data());
+        if (obs != get_observations(local_env)) {
+            std::cout << "remote env observe error." << std::endl;
+            ok = false;
+        }
+    }
+    server_thread.join();
+    return ok;
+}
+
+int main() {
+    return test_remote_env() ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+auto test_sprite_size() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    state.apply_action(Action::kDown);
+
+    // Default renderer matches to_image()
+    const ImageRenderer renderer;
+    if (renderer.render(state) != state.to_image() || renderer.image_shape(state) != state.image_shape()) {
+        std::cout << "default renderer error." << std::endl;
+        return false;
+    }
+
+    // One pixel per cell
+    const ImageRenderer small_renderer(1);
+    const auto shape = small_renderer.image_shape(state);
+    const auto img = small_renderer.render(state);
+    const auto board_cols = shape[1] - 2;
+    for (std::size_t i = 0; i < (shape[0] - 2) * board_cols; ++i) {
+        const auto h = i / board_cols + 1;
+        const auto w = i % board_cols + 1;
+        const auto &pixel = get_element_pixel(state.get_item(i));
+        const auto *img_pixel = &img[(h * shape[1] + w) * SPRITE_CHANNELS];
+        if (img_pixel[0] != pixel.r || img_pixel[1] != pixel.g || img_pixel[2] != pixel.b) {
+            std::cout << "sprite size error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_incremental_render() -> bool {
+    // Agent top left, single key below, and a goal box locked with the key's colour
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    IncrementalRenderer diff_renderer(4);
+    IncrementalRenderer record_renderer(4);
+    const ImageRenderer renderer(4);
+    diff_renderer.render(state);
+    record_renderer.render(state);
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kDown}) {
+        const auto record = state.apply_action_with_undo(action);
+        const auto expected = renderer.render(state);
+        if (diff_renderer.render(state) != expected || record_renderer.update(state, record) != expected) {
+            std::cout << "incremental render error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_render_batch() -> bool {
+    const ImageRenderer renderer(4);
+    std::vector<BoxWorldGameState> states;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kLeft, Action::kUp}) {
+        state.apply_action(action);
+        states.push_back(state);
+    }
+
+    // Each image matches one drawn cell by cell
+    const auto shape = renderer.image_shape(state);
+    const auto img_size = shape[0] * shape[1] * shape[2];
+    const auto cols = shape[1] / renderer.sprite_size();
+    std::vector<uint8_t> expected(states.size() * img_size, 0);
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        auto *img = expected.data() + i * img_size;
+        if (states[i].has_key()) {
+            renderer.draw_cell(img, 0, 0, cols, states[i].get_inventory());
+        }
+        for (std::size_t idx = 0; idx < (shape[0] / renderer.sprite_size() - 2) * (cols - 2); ++idx) {
+            renderer.draw_cell(img, idx / (cols - 2) + 1, idx % (cols - 2) + 1, cols, states[i].get_item(idx));
+        }
+        if (renderer.render(states[i]) != std::vector<uint8_t>(img, img + img_size)) {
+            std::cout << "render error." << std::endl;
+            return false;
+        }
+    }
+    for (const std::size_t num_threads : {1, 3}) {
+        std::vector<uint8_t> imgs(states.size() * img_size, 1);
+        renderer.render_batch(states.data(), states.size(), imgs.data(), num_threads);
+        if (imgs != expected) {
+            std::cout << "render batch error." << std::endl;
+            return false;
+        }
+    }
+
+    // Batches of environments match to_image()
+    BoxWorldVecEnv vec_env(kDefaultGameParams, 3);
+    vec_env.set_num_threads(2);
+    const std::vector<Action> actions{Action::kDown, Action::kRight, Action::kUp};
+    vec_env.step(actions.data());
+    const auto env_shape = vec_env.image_shape();
+    const auto env_img_size = env_shape[0] * env_shape[1] * env_shape[2];
+    std::vector<uint8_t> env_imgs(vec_env.num_envs() * env_img_size);
+    vec_env.render(env_imgs.data());
+    for (std::size_t i = 0; i < vec_env.num_envs(); ++i) {
+        const auto img = vec_env.get_state(i).to_image();
+        if (!std::equal(img.begin(), img.end(), env_imgs.begin() + static_cast<std::ptrdiff_t>(i * env_img_size))) {
+            std::cout << "vec env render error." << std::endl;
+            return false;
+        }
+    }
+
+    // States of a batch must share the board dimensions
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    states.emplace_back(params);
+    bool thrown = false;
+    try {
+        std::vector<uint8_t> imgs(states.size() * img_size);
+        renderer.render_batch(states.data(), states.size(), imgs.data());
+    } catch (const std::invalid_argument &) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cout << "render batch dimensions error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_indexed_image() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    state.apply_action(Action::kDown);
+    for (const std::size_t sprite_size : {1, 4}) {
+        // Looking up the palette gives the colour image
+        const ImageRenderer renderer(sprite_size);
+        const auto shape = renderer.indexed_image_shape(state);
+        const auto indexed = renderer.render_indexed(state);
+        const auto img = renderer.render(state);
+        if (shape[2] != 1 || indexed.size() * SPRITE_CHANNELS != img.size()) {
+            std::cout << "indexed image shape error." << std::endl;
+            return false;
+        }
+        for (std::size_t i = 0; i < indexed.size(); ++i) {
+            const auto &pixel = get_palette().at(indexed[i]);
+            if (img[i * 3] != pixel.r || img[i * 3 + 1] != pixel.g || img[i * 3 + 2] != pixel.b) {
+                std::cout << "indexed image colour error." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // One index per cell of the padded board, with the border distinct from the black agent
+    const auto cells = ImageRenderer(1).render_indexed(state);
+    const auto cols = state.observation_shape()[1] + 2;
+    if (cells[0] != kBorderPaletteIndex || cells[cols + 1] != static_cast<uint8_t>(state.get_item(0)) ||
+        state.to_indexed_image() != ImageRenderer().render_indexed(state) ||
+        state.indexed_image_shape() != ImageRenderer().indexed_image_shape(state)) {
+        std::cout << "indexed image error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_sprite_size() && ok;
+    ok = test_incremental_render() && ok;
+    ok = test_render_batch() && ok;
+    ok = test_indexed_image() && ok;
+    return ok ? 0 : 1;
+}
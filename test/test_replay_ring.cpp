@@ -0,0 +1,182 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+// Pushed transition along with the observations of its states
+struct Record {
+    ReplayTransition transition;
+    std::vector<float> obs;
+    std::vector<float> next_obs;
+};
+
+auto make_levels(std::size_t n) -> std::vector<BoxWorldGameState> {
+    const auto levels = LevelGenerator(GeneratorConfig{}).generate(0, n);
+    return BoxWorldGameState::make_states(levels.data(), levels.size());
+}
+
+// Random walk over the levels, resetting on solution
+auto play(const std::vector<BoxWorldGameState> &levels, std::size_t num_steps, uint64_t seed) -> std::vector<Record> {
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(seed));
+    std::vector<Record> records;
+    uint32_t level_index = 0;
+    auto state = levels[level_index];
+    for (std::size_t step = 0; step < num_steps; ++step) {
+        Record record;
+        record.transition.level_index = level_index;
+        record.transition.state = state.packed_key();
+        record.obs = state.get_observation();
+        const auto actions = state.productive_actions();
+        record.transition.action = actions.empty() ? Action::kUp : actions[rng() % actions.size()];
+        state.apply_action(record.transition.action);
+        record.transition.reward_signal = static_cast<uint32_t>(state.get_reward_signal());
+        record.transition.next_state = state.packed_key();
+        record.transition.done = state.is_solution();
+        record.next_obs = state.get_observation();
+        records.push_back(record);
+        if (state.is_solution() || step % 50 == 49) {
+            level_index = static_cast<uint32_t>(rng() % levels.size());
+            state = levels[level_index];
+        }
+    }
+    return records;
+}
+}    // namespace
+
+// Samples are pushed transitions, decoded to the observations of their states
+auto test_replay_ring_sample() -> bool {
+    const auto levels = make_levels(8);
+    const auto records = play(levels, 500, 0);
+    constexpr std::size_t kCapacity = 128;
+    ReplayRing ring(levels, kCapacity);
+    for (const auto &record : records) {
+        ring.push(record.transition);
+    }
+    if (ring.size() != kCapacity || ring.capacity() != kCapacity || ring.num_pushed() != records.size() ||
+        ring.observation_size() != records[0].obs.size()) {
+        std::cout << "replay ring size error." << std::endl;
+        return false;
+    }
+
+    constexpr std::size_t kNumSamples = 256;
+    const auto obs_size = ring.observation_size();
+    std::vector<ReplayTransition> transitions(kNumSamples);
+    std::vector<float> obs(kNumSamples * obs_size);
+    std::vector<float> next_obs(kNumSamples * obs_size);
+    ring.sample(kNumSamples, 1, transitions.data(), obs.data(), next_obs.data());
+    // Only the latest capacity transitions are held
+    const auto held_begin = records.end() - static_cast<std::ptrdiff_t>(kCapacity);
+    for (std::size_t i = 0; i < kNumSamples; ++i) {
+        const auto it = std::find_if(held_begin, records.end(),
+                                     [&](const Record &record) { return record.transition == transitions[i]; });
+        if (it == records.end() ||
+            !std::equal(it->obs.begin(), it->obs.end(), obs.begin() + static_cast<std::ptrdiff_t>(i * obs_size)) ||
+            !std::equal(it->next_obs.begin(), it->next_obs.end(),
+                        next_obs.begin() + static_cast<std::ptrdiff_t>(i * obs_size))) {
+            std::cout << "replay ring sample error." << std::endl;
+            return false;
+        }
+    }
+
+    // Samples do not depend on the threads
+    std::vector<ReplayTransition> threaded_transitions(kNumSamples);
+    std::vector<float> threaded_obs(kNumSamples * obs_size);
+    ring.sample(kNumSamples, 1, threaded_transitions.data(), threaded_obs.data(), nullptr, 3);
+    if (threaded_transitions != transitions || threaded_obs != obs) {
+        std::cout << "replay ring sample threads error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Concurrent pushes and samples never see a torn transition
+auto test_replay_ring_concurrent() -> bool {
+    constexpr std::size_t kNumProducers = 4;
+    constexpr std::size_t kPushesPerProducer = 20000;
+    ReplayRing ring(make_levels(kNumProducers), 64);
+    // Synthetic transitions whose reward signal is a checksum of the other fields
+    const auto checksum = [](const ReplayTransition &transition) {
+        return static_cast<uint32_t>(transition.state.remaining ^ (transition.next_state.remaining >> 7U) ^
+                                     transition.level_index ^ transition.state.agent_idx);
+    };
+    std::atomic<bool> is_torn{false};
+    std::atomic<std::size_t> num_finished{0};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < kNumProducers; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(t);
+            for (std::size_t i = 0; i < kPushesPerProducer; ++i) {
+                ReplayTransition transition;
+                transition.level_index = static_cast<uint32_t>(t);
+                transition.state.agent_idx = static_cast<uint16_t>(i);
+                transition.state.remaining = rng();
+                transition.next_state.remaining = rng();
+                transition.reward_signal = checksum(transition);
+                ring.push(transition);
+            }
+            ++num_finished;
+        });
+    }
+    threads.emplace_back([&]() {
+        std::vector<ReplayTransition> transitions(16);
+        for (uint64_t seed = 0; num_finished < kNumProducers; ++seed) {
+            if (ring.size() == 0) {
+                continue;
+            }
+            ring.sample(transitions.size(), seed, transitions.data());
+            for (const auto &transition : transitions) {
+                if (transition.reward_signal != checksum(transition)) {
+                    is_torn = true;
+                }
+            }
+        }
+    });
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (is_torn || ring.num_pushed() != kNumProducers * kPushesPerProducer) {
+        std::cout << "replay ring concurrent error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_replay_ring_invalid() -> bool {
+    const auto levels = make_levels(2);
+    bool ok = true;
+    const auto expect_throw = [&](auto &&func) {
+        try {
+            func();
+            ok = false;
+        } catch (const std::invalid_argument &) {
+        }
+    };
+    expect_throw([&]() { const ReplayRing ring(levels, 0); });
+    expect_throw([&]() { const ReplayRing ring({}, 16); });
+    ReplayRing ring(levels, 16);
+    expect_throw([&]() { ring.sample(1, 0, nullptr); });
+    ReplayTransition transition;
+    transition.level_index = 2;
+    expect_throw([&]() { ring.push(transition); });
+    if (!ok || ring.size() != 0) {
+        std::cout << "replay ring invalid error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_replay_ring_sample() && ok;
+    ok = test_replay_ring_concurrent() && ok;
+    ok = test_replay_ring_invalid() && ok;
+    return ok ? 0 : 1;
+}
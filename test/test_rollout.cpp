@@ -0,0 +1,82 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <string>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+auto make_small_state() -> BoxWorldGameState {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    return BoxWorldGameState(params);
+}
+}    // namespace
+
+// Playouts stop at the solution and only take actions which change the state
+auto test_rollout_single() -> bool {
+    const auto start = make_small_state();
+    Xoshiro256 rng(0);
+    for (int i = 0; i < 100; ++i) {
+        auto state = start;
+        const auto result = rollout(state, 1000, rng);
+        // The goal is the second lock after the single key, so a solved playout has two reward signals
+        if (!result.solved || !state.is_solution() || result.num_reward_signals != 2 || result.depth < 4 ||
+            result.first_reward_depth == 0 || result.first_reward_depth > result.depth) {
+            std::cout << "rollout single error." << std::endl;
+            return false;
+        }
+    }
+    auto state = start;
+    const auto result = rollout(state, 0, rng);
+    if (result.solved || result.depth != 0 || state != start) {
+        std::cout << "rollout depth limit error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Batched statistics are consistent and do not depend on the number of threads
+auto test_rollout_batch() -> bool {
+    const auto start = make_small_state();
+    const auto stats = rollouts(start, 1000, 6, 3);
+    if (stats.num_rollouts != 1000 || stats.num_solved == 0 || stats.num_solved == 1000 ||
+        stats.solve_rate() <= 0 || stats.solve_rate() >= 1 || stats.mean_solved_depth() < 4 ||
+        stats.mean_solved_depth() > 6 || stats.num_rewarded < stats.num_solved) {
+        std::cout << "rollout batch error." << std::endl;
+        return false;
+    }
+    for (const std::size_t num_threads : {2, 4}) {
+        const auto threaded_stats = rollouts(start, 1000, 6, 3, num_threads);
+        if (threaded_stats.num_solved != stats.num_solved || threaded_stats.total_depth != stats.total_depth ||
+            threaded_stats.total_reward_signals != stats.total_reward_signals) {
+            std::cout << "rollout threads error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Playouts on generated levels leave the source state untouched
+auto test_rollout_generated() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    state.reset(5, GeneratorConfig{});
+    const auto copy = state;
+    const auto stats = rollouts(state, 200, 500, 1);
+    if (state != copy || stats.num_rollouts != 200 || stats.total_depth == 0) {
+        std::cout << "rollout generated error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_rollout_single() && ok;
+    ok = test_rollout_batch() && ok;
+    ok = test_rollout_generated() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+auto check_solution(const BoxWorldGameState& start, const SolverResult& result, std::size_t cost) -> bool {
+    auto state = start;
+    for (const auto& action : result.actions) {
+        state.apply_action(action);
+    }
+    return result.solved && result.cost == cost && result.actions.size() == cost && state.is_solution();
+}
+}    // namespace
+
+auto test_search_optimal() -> bool {
+    const BoxWorldSolver solver;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (const std::size_t num_threads : {1, 4}) {
+        const ParallelSearch search(num_threads);
+        for (uint64_t seed = 0; seed < 8; ++seed) {
+            state.reset(seed, GeneratorConfig{});
+            const auto cost = solver.solve(state).cost;
+            if (!check_solution(state, search.bfs(state), cost)) {
+                std::cout << "parallel bfs error." << std::endl;
+                return false;
+            }
+            if (!check_solution(state, search.astar(state), cost) ||
+                !check_solution(state, search.astar(state, zero_heuristic), cost) ||
+                !check_solution(state, search.astar(state, key_chain_distance_heuristic), cost) ||
+                !check_solution(state, search.astar(state, key_chain_path_heuristic), cost)) {
+                std::cout << "parallel astar error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+auto test_key_chain_heuristic() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    if (key_chain_heuristic(state) != 2) {
+        std::cout << "key chain heuristic error." << std::endl;
+        return false;
+    }
+    state.apply_action(Action::kDown);
+    if (key_chain_heuristic(state) != 1) {
+        std::cout << "key chain heuristic key error." << std::endl;
+        return false;
+    }
+    // Goal box locked with a colour which is never available
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|14|14|00|14|14|14|14|12|01|14"));
+    const BoxWorldGameState unsolvable(params);
+    if (key_chain_heuristic(unsolvable) != kDeadEnd || ParallelSearch(2).astar(unsolvable).solved ||
+        ParallelSearch(2).bfs(unsolvable).solved) {
+        std::cout << "key chain heuristic dead end error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_key_chain_distance_heuristics() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    if (key_chain_distance_heuristic(state) != 2 || key_chain_path_heuristic(state) != 2) {
+        std::cout << "key chain distance heuristic error." << std::endl;
+        return false;
+    }
+    // Lock is 3 actions away, the same by Manhattan and walking distance
+    const auto record = state.apply_action_with_undo(Action::kDown);
+    if (state.get_remaining_chain_length() != 1 || key_chain_distance_heuristic(state) != 3 ||
+        key_chain_path_heuristic(state) != 3) {
+        std::cout << "key chain distance heuristic key error." << std::endl;
+        return false;
+    }
+    state.undo_action(record);
+    if (state.get_remaining_chain_length() != 2) {
+        std::cout << "remaining chain length undo error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Heuristics never exceed the actions left along an optimal solution, and are ordered by strength
+auto test_heuristics_admissible() -> bool {
+    const BoxWorldSolver solver;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 16; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        const auto result = solver.solve(state);
+        auto walk = state;
+        auto remaining = result.cost;
+        for (std::size_t i = 0; i <= result.actions.size(); ++i) {
+            const auto chain = key_chain_heuristic(walk);
+            const auto manhattan = key_chain_distance_heuristic(walk);
+            const auto path = key_chain_path_heuristic(walk);
+            if (chain > manhattan || manhattan > path || path > remaining) {
+                std::cout << "heuristic admissible error." << std::endl;
+                return false;
+            }
+            if (i < result.actions.size()) {
+                walk.apply_action(result.actions[i]);
+                --remaining;
+            }
+        }
+    }
+    return true;
+}
+
+// Stronger heuristics never expand more states than weaker ones
+auto test_heuristic_expansions() -> bool {
+    const ParallelSearch search(1);
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        const auto chain = search.astar(state, key_chain_heuristic).expanded;
+        const auto path = search.astar(state, key_chain_path_heuristic).expanded;
+        if (path > chain) {
+            std::cout << "heuristic expansions error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_search_optimal() && ok;
+    ok = test_key_chain_heuristic() && ok;
+    ok = test_key_chain_distance_heuristics() && ok;
+    ok = test_heuristics_admissible() && ok;
+    ok = test_heuristic_expansions() && ok;
+    return ok ? 0 : 1;
+}
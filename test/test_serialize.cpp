@@ -1,6 +1,20 @@
 #include <boxworld/boxworld.h>
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/buffer_writer.h>
+
+#include "test_boards.h"
 
 using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+// Layout FlatIndexSet was encoded with as a NOP_STRUCTURE, which its encoding must keep
+struct IndexSetLayout {
+    std::vector<uint16_t> indices;
+    NOP_STRUCTURE(IndexSetLayout, indices);
+};
+}    // namespace
 
 void test_serialization() {
     const std::string board_str =
@@ -40,6 +54,132 @@ void test_serialization() {
     std::cout << state_copy.get_hash() << std::endl;
 }
 
+void test_serialization_buffer() {
+    GameParameters params = kDefaultGameParams;
+    BoxWorldGameState state(params);
+    state.apply_action(Action(1));
+
+    std::vector<uint8_t> buffer(state.serialized_size());
+    const auto bytes_written = state.serialize_into(buffer.data(), buffer.size());
+    buffer.resize(bytes_written);
+    if (state.serialize() != buffer) {
+        std::cout << "buffer serialization error." << std::endl;
+    }
+
+    BoxWorldGameState state_copy(kDefaultGameParams);
+    state_copy.deserialize_from(buffer.data(), buffer.size());
+    if (state != state_copy || state.get_hash() != state_copy.get_hash()) {
+        std::cout << "buffer serialization error." << std::endl;
+    }
+    state_copy.reset();
+    if (state_copy.get_hash() != BoxWorldGameState(kDefaultGameParams).get_hash()) {
+        std::cout << "buffer serialization reset error." << std::endl;
+    }
+}
+
+void test_serialization_local() {
+    BoxWorldGameState state(kDefaultGameParams);
+    state.apply_action(Action(1));
+    const std::vector<uint8_t> bytes = state.serialize_local();
+    if (bytes.size() >= state.serialize().size()) {
+        std::cout << "local serialization size error." << std::endl;
+    }
+
+    BoxWorldGameState state_copy(kDefaultGameParams);
+    state_copy.deserialize_local_from(bytes.data(), bytes.size());
+    if (state != state_copy || state.get_hash() != state_copy.get_hash() ||
+        state.get_level_id() != state_copy.get_level_id()) {
+        std::cout << "local serialization error." << std::endl;
+    }
+
+    // Full deserialization also shares the registered level
+    const BoxWorldGameState state_full(state.serialize());
+    if (state_full.get_level_id() != state.get_level_id() ||
+        LevelRegistry::get_instance().find(state.get_level_id()) == nullptr) {
+        std::cout << "level registry error." << std::endl;
+    }
+}
+
+void test_serialization_sparse() {
+    for (const bool collect_first_key : {false, true}) {
+        GameParameters params = kDefaultGameParams;
+        params["collect_first_key"] = GameParameter(collect_first_key);
+        BoxWorldGameState state(params);
+        const auto solution = BoxWorldSolver().solve(state).actions;
+        for (std::size_t step = 0; step <= solution.size(); ++step) {
+            const std::vector<uint8_t> bytes = state.serialize_sparse();
+            if (bytes.size() != state.serialized_sparse_size() || bytes.size() * 2 >= state.serialize().size()) {
+                std::cout << "sparse serialization size error." << std::endl;
+            }
+            BoxWorldGameState state_copy(kDefaultGameParams);
+            state_copy.deserialize_sparse_from(bytes.data(), bytes.size());
+            if (state != state_copy || state.get_hash() != state_copy.get_hash() ||
+                state.get_level_id() != state_copy.get_level_id() ||
+                state.get_target_indices() != state_copy.get_target_indices() ||
+                state.get_reward_signal() != state_copy.get_reward_signal()) {
+                std::cout << "sparse serialization error." << std::endl;
+            }
+            // The copy continues the same as the original
+            if (step < solution.size()) {
+                state.apply_action(solution[step]);
+                state_copy.apply_action(solution[step]);
+                if (state != state_copy || state.get_hash() != state_copy.get_hash()) {
+                    std::cout << "sparse serialization step error." << std::endl;
+                }
+            }
+        }
+        if (!state.is_solution()) {
+            std::cout << "sparse serialization solution error." << std::endl;
+        }
+    }
+}
+
+// Sets emptied by collecting the only key, then opening the only lock, round trip in every format
+void test_serialization_empty_sets() {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState state(params);
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kDown}) {
+        state.apply_action(action);
+        const BoxWorldGameState state_copy(state.serialize());
+        BoxWorldGameState state_local(params);
+        const auto local_bytes = state.serialize_local();
+        state_local.deserialize_local_from(local_bytes.data(), local_bytes.size());
+        if (state != state_copy || state.get_hash() != state_copy.get_hash() || state != state_local ||
+            state.get_key_indices().size() != state_copy.get_key_indices().size() ||
+            state.get_lock_indices().size() != state_local.get_lock_indices().size()) {
+            std::cout << "empty set serialization error." << std::endl;
+        }
+    }
+    if (!state.get_key_indices().empty() || !state.get_lock_indices().empty() || !state.is_solution()) {
+        std::cout << "empty set serialization setup error." << std::endl;
+    }
+
+    // The encoding matches that of the structure layout, empty or not
+    for (const auto &indices : {std::vector<uint16_t>{}, std::vector<uint16_t>{3, 7}}) {
+        FlatIndexSet set;
+        for (const auto &index : indices) {
+            set.insert(index);
+        }
+        // Reserved so the layout is never written from a null data()
+        IndexSetLayout layout;
+        layout.indices.reserve(indices.size() + 1);
+        layout.indices = indices;
+        std::array<uint8_t, 64> set_bytes{};
+        std::array<uint8_t, 64> layout_bytes{};
+        nop::Serializer<nop::BufferWriter> set_serializer{set_bytes.data(), set_bytes.size()};
+        nop::Serializer<nop::BufferWriter> layout_serializer{layout_bytes.data(), layout_bytes.size()};
+        if (!set_serializer.Write(set) || !layout_serializer.Write(layout) || set_bytes != layout_bytes ||
+            nop::Encoding<FlatIndexSet>::Size(set) != nop::Encoding<IndexSetLayout>::Size(layout)) {
+            std::cout << "index set encoding error." << std::endl;
+        }
+    }
+}
+
 int main() {
     test_serialization();
+    test_serialization_buffer();
+    test_serialization_local();
+    test_serialization_sparse();
+    test_serialization_empty_sets();
 }
@@ -0,0 +1,95 @@
+#include <boxworld/boxworld.h>
+
+#include <signal.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+// Worker process steps match synchronous steps, and each result stays valid while the next step runs
+auto test_shm_vec_env() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    constexpr std::size_t num_envs = 5;
+    constexpr std::size_t num_steps = 40;
+
+    BoxWorldVecEnv sync_env(params, num_envs);
+    ShmVecEnv shm_env(params, num_envs, 2);
+    const auto obs_size = num_envs * sync_env.observation_size();
+    std::vector<float> obs(obs_size);
+    std::vector<uint64_t> rewards(num_envs);
+    std::vector<uint8_t> dones(num_envs);
+    sync_env.reset(obs.data());
+    auto result = shm_env.reset();
+    if (shm_env.observation_shape() != sync_env.observation_shape() ||
+        !std::equal(obs.begin(), obs.end(), result.obs)) {
+        std::cout << "shm vec env reset error." << std::endl;
+        return false;
+    }
+
+    std::vector<float> prev_obs(obs);
+    std::vector<Action> actions(num_envs);
+    for (std::size_t step = 0; step < num_steps; ++step) {
+        for (std::size_t i = 0; i < num_envs; ++i) {
+            actions[i] = static_cast<Action>((i + step * step) % kNumActions);
+        }
+        shm_env.step_async(actions.data());
+        // Previous results are untouched by the step in progress
+        if (!std::equal(prev_obs.begin(), prev_obs.end(), result.obs)) {
+            std::cout << "shm vec env double buffer error." << std::endl;
+            return false;
+        }
+        sync_env.step(actions.data(), obs.data(), rewards.data(), dones.data());
+        result = shm_env.step_wait();
+        if (!std::equal(obs.begin(), obs.end(), result.obs) ||
+            !std::equal(rewards.begin(), rewards.end(), result.reward_signals) ||
+            !std::equal(dones.begin(), dones.end(), result.dones)) {
+            std::cout << "shm vec env step error." << std::endl;
+            return false;
+        }
+        prev_obs = obs;
+    }
+
+    try {
+        shm_env.step_async(actions.data());
+        shm_env.step_async(actions.data());
+    } catch (const std::invalid_argument &) {
+        shm_env.step_wait();
+        return true;
+    }
+    std::cout << "shm vec env pending step error." << std::endl;
+    return false;
+}
+
+// A worker which dies is reported to the caller instead of being waited on forever
+auto test_shm_vec_env_worker_exit() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    ShmVecEnv shm_env(params, 4, 2);
+    shm_env.reset();
+    kill(shm_env.worker_pids()[1], SIGKILL);
+    const std::vector<Action> actions(shm_env.num_envs(), Action::kRight);
+    try {
+        shm_env.step_async(actions.data());
+        shm_env.step_wait();
+    } catch (const std::runtime_error &) {
+        if (shm_env.worker_pids()[1] == 0) {
+            return true;
+        }
+    }
+    std::cout << "shm vec env worker exit error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_shm_vec_env() && ok;
+    ok = test_shm_vec_env_worker_exit() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <boxworld/boxworld.h>
+
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+static_assert(std::is_trivially_copyable_v<StateSnapshot>, "Snapshots should be trivially copyable.");
+
+// Snapshots cloned with memcpy restore every state along a random walk
+auto test_snapshot_restore() -> bool {
+    BoxWorldGameState state(kDefaultGameParams);
+    std::mt19937 rng(0);
+    std::vector<BoxWorldGameState> states;
+    std::vector<StateSnapshot> arena;
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        states.clear();
+        arena.clear();
+        for (int step = 0; step < 200 && !state.is_solution(); ++step) {
+            const auto snapshot = state.snapshot();
+            arena.emplace_back();
+            std::memcpy(&arena.back(), &snapshot, sizeof(StateSnapshot));
+            states.push_back(state);
+            state.apply_action(static_cast<Action>(rng() % kNumActions));
+        }
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            state.restore(arena[i]);
+            if (state != states[i] || state.get_hash() != states[i].get_hash() ||
+                state.get_reward_signal(true) != states[i].get_reward_signal(true) ||
+                state.get_target_indices() != states[i].get_target_indices()) {
+                std::cout << "snapshot restore error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Snapshots of levels of another board size are rejected
+auto test_snapshot_mismatch() -> bool {
+    GameParameters params = kDefaultGameParams;
+    const BoxWorldGameState large_state(params);
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState small_state(params);
+    try {
+        small_state.restore(large_state.snapshot());
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    std::cout << "snapshot mismatch error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_snapshot_restore() && ok;
+    ok = test_snapshot_mismatch() && ok;
+    return ok ? 0 : 1;
+}
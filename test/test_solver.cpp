@@ -0,0 +1,96 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+
+// Optimal solution length by breadth first search over full states
+auto bfs_solution_length(const BoxWorldGameState& start) -> std::size_t {
+    std::unordered_map<uint64_t, std::size_t> visited{{start.get_hash(), 0}};
+    std::queue<BoxWorldGameState> open;
+    open.push(start);
+    while (!open.empty()) {
+        const auto state = open.front();
+        open.pop();
+        const auto cost = visited.at(state.get_hash());
+        for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+            auto child = state;
+            child.apply_action(action);
+            if (child.is_solution()) {
+                return cost + 1;
+            }
+            if (visited.emplace(child.get_hash(), cost + 1).second) {
+                open.push(child);
+            }
+        }
+    }
+    return 0;
+}
+
+auto check_solution(const BoxWorldGameState& start, const SolverResult& result) -> bool {
+    auto state = start;
+    for (const auto& action : result.actions) {
+        state.apply_action(action);
+    }
+    return result.solved && result.cost == result.actions.size() && state.is_solution();
+}
+}    // namespace
+
+auto test_solver_small() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    const BoxWorldGameState state(params);
+    const auto result = BoxWorldSolver().solve(state);
+    if (!check_solution(state, result) || result.cost != 4) {
+        std::cout << "solver small error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_solver_optimal() -> bool {
+    GeneratorConfig config;
+    config.map_size = 8;
+    config.goal_length = 3;
+    config.num_distractor = 1;
+    config.distractor_length = 1;
+    const BoxWorldSolver solver;
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 16; ++seed) {
+        state.reset(seed, config);
+        const auto result = solver.solve(state);
+        if (!check_solution(state, result) || result.cost != bfs_solution_length(state)) {
+            std::cout << "solver optimal error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_solver_unsolvable() -> bool {
+    // Goal box locked with a colour which is never available
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|14|14|00|14|14|14|14|12|01|14"));
+    const BoxWorldGameState state(params);
+    const auto result = BoxWorldSolver().solve(state);
+    if (result.solved || !result.actions.empty()) {
+        std::cout << "solver unsolvable error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_solver_small() && ok;
+    ok = test_solver_optimal() && ok;
+    ok = test_solver_unsolvable() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+auto is_same(const SparseBoxWorld &sparse, const BoxWorldGameState &state) -> bool {
+    for (std::size_t i = 0; i < sparse.rows() * sparse.cols(); ++i) {
+        if (sparse.get_item(i) != state.get_item(i)) {
+            return false;
+        }
+    }
+    return sparse.get_hash() == state.get_hash() && sparse.get_agent_index() == state.get_agent_index() &&
+           sparse.get_inventory() == state.get_inventory() && sparse.is_solution() == state.is_solution() &&
+           sparse.get_reward_signal(false) == state.get_reward_signal(false) &&
+           sparse.get_reward_signal(true) == state.get_reward_signal(true) &&
+           sparse.observation_shape() == state.observation_shape() &&
+           sparse.get_observation() == state.get_observation() &&
+           sparse.get_observation_entities() == state.get_observation_entities();
+}
+}    // namespace
+
+// Stepping matches the dense state, through key pickups, lock openings, and the goal
+auto test_sparse_boxworld() -> bool {
+    const BoxWorldSolver solver;
+    std::mt19937 rng(0);
+    for (const std::size_t map_size : {10, 24}) {
+        GeneratorConfig config;
+        config.map_size = map_size;
+        const LevelGenerator generator(config);
+        for (const bool collect_first_key : {false, true}) {
+            for (uint64_t seed = 0; seed < 8; ++seed) {
+                const auto level = generator.generate(seed);
+                BoxWorldGameState state(level, collect_first_key);
+                SparseBoxWorld sparse(level, collect_first_key);
+                if (!is_same(sparse, state)) {
+                    std::cout << "sparse boxworld construct error." << std::endl;
+                    return false;
+                }
+                // Random steps then the rest of a solution, so the level is solved when it can be
+                for (int step = 0; step < 20; ++step) {
+                    const auto action = BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions];
+                    state.apply_action(action);
+                    sparse.apply_action(action);
+                }
+                if (!(SparseBoxWorld(state) == sparse)) {
+                    std::cout << "sparse boxworld from state error." << std::endl;
+                    return false;
+                }
+                for (const auto &action : solver.solve(state).actions) {
+                    state.apply_action(action);
+                    sparse.apply_action(action);
+                    if (!is_same(sparse, state)) {
+                        std::cout << "sparse boxworld step error." << std::endl;
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Entities only hold the non-empty cells, so the state does not grow with the board
+auto test_sparse_boxworld_entities() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    const BoxWorldGameState state(params);
+    SparseBoxWorld sparse(state);
+    using Kind = SparseBoxWorld::EntityKind;
+    const std::vector<SparseBoxWorld::Entity> expected = {{4, Element::kColour0, Kind::kKey},
+                                                          {9, Element::kColourGoal, Kind::kBlocked},
+                                                          {10, Element::kColour0, Kind::kLock}};
+    if (sparse.get_entities() != expected) {
+        std::cout << "sparse boxworld entities error." << std::endl;
+        return false;
+    }
+    for (const auto &action : {Action::kDown, Action::kRight, Action::kRight, Action::kDown}) {
+        sparse.apply_action(action);
+    }
+    if (!sparse.is_solution() || !sparse.get_entities().empty() || sparse.get_reward_signal(false) != 11) {
+        std::cout << "sparse boxworld solve error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_sparse_boxworld() && ok;
+    ok = test_sparse_boxworld_entities() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,60 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+using namespace boxworld;
+
+// States stored across several blocks of an arena load back unchanged, and freed slots are reused
+auto test_state_pool() -> bool {
+    std::pmr::monotonic_buffer_resource arena;
+    StatePool pool(8, &arena);
+    BoxWorldGameState state(kDefaultGameParams);
+    const auto start = state;
+    std::mt19937 rng(0);
+    std::vector<BoxWorldGameState> states;
+    std::vector<StatePool::Handle> handles;
+    for (int step = 0; step < 50; ++step) {
+        states.push_back(state);
+        handles.push_back(pool.store(state));
+        state.apply_action(static_cast<Action>(rng() % kNumActions));
+    }
+    if (pool.size() != states.size()) {
+        std::cout << "state pool size error." << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        pool.load(handles[i], state);
+        if (state != states[i] || state.get_hash() != states[i].get_hash()) {
+            std::cout << "state pool load error." << std::endl;
+            return false;
+        }
+    }
+
+    const auto capacity = pool.capacity();
+    pool.free(handles[3]);
+    const auto handle = pool.store(start);
+    pool.load(handle, state);
+    if (handle != handles[3] || pool.capacity() != capacity || state != start) {
+        std::cout << "state pool free error." << std::endl;
+        return false;
+    }
+
+    pool.clear();
+    if (pool.size() != 0 || pool.capacity() != capacity + states.size()) {
+        std::cout << "state pool clear error." << std::endl;
+        return false;
+    }
+    pool.release();
+    if (pool.capacity() != 0) {
+        std::cout << "state pool release error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    return test_state_pool() ? 0 : 1;
+}
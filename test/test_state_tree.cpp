@@ -0,0 +1,73 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace boxworld;
+
+// Loaded nodes match the states made by copying the parent and applying the action
+auto test_state_tree() -> bool {
+    std::mt19937 rng(0);
+    GeneratorConfig config;
+    config.map_size = 16;
+    BoxWorldGameState state(kDefaultGameParams);
+    state.reset(0, config);
+    StateTree tree(state);
+    std::vector<BoxWorldGameState> expected{state};
+    for (int i = 0; i < 500; ++i) {
+        const auto parent = static_cast<StateTree::Handle>(rng() % tree.size());
+        const auto action = BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions];
+        auto child = expected[parent];
+        child.apply_action(action);
+        expected.push_back(child);
+        if (tree.add_child(parent, action) != expected.size() - 1) {
+            std::cout << "state tree handle error." << std::endl;
+            return false;
+        }
+    }
+    for (StateTree::Handle handle = 0; handle < tree.size(); ++handle) {
+        tree.load(handle, state);
+        auto replayed = tree.get_root();
+        for (const auto& action : tree.get_path(handle)) {
+            replayed.apply_action(action);
+        }
+        if (state.get_hash() != expected[handle].get_hash() ||
+            state.get_observation() != expected[handle].get_observation() ||
+            replayed.get_hash() != expected[handle].get_hash()) {
+            std::cout << "state tree load error." << std::endl;
+            return false;
+        }
+    }
+    if (tree.node_bytes() != tree.size() * sizeof(StateTree::Node)) {
+        std::cout << "state tree bytes error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_state_tree_handles() -> bool {
+    const BoxWorldGameState state(kDefaultGameParams);
+    StateTree tree(state);
+    const auto child = tree.add_child(StateTree::kRoot, Action::kDown);
+    tree.clear();
+    if (tree.size() != 1 || !tree.get_path(StateTree::kRoot).empty()) {
+        std::cout << "state tree clear error." << std::endl;
+        return false;
+    }
+    try {
+        (void)tree.get_node(child);
+        std::cout << "state tree handle check error." << std::endl;
+        return false;
+    } catch (const std::invalid_argument&) {
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_state_tree() && ok;
+    ok = test_state_tree_handles() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boxworld;
+
+// Events are counted on every thread, including threads which have exited, only when built with stats
+auto test_stats_counts() -> bool {
+    reset_stats();
+    BoxWorldGameState state(kDefaultGameParams);
+    const auto obs = state.get_observation();
+    const auto bytes = state.serialize();
+    const BoxWorldGameState restored(bytes);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([state]() mutable {
+            for (int i = 0; i < 10; ++i) {
+                state.apply_action(Action::kUp);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const auto stats = get_stats();
+    const uint64_t scale = stats_enabled() ? 1 : 0;
+    if (stats[StatsEvent::kApplyAction].count != 20 * scale || stats[StatsEvent::kReset].count != scale ||
+        stats[StatsEvent::kGetObservation].count != scale || stats[StatsEvent::kSerialize].count != scale ||
+        stats[StatsEvent::kDeserialize].count != scale || stats[StatsEvent::kBufferAllocation].count != 2 * scale) {
+        std::cout << "stats counts error." << std::endl;
+        return false;
+    }
+    reset_stats();
+    if (get_stats()[StatsEvent::kApplyAction].count != 0) {
+        std::cout << "stats reset error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Dumps name every event
+auto test_stats_dump() -> bool {
+    Stats stats;
+    stats.entries[static_cast<std::size_t>(StatsEvent::kApplyAction)] = {3, 1500000000};
+    stats.entries[static_cast<std::size_t>(StatsEvent::kLevelAllocation)] = {2, 0};
+    const auto json = stats_to_json(stats);
+    if (json.find("\"apply_action\":{\"count\":3,\"nanoseconds\":1500000000}") == std::string::npos ||
+        json.find("\"level_allocation\":{\"count\":2,\"nanoseconds\":0}") == std::string::npos ||
+        json.front() != '{' || json.back() != '}') {
+        std::cout << "stats json error." << std::endl;
+        return false;
+    }
+    const auto text = stats_to_prometheus(stats);
+    if (text.find("boxworld_calls_total{function=\"apply_action\"} 3\n") == std::string::npos ||
+        text.find("boxworld_call_seconds_total{function=\"apply_action\"} 1.500000000\n") == std::string::npos ||
+        text.find("boxworld_allocations_total{kind=\"level\"} 2\n") == std::string::npos ||
+        text.find("function=\"level\"") != std::string::npos) {
+        std::cout << "stats prometheus error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Copies of a state share its level, and only the local part grows with the board
+auto test_memory_usage() -> bool {
+    const BoxWorldGameState state(kDefaultGameParams);
+    const auto copy = state;
+    const auto usage = state.memory_usage();
+    if (usage.local_bytes <= sizeof(BoxWorldGameState) || usage.shared_bytes <= sizeof(SharedStateInfo) ||
+        copy.memory_usage().shared_bytes != usage.shared_bytes) {
+        std::cout << "state memory usage error." << std::endl;
+        return false;
+    }
+    // Cached distance maps are held by the state
+    const auto &distances = state.get_distance_map(state.get_target_indices().front());
+    if (state.memory_usage().local_bytes < usage.local_bytes + distances.size() * sizeof(uint16_t)) {
+        std::cout << "state memory usage cache error." << std::endl;
+        return false;
+    }
+    StatePool pool(16);
+    const auto empty_bytes = pool.memory_usage();
+    static_cast<void>(pool.store(state));
+    if (pool.memory_usage() < empty_bytes + 16 * sizeof(StateSnapshot)) {
+        std::cout << "state pool memory usage error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Gauges follow registered levels, cached Zobrist tables and live pool blocks
+auto test_memory_stats() -> bool {
+    const auto before = get_memory_stats();
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(std::string("3|4|13|14|14|14|00|14|14|14|14|12|01|14"));
+    const BoxWorldGameState state(params);
+    // Levels are registered on their first local serialization
+    static_cast<void>(state.serialize_local());
+    {
+        StatePool pool(8);
+        static_cast<void>(pool.store(state));
+        const auto during = get_memory_stats();
+        if (during[MemoryKind::kStatePools].count != before[MemoryKind::kStatePools].count + 1 ||
+            during[MemoryKind::kStatePools].bytes !=
+                before[MemoryKind::kStatePools].bytes + 8 * sizeof(StateSnapshot) ||
+            during[MemoryKind::kRegisteredLevels].count != before[MemoryKind::kRegisteredLevels].count + 1 ||
+            during[MemoryKind::kRegisteredLevels].bytes <
+                before[MemoryKind::kRegisteredLevels].bytes + state.memory_usage().shared_bytes ||
+            during[MemoryKind::kZobristTables].count < 1 || during.total_bytes() <= before.total_bytes()) {
+            std::cout << "memory stats error." << std::endl;
+            return false;
+        }
+    }
+    LevelRegistry::get_instance().erase(state.get_level_id());
+    if (get_memory_stats()[MemoryKind::kStatePools].bytes != before[MemoryKind::kStatePools].bytes) {
+        std::cout << "memory stats pool release error." << std::endl;
+        return false;
+    }
+    MemoryStats stats;
+    stats.gauges[static_cast<std::size_t>(MemoryKind::kZobristTables)] = {2, 4096};
+    if (memory_stats_to_json(stats).find("\"zobrist_tables\":{\"count\":2,\"bytes\":4096}") == std::string::npos ||
+        memory_stats_to_prometheus(stats).find("boxworld_memory_bytes{kind=\"zobrist_tables\"} 4096\n") ==
+            std::string::npos) {
+        std::cout << "memory stats dump error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_stats_counts() && ok;
+    ok = test_stats_dump() && ok;
+    ok = test_memory_usage() && ok;
+    ok = test_memory_stats() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+// Children match copying the state and applying each productive action
+auto test_successors() -> bool {
+    std::mt19937 rng(0);
+    BoxWorldGameState state(kDefaultGameParams);
+    BoxWorldGameState scratch(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        for (int step = 0; step < 200 && !state.is_solution(); ++step) {
+            const auto actions = state.productive_actions();
+            std::size_t i = 0;
+            for (const auto& successor : successors(state, scratch, true)) {
+                if (i >= actions.size()) {
+                    std::cout << "successors count error." << std::endl;
+                    return false;
+                }
+                auto child = state;
+                child.apply_action(actions[i]);
+                if (successor.action != actions[i] || successor.hash != child.get_hash() ||
+                    successor.reward_signal != child.get_reward_signal(true) ||
+                    successor.state->get_observation() != child.get_observation()) {
+                    std::cout << "successors error." << std::endl;
+                    return false;
+                }
+                ++i;
+            }
+            if (i != actions.size() || scratch.get_hash() != state.get_hash() ||
+                scratch.get_observation() != state.get_observation()) {
+                std::cout << "successors exhausted error." << std::endl;
+                return false;
+            }
+            state.apply_action(BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions]);
+        }
+    }
+    return true;
+}
+
+// Breaking out leaves the later children ungenerated, with the scratch state holding the last child
+auto test_successors_break() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    const BoxWorldGameState state(params);
+    BoxWorldGameState scratch(params);
+    std::size_t num_visited = 0;
+    for (const auto& successor : successors(state, scratch)) {
+        ++num_visited;
+        if (successor.action == Action::kRight) {
+            break;
+        }
+    }
+    auto expected = state;
+    expected.apply_action(Action::kRight);
+    if (num_visited != 1 || scratch.get_hash() != expected.get_hash()) {
+        std::cout << "successors break error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_successors() && ok;
+    ok = test_successors_break() && ok;
+    return ok ? 0 : 1;
+}
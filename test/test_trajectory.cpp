@@ -0,0 +1,166 @@
+#include <boxworld/boxworld.h>
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace boxworld;
+
+// Record a random walk, keeping every visited state
+auto record_walk(uint64_t seed, std::vector<BoxWorldGameState> &states) -> Trajectory {
+    BoxWorldGameState state(kDefaultGameParams);
+    state.reset(seed, GeneratorConfig{});
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(seed));
+    TrajectoryRecorder recorder(state);
+    states = {state};
+    for (int step = 0; step < 300 && !state.is_solution(); ++step) {
+        const auto action = static_cast<Action>(rng() % kNumActions);
+        state.apply_action(action);
+        recorder.record(action, state);
+        states.push_back(state);
+    }
+    return recorder.get_trajectory();
+}
+
+// Every step of a recorded trajectory is reconstructed by the reader
+auto test_trajectory_replay() -> bool {
+    std::vector<BoxWorldGameState> states;
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        const auto trajectory = record_walk(seed, states);
+        const TrajectoryReader reader(trajectory, 16);
+        if (reader.size() != states.size() - 1) {
+            std::cout << "trajectory replay size error." << std::endl;
+            return false;
+        }
+        for (std::size_t step = 0; step < states.size(); ++step) {
+            const auto state = reader.get_state(step);
+            if (state != states[step] || state.get_hash() != states[step].get_hash()) {
+                std::cout << "trajectory replay error." << std::endl;
+                return false;
+            }
+        }
+        for (const auto &event : reader.get_reward_events()) {
+            const auto &state = states[event.step + 1];
+            if (event.signal_index != state.get_reward_signal(false) ||
+                event.signal_colour != state.get_reward_signal(true)) {
+                std::cout << "trajectory reward event error." << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Trajectories round trip through bytes and files
+auto test_trajectory_serialize() -> bool {
+    std::vector<BoxWorldGameState> states;
+    const auto trajectory = record_walk(7, states);
+    const auto bytes = serialize_trajectory(trajectory);
+    const auto restored = deserialize_trajectory(bytes.data(), bytes.size());
+    if (restored.start_state != trajectory.start_state || restored.actions != trajectory.actions ||
+        restored.reward_events != trajectory.reward_events) {
+        std::cout << "trajectory serialize error." << std::endl;
+        return false;
+    }
+    const std::string path = "test_trajectory.bin";
+    write_trajectory(path, trajectory);
+    const TrajectoryReader reader(read_trajectory(path));
+    std::remove(path.c_str());
+    if (reader.get_state(reader.size()) != states.back()) {
+        std::cout << "trajectory file error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Out of range steps are rejected
+auto test_trajectory_bounds() -> bool {
+    std::vector<BoxWorldGameState> states;
+    const TrajectoryReader reader(record_walk(1, states));
+    try {
+        (void)reader.get_state(reader.size() + 1);
+    } catch (const std::out_of_range &) {
+        return true;
+    }
+    std::cout << "trajectory bounds error." << std::endl;
+    return false;
+}
+
+// Plans replay as recorded walks, and stop at the solution
+auto test_execute_plans() -> bool {
+    std::vector<BoxWorldGameState> levels;
+    std::vector<std::vector<Action>> plans;
+    std::vector<Trajectory> trajectories;
+    std::vector<BoxWorldGameState> final_states;
+    const BoxWorldSolver solver;
+    for (uint64_t seed = 0; seed < 40; ++seed) {
+        std::vector<BoxWorldGameState> states;
+        trajectories.push_back(record_walk(seed, states));
+        levels.push_back(states.front());
+        final_states.push_back(states.back());
+        plans.emplace_back();
+        for (const auto action : trajectories.back().actions) {
+            plans.back().push_back(static_cast<Action>(action));
+        }
+        // Solutions with actions past the solution, which are not applied
+        const auto solution = solver.solve(states.front());
+        if (solution.solved) {
+            levels.push_back(states.front());
+            plans.push_back(solution.actions);
+            plans.back().push_back(Action::kUp);
+            trajectories.push_back(Trajectory{});
+            final_states.push_back(states.front());
+            for (const auto action : solution.actions) {
+                final_states.back().apply_action(action);
+            }
+        }
+    }
+    std::vector<PlanResult> results;
+    for (const std::size_t num_threads : {1, 3}) {
+        execute_plans(levels, plans, results, num_threads);
+        if (results.size() != plans.size()) {
+            std::cout << "execute plans size error." << std::endl;
+            return false;
+        }
+        for (std::size_t i = 0; i < plans.size(); ++i) {
+            const auto is_solution_plan = trajectories[i].actions.empty() && !plans[i].empty();
+            const auto expected_steps = is_solution_plan ? plans[i].size() - 1 : plans[i].size();
+            if (results[i].final_hash != final_states[i].get_hash() ||
+                results[i].solved != final_states[i].is_solution() || results[i].num_steps != expected_steps ||
+                (!is_solution_plan && results[i].reward_events != trajectories[i].reward_events) ||
+                (is_solution_plan && !results[i].solved)) {
+                std::cout << "execute plans error." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    bool ok = true;
+    try {
+        levels.pop_back();
+        execute_plans(levels, plans, results);
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    try {
+        execute_plans({levels[0]}, {{Action::kUp, static_cast<Action>(kNumActions)}}, results, 1);
+        ok = false;
+    } catch (const std::invalid_argument &) {
+    }
+    if (!ok) {
+        std::cout << "execute plans invalid error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_trajectory_replay() && ok;
+    ok = test_trajectory_serialize() && ok;
+    ok = test_trajectory_bounds() && ok;
+    ok = test_execute_plans() && ok;
+    return ok ? 0 : 1;
+}
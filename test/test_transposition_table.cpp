@@ -0,0 +1,135 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <queue>
+#include <random>
+#include <thread>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+auto test_table_find_insert() -> bool {
+    TranspositionTable table(1, ReplacementPolicy::kKeep);
+    if (table.size_bytes() != 1024 * 1024 || table.capacity() != table.size_bytes() / 16) {
+        std::cout << "transposition table size error." << std::endl;
+        return false;
+    }
+    if (table.find(1234).has_value() || table.insert(1234, 7) != InsertResult::kInserted ||
+        table.insert(1234, 8) != InsertResult::kExists || table.find(1234)->value != 7) {
+        std::cout << "transposition table insert error." << std::endl;
+        return false;
+    }
+    // Keys in the same bucket are dropped once the bucket is full
+    const auto stride = table.size_bytes() / 64;
+    for (std::size_t i = 1; i < TranspositionTable::kBucketSize; ++i) {
+        if (table.insert(1234 + i * stride, i) != InsertResult::kInserted) {
+            std::cout << "transposition table bucket error." << std::endl;
+            return false;
+        }
+    }
+    if (table.insert(1234 + TranspositionTable::kBucketSize * stride, 0) != InsertResult::kDropped ||
+        table.find(1234)->value != 7) {
+        std::cout << "transposition table keep error." << std::endl;
+        return false;
+    }
+    table.clear();
+    if (table.find(1234).has_value()) {
+        std::cout << "transposition table clear error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_table_priority() -> bool {
+    TranspositionTable table(1, ReplacementPolicy::kPriority);
+    const auto stride = table.size_bytes() / 64;
+    for (std::size_t i = 0; i < TranspositionTable::kBucketSize; ++i) {
+        table.insert(i * stride, i, static_cast<uint16_t>(10 + i));
+    }
+    // Lower priority than everything in the bucket is dropped, higher replaces the lowest
+    if (table.insert(100 * stride, 100, 5) != InsertResult::kDropped ||
+        table.insert(100 * stride, 100, 20) != InsertResult::kInserted || table.find(0).has_value() ||
+        table.find(100 * stride)->priority != 20) {
+        std::cout << "transposition table replace error." << std::endl;
+        return false;
+    }
+    if (table.insert(stride, 50, 1) != InsertResult::kExists ||
+        table.insert(stride, 50, 30) != InsertResult::kUpdated || table.find(stride)->value != 50) {
+        std::cout << "transposition table update error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+auto test_table_concurrent() -> bool {
+    constexpr std::size_t num_keys = 1 << 14;
+    TranspositionTable table(4, ReplacementPolicy::kKeep);
+    constexpr std::size_t num_threads = 4;
+    std::mt19937_64 rng(0);
+    std::vector<uint64_t> keys(num_keys);
+    for (auto& key : keys) {
+        key = rng();
+    }
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i = t; i < num_keys; i += num_threads) {
+                table.insert_concurrent(keys[i], i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (std::size_t i = 0; i < num_keys; ++i) {
+        const auto entry = table.find(keys[i]);
+        if (!entry.has_value() || entry->value != i) {
+            std::cout << "transposition table concurrent error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+auto test_table_closed_list() -> bool {
+    // BFS over states using the table as the closed list, storing the depth
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    const BoxWorldGameState start(params);
+    TranspositionTable table(1, ReplacementPolicy::kKeep);
+    std::queue<BoxWorldGameState> open;
+    table.insert(start.get_hash(), 0);
+    open.push(start);
+    while (!open.empty()) {
+        const auto state = open.front();
+        open.pop();
+        const auto depth = table.find(state.get_hash())->value;
+        if (state.is_solution()) {
+            if (depth != 4) {
+                std::cout << "transposition table closed list error." << std::endl;
+                return false;
+            }
+            return true;
+        }
+        for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+            auto child = state;
+            child.apply_action(action);
+            if (table.insert(child.get_hash(), depth + 1) == InsertResult::kInserted) {
+                open.push(child);
+            }
+        }
+    }
+    std::cout << "transposition table closed list error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_table_find_insert() && ok;
+    ok = test_table_priority() && ok;
+    ok = test_table_concurrent() && ok;
+    ok = test_table_closed_list() && ok;
+    return ok ? 0 : 1;
+}
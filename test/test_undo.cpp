@@ -0,0 +1,50 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+
+// Walk every action sequence to the given depth in place, checking each undo restores the parent
+auto search_undo(BoxWorldGameState &state, int depth) -> bool {
+    if (depth == 0 || state.is_solution()) {
+        return true;
+    }
+    for (const auto &action : BoxWorldGameState::ALL_ACTIONS) {
+        const BoxWorldGameState parent = state;
+        BoxWorldGameState child = state;
+        child.apply_action(action);
+        const auto record = state.apply_action_with_undo(action);
+        if (state != child || state.get_hash() != child.get_hash()) {
+            std::cout << "apply with undo error." << std::endl;
+            return false;
+        }
+        if (!search_undo(state, depth - 1)) {
+            return false;
+        }
+        state.undo_action(record);
+        if (state != parent || state.get_hash() != parent.get_hash() ||
+            state.get_target_indices() != parent.get_target_indices()) {
+            std::cout << "undo error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}    // namespace
+
+auto test_undo() -> bool {
+    GameParameters params = kDefaultGameParams;
+    BoxWorldGameState default_state(params);
+    params["game_board_str"] = GameParameter(kBoardStr);
+    BoxWorldGameState small_state(params);
+    return search_undo(default_state, 5) && search_undo(small_state, 6);
+}
+
+int main() {
+    return test_undo() ? 0 : 1;
+}
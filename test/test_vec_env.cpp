@@ -0,0 +1,281 @@
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <utility>
+
+#include "test_boards.h"
+
+using namespace boxworld;
+using boxworld::test::kBoardStr;
+
+namespace {
+const std::vector<Action> kSolution{Action::kDown, Action::kRight, Action::kRight, Action::kDown};
+// The shared board with a distractor box in the top right, opened with the key to reach a dead end
+const std::string kDistractorBoardStr = "3|4|13|14|01|00|00|14|14|14|14|12|00|14";
+const std::vector<Action> kDeadEndActions{Action::kDown, Action::kRight, Action::kRight, Action::kRight, Action::kUp};
+// Larger board of the same layout, for batches of mixed board dimensions
+const std::string kLargeBoardStr = "4|5|13|14|14|14|14|14|14|14|14|14|00|14|14|12|00|14|14|14|14|14";
+}    // namespace
+
+auto test_vec_env_step() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    constexpr std::size_t num_envs = 3;
+
+    BoxWorldVecEnv vec_env(params, num_envs);
+    BoxWorldGameState state(params);
+    std::vector<float> obs(num_envs * vec_env.observation_size());
+    std::vector<uint64_t> rewards(num_envs);
+    std::vector<uint8_t> dones(num_envs);
+    vec_env.reset(obs.data());
+
+    for (std::size_t step = 0; step < kSolution.size(); ++step) {
+        // Last env stays in place by walking into the wall
+        const std::vector<Action> actions{kSolution[step], kSolution[step], Action::kLeft};
+        vec_env.step(actions.data(), obs.data(), rewards.data(), dones.data());
+        state.apply_action(kSolution[step]);
+        const bool is_last = step == kSolution.size() - 1;
+        if (dones[0] != static_cast<uint8_t>(is_last) || dones[1] != static_cast<uint8_t>(is_last) || dones[2] != 0) {
+            std::cout << "vec env done error." << std::endl;
+            return false;
+        }
+        if (rewards[0] != state.get_reward_signal() || rewards[2] != 0) {
+            std::cout << "vec env reward error." << std::endl;
+            return false;
+        }
+        if (is_last) {
+            state.reset();
+        }
+        const auto expected_obs = state.get_observation();
+        if (!std::equal(expected_obs.begin(), expected_obs.end(), obs.begin())) {
+            std::cout << "vec env observation error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Observations follow the configured layout, with the inventory as a side output
+auto test_vec_env_observation_config() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    constexpr std::size_t num_envs = 2;
+
+    BoxWorldVecEnv vec_env(params, num_envs);
+    ObservationConfig config;
+    config.layout = ObservationLayout::kHWC;
+    config.inventory_planes = false;
+    vec_env.set_observation_config(config);
+    BoxWorldGameState state(params);
+    if (vec_env.observation_shape() != state.observation_shape(config) ||
+        vec_env.observation_size() != (kNumElements - 1) * 12) {
+        std::cout << "vec env observation config shape error." << std::endl;
+        return false;
+    }
+    std::vector<float> obs(num_envs * vec_env.observation_size());
+    std::vector<float> inventories(num_envs * kNumColours);
+    vec_env.reset(obs.data());
+    const std::vector<Action> actions(num_envs, Action::kDown);
+    vec_env.step(actions.data(), obs.data());
+    vec_env.get_inventories(inventories.data());
+    state.apply_action(Action::kDown);
+    std::vector<float> expected_obs(vec_env.observation_size());
+    std::vector<float> expected_inventory(kNumColours);
+    state.get_observation(config, expected_obs.data(), expected_inventory.data());
+    for (std::size_t i = 0; i < num_envs; ++i) {
+        const auto obs_it = obs.begin() + static_cast<std::ptrdiff_t>(i * expected_obs.size());
+        const auto inventory_it = inventories.begin() + static_cast<std::ptrdiff_t>(i * kNumColours);
+        if (!std::equal(expected_obs.begin(), expected_obs.end(), obs_it) ||
+            !std::equal(expected_inventory.begin(), expected_inventory.end(), inventory_it)) {
+            std::cout << "vec env observation config error." << std::endl;
+            return false;
+        }
+    }
+
+    config.board_channels = {Element::kEmpty};
+    try {
+        vec_env.set_observation_config(config);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    std::cout << "vec env observation config channel error." << std::endl;
+    return false;
+}
+
+// Stepping on any number of threads gives identical results
+auto test_vec_env_threads() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kBoardStr);
+    constexpr std::size_t num_envs = 37;
+    constexpr std::size_t num_steps = 50;
+
+    const auto run = [&](std::size_t num_threads) {
+        BoxWorldVecEnv vec_env(params, num_envs);
+        vec_env.set_num_threads(num_threads);
+        std::vector<float> obs(num_envs * vec_env.observation_size());
+        std::vector<uint64_t> rewards(num_envs);
+        std::vector<uint8_t> dones(num_envs);
+        std::vector<float> results;
+        std::vector<Action> actions(num_envs);
+        vec_env.reset(obs.data());
+        for (std::size_t step = 0; step < num_steps; ++step) {
+            for (std::size_t i = 0; i < num_envs; ++i) {
+                actions[i] = static_cast<Action>((i * 7 + step * 3 + i * step) % kNumActions);
+            }
+            vec_env.step(actions.data(), obs.data(), rewards.data(), dones.data());
+            results.insert(results.end(), obs.begin(), obs.end());
+            results.insert(results.end(), rewards.begin(), rewards.end());
+            results.insert(results.end(), dones.begin(), dones.end());
+        }
+        return results;
+    };
+    const auto expected = run(1);
+    for (const std::size_t num_threads : {2, 3, 8}) {
+        if (run(num_threads) != expected) {
+            std::cout << "vec env threads error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Dead end episodes are only ended when the option is set
+auto test_vec_env_dead_ends() -> bool {
+    GameParameters params = kDefaultGameParams;
+    params["game_board_str"] = GameParameter(kDistractorBoardStr);
+    BoxWorldVecEnv vec_env(params, 1);
+    const BoxWorldGameState start(params);
+    std::vector<uint8_t> dones(1);
+    for (const bool terminate : {false, true}) {
+        vec_env.set_terminate_dead_ends(terminate);
+        vec_env.reset();
+        for (std::size_t step = 0; step < kDeadEndActions.size(); ++step) {
+            vec_env.step(&kDeadEndActions[step], nullptr, nullptr, dones.data());
+            const bool is_last = step == kDeadEndActions.size() - 1;
+            const auto expected = terminate && is_last ? kDoneDeadEnd : kNotDone;
+            if (dones[0] != expected || vec_env.get_terminate_dead_ends() != terminate) {
+                std::cout << "vec env dead end error." << std::endl;
+                return false;
+            }
+        }
+        // Reset on termination, else left in the dead end
+        if ((vec_env.get_state(0) == start) != terminate || vec_env.get_state(0).is_dead_end() == terminate) {
+            std::cout << "vec env dead end reset error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Padded observations hold each environment's own observation in the top left, with a mask of its cells
+auto test_vec_env_padded() -> bool {
+    constexpr std::size_t kMaxRows = 5;
+    constexpr std::size_t kMaxCols = 6;
+    std::vector<GameParameters> params_list;
+    for (const auto &board_str : {kBoardStr, kLargeBoardStr, kBoardStr}) {
+        GameParameters params = kDefaultGameParams;
+        params["game_board_str"] = GameParameter(board_str);
+        params_list.push_back(params);
+    }
+    BoxWorldVecEnv vec_env(params_list, kMaxRows, kMaxCols);
+    vec_env.set_num_threads(2);
+    const std::vector<Action> actions(params_list.size(), Action::kDown);
+    for (const auto layout : {ObservationLayout::kCHW, ObservationLayout::kHWC}) {
+        ObservationConfig config;
+        config.layout = layout;
+        vec_env.set_observation_config(config);
+        const auto num_channels = config.num_channels() + 1;
+        const auto expected_shape = layout == ObservationLayout::kCHW
+                                        ? std::array<std::size_t, 3>{num_channels, kMaxCols, kMaxRows}
+                                        : std::array<std::size_t, 3>{kMaxCols, kMaxRows, num_channels};
+        if (!vec_env.is_padded() || vec_env.observation_shape() != expected_shape ||
+            vec_env.observation_size() != num_channels * kMaxRows * kMaxCols) {
+            std::cout << "vec env padded shape error." << std::endl;
+            return false;
+        }
+        std::vector<float> obs(params_list.size() * vec_env.observation_size());
+        vec_env.reset();
+        vec_env.step(actions.data(), obs.data());
+        for (std::size_t i = 0; i < params_list.size(); ++i) {
+            BoxWorldGameState state(params_list[i]);
+            state.apply_action(Action::kDown);
+            const auto rows = state.observation_shape()[2];
+            const auto cols = state.observation_shape()[1];
+            std::vector<float> expected(config.num_channels() * rows * cols);
+            state.get_observation(config, expected.data());
+            for (std::size_t channel = 0; channel < num_channels; ++channel) {
+                for (std::size_t row = 0; row < kMaxRows; ++row) {
+                    for (std::size_t col = 0; col < kMaxCols; ++col) {
+                        const bool is_cell = row < rows && col < cols;
+                        auto value = is_cell ? 1.0F : 0.0F;
+                        if (is_cell && channel < config.num_channels()) {
+                            value = layout == ObservationLayout::kCHW
+                                        ? expected[(channel * rows + row) * cols + col]
+                                        : expected[(row * cols + col) * config.num_channels() + channel];
+                        }
+                        const auto index = layout == ObservationLayout::kCHW
+                                               ? (channel * kMaxRows + row) * kMaxCols + col
+                                               : (row * kMaxCols + col) * num_channels + channel;
+                        if (obs[i * vec_env.observation_size() + index] != value) {
+                            std::cout << "vec env padded observation error." << std::endl;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Images are padded the same way, in black
+    const auto shape = vec_env.image_shape();
+    std::vector<uint8_t> imgs(params_list.size() * shape[0] * shape[1] * shape[2]);
+    vec_env.render(imgs.data());
+    for (std::size_t i = 0; i < params_list.size(); ++i) {
+        const auto expected = vec_env.get_state(i).to_image();
+        const auto native_shape = vec_env.get_state(i).image_shape();
+        const auto *img = imgs.data() + i * shape[0] * shape[1] * shape[2];
+        for (std::size_t row = 0; row < shape[0]; ++row) {
+            for (std::size_t col = 0; col < shape[1] * shape[2]; ++col) {
+                const bool is_native = row < native_shape[0] && col < native_shape[1] * native_shape[2];
+                const auto value = is_native ? expected[row * native_shape[1] * native_shape[2] + col] : 0;
+                if (img[row * shape[1] * shape[2] + col] != value) {
+                    std::cout << "vec env padded image error." << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Boards must fit in the padded shape, and be of one size if not padded
+    for (const auto &[max_rows, max_cols] : {std::pair<std::size_t, std::size_t>{3, 6}, {0, 0}}) {
+        bool thrown = false;
+        try {
+            const BoxWorldVecEnv small_env(params_list, max_rows, max_cols);
+        } catch (const std::invalid_argument &) {
+            thrown = true;
+        }
+        if (!thrown) {
+            std::cout << "vec env padded invalid error." << std::endl;
+            return false;
+        }
+    }
+    try {
+        const BoxWorldVecEnv unpadded_env(params_list);
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    std::cout << "vec env mixed dimensions error." << std::endl;
+    return false;
+}
+
+int main() {
+    bool ok = true;
+    ok = test_vec_env_step() && ok;
+    ok = test_vec_env_observation_config() && ok;
+    ok = test_vec_env_threads() && ok;
+    ok = test_vec_env_dead_ends() && ok;
+    ok = test_vec_env_padded() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include <boxworld/boxworld.h>
+
+#include <iostream>
+#include <random>
+#include <unordered_set>
+
+using namespace boxworld;
+
+// Tables are cached per board size and match the generated tables
+auto test_zobrist_cache() -> bool {
+    const auto table = get_zobrist_table(10, 12);
+    if (table != get_zobrist_table(10, 12) || table == get_zobrist_table(12, 10) ||
+        table->board.size() != kNumElements * 10 * 12) {
+        std::cout << "zobrist cache error." << std::endl;
+        return false;
+    }
+    const auto generated = make_zobrist_table(10, 12);
+    if (generated.board != table->board || generated.inventory != table->inventory) {
+        std::cout << "zobrist generate error." << std::endl;
+        return false;
+    }
+    std::unordered_set<uint64_t> values(table->board.begin(), table->board.end());
+    values.insert(table->inventory.begin(), table->inventory.end());
+    if (values.size() != table->board.size() + table->inventory.size()) {
+        std::cout << "zobrist distinct error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Hashes of states are unchanged by which level of the size generated the table
+auto test_zobrist_levels() -> bool {
+    const LevelGenerator generator(GeneratorConfig{});
+    const auto level_a = generator.generate(1);
+    const auto level_b = generator.generate(2);
+    BoxWorldGameState state(level_a, false);
+    const BoxWorldGameState expected(level_b, false);
+    state.reset(level_b);
+    if (state.get_hash() != expected.get_hash()) {
+        std::cout << "zobrist level hash error." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Successor hashes match the hashes of the children made by applying each action
+auto test_successor_hashes() -> bool {
+    std::mt19937 rng(0);
+    BoxWorldGameState state(kDefaultGameParams);
+    std::array<uint64_t, kNumActions> hashes{};
+    uint8_t valid_mask = 0;
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        for (int step = 0; step < 1000 && !state.is_solution(); ++step) {
+            state.successor_hashes(hashes, valid_mask);
+            if (valid_mask != state.productive_actions_mask()) {
+                std::cout << "successor hashes mask error." << std::endl;
+                return false;
+            }
+            for (const auto& action : BoxWorldGameState::ALL_ACTIONS) {
+                auto child = state;
+                child.apply_action(action);
+                if (hashes[static_cast<std::size_t>(action)] != child.get_hash()) {
+                    std::cout << "successor hashes error." << std::endl;
+                    return false;
+                }
+            }
+            state.apply_action(BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions]);
+        }
+    }
+    return true;
+}
+
+#ifdef BOXWORLD_HASH128
+// High halves are maintained through actions, undo, and snapshots, and match rebuilding the state
+auto test_hash128() -> bool {
+    std::mt19937 rng(0);
+    const auto table = get_zobrist_table(10, 10);
+    if (table->board_high.size() != table->board.size() || table->board_high == table->board) {
+        std::cout << "hash128 table error." << std::endl;
+        return false;
+    }
+    BoxWorldGameState state(kDefaultGameParams);
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        state.reset(seed, GeneratorConfig{});
+        const auto start = state.get_hash128();
+        const auto snapshot = state.snapshot();
+        std::vector<UndoRecord> records;
+        for (int step = 0; step < 200 && !state.is_solution(); ++step) {
+            records.push_back(state.apply_action_with_undo(BoxWorldGameState::ALL_ACTIONS[rng() % kNumActions]));
+            const auto hash = state.get_hash128();
+            const auto copy = BoxWorldGameState(state.serialize());
+            if (hash.low != state.get_hash() || copy.get_hash128() != hash) {
+                std::cout << "hash128 step error." << std::endl;
+                return false;
+            }
+        }
+        for (auto it = records.rbegin(); it != records.rend(); ++it) {
+            state.undo_action(*it);
+        }
+        if (state.get_hash128() != start) {
+            std::cout << "hash128 undo error." << std::endl;
+            return false;
+        }
+        state.restore(snapshot);
+        if (state.get_hash128() != start) {
+            std::cout << "hash128 restore error." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+int main() {
+    bool ok = true;
+    ok = test_zobrist_cache() && ok;
+    ok = test_zobrist_levels() && ok;
+    ok = test_successor_hashes() && ok;
+#ifdef BOXWORLD_HASH128
+    ok = test_hash128() && ok;
+#endif
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// Index the starting boards of a level file or pack, to deduplicate it or check its overlap with another level set.
+// Usage: boxworld_dedup LEVELS [--index PATH] [--dedup PATH] [--overlap OTHER] [--threads N]
+//   LEVELS is a text file of one board string per line (e.g. train.txt), a binary level pack, or a level index
+//   --index writes the level index of LEVELS, for later overlap checks without the levels
+//   --dedup writes a level pack of the first occurrence of each distinct board of LEVELS
+//   --overlap counts the levels of LEVELS whose board is also in OTHER, a level file, pack, or index
+//   Writes a CSV row of: levels,unique,duplicates,overlap
+
+#include <boxworld/boxworld.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+
+void print_usage() {
+    std::cerr << "Usage: boxworld_dedup LEVELS [--index PATH] [--dedup PATH] [--overlap OTHER] [--threads N]"
+              << std::endl;
+}
+
+auto has_magic(const std::string &path, const char *expected, std::size_t size) -> bool {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> magic(size);
+    file.read(magic.data(), static_cast<std::streamsize>(size));
+    return file && std::memcmp(magic.data(), expected, size) == 0;
+}
+
+auto is_level_pack(const std::string &path) -> bool {
+    return has_magic(path, kLevelPackMagic, sizeof(kLevelPackMagic));
+}
+
+auto is_level_index(const std::string &path) -> bool {
+    return has_magic(path, kLevelIndexMagic, sizeof(kLevelIndexMagic));
+}
+
+auto build_index(const std::string &path, std::size_t num_threads) -> LevelIndex {
+    if (is_level_index(path)) {
+        return LevelIndex::read(path);
+    }
+    if (is_level_pack(path)) {
+        return LevelIndex(LevelPack(path), num_threads);
+    }
+    return LevelIndex(read_level_file(path));
+}
+
+auto read_levels(const std::string &path, const std::vector<std::size_t> &indices) -> std::vector<Level> {
+    std::vector<Level> levels;
+    levels.reserve(indices.size());
+    if (is_level_pack(path)) {
+        const LevelPack pack(path);
+        for (const auto &i : indices) {
+            levels.push_back(pack.get_level(i));
+        }
+    } else {
+        auto all_levels = read_level_file(path);
+        for (const auto &i : indices) {
+            levels.push_back(std::move(all_levels[i]));
+        }
+    }
+    return levels;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    const std::string levels_path = argv[1];
+    std::optional<std::string> index_path;
+    std::optional<std::string> dedup_path;
+    std::optional<std::string> overlap_path;
+    std::size_t num_threads = 0;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--index" && i + 1 < argc) {
+            index_path = argv[++i];
+        } else if (arg == "--dedup" && i + 1 < argc) {
+            dedup_path = argv[++i];
+        } else if (arg == "--overlap" && i + 1 < argc) {
+            overlap_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::stoul(argv[++i]);
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try {
+        if (dedup_path && is_level_index(levels_path)) {
+            std::cerr << "Cannot deduplicate a level index, which does not hold the levels." << std::endl;
+            return 1;
+        }
+        const auto index = build_index(levels_path, num_threads);
+        const auto unique = index.unique_indices();
+        std::size_t num_overlap = 0;
+        if (overlap_path) {
+            num_overlap = index.overlap(build_index(*overlap_path, num_threads)).size();
+        }
+        if (index_path) {
+            index.write(*index_path);
+        }
+        if (dedup_path) {
+            write_level_pack(*dedup_path, read_levels(levels_path, unique));
+        }
+        std::cout << "levels,unique,duplicates,overlap\n";
+        std::cout << index.size() << "," << unique.size() << "," << index.size() - unique.size() << ","
+                  << num_overlap << "\n";
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
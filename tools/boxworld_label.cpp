@@ -0,0 +1,146 @@
+// Label each level of a level file or pack with its solvability, optimal solution length, and distractor branches.
+// Usage: boxworld_label LEVELS [--output PATH] [--threads N] [--collect_first_key]
+//   LEVELS is a text file of one board string per line (e.g. train.txt), or a binary level pack
+//   Writes CSV rows of: index,solvable,optimal_length,num_distractor_branches,num_boxes
+
+#include <boxworld/boxworld.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/parallel.h"
+
+using namespace boxworld;
+
+namespace {
+
+struct Label {
+    bool solvable = false;
+    std::size_t optimal_length = 0;
+    std::size_t num_distractor_branches = 0;
+    std::size_t num_boxes = 0;
+};
+
+void print_usage() {
+    std::cerr << "Usage: boxworld_label LEVELS [--output PATH] [--threads N] [--collect_first_key]" << std::endl;
+}
+
+auto is_level_pack(const std::string &path) -> bool {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kLevelPackMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, kLevelPackMagic, sizeof(magic)) == 0;
+}
+
+// Distractor branches are locks off the solution path which can be opened with a key held along it
+auto label_state(const BoxWorldGameState &start, const BoxWorldSolver &solver) -> Label {
+    Label label;
+    label.num_boxes = start.get_lock_indices().size();
+    const auto result = solver.solve(start);
+    if (!result.solved) {
+        return label;
+    }
+    label.solvable = true;
+    label.optimal_length = result.cost;
+
+    auto state = start;
+    std::set<Element> held_colours;
+    if (state.has_key()) {
+        held_colours.insert(state.get_inventory());
+    }
+    for (const auto &action : result.actions) {
+        state.apply_action(action);
+        if (state.has_key()) {
+            held_colours.insert(state.get_inventory());
+        }
+    }
+    for (const auto &idx : start.get_lock_indices()) {
+        if (state.get_lock_indices().contains(idx) && held_colours.count(start.get_item(idx)) > 0) {
+            ++label.num_distractor_branches;
+        }
+    }
+    return label;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    const std::string levels_path = argv[1];
+    std::optional<std::string> output_path;
+    std::size_t num_threads = 0;
+    bool collect_first_key = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::stoul(argv[++i]);
+        } else if (arg == "--collect_first_key") {
+            collect_first_key = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::vector<Label> labels;
+    try {
+        GameParameters params = kDefaultGameParams;
+        params["collect_first_key"] = GameParameter(collect_first_key);
+        const BoxWorldGameState scratch(params);
+        const BoxWorldSolver solver;
+        constexpr std::size_t kGrainSize = 16;
+        // Each chunk resets its own state in place, so levels are never registered. Errors such as a malformed pack
+        // record are rethrown on this thread by parallel_for_dynamic(), so reach the catch below
+        if (is_level_pack(levels_path)) {
+            const LevelPack pack(levels_path);
+            labels.resize(pack.size());
+            parallel_for_dynamic(pack.size(), num_threads, kGrainSize, [&](std::size_t begin, std::size_t end) {
+                auto state = scratch;
+                for (std::size_t i = begin; i < end; ++i) {
+                    state.reset(pack, i);
+                    labels[i] = label_state(state, solver);
+                }
+            });
+        } else {
+            const auto levels = read_level_file(levels_path);
+            labels.resize(levels.size());
+            parallel_for_dynamic(levels.size(), num_threads, kGrainSize, [&](std::size_t begin, std::size_t end) {
+                auto state = scratch;
+                for (std::size_t i = begin; i < end; ++i) {
+                    state.reset(levels[i]);
+                    labels[i] = label_state(state, solver);
+                }
+            });
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::ofstream output_file;
+    if (output_path) {
+        output_file.open(*output_path);
+        if (!output_file) {
+            std::cerr << "Unable to open output file: " << *output_path << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &os = output_path ? output_file : std::cout;
+    os << "index,solvable,optimal_length,num_distractor_branches,num_boxes\n";
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        const auto &label = labels[i];
+        os << i << "," << static_cast<int>(label.solvable) << "," << label.optimal_length << ","
+           << label.num_distractor_branches << "," << label.num_boxes << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Serve a batch of environments over TCP for RemoteEnvClient, so environments can run on other nodes than the learner.
+// Usage: boxworld_server LEVELS [--port N] [--envs N] [--threads N] [--collect_first_key] [--terminate_dead_ends]
+//   LEVELS is a text file of one board string per line (e.g. train.txt), or a binary level pack
+//   Environment i plays level i modulo the number of levels
+
+#include <boxworld/boxworld.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace boxworld;
+
+namespace {
+
+void print_usage() {
+    std::cerr << "Usage: boxworld_server LEVELS [--port N] [--envs N] [--threads N] [--collect_first_key] "
+                 "[--terminate_dead_ends]"
+              << std::endl;
+}
+
+auto is_level_pack(const std::string &path) -> bool {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kLevelPackMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, kLevelPackMagic, sizeof(magic)) == 0;
+}
+
+auto read_levels(const std::string &path) -> std::vector<Level> {
+    if (!is_level_pack(path)) {
+        return read_level_file(path);
+    }
+    const LevelPack pack(path);
+    std::vector<Level> levels;
+    levels.reserve(pack.size());
+    for (std::size_t i = 0; i < pack.size(); ++i) {
+        levels.push_back(pack.get_level(i));
+    }
+    return levels;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    const std::string levels_path = argv[1];
+    uint16_t port = 0;
+    std::size_t num_envs = 1;
+    std::size_t num_threads = 1;
+    bool collect_first_key = false;
+    bool terminate_dead_ends = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::stoul(argv[++i]));
+        } else if (arg == "--envs" && i + 1 < argc) {
+            num_envs = std::stoul(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = std::stoul(argv[++i]);
+        } else if (arg == "--collect_first_key") {
+            collect_first_key = true;
+        } else if (arg == "--terminate_dead_ends") {
+            terminate_dead_ends = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try {
+        const auto levels = read_levels(levels_path);
+        if (levels.empty()) {
+            std::cerr << "No levels in " << levels_path << std::endl;
+            return 1;
+        }
+        std::vector<GameParameters> params_list;
+        params_list.reserve(num_envs);
+        for (std::size_t i = 0; i < num_envs; ++i) {
+            GameParameters params = kDefaultGameParams;
+            params["game_board_str"] = GameParameter(to_board_str(levels[i % levels.size()]));
+            params["collect_first_key"] = GameParameter(collect_first_key);
+            params_list.push_back(std::move(params));
+        }
+        BoxWorldVecEnv vec_env(params_list);
+        vec_env.set_num_threads(num_threads);
+        vec_env.set_terminate_dead_ends(terminate_dead_ends);
+        RemoteEnvServer server(std::move(vec_env), port);
+        std::cout << "Serving " << num_envs << " environments on port " << server.port() << std::endl;
+        server.serve();
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
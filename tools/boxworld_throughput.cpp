@@ -0,0 +1,214 @@
+// Measure end-to-end actor throughput over a level file or pack, for each of a list of thread counts.
+// Usage: boxworld_throughput LEVELS [--threads N,N,...] [--steps N] [--policy random|productive]
+//                            [--max_episode_steps N] [--image_every N] [--seed N] [--collect_first_key]
+//   LEVELS is a text file of one board string per line (e.g. train.txt), or a binary level pack
+//   Each thread plays its own state as an actor does: apply_action() and get_observation() every step, to_image() every
+//   image_every steps, and reset() onto a random level of the pack when the episode is solved or runs out of steps
+//   Writes CSV rows of: threads,steps_per_sec,resets_per_sec,obs_gb_per_sec,images_per_sec,p50_step_us,p99_step_us
+
+#include <boxworld/boxworld.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/rng.h"
+
+using namespace boxworld;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Policy {
+    kRandom,        // Uniformly random actions
+    kProductive,    // Random among the actions which change the state, see productive_actions_mask()
+};
+
+struct Options {
+    std::vector<std::size_t> thread_counts{1};
+    std::size_t steps = 100000;    // Steps per thread
+    Policy policy = Policy::kRandom;
+    std::size_t max_episode_steps = 200;
+    std::size_t image_every = 0;    // 0 to never render
+    uint64_t seed = 0;
+    bool collect_first_key = false;
+};
+
+// Counts and step latencies of a single actor thread
+struct ActorResult {
+    std::size_t steps = 0;
+    std::size_t resets = 0;
+    std::size_t images = 0;
+    std::size_t obs_bytes = 0;
+    std::vector<float> step_us;
+};
+
+void print_usage() {
+    std::cerr << "Usage: boxworld_throughput LEVELS [--threads N,N,...] [--steps N] [--policy random|productive] "
+                 "[--max_episode_steps N] [--image_every N] [--seed N] [--collect_first_key]"
+              << std::endl;
+}
+
+auto is_level_pack(const std::string &path) -> bool {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kLevelPackMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, kLevelPackMagic, sizeof(magic)) == 0;
+}
+
+auto parse_thread_counts(const std::string &arg) -> std::vector<std::size_t> {
+    std::vector<std::size_t> counts;
+    std::stringstream ss(arg);
+    std::string count;
+    while (std::getline(ss, count, ',')) {
+        counts.push_back(std::max<std::size_t>(std::stoul(count), 1));
+    }
+    return counts;
+}
+
+auto select_action(const BoxWorldGameState &state, Policy policy, SplitMix64 &rng) -> Action {
+    if (policy == Policy::kProductive) {
+        const auto mask = state.productive_actions_mask();
+        if (mask != 0) {
+            std::array<Action, kNumActions> actions{};
+            std::size_t num_actions = 0;
+            for (std::size_t a = 0; a < kNumActions; ++a) {
+                if ((mask & (1U << a)) != 0) {
+                    actions[num_actions++] = static_cast<Action>(a);
+                }
+            }
+            return actions[rng.next_below(num_actions)];
+        }
+    }
+    return static_cast<Action>(rng.next_below(kNumActions));
+}
+
+auto run_actor(const LevelPack &pack, const BoxWorldGameState &scratch, const Options &options, uint64_t seed)
+    -> ActorResult {
+    ActorResult result;
+    result.step_us.reserve(options.steps);
+    SplitMix64 rng(seed);
+    auto state = scratch;
+    state.reset(pack, rng.next_below(pack.size()));
+    const auto obs_shape = state.observation_shape();
+    std::vector<float> obs(obs_shape[0] * obs_shape[1] * obs_shape[2]);
+    const auto image_shape = state.image_shape();
+    std::vector<uint8_t> img(image_shape[0] * image_shape[1] * image_shape[2]);
+    std::size_t episode_steps = 0;
+    for (std::size_t step = 0; step < options.steps; ++step) {
+        const auto start = Clock::now();
+        state.apply_action(select_action(state, options.policy, rng));
+        ++episode_steps;
+        if (state.is_solution() || episode_steps == options.max_episode_steps) {
+            state.reset(pack, rng.next_below(pack.size()));
+            episode_steps = 0;
+            ++result.resets;
+        }
+        state.get_observation(obs.data());
+        result.obs_bytes += obs.size() * sizeof(float);
+        if (options.image_every > 0 && step % options.image_every == 0) {
+            state.to_image(img.data());
+            ++result.images;
+        }
+        result.step_us.push_back(std::chrono::duration<float, std::micro>(Clock::now() - start).count());
+        ++result.steps;
+    }
+    return result;
+}
+
+auto percentile(std::vector<float> &values, double fraction) -> float {
+    if (values.empty()) {
+        return 0;
+    }
+    const auto nth = values.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    const std::string levels_path = argv[1];
+    Options options;
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.thread_counts = parse_thread_counts(argv[++i]);
+        } else if (arg == "--steps" && i + 1 < argc) {
+            options.steps = std::stoul(argv[++i]);
+        } else if (arg == "--policy" && i + 1 < argc) {
+            const std::string policy = argv[++i];
+            if (policy != "random" && policy != "productive") {
+                print_usage();
+                return 1;
+            }
+            options.policy = policy == "random" ? Policy::kRandom : Policy::kProductive;
+        } else if (arg == "--max_episode_steps" && i + 1 < argc) {
+            options.max_episode_steps = std::max<std::size_t>(std::stoul(argv[++i]), 1);
+        } else if (arg == "--image_every" && i + 1 < argc) {
+            options.image_every = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--collect_first_key") {
+            options.collect_first_key = true;
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try {
+        const auto pack = is_level_pack(levels_path) ? LevelPack(levels_path) : LevelPack::load_level_file(levels_path);
+        GameParameters params = kDefaultGameParams;
+        params["collect_first_key"] = GameParameter(options.collect_first_key);
+        const BoxWorldGameState scratch(params);
+
+        std::cout << "threads,steps_per_sec,resets_per_sec,obs_gb_per_sec,images_per_sec,p50_step_us,p99_step_us\n";
+        for (const auto num_threads : options.thread_counts) {
+            std::vector<ActorResult> results(num_threads);
+            std::vector<std::thread> threads;
+            threads.reserve(num_threads);
+            const auto start = Clock::now();
+            for (std::size_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&, t]() {
+                    results[t] = run_actor(pack, scratch, options, SplitMix64(options.seed + t)());
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+            ActorResult total;
+            for (auto &result : results) {
+                total.steps += result.steps;
+                total.resets += result.resets;
+                total.images += result.images;
+                total.obs_bytes += result.obs_bytes;
+                total.step_us.insert(total.step_us.end(), result.step_us.begin(), result.step_us.end());
+            }
+            const auto p50 = percentile(total.step_us, 0.5);
+            const auto p99 = percentile(total.step_us, 0.99);
+            std::cout << num_threads << "," << static_cast<double>(total.steps) / seconds << ","
+                      << static_cast<double>(total.resets) / seconds << ","
+                      << static_cast<double>(total.obs_bytes) / seconds / 1e9 << ","
+                      << static_cast<double>(total.images) / seconds << "," << p50 << "," << p99 << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}